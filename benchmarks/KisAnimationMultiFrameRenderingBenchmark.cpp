@@ -0,0 +1,128 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisAnimationMultiFrameRenderingBenchmark.h"
+
+#include <QTest>
+
+#include <testutil.h>
+#include "KisAsyncAnimationMultiFrameRenderer.h"
+#include "kis_time_range.h"
+#include "kis_image_animation_interface.h"
+#include "KisPart.h"
+#include "KisDocument.h"
+#include "kis_image.h"
+#include "kis_image_config.h"
+#include "kis_paint_device.h"
+
+ProjectionFetchingRenderer::ProjectionFetchingRenderer()
+{
+    connect(this, SIGNAL(sigFrameFetched(int)), SLOT(notifyFrameCompleted(int)));
+}
+
+void ProjectionFetchingRenderer::frameCompletedCallback(int frame)
+{
+    KisImageSP image = requestedImage();
+    if (!image) return;
+
+    QImage result = image->projection()->convertToQImage(0, image->bounds());
+    Q_UNUSED(result);
+
+    emit sigFrameFetched(frame);
+}
+
+void ProjectionFetchingRenderer::frameCancelledCallback(int frame)
+{
+    notifyFrameCancelled(frame);
+}
+
+namespace {
+void runRenderingTest(KisImageSP image, int numCores, int numClones)
+{
+    {
+        KisImageConfig cfg;
+        cfg.setMaxNumberOfThreads(numCores);
+        cfg.setFrameRenderingClones(numClones);
+    }
+
+    const KisTimeRange range = image->animationInterface()->fullClipRange();
+
+    QList<int> frames;
+    for (int i = range.start(); i <= range.end(); i++) {
+        frames << i;
+    }
+
+    KisAsyncAnimationMultiFrameRenderer renderer(
+        [] (KisImageSP image) {
+            Q_UNUSED(image);
+            return new ProjectionFetchingRenderer();
+        },
+        [] (KisAsyncAnimationRendererBase *renderer, KisImageSP image, int frame) {
+            Q_UNUSED(renderer);
+            Q_UNUSED(image);
+            Q_UNUSED(frame);
+        });
+
+    int numCancelledFrames = 0;
+    QObject::connect(&renderer, &KisAsyncAnimationMultiFrameRenderer::sigFrameCancelled,
+                     [&numCancelledFrames] (int) { numCancelledFrames++; });
+
+    QEventLoop loop;
+    QObject::connect(&renderer, SIGNAL(sigRenderingFinished()), &loop, SLOT(quit()));
+
+    QElapsedTimer timer;
+    timer.start();
+
+    renderer.startRendering(image, frames);
+    if (renderer.isActive()) {
+        loop.exec();
+    }
+
+    qDebug() << "Cores:" << numCores << "Clones:" << numClones
+             << "Workers:" << renderer.numWorkers()
+             << "Frames:" << frames.size()
+             << "Time:" << timer.elapsed();
+
+    renderer.releaseWorkers();
+
+    QCOMPARE(numCancelledFrames, 0);
+}
+
+}
+
+void KisAnimationMultiFrameRenderingBenchmark::testMultiFrameRendering()
+{
+    const QString fileName = TestUtil::fetchDataFileLazy("miloor_turntable_002.kra", true);
+    QVERIFY(QFileInfo(fileName).exists());
+
+    QScopedPointer<KisDocument> doc(KisPart::instance()->createDocument());
+
+    bool loadingResult = doc->loadNativeFormat(fileName);
+    QVERIFY(loadingResult);
+
+    doc->image()->barrierLock();
+    doc->image()->unlock();
+
+    const int numCores = QThread::idealThreadCount();
+
+    for (int numClones = 1; numClones <= numCores; numClones++) {
+        runRenderingTest(doc->image(), numCores, numClones);
+    }
+}
+
+QTEST_MAIN(KisAnimationMultiFrameRenderingBenchmark)
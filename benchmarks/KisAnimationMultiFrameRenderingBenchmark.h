@@ -0,0 +1,51 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KISANIMATIONMULTIFRAMERENDERINGBENCHMARK_H
+#define KISANIMATIONMULTIFRAMERENDERINGBENCHMARK_H
+
+#include <QtTest>
+
+#include "KisAsyncAnimationRendererBase.h"
+
+/**
+ * A renderer that just fetches the projection of the frame, so that
+ * the benchmark measures the regeneration itself
+ */
+class ProjectionFetchingRenderer : public KisAsyncAnimationRendererBase
+{
+    Q_OBJECT
+public:
+    ProjectionFetchingRenderer();
+
+protected:
+    void frameCompletedCallback(int frame) override;
+    void frameCancelledCallback(int frame) override;
+
+Q_SIGNALS:
+    void sigFrameFetched(int frame);
+};
+
+class KisAnimationMultiFrameRenderingBenchmark : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testMultiFrameRendering();
+};
+
+#endif // KISANIMATIONMULTIFRAMERENDERINGBENCHMARK_H
@@ -47,6 +47,9 @@
 #include <KoColorSpaceTraits.h>
 #include <KoCompositeOpAlphaDarken.h>
 #include <KoCompositeOpOver.h>
+#include <KoCompositeOpGeneric.h>
+#include <KoCompositeOpFunctions.h>
+#include <KoCompositeOpRegistry.h>
 #include "KoOptimizedCompositeOpFactory.h"
 
 // for posix_memalign()
@@ -127,6 +130,27 @@ struct RandomGenerator<quint8>
     boost::mt11213b m_rnd;
 };
 
+template <>
+struct RandomGenerator<quint16>
+{
+    RandomGenerator(int seed)
+        : m_smallint(0,65535),
+          m_rnd(seed)
+    {
+    }
+
+    quint16 operator() () {
+        return m_smallint(m_rnd);
+    }
+
+    quint16 unit() {
+        return KoColorSpaceMathsTraits<quint16>::unitValue;
+    }
+
+    boost::uniform_smallint<int> m_smallint;
+    boost::mt11213b m_rnd;
+};
+
 template <>
 struct RandomGenerator<float>
 {
@@ -255,6 +279,8 @@ QVector<Tile> generateTiles(int size,
 
         if (pixelSize == 4) {
             generateDataLine<quint8>(1, numPixels, tiles[i].src, tiles[i].dst, tiles[i].mask, srcAlphaRange, dstAlphaRange);
+        } else if (pixelSize == 8) {
+            generateDataLine<quint16>(1, numPixels, tiles[i].src, tiles[i].dst, tiles[i].mask, srcAlphaRange, dstAlphaRange);
         } else if (pixelSize == 16) {
             generateDataLine<float>(1, numPixels, tiles[i].src, tiles[i].dst, tiles[i].mask, srcAlphaRange, dstAlphaRange);
         } else {
@@ -322,7 +348,7 @@ bool compareTwoOpsPixels(QVector<Tile> &tiles, channel_type prec) {
     return true;
 }
 
-bool compareTwoOps(bool haveMask, const KoCompositeOp *op1, const KoCompositeOp *op2)
+bool compareTwoOps(bool haveMask, const KoCompositeOp *op1, const KoCompositeOp *op2, float floatPrecision = 2e-7)
 {
     Q_ASSERT(op1->colorSpace()->pixelSize() == op2->colorSpace()->pixelSize());
     const quint32 pixelSize = op1->colorSpace()->pixelSize();
@@ -354,8 +380,11 @@ bool compareTwoOps(bool haveMask, const KoCompositeOp *op1, const KoCompositeOp
     if (pixelSize == 4) {
         compareResult = compareTwoOpsPixels<quint8>(tiles, 10);
     }
+    else if (pixelSize == 8) {
+        compareResult = compareTwoOpsPixels<quint16>(tiles, 10 * 257);
+    }
     else if (pixelSize == 16) {
-        compareResult = compareTwoOpsPixels<float>(tiles, 2e-7);
+        compareResult = compareTwoOpsPixels<float>(tiles, floatPrecision);
     }
     else {
         qFatal("Pixel size %i is not implemented", pixelSize);
@@ -710,6 +739,67 @@ void KisCompositionBenchmark::compareRgbF32OverOps()
     delete opAct;
 }
 
+template<class Traits, typename Traits::channels_type compositeFunc(typename Traits::channels_type, typename Traits::channels_type)>
+void compareSeparableOps(const KoColorSpace *cs, const QString &id)
+{
+    const QString description = KoCompositeOpRegistry::instance().getKoID(id).name();
+    KoCompositeOp *opAct = 0;
+
+    switch (cs->pixelSize()) {
+    case 4:
+        opAct = KoOptimizedCompositeOpFactory::createSeparableOp32(cs, id, description, KoCompositeOp::categoryMix());
+        break;
+    case 8:
+        opAct = KoOptimizedCompositeOpFactory::createSeparableOp64(cs, id, description, KoCompositeOp::categoryMix());
+        break;
+    case 16:
+        opAct = KoOptimizedCompositeOpFactory::createSeparableOp128(cs, id, description, KoCompositeOp::categoryMix());
+        break;
+    }
+
+    if (!opAct) {
+        QSKIP("There is no vectorized version of the op for this CPU");
+    }
+
+    KoCompositeOp *opExp = new KoCompositeOpGenericSC<Traits, compositeFunc>(cs, id, description, KoCompositeOp::categoryMix());
+
+    QVERIFY(compareTwoOps(true, opAct, opExp, 1e-5));
+    QVERIFY(compareTwoOps(false, opAct, opExp, 1e-5));
+
+    delete opExp;
+    delete opAct;
+}
+
+template<class Traits>
+void compareAllSeparableOps(const KoColorSpace *cs)
+{
+    typedef typename Traits::channels_type Arg;
+
+    compareSeparableOps<Traits, &cfMultiply<Arg> >(cs, COMPOSITE_MULT);
+    compareSeparableOps<Traits, &cfScreen<Arg> >(cs, COMPOSITE_SCREEN);
+    compareSeparableOps<Traits, &cfOverlay<Arg> >(cs, COMPOSITE_OVERLAY);
+    compareSeparableOps<Traits, &cfAddition<Arg> >(cs, COMPOSITE_ADD);
+    compareSeparableOps<Traits, &cfColorDodge<Arg> >(cs, COMPOSITE_DODGE);
+    compareSeparableOps<Traits, &cfColorBurn<Arg> >(cs, COMPOSITE_BURN);
+    compareSeparableOps<Traits, &cfDarkenOnly<Arg> >(cs, COMPOSITE_DARKEN);
+    compareSeparableOps<Traits, &cfLightenOnly<Arg> >(cs, COMPOSITE_LIGHTEN);
+}
+
+void KisCompositionBenchmark::compareRgb8SeparableOps()
+{
+    compareAllSeparableOps<KoBgrU8Traits>(KoColorSpaceRegistry::instance()->rgb8());
+}
+
+void KisCompositionBenchmark::compareRgb16SeparableOps()
+{
+    compareAllSeparableOps<KoBgrU16Traits>(KoColorSpaceRegistry::instance()->rgb16());
+}
+
+void KisCompositionBenchmark::compareRgbF32SeparableOps()
+{
+    compareAllSeparableOps<KoRgbF32Traits>(KoColorSpaceRegistry::instance()->colorSpace("RGBA", "F32", ""));
+}
+
 void KisCompositionBenchmark::testRgb8CompositeAlphaDarkenLegacy()
 {
     const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
@@ -774,6 +864,82 @@ void KisCompositionBenchmark::testRgbF32CompositeOverOptimized()
     delete op;
 }
 
+void KisCompositionBenchmark::testRgb8CompositeMultiplyLegacy()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KoCompositeOp *op = new KoCompositeOpGenericSC<KoBgrU8Traits, &cfMultiply<quint8> >(cs, COMPOSITE_MULT, "Multiply", KoCompositeOp::categoryArithmetic());
+    benchmarkCompositeOp(op, "Legacy");
+    delete op;
+}
+
+void KisCompositionBenchmark::testRgb8CompositeMultiplyOptimized()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KoCompositeOp *op = KoOptimizedCompositeOpFactory::createSeparableOp32(cs, COMPOSITE_MULT, "Multiply", KoCompositeOp::categoryArithmetic());
+    if (!op) {
+        QSKIP("There is no vectorized version of the op for this CPU");
+    }
+    benchmarkCompositeOp(op, "Optimized");
+    delete op;
+}
+
+void KisCompositionBenchmark::testRgb8CompositeOverlayLegacy()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KoCompositeOp *op = new KoCompositeOpGenericSC<KoBgrU8Traits, &cfOverlay<quint8> >(cs, COMPOSITE_OVERLAY, "Overlay", KoCompositeOp::categoryMix());
+    benchmarkCompositeOp(op, "Legacy");
+    delete op;
+}
+
+void KisCompositionBenchmark::testRgb8CompositeOverlayOptimized()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KoCompositeOp *op = KoOptimizedCompositeOpFactory::createSeparableOp32(cs, COMPOSITE_OVERLAY, "Overlay", KoCompositeOp::categoryMix());
+    if (!op) {
+        QSKIP("There is no vectorized version of the op for this CPU");
+    }
+    benchmarkCompositeOp(op, "Optimized");
+    delete op;
+}
+
+void KisCompositionBenchmark::testRgb16CompositeMultiplyLegacy()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb16();
+    KoCompositeOp *op = new KoCompositeOpGenericSC<KoBgrU16Traits, &cfMultiply<quint16> >(cs, COMPOSITE_MULT, "Multiply", KoCompositeOp::categoryArithmetic());
+    benchmarkCompositeOp(op, "RGB16 Legacy");
+    delete op;
+}
+
+void KisCompositionBenchmark::testRgb16CompositeMultiplyOptimized()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb16();
+    KoCompositeOp *op = KoOptimizedCompositeOpFactory::createSeparableOp64(cs, COMPOSITE_MULT, "Multiply", KoCompositeOp::categoryArithmetic());
+    if (!op) {
+        QSKIP("There is no vectorized version of the op for this CPU");
+    }
+    benchmarkCompositeOp(op, "RGB16 Optimized");
+    delete op;
+}
+
+void KisCompositionBenchmark::testRgbF32CompositeMultiplyLegacy()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->colorSpace("RGBA", "F32", "");
+    KoCompositeOp *op = new KoCompositeOpGenericSC<KoRgbF32Traits, &cfMultiply<float> >(cs, COMPOSITE_MULT, "Multiply", KoCompositeOp::categoryArithmetic());
+    benchmarkCompositeOp(op, "RGBF32 Legacy");
+    delete op;
+}
+
+void KisCompositionBenchmark::testRgbF32CompositeMultiplyOptimized()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->colorSpace("RGBA", "F32", "");
+    KoCompositeOp *op = KoOptimizedCompositeOpFactory::createSeparableOp128(cs, COMPOSITE_MULT, "Multiply", KoCompositeOp::categoryArithmetic());
+    if (!op) {
+        QSKIP("There is no vectorized version of the op for this CPU");
+    }
+    benchmarkCompositeOp(op, "RGBF32 Optimized");
+    delete op;
+}
+
 void KisCompositionBenchmark::testRgb8CompositeAlphaDarkenReal_Aligned()
 {
     const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
@@ -45,6 +45,9 @@ private Q_SLOTS:
     void compareOverOps();
     void compareOverOpsNoMask();
     void compareRgbF32OverOps();
+    void compareRgb8SeparableOps();
+    void compareRgb16SeparableOps();
+    void compareRgbF32SeparableOps();
 
     void testRgb8CompositeAlphaDarkenLegacy();
     void testRgb8CompositeAlphaDarkenOptimized();
@@ -58,6 +61,18 @@ private Q_SLOTS:
     void testRgbF32CompositeOverLegacy();
     void testRgbF32CompositeOverOptimized();
 
+    void testRgb8CompositeMultiplyLegacy();
+    void testRgb8CompositeMultiplyOptimized();
+
+    void testRgb8CompositeOverlayLegacy();
+    void testRgb8CompositeOverlayOptimized();
+
+    void testRgb16CompositeMultiplyLegacy();
+    void testRgb16CompositeMultiplyOptimized();
+
+    void testRgbF32CompositeMultiplyLegacy();
+    void testRgbF32CompositeMultiplyOptimized();
+
     void testRgb8CompositeAlphaDarkenReal_Aligned();
     void testRgb8CompositeOverReal_Aligned();
 
@@ -0,0 +1,147 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <QTest>
+#include <QtConcurrent>
+
+#include "kis_convolution_benchmark.h"
+#include "kis_benchmark_values.h"
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+
+#include <kis_paint_device.h>
+#include <kis_iterator_ng.h>
+#include <kis_convolution_painter.h>
+#include <kis_convolution_kernel.h>
+#include <kis_gaussian_kernel.h>
+
+#include "config_convolution.h"
+
+
+void KisConvolutionBenchmark::initTestCase()
+{
+    m_colorSpace = KoColorSpaceRegistry::instance()->rgb8();
+    m_device = new KisPaintDevice(m_colorSpace);
+    KoColor color(m_colorSpace);
+
+    srand(31524744);
+
+    int r,g,b;
+
+    KisSequentialIterator it(m_device, QRect(0,0,GMP_IMAGE_WIDTH, GMP_IMAGE_HEIGHT));
+    while (it.nextPixel()) {
+        r = rand() % 255;
+        g = rand() % 255;
+        b = rand() % 255;
+
+        color.fromQColor(QColor(r,g,b));
+        memcpy(it.rawData(), color.data(), m_colorSpace->pixelSize());
+    }
+}
+
+void KisConvolutionBenchmark::createRowsColumns()
+{
+    QTest::addColumn<int>("engine");
+    QTest::addColumn<qreal>("radius");
+
+    QList<qreal> radii;
+    radii << 5 << 20 << 50;
+
+    Q_FOREACH (qreal radius, radii) {
+        QTest::newRow(QString("spatial, %1").arg(radius).toLatin1().data())
+            << int(KisConvolutionPainter::SPATIAL) << radius;
+
+#ifdef HAVE_FFTW3
+        QTest::newRow(QString("fftw, %1").arg(radius).toLatin1().data())
+            << int(KisConvolutionPainter::FFTW) << radius;
+#endif
+    }
+}
+
+/**
+ * Convolution of the whole image with a square kernel
+ */
+void KisConvolutionBenchmark::benchmarkConvolution_data()
+{
+    createRowsColumns();
+}
+
+void KisConvolutionBenchmark::benchmarkConvolution()
+{
+    QFETCH(int, engine);
+    QFETCH(qreal, radius);
+
+    Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> matrix =
+        KisGaussianKernel::createVerticalMatrix(radius) *
+        KisGaussianKernel::createHorizontalMatrix(radius);
+
+    KisConvolutionKernelSP kernel = KisConvolutionKernel::fromMatrix(matrix, 0, matrix.sum());
+
+    const QRect rc(0, 0, GMP_IMAGE_WIDTH, GMP_IMAGE_HEIGHT);
+    KisPaintDeviceSP dst = new KisPaintDevice(m_colorSpace);
+
+    QBENCHMARK {
+        KisConvolutionPainter painter(dst, KisConvolutionPainter::EnginePreference(engine));
+        painter.applyMatrix(kernel, m_device, rc.topLeft(), rc.topLeft(), rc.size(), BORDER_REPEAT);
+    }
+}
+
+/**
+ * Several small convolutions running at once, like the filter masks
+ * updated in parallel during the projection update. The FFTW engine
+ * used to serialize them on the planner lock.
+ */
+void KisConvolutionBenchmark::benchmarkConcurrentConvolutions_data()
+{
+    createRowsColumns();
+}
+
+void KisConvolutionBenchmark::benchmarkConcurrentConvolutions()
+{
+    QFETCH(int, engine);
+    QFETCH(qreal, radius);
+
+    Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> matrix =
+        KisGaussianKernel::createVerticalMatrix(radius) *
+        KisGaussianKernel::createHorizontalMatrix(radius);
+
+    KisConvolutionKernelSP kernel = KisConvolutionKernel::fromMatrix(matrix, 0, matrix.sum());
+
+    QVector<QRect> patches;
+    for (int y = 0; y + 256 <= GMP_IMAGE_HEIGHT; y += 256) {
+        for (int x = 0; x + 256 <= GMP_IMAGE_WIDTH; x += 256) {
+            patches << QRect(x, y, 256, 256);
+        }
+    }
+
+    KisPaintDeviceSP src = m_device;
+    KisPaintDeviceSP dst = new KisPaintDevice(m_colorSpace);
+
+    auto convolvePatch = [src, dst, kernel, engine] (const QRect &rc) {
+        KisConvolutionPainter painter(dst, KisConvolutionPainter::EnginePreference(engine));
+        painter.applyMatrix(kernel, src, rc.topLeft(), rc.topLeft(), rc.size(), BORDER_REPEAT);
+    };
+
+    QBENCHMARK {
+        QtConcurrent::blockingMap(patches, convolvePatch);
+    }
+}
+
+QTEST_MAIN(KisConvolutionBenchmark)
@@ -20,7 +20,10 @@
 #include "kis_benchmark_values.h"
 
 #include <QTest>
+#include <QThreadPool>
 #include <kis_datamanager.h>
+#include <kis_paint_device_writer.h>
+#include "tiles3/swap/kis_tile_compressor_2.h"
 
 // RGBA
 #define PIXEL_SIZE 4
@@ -198,5 +201,161 @@ void KisDatamanagerBenchmark::benchmarkMemCpy()
     delete[] dst;
 }
 
+namespace {
+
+// 16k x 16k device, 256 x 256 tiles
+const int TILES_PER_SIDE = 256;
+const int LOOKUPS_PER_THREAD = 1000000;
+
+void createTiles(KisDataManager &dm)
+{
+    for (int row = 0; row < TILES_PER_SIDE; row++) {
+        for (int col = 0; col < TILES_PER_SIDE; col++) {
+            dm.getTile(col, row, true);
+        }
+    }
+}
+
+class GetTileRunner : public QRunnable
+{
+public:
+    GetTileRunner(KisDataManager *dm, quint32 seed)
+        : m_dm(dm),
+          m_seed(seed)
+    {
+    }
+
+    void run() override {
+        quint32 value = m_seed;
+
+        for (int i = 0; i < LOOKUPS_PER_THREAD; i++) {
+            // a simple LCG to avoid contention on a shared random generator
+            value = value * 1103515245U + 12345U;
+            const qint32 col = (value >> 16) % TILES_PER_SIDE;
+            value = value * 1103515245U + 12345U;
+            const qint32 row = (value >> 16) % TILES_PER_SIDE;
+
+            KisTileSP tile = m_dm->getTile(col, row, false);
+            Q_UNUSED(tile);
+        }
+    }
+
+private:
+    KisDataManager *m_dm;
+    quint32 m_seed;
+};
+
+void runGetTileBenchmark(int numThreads)
+{
+    quint8 *p = new quint8[PIXEL_SIZE];
+    memset(p, 0, PIXEL_SIZE);
+    KisDataManager dm(PIXEL_SIZE, p);
+    createTiles(dm);
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(numThreads);
+
+    QBENCHMARK {
+        for (int i = 0; i < numThreads; i++) {
+            pool.start(new GetTileRunner(&dm, i + 1));
+        }
+        pool.waitForDone();
+    }
+
+    delete[] p;
+}
+
+}
+
+void KisDatamanagerBenchmark::benchmarkGetTileSingleThreaded()
+{
+    runGetTileBenchmark(1);
+}
+
+void KisDatamanagerBenchmark::benchmarkGetTileMultithreaded()
+{
+    runGetTileBenchmark(qMax(2, QThread::idealThreadCount()));
+}
+
+namespace {
+
+// 4k x 4k device, 64 x 64 tiles
+const int WRITE_TILES_PER_SIDE = 64;
+
+class BufferPaintDeviceWriter : public KisPaintDeviceWriter
+{
+public:
+    bool write(const QByteArray &data) override {
+        m_data.append(data);
+        return true;
+    }
+
+    bool write(const char* data, qint64 length) override {
+        m_data.append(data, length);
+        return true;
+    }
+
+    QByteArray m_data;
+};
+
+QVector<KisTileSP> createNoisyTiles(KisDataManager &dm)
+{
+    const int size = WRITE_TILES_PER_SIDE * 64;
+    QByteArray data(size * size * PIXEL_SIZE, 0);
+    quint32 value = 1;
+
+    // half-compressible content: noise in the low bits only
+    for (int i = 0; i < data.size(); i++) {
+        value = value * 1103515245U + 12345U;
+        data[i] = char((i / PIXEL_SIZE / 64) & 0xf0) | char((value >> 16) & 0x0f);
+    }
+    dm.writeBytes(reinterpret_cast<const quint8*>(data.constData()), 0, 0, size, size);
+
+    QVector<KisTileSP> tiles;
+    for (int row = 0; row < WRITE_TILES_PER_SIDE; row++) {
+        for (int col = 0; col < WRITE_TILES_PER_SIDE; col++) {
+            tiles << dm.getTile(col, row, false);
+        }
+    }
+    return tiles;
+}
+
+}
+
+void KisDatamanagerBenchmark::benchmarkWriteTilesSerial()
+{
+    quint8 *p = new quint8[PIXEL_SIZE];
+    memset(p, 0, PIXEL_SIZE);
+    KisDataManager dm(PIXEL_SIZE, p);
+    QVector<KisTileSP> tiles = createNoisyTiles(dm);
+
+    KisTileCompressor2 compressor;
+
+    QBENCHMARK {
+        BufferPaintDeviceWriter writer;
+        Q_FOREACH (KisTileSP tile, tiles) {
+            compressor.writeTile(tile, writer);
+        }
+    }
+
+    delete[] p;
+}
+
+void KisDatamanagerBenchmark::benchmarkWriteTilesParallel()
+{
+    quint8 *p = new quint8[PIXEL_SIZE];
+    memset(p, 0, PIXEL_SIZE);
+    KisDataManager dm(PIXEL_SIZE, p);
+    QVector<KisTileSP> tiles = createNoisyTiles(dm);
+
+    KisTileCompressor2 compressor;
+
+    QBENCHMARK {
+        BufferPaintDeviceWriter writer;
+        compressor.writeTiles(tiles, writer);
+    }
+
+    delete[] p;
+}
 
 QTEST_MAIN(KisDatamanagerBenchmark)
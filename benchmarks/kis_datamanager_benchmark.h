@@ -36,6 +36,10 @@ private Q_SLOTS:
     void benchmarkExtent();
     void benchmarkClear();
     void benchmarkMemCpy();
+    void benchmarkGetTileSingleThreaded();
+    void benchmarkGetTileMultithreaded();
+    void benchmarkWriteTilesSerial();
+    void benchmarkWriteTilesParallel();
 };
 
 #endif
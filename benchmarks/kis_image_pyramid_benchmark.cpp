@@ -0,0 +1,149 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <QTest>
+
+#include "kis_image_pyramid_benchmark.h"
+#include "kis_benchmark_values.h"
+
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoColor.h>
+
+#include <kis_image.h>
+#include <kis_paint_device.h>
+#include <kis_iterator_ng.h>
+
+#include "canvas/kis_image_pyramid.h"
+#include "canvas/kis_update_info.h"
+
+#define PYRAMID_HEIGHT 4
+
+void KisImagePyramidBenchmark::initTestCase()
+{
+    /**
+     * The projection is 16-bit, so that the pyramid has to do
+     * a real color conversion into the monitor color space
+     */
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb16();
+    m_image = new KisImage(0, TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT, cs, "pyramid benchmark image");
+
+    KisPaintDeviceSP projection = m_image->projection();
+    KoColor color(cs);
+
+    KisSequentialIterator it(projection, m_image->bounds());
+    while (it.nextPixel()) {
+        const int x = it.x();
+        const int y = it.y();
+
+        color.fromQColor(QColor((x / 32 + y / 32) % 2 ? 220 : 40, x % 256, y % 256));
+        memcpy(it.rawData(), color.data(), cs->pixelSize());
+    }
+}
+
+static void addMultithreadingRows()
+{
+    QTest::addColumn<bool>("useMultithreading");
+
+    QTest::newRow("single-threaded") << false;
+    QTest::newRow("multithreaded") << true;
+}
+
+static void initPyramid(KisImagePyramid *pyramid, bool useMultithreading)
+{
+    pyramid->setUseMultithreading(useMultithreading);
+    pyramid->setMonitorProfile(KoColorSpaceRegistry::instance()->rgb8()->profile(),
+                               KoColorConversionTransformation::internalRenderingIntent(),
+                               KoColorConversionTransformation::internalConversionFlags());
+}
+
+void KisImagePyramidBenchmark::benchmarkSetImage_data()
+{
+    addMultithreadingRows();
+}
+
+void KisImagePyramidBenchmark::benchmarkSetImage()
+{
+    QFETCH(bool, useMultithreading);
+
+    KisImagePyramid pyramid(PYRAMID_HEIGHT);
+    initPyramid(&pyramid, useMultithreading);
+
+    QBENCHMARK {
+        pyramid.setImage(m_image);
+    }
+}
+
+void KisImagePyramidBenchmark::benchmarkRecalculateCache_data()
+{
+    addMultithreadingRows();
+}
+
+void KisImagePyramidBenchmark::benchmarkRecalculateCache()
+{
+    QFETCH(bool, useMultithreading);
+
+    KisImagePyramid pyramid(PYRAMID_HEIGHT);
+    initPyramid(&pyramid, useMultithreading);
+    pyramid.setImage(m_image);
+
+    /**
+     * Emulates the updates coming from a big brush stroke
+     */
+    QVector<QRect> dirtyRects;
+    for (int i = 0; i < 16; i++) {
+        dirtyRects << (QRect(i * 200, i * 150, 1024, 1024) & m_image->bounds());
+    }
+
+    QBENCHMARK {
+        Q_FOREACH (const QRect &rc, dirtyRects) {
+            pyramid.updateCache(rc);
+
+            KisPPUpdateInfoSP info = new KisPPUpdateInfo();
+            info->dirtyImageRectVar = rc;
+            pyramid.recalculateCache(info);
+        }
+    }
+}
+
+void KisImagePyramidBenchmark::benchmarkNearestPatch_data()
+{
+    addMultithreadingRows();
+}
+
+void KisImagePyramidBenchmark::benchmarkNearestPatch()
+{
+    QFETCH(bool, useMultithreading);
+
+    KisImagePyramid pyramid(PYRAMID_HEIGHT);
+    initPyramid(&pyramid, useMultithreading);
+    pyramid.setImage(m_image);
+
+    KisPPUpdateInfoSP info = new KisPPUpdateInfo();
+    info->imageRect = m_image->bounds();
+    info->scaleX = 0.5;
+    info->scaleY = 0.5;
+    info->borderWidth = 0;
+
+    QBENCHMARK {
+        KisImagePatch patch = pyramid.getNearestPatch(info);
+        Q_UNUSED(patch);
+    }
+}
+
+QTEST_MAIN(KisImagePyramidBenchmark)
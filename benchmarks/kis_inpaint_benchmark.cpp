@@ -0,0 +1,111 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <QTest>
+#include <cmath>
+
+#include "kis_inpaint_benchmark.h"
+
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoColor.h>
+
+#include <kis_paint_device.h>
+#include <kis_iterator_ng.h>
+
+#include "kis_inpaint.h"
+
+#define TEXTURE_SIZE 512
+#define HOLE_SIZE 64
+
+/**
+ * The random search of PatchMatch is driven by a fixed seed, so all
+ * the runs of the benchmark do exactly the same amount of work.
+ */
+static const quint32 SEED = 31524744;
+
+void KisInpaintBenchmark::initTestCase()
+{
+    m_colorSpace = KoColorSpaceRegistry::instance()->rgb8();
+    m_device = new KisPaintDevice(m_colorSpace);
+    KoColor color(m_colorSpace);
+
+    // a periodic texture, so that there is something to match
+    KisSequentialIterator it(m_device, QRect(0, 0, TEXTURE_SIZE, TEXTURE_SIZE));
+    while (it.nextPixel()) {
+        const int x = it.x();
+        const int y = it.y();
+
+        const int r = 128 + 127 * std::sin(x * 0.15);
+        const int g = 128 + 127 * std::sin(y * 0.11);
+        const int b = ((x / 16 + y / 16) % 2) ? 200 : 50;
+
+        color.fromQColor(QColor(r, g, b));
+        memcpy(it.rawData(), color.data(), m_colorSpace->pixelSize());
+    }
+
+    m_mask = new KisPaintDevice(KoColorSpaceRegistry::instance()->alpha8());
+    const QRect holeRect((TEXTURE_SIZE - HOLE_SIZE) / 2, (TEXTURE_SIZE - HOLE_SIZE) / 2, HOLE_SIZE, HOLE_SIZE);
+    m_mask->fill(holeRect, KoColor(Qt::white, m_mask->colorSpace()));
+}
+
+void KisInpaintBenchmark::cleanupTestCase()
+{
+}
+
+void KisInpaintBenchmark::testReproducibility()
+{
+    KisPaintDeviceSP dev1 = new KisPaintDevice(*m_device);
+    KisPaintDeviceSP dev2 = new KisPaintDevice(*m_device);
+
+    const QRect rc1 = patchImage(dev1, m_mask, 4, 50, SEED);
+    const QRect rc2 = patchImage(dev2, m_mask, 4, 50, SEED);
+
+    QCOMPARE(rc1, rc2);
+
+    QByteArray bytes1(rc1.width() * rc1.height() * m_colorSpace->pixelSize(), 0);
+    QByteArray bytes2(bytes1.size(), 0);
+
+    dev1->readBytes(reinterpret_cast<quint8*>(bytes1.data()), rc1);
+    dev2->readBytes(reinterpret_cast<quint8*>(bytes2.data()), rc2);
+
+    QVERIFY(bytes1 == bytes2);
+}
+
+void KisInpaintBenchmark::benchmarkPatchImage_data()
+{
+    QTest::addColumn<int>("radius");
+    QTest::addColumn<int>("accuracy");
+
+    QTest::newRow("radius 2, accuracy 50") << 2 << 50;
+    QTest::newRow("radius 4, accuracy 50") << 4 << 50;
+    QTest::newRow("radius 4, accuracy 100") << 4 << 100;
+}
+
+void KisInpaintBenchmark::benchmarkPatchImage()
+{
+    QFETCH(int, radius);
+    QFETCH(int, accuracy);
+
+    QBENCHMARK {
+        KisPaintDeviceSP dev = new KisPaintDevice(*m_device);
+        patchImage(dev, m_mask, radius, accuracy, SEED);
+    }
+}
+
+QTEST_MAIN(KisInpaintBenchmark)
@@ -0,0 +1,112 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <QTest>
+#include <cmath>
+
+#include "kis_liquify_benchmark.h"
+#include "kis_benchmark_values.h"
+
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoColor.h>
+
+#include <kis_paint_device.h>
+#include <kis_iterator_ng.h>
+#include <kis_liquify_transform_worker.h>
+
+#define NUM_DABS 100
+#define PIXEL_PRECISION 8
+
+/**
+ * A synthetic stroke: a wavy line of translation dabs crossing the
+ * whole image, like a user would do with the liquify brush
+ */
+static void applyDab(KisLiquifyTransformWorker *worker, int i)
+{
+    const QPointF pos(GMP_IMAGE_WIDTH * (0.1 + 0.8 * i / NUM_DABS),
+                      GMP_IMAGE_HEIGHT * (0.5 + 0.2 * std::sin(i * 0.1)));
+
+    worker->translatePoints(pos, QPointF(5, 2), 60, false, 0.2);
+}
+
+void KisLiquifyBenchmark::initTestCase()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    m_device = new KisPaintDevice(cs);
+    KoColor color(cs);
+
+    KisSequentialIterator it(m_device, QRect(0, 0, GMP_IMAGE_WIDTH, GMP_IMAGE_HEIGHT));
+    while (it.nextPixel()) {
+        const int x = it.x();
+        const int y = it.y();
+
+        color.fromQColor(QColor((x / 32 + y / 32) % 2 ? 220 : 40, x % 256, y % 256));
+        memcpy(it.rawData(), color.data(), cs->pixelSize());
+    }
+
+    m_thumbnail = m_device->convertToQImage(0, 0, 0, GMP_IMAGE_WIDTH, GMP_IMAGE_HEIGHT);
+}
+
+void KisLiquifyBenchmark::benchmarkStrokePreview()
+{
+    QBENCHMARK {
+        KisLiquifyTransformWorker worker(m_device->exactBounds(), 0, PIXEL_PRECISION);
+
+        for (int i = 0; i < NUM_DABS; i++) {
+            applyDab(&worker, i);
+
+            QPointF newOffset;
+            worker.runOnQImage(m_thumbnail, QPointF(), QTransform(), &newOffset);
+        }
+    }
+}
+
+void KisLiquifyBenchmark::benchmarkStrokePreviewFullUpdate()
+{
+    QBENCHMARK {
+        KisLiquifyTransformWorker worker(m_device->exactBounds(), 0, PIXEL_PRECISION);
+
+        for (int i = 0; i < NUM_DABS; i++) {
+            applyDab(&worker, i);
+
+            // a detached copy of the thumbnail has a new cache key,
+            // so every redraw is a full one
+            QImage thumbnail = m_thumbnail.copy();
+
+            QPointF newOffset;
+            worker.runOnQImage(thumbnail, QPointF(), QTransform(), &newOffset);
+        }
+    }
+}
+
+void KisLiquifyBenchmark::benchmarkRunOnDevice()
+{
+    KisLiquifyTransformWorker worker(m_device->exactBounds(), 0, PIXEL_PRECISION);
+
+    for (int i = 0; i < NUM_DABS; i++) {
+        applyDab(&worker, i);
+    }
+
+    QBENCHMARK {
+        KisPaintDeviceSP dev = new KisPaintDevice(*m_device);
+        worker.run(dev);
+    }
+}
+
+QTEST_MAIN(KisLiquifyBenchmark)
@@ -35,8 +35,8 @@
 
 #include "kis_mask_generator_benchmark.h"
 
-#include "kis_circle_mask_generator.h"
-#include "kis_rect_mask_generator.h"
+#include "kis_mask_generator.h"
+#include "kis_cubic_curve.h"
 
 void KisMaskGeneratorBenchmark::benchmarkCircle()
 {
@@ -108,4 +108,142 @@ void KisMaskGeneratorBenchmark::benchmarkSquare()
     }
 }
 
+enum MaskType {
+    DEFAULT, GAUSS, CURVE
+};
+
+KisMaskGenerator* createMaskGenerator(MaskType type, KisMaskGenerator::Type shape)
+{
+    const qreal diameter = 1000;
+    const qreal ratio = 1.0;
+    const qreal fade = 0.5;
+    const int spikes = 2;
+    const bool antialiasEdges = true;
+
+    /**
+     * A soft curve, similar to the ones used in the default
+     * "Soft" presets
+     */
+    KisCubicCurve curve;
+    curve.fromString("0,1;0.25,0.9;0.5,0.5;0.75,0.1;1,0;");
+
+    KisMaskGenerator *gen = 0;
+
+    switch (type) {
+    case DEFAULT:
+        gen = shape == KisMaskGenerator::CIRCLE ?
+            static_cast<KisMaskGenerator*>(new KisCircleMaskGenerator(diameter, ratio, fade, fade, spikes, antialiasEdges)) :
+            static_cast<KisMaskGenerator*>(new KisRectangleMaskGenerator(diameter, ratio, fade, fade, spikes, antialiasEdges));
+        break;
+    case GAUSS:
+        gen = shape == KisMaskGenerator::CIRCLE ?
+            static_cast<KisMaskGenerator*>(new KisGaussCircleMaskGenerator(diameter, ratio, fade, fade, spikes, antialiasEdges)) :
+            static_cast<KisMaskGenerator*>(new KisGaussRectangleMaskGenerator(diameter, ratio, fade, fade, spikes, antialiasEdges));
+        break;
+    case CURVE:
+        gen = shape == KisMaskGenerator::CIRCLE ?
+            static_cast<KisMaskGenerator*>(new KisCurveCircleMaskGenerator(diameter, ratio, fade, fade, spikes, curve, antialiasEdges)) :
+            static_cast<KisMaskGenerator*>(new KisCurveRectangleMaskGenerator(diameter, ratio, fade, fade, spikes, curve, antialiasEdges));
+        break;
+    }
+
+    gen->setScale(1.0, 1.0);
+    return gen;
+}
+
+void benchmarkApplicator(MaskType type, KisMaskGenerator::Type shape, bool useVectorApplicator)
+{
+    const KoColorSpace * cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisFixedPaintDeviceSP dev = new KisFixedPaintDevice(cs);
+    dev->setRect(QRect(0, 0, 1000, 1000));
+    dev->initialize();
+
+    MaskProcessingData data(dev, cs,
+                            0.0, 1.0,
+                            500, 500, 0);
+
+    QScopedPointer<KisMaskGenerator> gen(createMaskGenerator(type, shape));
+
+    /**
+     * KisMaskGenerator::applicator() is the generic scalar applicator
+     * calling valueAt() for every pixel
+     */
+    KisBrushMaskApplicatorBase *applicator =
+        useVectorApplicator ? gen->applicator() : gen->KisMaskGenerator::applicator();
+
+    applicator->initializeData(&data);
+
+    // the applicators work with full-width strips, like KisAutoBrush does
+    QVector<QRect> rects;
+    for (int y = 0; y < 1000; y += 100) {
+        rects << QRect(0, y, 1000, 100);
+    }
+
+    QBENCHMARK{
+        Q_FOREACH (const QRect &rc, rects) {
+            applicator->process(rc);
+        }
+    }
+}
+
+void KisMaskGeneratorBenchmark::benchmarkDefaultCircle_Scalar()
+{
+    benchmarkApplicator(DEFAULT, KisMaskGenerator::CIRCLE, false);
+}
+
+void KisMaskGeneratorBenchmark::benchmarkDefaultCircle_Vector()
+{
+    benchmarkApplicator(DEFAULT, KisMaskGenerator::CIRCLE, true);
+}
+
+void KisMaskGeneratorBenchmark::benchmarkDefaultRect_Scalar()
+{
+    benchmarkApplicator(DEFAULT, KisMaskGenerator::RECTANGLE, false);
+}
+
+void KisMaskGeneratorBenchmark::benchmarkDefaultRect_Vector()
+{
+    benchmarkApplicator(DEFAULT, KisMaskGenerator::RECTANGLE, true);
+}
+
+void KisMaskGeneratorBenchmark::benchmarkGaussCircle_Scalar()
+{
+    benchmarkApplicator(GAUSS, KisMaskGenerator::CIRCLE, false);
+}
+
+void KisMaskGeneratorBenchmark::benchmarkGaussCircle_Vector()
+{
+    benchmarkApplicator(GAUSS, KisMaskGenerator::CIRCLE, true);
+}
+
+void KisMaskGeneratorBenchmark::benchmarkGaussRect_Scalar()
+{
+    benchmarkApplicator(GAUSS, KisMaskGenerator::RECTANGLE, false);
+}
+
+void KisMaskGeneratorBenchmark::benchmarkGaussRect_Vector()
+{
+    benchmarkApplicator(GAUSS, KisMaskGenerator::RECTANGLE, true);
+}
+
+void KisMaskGeneratorBenchmark::benchmarkCurveCircle_Scalar()
+{
+    benchmarkApplicator(CURVE, KisMaskGenerator::CIRCLE, false);
+}
+
+void KisMaskGeneratorBenchmark::benchmarkCurveCircle_Vector()
+{
+    benchmarkApplicator(CURVE, KisMaskGenerator::CIRCLE, true);
+}
+
+void KisMaskGeneratorBenchmark::benchmarkCurveRect_Scalar()
+{
+    benchmarkApplicator(CURVE, KisMaskGenerator::RECTANGLE, false);
+}
+
+void KisMaskGeneratorBenchmark::benchmarkCurveRect_Vector()
+{
+    benchmarkApplicator(CURVE, KisMaskGenerator::RECTANGLE, true);
+}
+
 QTEST_MAIN(KisMaskGeneratorBenchmark)
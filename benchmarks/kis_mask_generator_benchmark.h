@@ -30,6 +30,19 @@ private Q_SLOTS:
     void benchmarkSIMD_FadedBrush();
     void benchmarkSquare();
 
+    void benchmarkDefaultCircle_Scalar();
+    void benchmarkDefaultCircle_Vector();
+    void benchmarkDefaultRect_Scalar();
+    void benchmarkDefaultRect_Vector();
+    void benchmarkGaussCircle_Scalar();
+    void benchmarkGaussCircle_Vector();
+    void benchmarkGaussRect_Scalar();
+    void benchmarkGaussRect_Vector();
+    void benchmarkCurveCircle_Scalar();
+    void benchmarkCurveCircle_Vector();
+    void benchmarkCurveRect_Scalar();
+    void benchmarkCurveRect_Vector();
+
 };
 
 #endif
@@ -0,0 +1,140 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include <QTest>
+#include <QtConcurrent>
+
+#include "kis_oilpaint_benchmark.h"
+#include "kis_benchmark_values.h"
+
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoColor.h>
+
+#include "filter/kis_filter_registry.h"
+#include "filter/kis_filter_configuration.h"
+#include "filter/kis_filter.h"
+
+#include <kis_paint_device.h>
+#include <kis_iterator_ng.h>
+#include <kis_transaction.h>
+#include <krita_utils.h>
+
+#include "testutil.h"
+
+void KisOilPaintBenchmark::initTestCase()
+{
+    m_colorSpace = KoColorSpaceRegistry::instance()->rgb8();
+    m_device = new KisPaintDevice(m_colorSpace);
+    KoColor color(m_colorSpace);
+
+    srand(31524744);
+
+    int r,g,b;
+
+    KisSequentialIterator it(m_device, QRect(0,0,GMP_IMAGE_WIDTH, GMP_IMAGE_HEIGHT));
+    while (it.nextPixel()) {
+        r = rand() % 255;
+        g = rand() % 255;
+        b = rand() % 255;
+
+        color.fromQColor(QColor(r,g,b));
+        memcpy(it.rawData(), color.data(), m_colorSpace->pixelSize());
+    }
+}
+
+void KisOilPaintBenchmark::cleanupTestCase()
+{
+}
+
+void KisOilPaintBenchmark::benchmarkFilter_data()
+{
+    QTest::addColumn<int>("brushSize");
+
+    QTest::newRow("1") << 1;
+    QTest::newRow("5") << 5;
+    QTest::newRow("20") << 20;
+}
+
+void KisOilPaintBenchmark::benchmarkFilter()
+{
+    QFETCH(int, brushSize);
+
+    KisFilterSP filter = KisFilterRegistry::instance()->value("oilpaint");
+    QVERIFY(filter);
+
+    KisFilterConfigurationSP kfc = filter->defaultConfiguration();
+    kfc->setProperty("brushSize", brushSize);
+    kfc->setProperty("smooth", 30);
+
+    QBENCHMARK{
+        filter->process(m_device, QRect(0, 0, GMP_IMAGE_WIDTH,GMP_IMAGE_HEIGHT), kfc);
+    }
+}
+
+void KisOilPaintBenchmark::benchmarkFilterPatches_data()
+{
+    benchmarkFilter_data();
+}
+
+void KisOilPaintBenchmark::benchmarkFilterPatches()
+{
+    QFETCH(int, brushSize);
+
+    KisFilterSP filter = KisFilterRegistry::instance()->value("oilpaint");
+    QVERIFY(filter);
+    QVERIFY(filter->supportsThreading());
+
+    KisFilterConfigurationSP kfc = filter->defaultConfiguration();
+    kfc->setProperty("brushSize", brushSize);
+    kfc->setProperty("smooth", 30);
+
+    /**
+     * Split the image the same way the filter stroke does
+     */
+    QVector<QRect> patches =
+        KritaUtils::splitRectIntoPatches(QRect(0, 0, GMP_IMAGE_WIDTH,GMP_IMAGE_HEIGHT),
+                                         KritaUtils::optimalPatchSize());
+
+    const QRect applyRect(0, 0, GMP_IMAGE_WIDTH,GMP_IMAGE_HEIGHT);
+
+    KisPaintDeviceSP reference = new KisPaintDevice(*m_device);
+    filter->process(reference, applyRect, kfc);
+
+    KisPaintDeviceSP device;
+    auto processPatch = [filter, kfc, &device] (const QRect &rc) {
+        filter->processImpl(device, rc, kfc, 0);
+    };
+
+    QBENCHMARK{
+        device = new KisPaintDevice(*m_device);
+
+        /**
+         * The patches are processed in-place, so, just like in the filter
+         * stroke, the transaction keeps the original pixels for oldRawData()
+         */
+        KisTransaction transaction(device);
+        QtConcurrent::blockingMap(patches, processPatch);
+        delete transaction.endAndTake();
+    }
+
+    QPoint pt;
+    QVERIFY(TestUtil::comparePaintDevices(pt, device, reference));
+}
+
+QTEST_MAIN(KisOilPaintBenchmark)
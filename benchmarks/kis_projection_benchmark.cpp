@@ -22,11 +22,17 @@
 
 #include <KoColor.h>
 
+#include <KoColorSpaceRegistry.h>
+
 #include <kis_group_layer.h>
+#include <kis_paint_layer.h>
 #include <kis_paint_device.h>
 #include <KisDocument.h>
 #include <kis_image.h>
 #include <KisPart.h>
+#include <kis_merge_walker.h>
+#include <kis_async_merger.h>
+#include <krita_utils.h>
 
 void KisProjectionBenchmark::initTestCase()
 {
@@ -59,4 +65,69 @@ void KisProjectionBenchmark::benchmarkLoading()
 }
 
 
+void KisProjectionBenchmark::benchmarkOcclusionCulling_data()
+{
+    QTest::addColumn<bool>("useOcclusionCulling");
+
+    QTest::newRow("no-culling") << false;
+    QTest::newRow("culling") << true;
+}
+
+/**
+ * A typical painting: a pile of layers under an opaque underpainting
+ * and a few semi-transparent texture layers on top of it
+ */
+void KisProjectionBenchmark::benchmarkOcclusionCulling()
+{
+    QFETCH(bool, useOcclusionCulling);
+
+    const int numLayersBelow = 20;
+    const int numLayersAbove = 3;
+
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, TEST_IMAGE_WIDTH, TEST_IMAGE_HEIGHT, cs, "occlusion benchmark");
+    const QRect bounds = image->bounds();
+
+    const QVector<QRect> patches = KritaUtils::splitRectIntoPatches(bounds, QSize(512, 512));
+
+    for (int i = 0; i < numLayersBelow; i++) {
+        KisPaintDeviceSP dev = new KisPaintDevice(cs);
+
+        int index = 0;
+        Q_FOREACH (const QRect &rc, patches) {
+            const QColor color((37 * index + 11 * i) % 256, (53 * i) % 256, (17 * index) % 256, 128 + i);
+            dev->fill(rc, KoColor(color, cs));
+            index++;
+        }
+
+        image->addNode(new KisPaintLayer(image, QString("below %1").arg(i), OPACITY_OPAQUE_U8, dev), image->root());
+    }
+
+    KisPaintDeviceSP underpainting = new KisPaintDevice(cs);
+    underpainting->fill(bounds, KoColor(Qt::white, cs));
+    KisLayerSP underpaintingLayer = new KisPaintLayer(image, "underpainting", OPACITY_OPAQUE_U8, underpainting);
+    image->addNode(underpaintingLayer, image->root());
+
+    KisLayerSP topLayer;
+
+    for (int i = 0; i < numLayersAbove; i++) {
+        KisPaintDeviceSP dev = new KisPaintDevice(cs);
+        dev->fill(bounds, KoColor(QColor(100, 80 * i, 40, 64), cs));
+
+        topLayer = new KisPaintLayer(image, QString("above %1").arg(i), OPACITY_OPAQUE_U8, dev);
+        image->addNode(topLayer, image->root());
+    }
+
+    KisMergeWalker walker(bounds);
+    KisAsyncMerger merger;
+    merger.setUseOcclusionCulling(useOcclusionCulling);
+
+    QBENCHMARK {
+        Q_FOREACH (const QRect &rc, patches) {
+            walker.collectRects(topLayer, rc);
+            merger.startMerge(walker);
+        }
+    }
+}
+
 QTEST_MAIN(KisProjectionBenchmark)
@@ -0,0 +1,184 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_tile_compression_benchmark.h"
+
+#include <QTest>
+#include <QImage>
+
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+#include <KoColorModelStandardIds.h>
+
+#include <kis_paint_device.h>
+#include "tiles3/swap/kis_abstract_compression.h"
+#include "tiles3/swap/kis_compression_factory.h"
+
+namespace {
+
+const int TILE_SIZE = 64;
+
+const KoColorSpace* colorSpaceForDepth(const QString &depthId)
+{
+    return KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), depthId, 0);
+}
+
+/**
+ * Splits a real photo into tiles of the requested color depth,
+ * the same way the data manager stores them
+ */
+QVector<QByteArray> loadTiles(const KoColorSpace *cs)
+{
+    QImage image(QString(FILES_DEFAULT_DATA_DIR) + QDir::separator() + "hakonepa.png");
+
+    KisPaintDeviceSP dev = new KisPaintDevice(KoColorSpaceRegistry::instance()->rgb8());
+    dev->convertFromQImage(image, 0);
+
+    if (*cs != *dev->colorSpace()) {
+        delete dev->convertTo(cs);
+    }
+
+    const QRect rc = dev->exactBounds();
+    const int tileDataSize = TILE_SIZE * TILE_SIZE * cs->pixelSize();
+
+    QVector<QByteArray> tiles;
+
+    for (int y = rc.top(); y <= rc.bottom() - TILE_SIZE + 1; y += TILE_SIZE) {
+        for (int x = rc.left(); x <= rc.right() - TILE_SIZE + 1; x += TILE_SIZE) {
+            QByteArray tile(tileDataSize, 0);
+            dev->readBytes((quint8*)tile.data(), x, y, TILE_SIZE, TILE_SIZE);
+            tiles << tile;
+        }
+    }
+
+    return tiles;
+}
+
+void addRows()
+{
+    QTest::addColumn<QString>("codec");
+    QTest::addColumn<QString>("depth");
+
+    Q_FOREACH (const QString &codec, KisCompressionFactory::availableCompressions()) {
+        QTest::newRow(QString("%1-8bit").arg(codec).toLatin1()) << codec << Integer8BitsColorDepthID.id();
+        QTest::newRow(QString("%1-16bit").arg(codec).toLatin1()) << codec << Integer16BitsColorDepthID.id();
+        QTest::newRow(QString("%1-32bit-float").arg(codec).toLatin1()) << codec << Float32BitsColorDepthID.id();
+    }
+}
+
+struct CompressedTiles
+{
+    QVector<QByteArray> data;
+    qint64 rawSize = 0;
+    qint64 compressedSize = 0;
+};
+
+/**
+ * Compresses the tiles the same way KisTileCompressor2 does:
+ * linearizes the channels first and then runs the codec
+ */
+CompressedTiles compressTiles(KisAbstractCompression *compression,
+                              const QVector<QByteArray> &tiles,
+                              qint32 pixelSize)
+{
+    CompressedTiles result;
+
+    Q_FOREACH (const QByteArray &tile, tiles) {
+        QByteArray linearized(tile.size(), 0);
+        QByteArray compressed(compression->outputBufferSize(tile.size()), 0);
+
+        KisAbstractCompression::linearizeColors((quint8*)tile.data(), (quint8*)linearized.data(),
+                                                tile.size(), pixelSize);
+
+        const qint32 bytes = compression->compress((quint8*)linearized.data(), linearized.size(),
+                                                   (quint8*)compressed.data(), compressed.size());
+        compressed.resize(bytes);
+
+        result.data << compressed;
+        result.rawSize += tile.size();
+        result.compressedSize += bytes;
+    }
+
+    return result;
+}
+
+}
+
+void KisTileCompressionBenchmark::benchmarkCompression_data()
+{
+    addRows();
+}
+
+void KisTileCompressionBenchmark::benchmarkCompression()
+{
+    QFETCH(QString, codec);
+    QFETCH(QString, depth);
+
+    const KoColorSpace *cs = colorSpaceForDepth(depth);
+    const QVector<QByteArray> tiles = loadTiles(cs);
+
+    QScopedPointer<KisAbstractCompression> compression(KisCompressionFactory::create(codec));
+
+    CompressedTiles result;
+
+    QBENCHMARK {
+        result = compressTiles(compression.data(), tiles, cs->pixelSize());
+    }
+
+    qDebug() << codec << depth << "ratio:"
+             << qreal(result.compressedSize) / result.rawSize
+             << "(" << result.compressedSize << "/" << result.rawSize << "bytes )";
+}
+
+void KisTileCompressionBenchmark::benchmarkDecompression_data()
+{
+    addRows();
+}
+
+void KisTileCompressionBenchmark::benchmarkDecompression()
+{
+    QFETCH(QString, codec);
+    QFETCH(QString, depth);
+
+    const KoColorSpace *cs = colorSpaceForDepth(depth);
+    const QVector<QByteArray> tiles = loadTiles(cs);
+
+    QScopedPointer<KisAbstractCompression> compression(KisCompressionFactory::create(codec));
+    CompressedTiles compressed = compressTiles(compression.data(), tiles, cs->pixelSize());
+
+    const int tileDataSize = TILE_SIZE * TILE_SIZE * cs->pixelSize();
+    QByteArray linearized(tileDataSize, 0);
+    QByteArray result(tileDataSize, 0);
+
+    QBENCHMARK {
+        for (int i = 0; i < compressed.data.size(); i++) {
+            const QByteArray &data = compressed.data[i];
+
+            compression->decompress((quint8*)data.data(), data.size(),
+                                    (quint8*)linearized.data(), linearized.size());
+            KisAbstractCompression::delinearizeColors((quint8*)linearized.data(),
+                                                      (quint8*)result.data(),
+                                                      tileDataSize, cs->pixelSize());
+        }
+    }
+
+    // verify the last tile
+    QVERIFY(result == tiles.last());
+}
+
+QTEST_MAIN(KisTileCompressionBenchmark)
@@ -0,0 +1,4 @@
+/* config-lz4.h.  Generated by cmake from config-lz4.h.cmake */
+
+/* Define if you have LZ4, the fast compression library */
+#cmakedefine HAVE_LZ4 1
@@ -145,6 +145,39 @@ void KoShapeManager::Private::unlinkFromShapesRecursively(const QList<KoShape*>
     }
 }
 
+QList<KoShape*> KoShapeManager::Private::filterAndSortShapesForPainting(const QList<KoShape*> &unsortedShapes) const
+{
+    // filter all hidden shapes from the list
+    // also filter shapes with a parent which has filter effects applied
+    QList<KoShape*> sortedShapes;
+    foreach (KoShape *shape, unsortedShapes) {
+        if (!shape->isVisible())
+            continue;
+        bool addShapeToList = true;
+        // check if one of the shapes ancestors have filter effects
+        KoShapeContainer *parent = shape->parent();
+        while (parent) {
+            // parent must be part of the shape manager to be taken into account
+            if (!shapes.contains(parent))
+                break;
+            if (parent->filterEffectStack() && !parent->filterEffectStack()->isEmpty()) {
+                addShapeToList = false;
+                break;
+            }
+            parent = parent->parent();
+        }
+        if (addShapeToList) {
+            sortedShapes.append(shape);
+        } else if (parent) {
+            sortedShapes.append(parent);
+        }
+    }
+
+    std::sort(sortedShapes.begin(), sortedShapes.end(), KoShape::compareShapeZIndex);
+
+    return sortedShapes;
+}
+
 KoShapeManager::~KoShapeManager()
 {
     d->unlinkFromShapesRecursively(d->shapes);
@@ -263,33 +296,7 @@ void KoShapeManager::paint(QPainter &painter, const KoViewConverter &converter,
         warnFlake << "KoShapeManager::paint  Painting with a painter that has no clipping will lead to too much being painted!";
     }
 
-    // filter all hidden shapes from the list
-    // also filter shapes with a parent which has filter effects applied
-    QList<KoShape*> sortedShapes;
-    foreach (KoShape *shape, unsortedShapes) {
-        if (!shape->isVisible())
-            continue;
-        bool addShapeToList = true;
-        // check if one of the shapes ancestors have filter effects
-        KoShapeContainer *parent = shape->parent();
-        while (parent) {
-            // parent must be part of the shape manager to be taken into account
-            if (!d->shapes.contains(parent))
-                break;
-            if (parent->filterEffectStack() && !parent->filterEffectStack()->isEmpty()) {
-                addShapeToList = false;
-                break;
-            }
-            parent = parent->parent();
-        }
-        if (addShapeToList) {
-            sortedShapes.append(shape);
-        } else if (parent) {
-            sortedShapes.append(parent);
-        }
-    }
-
-    std::sort(sortedShapes.begin(), sortedShapes.end(), KoShape::compareShapeZIndex);
+    QList<KoShape*> sortedShapes = d->filterAndSortShapesForPainting(unsortedShapes);
 
     KoShapePaintingContext paintContext(d->canvas, forPrint); //FIXME
 
@@ -314,6 +321,27 @@ void KoShapeManager::paint(QPainter &painter, const KoViewConverter &converter,
     }
 }
 
+void KoShapeManager::preparePaintJobs(QVector<PaintJob> &jobs)
+{
+    d->updateTree();
+
+    for (auto it = jobs.begin(); it != jobs.end(); ++it) {
+        it->shapes = d->filterAndSortShapesForPainting(d->tree.intersects(it->docUpdateRect));
+    }
+}
+
+void KoShapeManager::paintJob(QPainter &painter, const KoViewConverter &converter, const PaintJob &job) const
+{
+    painter.setPen(Qt::NoPen);  // painters by default have a black stroke, lets turn that off.
+    painter.setBrush(Qt::NoBrush);
+
+    KoShapePaintingContext paintContext(d->canvas, false);
+
+    Q_FOREACH (KoShape *shape, job.shapes) {
+        renderSingleShape(shape, painter, converter, paintContext);
+    }
+}
+
 void KoShapeManager::renderSingleShape(KoShape *shape, QPainter &painter, const KoViewConverter &converter, KoShapePaintingContext &paintContext)
 {
     KisQPainterStateSaver saver(&painter);
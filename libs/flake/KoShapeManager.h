@@ -25,6 +25,9 @@
 #include <QList>
 #include <QObject>
 #include <QSet>
+#include <QRect>
+#include <QRectF>
+#include <QVector>
 
 #include "KoFlake.h"
 #include "kritaflake_export.h"
@@ -118,6 +121,47 @@ public:
      */
     void paint(QPainter &painter, const KoViewConverter &converter, bool forPrint);
 
+    /**
+     * A part of the canvas that can be painted independently of
+     * the other parts, e.g. in a separate thread
+     */
+    struct PaintJob {
+        PaintJob() {}
+        PaintJob(const QRectF &_docUpdateRect, const QRect &_viewUpdateRect)
+            : docUpdateRect(_docUpdateRect), viewUpdateRect(_viewUpdateRect)
+        {
+        }
+
+        QRectF docUpdateRect;
+        QRect viewUpdateRect;
+        QList<KoShape*> shapes;
+    };
+
+    /**
+     * Fills the list of shapes for every job in \p jobs. The shapes are
+     * looked up in the shapes tree by the job's docUpdateRect and are
+     * sorted in the painting order.
+     *
+     * This method updates the shapes tree, so it should be called from
+     * a single thread. paintJob() can then be called concurrently for
+     * jobs that don't share any shapes. The shapes keep lazily updated
+     * caches (e.g. the layout of a text shape), so a single shape must
+     * never be painted from two threads at the same time.
+     */
+    void preparePaintJobs(QVector<PaintJob> &jobs);
+
+    /**
+     * Paints the shapes of \p job. The shapes are painted with
+     * the same procedure as in paint(), but no decorations are
+     * rendered.
+     *
+     * @param painter the painter to paint to. It should be already
+     *        clipped to the job's viewUpdateRect.
+     * @param converter to convert between document and view coordinates.
+     * @param job the job prepared by preparePaintJobs()
+     */
+    void paintJob(QPainter &painter, const KoViewConverter &converter, const PaintJob &job) const;
+
     /**
      * Returns the shape located at a specific point in the document.
      * If more than one shape is located at the specific point, the given selection type
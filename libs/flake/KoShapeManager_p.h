@@ -71,6 +71,13 @@ public:
      */
     void unlinkFromShapesRecursively(const QList<KoShape *> &shapes);
 
+    /**
+     * Filters out hidden shapes and the shapes whose ancestors have
+     * filter effects applied (the ancestor is painted instead) and
+     * sorts the result in the painting order.
+     */
+    QList<KoShape*> filterAndSortShapesForPainting(const QList<KoShape*> &unsortedShapes) const;
+
     /**
      * Recursively paints the given group shape to the specified painter
      * This is needed for filter effects on group shapes where the filter effect
@@ -320,5 +320,48 @@ void TestShapePainting::testGroupUngroup()
     }
 }
 
+void TestShapePainting::testPaintJobs()
+{
+    MockShape *shape1 = new MockShape();
+    MockShape *shape2 = new MockShape();
+    QScopedPointer<MockContainer> container(new MockContainer());
+
+    shape1->setPosition(QPointF(0, 0));
+    shape1->setSize(QSizeF(10, 10));
+    shape1->setZIndex(2);
+    shape2->setPosition(QPointF(80, 80));
+    shape2->setSize(QSizeF(10, 10));
+    shape2->setZIndex(1);
+
+    container->addShape(shape1);
+    container->addShape(shape2);
+    container->setSize(QSizeF(100, 100));
+
+    MockCanvas canvas;
+    KoShapeManager manager(&canvas);
+    manager.addShape(container.data());
+
+    QVector<KoShapeManager::PaintJob> jobs;
+    jobs << KoShapeManager::PaintJob(QRectF(0, 0, 20, 20), QRect(0, 0, 20, 20));
+    jobs << KoShapeManager::PaintJob(QRectF(40, 40, 20, 20), QRect(40, 40, 20, 20));
+    jobs << KoShapeManager::PaintJob(QRectF(0, 0, 100, 100), QRect(0, 0, 100, 100));
+
+    manager.preparePaintJobs(jobs);
+
+    QCOMPARE(jobs[0].shapes, QList<KoShape*>() << container.data() << shape1);
+    QCOMPARE(jobs[1].shapes, QList<KoShape*>() << container.data());
+    QCOMPARE(jobs[2].shapes, QList<KoShape*>() << container.data() << shape2 << shape1);
+
+    QImage image(100, 100,  QImage::Format_Mono);
+    QPainter painter(&image);
+    KoViewConverter vc;
+
+    manager.paintJob(painter, vc, jobs[0]);
+
+    QCOMPARE(container->paintedCount, 1);
+    QCOMPARE(shape1->paintedCount, 1);
+    QCOMPARE(shape2->paintedCount, 0);
+}
+
 
 QTEST_MAIN(TestShapePainting)
@@ -0,0 +1,66 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef VCEXTRAMATH_H
+#define VCEXTRAMATH_H
+
+#include <config-vc.h>
+
+#if defined HAVE_VC
+
+#include <Vc/Vc>
+#include <Vc/IO>
+
+class VcExtraMath
+{
+public:
+    /**
+     * Vectorized version of erf() based on the Abramowitz and Stegun
+     * formula 7.1.26. The maximum absolute error is 1.5e-7, which is
+     * much less than the precision of an 8-bit mask.
+     */
+    static inline Vc::float_v erf(const Vc::float_v &x) {
+        const Vc::float_v a1( 0.254829592f);
+        const Vc::float_v a2(-0.284496736f);
+        const Vc::float_v a3( 1.421413741f);
+        const Vc::float_v a4(-1.453152027f);
+        const Vc::float_v a5( 1.061405429f);
+        const Vc::float_v p ( 0.3275911f);
+        const Vc::float_v vOne(Vc::One);
+
+        Vc::float_v xa = Vc::abs(x);
+
+        // the approximation is stable up to this value,
+        // after that erf() is equal to 1.0 in float precision
+        Vc::float_m precisionLimit = xa >= Vc::float_v(9.3f);
+        xa.setZero(precisionLimit);
+
+        Vc::float_v sign(vOne);
+        sign(x < Vc::float_v(Vc::Zero)) = -vOne;
+
+        Vc::float_v t = vOne / (vOne + p * xa);
+        Vc::float_v y = vOne - (((((a5 * t + a4) * t) + a3) * t + a2) * t + a1) * t * Vc::exp(-xa * xa);
+        y(precisionLimit) = vOne;
+
+        return sign * y;
+    }
+};
+
+#endif /* defined HAVE_VC */
+
+#endif // VCEXTRAMATH_H
@@ -27,6 +27,12 @@ KisAbstractProjectionPlane::~KisAbstractProjectionPlane()
 {
 }
 
+bool KisAbstractProjectionPlane::isOpaque(const QRect &rect) const
+{
+    Q_UNUSED(rect);
+    return false;
+}
+
 QRect KisDumbProjectionPlane::recalculate(const QRect& rect, KisNodeSP filthyNode)
 {
     Q_UNUSED(filthyNode);
@@ -83,6 +83,15 @@ public:
      * Returns a list of devices which should synchronize the lod cache on update
      */
     virtual KisPaintDeviceList getLodCapableDevices() const = 0;
+
+    /**
+     * Returns true if apply() is guaranteed to overwrite every pixel
+     * of \p rect with an opaque one, independently of what lies below.
+     * The merger uses it to skip the layers occluded by the plane.
+     *
+     * The default implementation returns false.
+     */
+    virtual bool isOpaque(const QRect &rect) const;
 };
 
 /**
@@ -21,6 +21,8 @@
 
 #include "kis_global.h"
 
+#include <compositeops/KoVcMultiArchBuildSupport.h>
+
 template <class BaseFade>
 class KisAntialiasingFadeMaker1D
 {
@@ -83,6 +85,34 @@ public:
         return false;
     }
 
+#if defined HAVE_VC
+    /**
+     * Vectorized version of needFade(). The returned mask marks the
+     * pixels whose value has been written into \p value. The value is
+     * normalized into [0.0, 1.0] range, as used by the vector applicator.
+     */
+    Vc::float_m needFade(const Vc::float_v &dist, Vc::float_v *value) const {
+        const Vc::float_v vOne(Vc::One);
+
+        Vc::float_m outsideMask = dist > Vc::float_v(float(m_radius));
+        *value = vOne;
+
+        if (!m_enableAntialiasing) {
+            return outsideMask;
+        }
+
+        const Vc::float_v vFadeStart(float(m_antialiasingFadeStart));
+
+        Vc::float_m fadeMask = (dist > vFadeStart) && !outsideMask;
+        (*value)(fadeMask) =
+            (Vc::float_v(float(m_fadeStartValue)) +
+             (dist - vFadeStart) * Vc::float_v(float(m_antialiasingFadeCoeff))) /
+            Vc::float_v(255.0f);
+
+        return outsideMask || fadeMask;
+    }
+#endif /* defined HAVE_VC */
+
 private:
     qreal m_radius;
     quint8 m_fadeStartValue;
@@ -174,6 +204,36 @@ public:
         return false;
     }
 
+#if defined HAVE_VC
+    /**
+     * Vectorized version of the limits check of needFade().
+     * \p x and \p y must be absolute values.
+     */
+    Vc::float_m outsideMask(const Vc::float_v &x, const Vc::float_v &y) const {
+        return x > Vc::float_v(float(m_xLimit)) ||
+            y > Vc::float_v(float(m_yLimit));
+    }
+
+    /**
+     * Vectorized version of the antialiasing part of needFade(). The
+     * \p value is the normalized base fade value calculated for (x, y).
+     * \p x and \p y must be absolute values.
+     */
+    void applyAntialiasingFade(Vc::float_v &value, const Vc::float_v &x, const Vc::float_v &y) const {
+        if (!m_enableAntialiasing) return;
+
+        const Vc::float_v vOne(Vc::One);
+
+        Vc::float_v xFade = (x - Vc::float_v(float(m_xFadeLimitStart))) * Vc::float_v(float(m_xFadeCoeff));
+        Vc::float_v yFade = (y - Vc::float_v(float(m_yFadeLimitStart))) * Vc::float_v(float(m_yFadeCoeff));
+
+        xFade.setZero(xFade < Vc::float_v(Vc::Zero));
+        yFade.setZero(yFade < Vc::float_v(Vc::Zero));
+
+        value = vOne - (vOne - value) * (vOne - xFade) * (vOne - yFade);
+    }
+#endif /* defined HAVE_VC */
+
 private:
     qreal m_xLimit;
     qreal m_yLimit;
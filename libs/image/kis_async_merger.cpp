@@ -207,11 +207,35 @@ private:
 /*                     KisAsyncMerger                                */
 /*********************************************************************/
 
+KisAsyncMerger::KisAsyncMerger()
+    : m_useOcclusionCulling(true),
+      m_numOccludedLeaves(0)
+{
+}
+
+void KisAsyncMerger::setUseOcclusionCulling(bool value)
+{
+    m_useOcclusionCulling = value;
+}
+
+bool KisAsyncMerger::useOcclusionCulling() const
+{
+    return m_useOcclusionCulling;
+}
+
+int KisAsyncMerger::numOccludedLeaves() const
+{
+    return m_numOccludedLeaves;
+}
+
 void KisAsyncMerger::startMerge(KisBaseRectsWalker &walker, bool notifyClones) {
     KisMergeWalker::LeafStack &leafStack = walker.leafStack();
 
     const bool useTempProjections = walker.needRectVaries();
 
+    m_lastOccluder = 0;
+    m_lastOccluderRect = QRect();
+
     while(!leafStack.isEmpty()) {
         KisMergeWalker::JobItem item = leafStack.pop();
         KisProjectionLeafSP currentLeaf = item.m_leaf;
@@ -271,7 +295,12 @@ void KisAsyncMerger::startMerge(KisBaseRectsWalker &walker, bool notifyClones) {
             /* nothing to do */
         }
 
-        compositeWithProjection(currentLeaf, applyRect);
+        if (!m_useOcclusionCulling || !isOccluded(walker, currentLeaf, applyRect)) {
+            compositeWithProjection(currentLeaf, applyRect);
+        } else {
+            DEBUG_NODE_ACTION("Skipping occluded", "", currentLeaf, applyRect);
+            m_numOccludedLeaves++;
+        }
 
         if(item.m_position & KisMergeWalker::N_TOPMOST) {
             writeProjection(currentLeaf, useTempProjections, applyRect);
@@ -283,6 +312,8 @@ void KisAsyncMerger::startMerge(KisBaseRectsWalker &walker, bool notifyClones) {
                  walker.levelOfDetail());
     }
 
+    m_lastOccluder = 0;
+
     if(notifyClones) {
         doNotifyClones(walker);
     }
@@ -297,6 +328,56 @@ void KisAsyncMerger::startMerge(KisBaseRectsWalker &walker, bool notifyClones) {
     }
 }
 
+bool KisAsyncMerger::isOccluded(KisBaseRectsWalker &walker, KisProjectionLeafSP leaf, const QRect &rect) {
+    if (!m_currentProjection) return false;
+
+    const KisMergeWalker::LeafStack &leafStack = walker.leafStack();
+    const KisProjectionLeafSP parent = leaf->parent();
+
+    /**
+     * Look through the siblings that will be composited above the
+     * leaf. The top of the stack is the next leaf to be merged.
+     */
+    for (int i = leafStack.size() - 1; i >= 0; i--) {
+        const KisMergeWalker::JobItem &item = leafStack[i];
+        const KisProjectionLeafSP upperLeaf = item.m_leaf;
+
+        if (upperLeaf->parent() != parent) break;
+
+        if (upperLeaf->visible() && !(item.m_position & KisMergeWalker::N_EXTRA)) {
+            /**
+             * A layer that takes the projection below it as an input
+             * (e.g. an adjustment layer) should see all the layers
+             * underneath, even if it is occluded itself.
+             */
+            if (upperLeaf->dependsOnLowerNodes()) break;
+
+            /**
+             * The projection of a filthy layer is not ready yet, so
+             * we can rely on the layers that will not be
+             * recalculated during this merge only.
+             */
+            if ((item.m_position & (KisMergeWalker::N_BELOW_FILTHY | KisMergeWalker::N_ABOVE_FILTHY)) &&
+                item.m_applyRect.contains(rect)) {
+
+                if (upperLeaf == m_lastOccluder && m_lastOccluderRect.contains(rect)) {
+                    return true;
+                }
+
+                if (upperLeaf->projectionPlane()->isOpaque(rect)) {
+                    m_lastOccluder = upperLeaf;
+                    m_lastOccluderRect = rect;
+                    return true;
+                }
+            }
+        }
+
+        if (item.m_position & KisMergeWalker::N_TOPMOST) break;
+    }
+
+    return false;
+}
+
 void KisAsyncMerger::resetProjection() {
     m_currentProjection = 0;
     m_finalProjection = 0;
@@ -19,18 +19,36 @@
 #ifndef __KIS_ASYNC_MERGER_H
 #define __KIS_ASYNC_MERGER_H
 
+#include <QRect>
+
 #include "kritaimage_export.h"
 #include "kis_types.h"
 
-class QRect;
 class KisBaseRectsWalker;
 
 class KRITAIMAGE_EXPORT KisAsyncMerger
 {
 public:
+    KisAsyncMerger();
+
     void startMerge(KisBaseRectsWalker &walker, bool notifyClones = true);
 
+    /**
+     * When enabled (default), the layers fully covered by an opaque
+     * layer in Normal mode above them are not composited into the
+     * projection. The result of the merge is the same.
+     */
+    void setUseOcclusionCulling(bool value);
+    bool useOcclusionCulling() const;
+
+    /**
+     * The number of layers skipped as occluded since the merger
+     * has been created. Used by tests and benchmarks.
+     */
+    int numOccludedLeaves() const;
+
 private:
+    inline bool isOccluded(KisBaseRectsWalker &walker, KisProjectionLeafSP leaf, const QRect &rect);
     inline void resetProjection();
     inline void setupProjection(KisProjectionLeafSP currentLeaf, const QRect& rect, bool useTempProjection);
     inline void writeProjection(KisProjectionLeafSP topmostLeaf, bool useTempProjection, const QRect &rect);
@@ -62,6 +80,16 @@ private:
      * setupProjection()
      */
     KisPaintDeviceSP m_cachedPaintDevice;
+
+    bool m_useOcclusionCulling;
+    int m_numOccludedLeaves;
+
+    /**
+     * The last layer found to be opaque in m_lastOccluderRect. Valid
+     * during a single merge only.
+     */
+    KisProjectionLeafSP m_lastOccluder;
+    QRect m_lastOccluderRect;
 };
 
 
@@ -18,11 +18,24 @@
 
 #include "kis_brush_mask_applicator_factories.h"
 
-#include "kis_circle_mask_generator.h"
+#include <QVector>
+#include <QPointF>
+
+#include "kis_mask_generator.h"
+
 #include "kis_circle_mask_generator_p.h"
+#include "kis_gauss_circle_mask_generator_p.h"
+#include "kis_curve_circle_mask_generator_p.h"
+
+#include "kis_rect_mask_generator_p.h"
+#include "kis_gauss_rect_mask_generator_p.h"
+#include "kis_curve_rect_mask_generator_p.h"
+
 #include "kis_brush_mask_applicators.h"
 #include "kis_brush_mask_applicator_base.h"
 
+#include "VcExtraMath.h"
+
 #define a(_s) #_s
 #define b(_s) a(_s)
 
@@ -42,6 +55,46 @@ MaskApplicatorFactory<KisCircleMaskGenerator, KisBrushMaskVectorApplicator>::cre
     return new KisBrushMaskVectorApplicator<KisCircleMaskGenerator,Vc::CurrentImplementation::current()>(maskGenerator);
 }
 
+template<>
+template<>
+MaskApplicatorFactory<KisGaussCircleMaskGenerator, KisBrushMaskVectorApplicator>::ReturnType
+MaskApplicatorFactory<KisGaussCircleMaskGenerator, KisBrushMaskVectorApplicator>::create<Vc::CurrentImplementation::current()>(ParamType maskGenerator)
+{
+    return new KisBrushMaskVectorApplicator<KisGaussCircleMaskGenerator,Vc::CurrentImplementation::current()>(maskGenerator);
+}
+
+template<>
+template<>
+MaskApplicatorFactory<KisCurveCircleMaskGenerator, KisBrushMaskVectorApplicator>::ReturnType
+MaskApplicatorFactory<KisCurveCircleMaskGenerator, KisBrushMaskVectorApplicator>::create<Vc::CurrentImplementation::current()>(ParamType maskGenerator)
+{
+    return new KisBrushMaskVectorApplicator<KisCurveCircleMaskGenerator,Vc::CurrentImplementation::current()>(maskGenerator);
+}
+
+template<>
+template<>
+MaskApplicatorFactory<KisRectangleMaskGenerator, KisBrushMaskVectorApplicator>::ReturnType
+MaskApplicatorFactory<KisRectangleMaskGenerator, KisBrushMaskVectorApplicator>::create<Vc::CurrentImplementation::current()>(ParamType maskGenerator)
+{
+    return new KisBrushMaskVectorApplicator<KisRectangleMaskGenerator,Vc::CurrentImplementation::current()>(maskGenerator);
+}
+
+template<>
+template<>
+MaskApplicatorFactory<KisGaussRectangleMaskGenerator, KisBrushMaskVectorApplicator>::ReturnType
+MaskApplicatorFactory<KisGaussRectangleMaskGenerator, KisBrushMaskVectorApplicator>::create<Vc::CurrentImplementation::current()>(ParamType maskGenerator)
+{
+    return new KisBrushMaskVectorApplicator<KisGaussRectangleMaskGenerator,Vc::CurrentImplementation::current()>(maskGenerator);
+}
+
+template<>
+template<>
+MaskApplicatorFactory<KisCurveRectangleMaskGenerator, KisBrushMaskVectorApplicator>::ReturnType
+MaskApplicatorFactory<KisCurveRectangleMaskGenerator, KisBrushMaskVectorApplicator>::create<Vc::CurrentImplementation::current()>(ParamType maskGenerator)
+{
+    return new KisBrushMaskVectorApplicator<KisCurveRectangleMaskGenerator,Vc::CurrentImplementation::current()>(maskGenerator);
+}
+
 #if defined HAVE_VC
 
 struct KisCircleMaskGenerator::FastRowProcessor
@@ -134,4 +187,411 @@ FastRowProcessor::process<Vc::CurrentImplementation::current()>(float* buffer, i
     }
 }
 
+
+struct KisGaussCircleMaskGenerator::FastRowProcessor
+{
+    FastRowProcessor(KisGaussCircleMaskGenerator *maskGenerator)
+        : d(maskGenerator->d.data()) {}
+
+    template<Vc::Implementation _impl>
+    void process(float* buffer, int width, float y, float cosa, float sina,
+                 float centerX, float centerY);
+
+    KisGaussCircleMaskGenerator::Private *d;
+};
+
+template<> void KisGaussCircleMaskGenerator::
+FastRowProcessor::process<Vc::CurrentImplementation::current()>(float* buffer, int width, float y, float cosa, float sina,
+                                   float centerX, float centerY)
+{
+    float y_ = y - centerY;
+    float sinay_ = sina * y_;
+    float cosay_ = cosa * y_;
+
+    float* bufferPointer = buffer;
+
+    Vc::float_v currentIndices = Vc::float_v::IndexesFromZero();
+
+    Vc::float_v increment((float)Vc::float_v::size());
+    Vc::float_v vCenterX(centerX);
+
+    Vc::float_v vCosa(cosa);
+    Vc::float_v vSina(sina);
+    Vc::float_v vCosaY_(cosay_);
+    Vc::float_v vSinaY_(sinay_);
+
+    Vc::float_v vYCoeff(d->ycoef);
+    Vc::float_v vDistfactor(d->distfactor);
+    Vc::float_v vAlphafactor(d->alphafactor / 255.0);
+    Vc::float_v vCenter(d->center);
+
+    Vc::float_v vZero(Vc::Zero);
+    Vc::float_v vOne(Vc::One);
+
+    for (int i=0; i < width; i+= Vc::float_v::size()){
+
+        Vc::float_v x_ = currentIndices - vCenterX;
+
+        Vc::float_v xr = x_ * vCosa - vSinaY_;
+        Vc::float_v yr = x_ * vSina + vCosaY_;
+
+        Vc::float_v dist = Vc::sqrt(pow2(xr) + pow2(yr * vYCoeff));
+
+        Vc::float_v vFade;
+        Vc::float_m excludeMask = d->fadeMaker.needFade(dist, &vFade);
+
+        if (!excludeMask.isFull()) {
+            Vc::float_v valDist = dist * vDistfactor;
+            Vc::float_v fullFade = vAlphafactor * (VcExtraMath::erf(valDist + vCenter) - VcExtraMath::erf(valDist - vCenter));
+
+            // 255 - alpha
+            Vc::float_v vValue = vOne - fullFade;
+            vValue.setZero(vValue < vZero);
+
+            // Mask in the pixels processed by the fade maker
+            vValue(excludeMask) = vFade;
+
+            vValue.store(bufferPointer, Vc::Aligned);
+        } else {
+            // Mask out everything outside the circle
+            vFade.store(bufferPointer, Vc::Aligned);
+        }
+
+        currentIndices = currentIndices + increment;
+
+        bufferPointer += Vc::float_v::size();
+    }
+}
+
+struct KisCurveCircleMaskGenerator::FastRowProcessor
+{
+    FastRowProcessor(KisCurveCircleMaskGenerator *maskGenerator)
+        : d(maskGenerator->d.data()) {}
+
+    template<Vc::Implementation _impl>
+    void process(float* buffer, int width, float y, float cosa, float sina,
+                 float centerX, float centerY);
+
+    KisCurveCircleMaskGenerator::Private *d;
+};
+
+template<> void KisCurveCircleMaskGenerator::
+FastRowProcessor::process<Vc::CurrentImplementation::current()>(float* buffer, int width, float y, float cosa, float sina,
+                                   float centerX, float centerY)
+{
+    float y_ = y - centerY;
+    float sinay_ = sina * y_;
+    float cosay_ = cosa * y_;
+
+    float* bufferPointer = buffer;
+
+    Vc::float_v currentIndices = Vc::float_v::IndexesFromZero();
+
+    Vc::float_v increment((float)Vc::float_v::size());
+    Vc::float_v vCenterX(centerX);
+
+    Vc::float_v vCosa(cosa);
+    Vc::float_v vSina(sina);
+    Vc::float_v vCosaY_(cosay_);
+    Vc::float_v vSinaY_(sinay_);
+
+    Vc::float_v vXCoeff(d->xcoef);
+    Vc::float_v vYCoeff(d->ycoef);
+    Vc::float_v vCurveResolution(d->curveResolution);
+
+    Vc::float_v vOne(Vc::One);
+
+    const qreal *curveDataPointer = d->curveData.constData();
+
+    for (int i=0; i < width; i+= Vc::float_v::size()){
+
+        Vc::float_v x_ = currentIndices - vCenterX;
+
+        Vc::float_v xr = x_ * vCosa - vSinaY_;
+        Vc::float_v yr = x_ * vSina + vCosaY_;
+
+        Vc::float_v dist = pow2(xr * vXCoeff) + pow2(yr * vYCoeff);
+
+        Vc::float_v vFade;
+        Vc::float_m excludeMask = d->fadeMaker.needFade(dist, &vFade);
+
+        if (!excludeMask.isFull()) {
+            // the excluded pixels must not point outside the curve data
+            Vc::float_v vDistance = Vc::min(dist, vOne) * vCurveResolution;
+            Vc::float_v vDistanceFloor = Vc::floor(vDistance);
+            Vc::float_v vAlphaValueF = vDistance - vDistanceFloor;
+
+            Vc::float_v::IndexType vAlphaValue =
+                Vc::simd_cast<Vc::float_v::IndexType>(vDistanceFloor);
+
+            Vc::float_v vCurvedData(curveDataPointer, vAlphaValue);
+            Vc::float_v vCurvedData1(curveDataPointer, vAlphaValue + 1);
+
+            Vc::float_v vAlpha = (vOne - vAlphaValueF) * vCurvedData + vAlphaValueF * vCurvedData1;
+            Vc::float_v vValue = vOne - vAlpha;
+
+            // Mask in the pixels processed by the fade maker
+            vValue(excludeMask) = vFade;
+
+            vValue.store(bufferPointer, Vc::Aligned);
+        } else {
+            // Mask out everything outside the circle
+            vFade.store(bufferPointer, Vc::Aligned);
+        }
+
+        currentIndices = currentIndices + increment;
+
+        bufferPointer += Vc::float_v::size();
+    }
+}
+
+struct KisRectangleMaskGenerator::FastRowProcessor
+{
+    FastRowProcessor(KisRectangleMaskGenerator *maskGenerator)
+        : d(maskGenerator->d.data()) {}
+
+    template<Vc::Implementation _impl>
+    void process(float* buffer, int width, float y, float cosa, float sina,
+                 float centerX, float centerY);
+
+    KisRectangleMaskGenerator::Private *d;
+};
+
+template<> void KisRectangleMaskGenerator::
+FastRowProcessor::process<Vc::CurrentImplementation::current()>(float* buffer, int width, float y, float cosa, float sina,
+                                   float centerX, float centerY)
+{
+    float y_ = y - centerY;
+    float sinay_ = sina * y_;
+    float cosay_ = cosa * y_;
+
+    float* bufferPointer = buffer;
+
+    Vc::float_v currentIndices = Vc::float_v::IndexesFromZero();
+
+    Vc::float_v increment((float)Vc::float_v::size());
+    Vc::float_v vCenterX(centerX);
+
+    Vc::float_v vCosa(cosa);
+    Vc::float_v vSina(sina);
+    Vc::float_v vCosaY_(cosay_);
+    Vc::float_v vSinaY_(sinay_);
+
+    const bool useSmoothing = d->copyOfAntialiasEdges;
+
+    Vc::float_v vXCoeff(d->xcoeff);
+    Vc::float_v vYCoeff(d->ycoeff);
+
+    Vc::float_v vTransformedFadeX(d->transformedFadeX);
+    Vc::float_v vTransformedFadeY(d->transformedFadeY);
+
+    Vc::float_v vOne(Vc::One);
+
+    for (int i=0; i < width; i+= Vc::float_v::size()){
+
+        Vc::float_v x_ = currentIndices - vCenterX;
+
+        Vc::float_v xr = Vc::abs(x_ * vCosa - vSinaY_);
+        Vc::float_v yr = Vc::abs(x_ * vSina + vCosaY_);
+
+        Vc::float_v nxr = xr * vXCoeff;
+        Vc::float_v nyr = yr * vYCoeff;
+
+        Vc::float_m outsideMask = (nxr > vOne) || (nyr > vOne);
+
+        if (!outsideMask.isFull()) {
+            if (useSmoothing) {
+                xr = xr + vOne;
+                yr = yr + vOne;
+            }
+
+            Vc::float_v fxr = xr * vTransformedFadeX;
+            Vc::float_v fyr = yr * vTransformedFadeY;
+
+            Vc::float_v fadeX = nxr * (fxr - vOne) / (fxr - nxr);
+            Vc::float_v fadeY = nyr * (fyr - vOne) / (fyr - nyr);
+
+            Vc::float_m fadeXMask = (fxr > vOne) && ((fxr > fyr) || (fyr < vOne));
+            Vc::float_m fadeYMask = (fyr > vOne) && ((fyr > fxr) || (fxr < vOne));
+
+            // the horizontal fade has priority, like in valueAt()
+            Vc::float_v vFade(Vc::Zero);
+            vFade(fadeYMask) = fadeY;
+            vFade(fadeXMask) = fadeX;
+
+            // Mask out the outer part of the rectangle
+            vFade(outsideMask) = vOne;
+
+            vFade.store(bufferPointer, Vc::Aligned);
+        } else {
+            // Mask out everything outside the rectangle
+            vOne.store(bufferPointer, Vc::Aligned);
+        }
+
+        currentIndices = currentIndices + increment;
+
+        bufferPointer += Vc::float_v::size();
+    }
+}
+
+struct KisGaussRectangleMaskGenerator::FastRowProcessor
+{
+    FastRowProcessor(KisGaussRectangleMaskGenerator *maskGenerator)
+        : d(maskGenerator->d.data()) {}
+
+    template<Vc::Implementation _impl>
+    void process(float* buffer, int width, float y, float cosa, float sina,
+                 float centerX, float centerY);
+
+    KisGaussRectangleMaskGenerator::Private *d;
+};
+
+template<> void KisGaussRectangleMaskGenerator::
+FastRowProcessor::process<Vc::CurrentImplementation::current()>(float* buffer, int width, float y, float cosa, float sina,
+                                   float centerX, float centerY)
+{
+    float y_ = y - centerY;
+    float sinay_ = sina * y_;
+    float cosay_ = cosa * y_;
+
+    float* bufferPointer = buffer;
+
+    Vc::float_v currentIndices = Vc::float_v::IndexesFromZero();
+
+    Vc::float_v increment((float)Vc::float_v::size());
+    Vc::float_v vCenterX(centerX);
+
+    Vc::float_v vCosa(cosa);
+    Vc::float_v vSina(sina);
+    Vc::float_v vCosaY_(cosay_);
+    Vc::float_v vSinaY_(sinay_);
+
+    Vc::float_v vXFade(d->xfade);
+    Vc::float_v vYFade(d->yfade);
+    Vc::float_v vHalfWidth(d->halfWidth);
+    Vc::float_v vHalfHeight(d->halfHeight);
+    Vc::float_v vAlphafactor(d->alphafactor / 255.0);
+
+    Vc::float_v vZero(Vc::Zero);
+    Vc::float_v vOne(Vc::One);
+
+    for (int i=0; i < width; i+= Vc::float_v::size()){
+
+        Vc::float_v x_ = currentIndices - vCenterX;
+
+        Vc::float_v xr = Vc::abs(x_ * vCosa - vSinaY_);
+        Vc::float_v yr = Vc::abs(x_ * vSina + vCosaY_);
+
+        Vc::float_m outsideMask = d->fadeMaker.outsideMask(xr, yr);
+
+        if (!outsideMask.isFull()) {
+            Vc::float_v fullFade = vAlphafactor *
+                (VcExtraMath::erf((vHalfWidth + xr) * vXFade) + VcExtraMath::erf((vHalfWidth - xr) * vXFade)) *
+                (VcExtraMath::erf((vHalfHeight + yr) * vYFade) + VcExtraMath::erf((vHalfHeight - yr) * vYFade));
+
+            // 255 - alpha
+            Vc::float_v vValue = vOne - fullFade;
+            vValue.setZero(vValue < vZero);
+
+            d->fadeMaker.applyAntialiasingFade(vValue, xr, yr);
+
+            // Mask out the outer part of the rectangle
+            vValue(outsideMask) = vOne;
+
+            vValue.store(bufferPointer, Vc::Aligned);
+        } else {
+            // Mask out everything outside the rectangle
+            vOne.store(bufferPointer, Vc::Aligned);
+        }
+
+        currentIndices = currentIndices + increment;
+
+        bufferPointer += Vc::float_v::size();
+    }
+}
+
+struct KisCurveRectangleMaskGenerator::FastRowProcessor
+{
+    FastRowProcessor(KisCurveRectangleMaskGenerator *maskGenerator)
+        : d(maskGenerator->d) {}
+
+    template<Vc::Implementation _impl>
+    void process(float* buffer, int width, float y, float cosa, float sina,
+                 float centerX, float centerY);
+
+    KisCurveRectangleMaskGenerator::Private *d;
+};
+
+template<> void KisCurveRectangleMaskGenerator::
+FastRowProcessor::process<Vc::CurrentImplementation::current()>(float* buffer, int width, float y, float cosa, float sina,
+                                   float centerX, float centerY)
+{
+    float y_ = y - centerY;
+    float sinay_ = sina * y_;
+    float cosay_ = cosa * y_;
+
+    float* bufferPointer = buffer;
+
+    Vc::float_v currentIndices = Vc::float_v::IndexesFromZero();
+
+    Vc::float_v increment((float)Vc::float_v::size());
+    Vc::float_v vCenterX(centerX);
+
+    Vc::float_v vCosa(cosa);
+    Vc::float_v vSina(sina);
+    Vc::float_v vCosaY_(cosay_);
+    Vc::float_v vSinaY_(sinay_);
+
+    Vc::float_v vXCoeff(d->xcoeff);
+    Vc::float_v vYCoeff(d->ycoeff);
+    Vc::float_v vCurveResolution(d->curveResolution);
+
+    Vc::float_v vHalf(0.5f);
+    Vc::float_v vOne(Vc::One);
+
+    const qreal *curveDataPointer = d->curveData.constData();
+
+    for (int i=0; i < width; i+= Vc::float_v::size()){
+
+        Vc::float_v x_ = currentIndices - vCenterX;
+
+        Vc::float_v xr = Vc::abs(x_ * vCosa - vSinaY_);
+        Vc::float_v yr = Vc::abs(x_ * vSina + vCosaY_);
+
+        Vc::float_m outsideMask = d->fadeMaker.outsideMask(xr, yr);
+
+        if (!outsideMask.isFull()) {
+            // the excluded pixels must not point outside the curve data,
+            // the rounding is the same as qRound() for positive values
+            Vc::float_v vIndexX = Vc::floor(Vc::min(xr * vXCoeff, vOne) * vCurveResolution + vHalf);
+            Vc::float_v vIndexY = Vc::floor(Vc::min(yr * vYCoeff, vOne) * vCurveResolution + vHalf);
+
+            Vc::float_v::IndexType sIndex = Vc::simd_cast<Vc::float_v::IndexType>(vIndexX);
+            Vc::float_v::IndexType tIndex = Vc::simd_cast<Vc::float_v::IndexType>(vIndexY);
+            Vc::float_v::IndexType sIndexInverted = Vc::simd_cast<Vc::float_v::IndexType>(vCurveResolution - vIndexX);
+            Vc::float_v::IndexType tIndexInverted = Vc::simd_cast<Vc::float_v::IndexType>(vCurveResolution - vIndexY);
+
+            Vc::float_v vBlend =
+                Vc::float_v(curveDataPointer, sIndex) * (vOne - Vc::float_v(curveDataPointer, sIndexInverted)) *
+                Vc::float_v(curveDataPointer, tIndex) * (vOne - Vc::float_v(curveDataPointer, tIndexInverted));
+
+            Vc::float_v vValue = vOne - vBlend;
+
+            d->fadeMaker.applyAntialiasingFade(vValue, xr, yr);
+
+            // Mask out the outer part of the rectangle
+            vValue(outsideMask) = vOne;
+
+            vValue.store(bufferPointer, Vc::Aligned);
+        } else {
+            // Mask out everything outside the rectangle
+            vOne.store(bufferPointer, Vc::Aligned);
+        }
+
+        currentIndices = currentIndices + increment;
+
+        bufferPointer += Vc::float_v::size();
+    }
+}
+
 #endif /* defined HAVE_VC */
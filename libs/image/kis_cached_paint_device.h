@@ -19,7 +19,7 @@
 #ifndef __KIS_CACHED_PAINT_DEVICE_H
 #define __KIS_CACHED_PAINT_DEVICE_H
 
-#include "tiles3/kis_lockless_stack.h"
+#include "kis_lockless_stack.h"
 
 class KisCachedPaintDevice
 {
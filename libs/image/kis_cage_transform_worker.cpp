@@ -370,12 +370,14 @@ void KisCageTransformWorker::run()
     }
 
     GridIterationTools::PaintDevicePolygonOp polygonOp(srcDev, tempDevice);
+    GridIterationTools::MultithreadedPolygonOp<GridIterationTools::PaintDevicePolygonOp> threadedOp(polygonOp);
     Private::MapIndexesOp indexesOp(m_d.data());
     GridIterationTools::iterateThroughGrid
-        <GridIterationTools::IncompletePolygonPolicy>(polygonOp, indexesOp,
+        <GridIterationTools::IncompletePolygonPolicy>(threadedOp, indexesOp,
                                                       m_d->gridSize,
                                                       m_d->validPoints,
                                                       transformedPoints);
+    threadedOp.flush();
 
     QRect rect = tempDevice->extent();
     KisPainter gc(m_d->dev);
@@ -432,12 +434,14 @@ QImage KisCageTransformWorker::runOnQImage(QPointF *newOffset)
     }
 
     GridIterationTools::QImagePolygonOp polygonOp(m_d->srcImage, tempImage, m_d->srcImageOffset, dstQImageOffset);
+    GridIterationTools::MultithreadedPolygonOp<GridIterationTools::QImagePolygonOp> threadedOp(polygonOp);
     Private::MapIndexesOp indexesOp(m_d.data());
     GridIterationTools::iterateThroughGrid
-        <GridIterationTools::IncompletePolygonPolicy>(polygonOp, indexesOp,
+        <GridIterationTools::IncompletePolygonPolicy>(threadedOp, indexesOp,
                                                       m_d->gridSize,
                                                       m_d->validPoints,
                                                       transformedPoints);
+    threadedOp.flush();
 
     {
         QPainter gc(&dstImage);
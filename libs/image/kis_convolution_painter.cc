@@ -50,6 +50,8 @@
 
 #include "kis_convolution_worker.h"
 #include "kis_convolution_worker_spatial.h"
+#include "kis_convolution_worker_iir.h"
+#include "kis_gaussian_kernel.h"
 
 #include "config_convolution.h"
 
@@ -65,6 +67,18 @@ KisConvolutionWorker<factory>* KisConvolutionPainter::createWorker(const KisConv
 {
     KisConvolutionWorker<factory> *worker;
 
+    /**
+     * The recursive filter only approximates the convolution, so it
+     * is used only when requested explicitly
+     */
+    if (m_enginePreference == IIR_GAUSSIAN) {
+        const qreal sigma = KisGaussianKernel::sigmaFromKernel(kernel);
+
+        if (sigma > 0.0) {
+            return new KisConvolutionWorkerIIR<factory>(painter, progress, sigma);
+        }
+    }
+
 #ifdef HAVE_FFTW3
     #define THRESHOLD_SIZE 5
 
@@ -105,12 +119,22 @@ KisConvolutionPainter::KisConvolutionPainter(KisPaintDeviceSP device, KisSelecti
 {
 }
 
-KisConvolutionPainter::KisConvolutionPainter(KisPaintDeviceSP device, TestingEnginePreference enginePreference)
+KisConvolutionPainter::KisConvolutionPainter(KisPaintDeviceSP device, EnginePreference enginePreference)
     : KisPainter(device),
       m_enginePreference(enginePreference)
 {
 }
 
+void KisConvolutionPainter::setEnginePreference(EnginePreference value)
+{
+    m_enginePreference = value;
+}
+
+KisConvolutionPainter::EnginePreference KisConvolutionPainter::enginePreference() const
+{
+    return m_enginePreference;
+}
+
 void KisConvolutionPainter::applyMatrix(const KisConvolutionKernelSP kernel, const KisPaintDeviceSP src, QPoint srcPos, QPoint dstPos, QSize areaSize, KisConvolutionBorderOp borderOp)
 {
     /**
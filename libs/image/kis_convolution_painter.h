@@ -43,9 +43,30 @@ class KRITAIMAGE_EXPORT KisConvolutionPainter : public KisPainter
 
 public:
 
+    /**
+     * The engine used for the convolution. NONE lets the painter choose
+     * the fastest one for the given kernel.
+     *
+     * IIR_GAUSSIAN is a recursive filter, whose cost per pixel does not
+     * depend on the size of the kernel. It approximates the convolution
+     * and can be used for the one-dimensional Gaussian kernels only,
+     * other kernels fall back to the automatic choice. NONE never
+     * chooses it.
+     */
+    enum EnginePreference {
+        NONE,
+        SPATIAL,
+        FFTW,
+        IIR_GAUSSIAN
+    };
+
     KisConvolutionPainter();
     KisConvolutionPainter(KisPaintDeviceSP device);
     KisConvolutionPainter(KisPaintDeviceSP device, KisSelectionSP selection);
+    KisConvolutionPainter(KisPaintDeviceSP device, EnginePreference enginePreference);
+
+    void setEnginePreference(EnginePreference value);
+    EnginePreference enginePreference() const;
 
     /**
      * Convolve all channels in src using the specified kernel; there is only one kernel for all
@@ -67,18 +88,6 @@ public:
     void applyMatrix(const KisConvolutionKernelSP kernel, const KisPaintDeviceSP src, QPoint srcPos, QPoint dstPos, QSize areaSize,
                      KisConvolutionBorderOp borderOp = BORDER_REPEAT);
 
-protected:
-    friend class KisConvolutionPainterTest;
-    enum TestingEnginePreference {
-        NONE,
-        SPATIAL,
-        FFTW
-    };
-
-
-    KisConvolutionPainter(KisPaintDeviceSP device, TestingEnginePreference enginePreference);
-
-
 private:
     template<class factory>
         KisConvolutionWorker<factory>* createWorker(const KisConvolutionKernelSP kernel,
@@ -86,6 +95,6 @@ private:
                                                     KoUpdater *progress);
 
 private:
-    TestingEnginePreference m_enginePreference;
+    EnginePreference m_enginePreference;
 };
 #endif //KIS_CONVOLUTION_PAINTER_H_
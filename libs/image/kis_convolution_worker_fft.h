@@ -35,15 +35,7 @@
 
 #include <fftw3.h>
 
-template<class _IteratorFactory_> class KisConvolutionWorkerFFT;
-class KisConvolutionWorkerFFTLock
-{
-private:
-    static QMutex fftwMutex;
-    template<class _IteratorFactory_> friend class KisConvolutionWorkerFFT;
-};
-
-QMutex KisConvolutionWorkerFFTLock::fftwMutex;
+#include "kis_fftw_plan_cache.h"
 
 
 template<class _IteratorFactory_>
@@ -79,11 +71,11 @@ public:
         addToProgress(0);
         if (isInterrupted()) return;
 
-        const quint32 halfKernelWidth = (kernel->width() - 1) / 2;
-        const quint32 halfKernelHeight = (kernel->height() - 1) / 2;
+        m_halfKernelWidth = (kernel->width() - 1) / 2;
+        m_halfKernelHeight = (kernel->height() - 1) / 2;
 
-        m_fftWidth = areaSize.width() + 4 * halfKernelWidth;
-        m_fftHeight = areaSize.height() + 2 * halfKernelHeight;
+        m_fftWidth = areaSize.width() + 4 * m_halfKernelWidth;
+        m_fftHeight = areaSize.height() + 2 * m_halfKernelHeight;
 
         /**
          * FIXME: check whether this "optimization" is needed to
@@ -95,75 +87,34 @@ public:
         m_fftLength = m_fftHeight * (m_fftWidth / 2 + 1);
         m_extraMem = (m_fftWidth % 2) ? 1 : 2;
 
+        KisFFTWPlanCache::PlansSP plans =
+            KisFFTWPlanCache::instance()->plans(m_fftWidth, m_fftHeight);
+
         // create and fill kernel
         m_kernelFFT = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * m_fftLength);
         memset(m_kernelFFT, 0, sizeof(fftw_complex) * m_fftLength);
         fftFillKernelMatrix(kernel, m_kernelFFT);
 
+        fftw_execute_dft_r2c(plans->forward, (double*)m_kernelFFT, m_kernelFFT);
+
         // find out which channels need convolving
         QList<KoChannelInfo*> convChannelList = this->convolvableChannelList(src);
 
-        m_channelFFT.resize(convChannelList.count());
-        for (auto i = m_channelFFT.begin(); i != m_channelFFT.end(); ++i) {
-            *i = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * m_fftLength);
-        }
-
         const double kernelFactor = kernel->factor() ? kernel->factor() : 1;
         const double fftScale = 1.0 / (m_fftHeight * m_fftWidth) / kernelFactor;
 
         FFTInfo info (fftScale, convChannelList, kernel, this->m_painter->device()->colorSpace());
-        int cacheRowStride = m_fftWidth + m_extraMem;
-
-        fillCacheFromDevice(src,
-                            QRect(srcPos.x() - halfKernelWidth,
-                                  srcPos.y() - halfKernelHeight,
-                                  m_fftWidth,
-                                  m_fftHeight),
-                            cacheRowStride,
-                            info, dataRect);
 
         addToProgress(10);
-        if (isInterrupted()) return;
-
-        // calculate number off fft operations required for progress reporting
-        const float progressPerFFT = (100 - 30) / (double)(convChannelList.count() * 2 + 1);
-
-        // perform FFT
-        fftw_plan fftwPlanForward, fftwPlanBackward;
-
-        KisConvolutionWorkerFFTLock::fftwMutex.lock();
-        fftwPlanForward = fftw_plan_dft_r2c_2d(m_fftHeight, m_fftWidth, (double*)m_kernelFFT, m_kernelFFT, FFTW_ESTIMATE);
-        fftwPlanBackward = fftw_plan_dft_c2r_2d(m_fftHeight, m_fftWidth, m_kernelFFT, (double*)m_kernelFFT, FFTW_ESTIMATE);
-        KisConvolutionWorkerFFTLock::fftwMutex.unlock();
-
-        fftw_execute(fftwPlanForward);
-        addToProgress(progressPerFFT);
-        if (isInterrupted()) return;
-
-        for (auto k = m_channelFFT.begin(); k != m_channelFFT.end(); ++k)
-        {
-            fftw_execute_dft_r2c(fftwPlanForward, (double*)(*k), *k);
-            addToProgress(progressPerFFT);
-            if (isInterrupted()) return;
-
-            fftMultiply(*k, m_kernelFFT);
-
-            fftw_execute_dft_c2r(fftwPlanBackward, *k, (double*)*k);
-            addToProgress(progressPerFFT);
-            if (isInterrupted()) return;
+        if (isInterrupted()) {
+            cleanUp();
+            return;
         }
 
-        KisConvolutionWorkerFFTLock::fftwMutex.lock();
-        fftw_destroy_plan(fftwPlanForward);
-        fftw_destroy_plan(fftwPlanBackward);
-        KisConvolutionWorkerFFTLock::fftwMutex.unlock();
-
-
-        writeResultToDevice(QRect(dstPos.x(), dstPos.y(), areaSize.width(), areaSize.height()),
-                            cacheRowStride, halfKernelWidth, halfKernelHeight,
-                            info, dataRect);
+        if (convolveArea(src, srcPos, QRect(dstPos, areaSize), *plans, info, dataRect)) {
+            addToProgress(20);
+        }
 
-        addToProgress(20);
         cleanUp();
     }
 
@@ -218,11 +169,77 @@ public:
         int alphaRealPos;
     };
 
+    /**
+     * Convolves the area of \p dstRect.size() at \p srcPos and writes
+     * it to \p dstRect. The whole area is read into the cache before
+     * anything is written, so \p src may be the destination device.
+     * Returns false if the operation was interrupted.
+     */
+    bool convolveArea(KisPaintDeviceSP src,
+                      const QPoint &srcPos,
+                      const QRect &dstRect,
+                      const KisFFTWPlanCache::Plans &plans,
+                      const FFTInfo &info,
+                      const QRect &dataRect) {
+
+        QVector<fftw_complex*> channelFFT(info.numChannels());
+        for (auto i = channelFFT.begin(); i != channelFFT.end(); ++i) {
+            *i = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * m_fftLength);
+        }
+
+        const int cacheRowStride = m_fftWidth + m_extraMem;
+
+        fillCacheFromDevice(src,
+                            QRect(srcPos.x() - m_halfKernelWidth,
+                                  srcPos.y() - m_halfKernelHeight,
+                                  m_fftWidth,
+                                  m_fftHeight),
+                            cacheRowStride,
+                            info, dataRect, channelFFT);
+
+        // calculate number off fft operations required for progress reporting
+        const float progressPerFFT = (100 - 30) / (double)(channelFFT.size() * 2 + 1);
+
+        addToProgress(progressPerFFT);
+        bool interrupted = isInterrupted();
+
+        for (auto k = channelFFT.begin(); k != channelFFT.end() && !interrupted; ++k)
+        {
+            fftw_execute_dft_r2c(plans.forward, (double*)(*k), *k);
+
+            addToProgress(progressPerFFT);
+            if (isInterrupted()) {
+                interrupted = true;
+                break;
+            }
+
+            fftMultiply(*k, m_kernelFFT);
+
+            fftw_execute_dft_c2r(plans.backward, *k, (double*)*k);
+
+            addToProgress(progressPerFFT);
+            interrupted = isInterrupted();
+        }
+
+        if (!interrupted) {
+            writeResultToDevice(dstRect,
+                                cacheRowStride, m_halfKernelWidth, m_halfKernelHeight,
+                                info, dataRect, channelFFT);
+        }
+
+        Q_FOREACH (fftw_complex *channel, channelFFT) {
+            fftw_free(channel);
+        }
+
+        return !interrupted;
+    }
+
     void fillCacheFromDevice(KisPaintDeviceSP src,
                              const QRect &rect,
                              const int cacheRowStride,
                              const FFTInfo &info,
-                             const QRect &dataRect) {
+                             const QRect &dataRect,
+                             const QVector<fftw_complex*> &channelFFT) {
 
         typename _IteratorFactory_::HLineConstIterator hitSrc =
             _IteratorFactory_::createHLineConstIterator(src,
@@ -234,7 +251,7 @@ public:
         const auto channelPtrBegin = channelPtr.begin();
         const auto channelPtrEnd = channelPtr.end();
 
-        auto iFFt = m_channelFFT.constBegin();
+        auto iFFt = channelFFT.constBegin();
         for (auto i = channelPtrBegin; i != channelPtrEnd; ++i, ++iFFt) {
             *i = (double*)*iFFt;
         }
@@ -313,7 +330,8 @@ public:
                              const int halfKernelWidth,
                              const int halfKernelHeight,
                              const FFTInfo &info,
-                             const QRect &dataRect) {
+                             const QRect &dataRect,
+                             const QVector<fftw_complex*> &channelFFT) {
 
         typename _IteratorFactory_::HLineIterator hitDst =
             _IteratorFactory_::createHLineIterator(this->m_painter->device(),
@@ -327,7 +345,7 @@ public:
         const auto channelPtrBegin = channelPtr.begin();
         const auto channelPtrEnd = channelPtr.end();
 
-        auto iFFt = m_channelFFT.constBegin();
+        auto iFFt = channelFFT.constBegin();
         for (auto i = channelPtrBegin; i != channelPtrEnd; ++i, ++iFFt) {
             *i = (double*)*iFFt + initialOffset;
         }
@@ -472,14 +490,15 @@ private:
 
     void fftLogMatrix(double* channel, const QString &f)
     {
-        KisConvolutionWorkerFFTLock::fftwMutex.lock();
+        static QMutex logMutex;
+        logMutex.lock();
         QString filename(QDir::homePath() + "/log_" + f + ".txt");
         dbgKrita << "Log File Name: " << filename;
         QFile file (filename);
         if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
         {
             dbgKrita << "Failed";
-            KisConvolutionWorkerFFTLock::fftwMutex.unlock();
+            logMutex.unlock();
             return;
         }
 
@@ -496,7 +515,7 @@ private:
             }
             in << "\n";
         }
-        KisConvolutionWorkerFFTLock::fftwMutex.unlock();
+        logMutex.unlock();
     }
 
     void addToProgress(float amount)
@@ -510,12 +529,7 @@ private:
 
     bool isInterrupted()
     {
-        if (this->m_progress && this->m_progress->interrupted()) {
-            cleanUp();
-            return true;
-        }
-
-        return false;
+        return this->m_progress && this->m_progress->interrupted();
     }
 
     void cleanUp()
@@ -523,19 +537,15 @@ private:
         // free kernel fft data
         if (m_kernelFFT) {
             fftw_free(m_kernelFFT);
+            m_kernelFFT = 0;
         }
-
-        Q_FOREACH (fftw_complex *channel, m_channelFFT) {
-            fftw_free(channel);
-        }
-        m_channelFFT.clear();
     }
 private:
     quint32 m_fftWidth, m_fftHeight, m_fftLength, m_extraMem;
+    quint32 m_halfKernelWidth, m_halfKernelHeight;
     float m_currentProgress;
 
     fftw_complex* m_kernelFFT;
-    QVector<fftw_complex*> m_channelFFT;
 };
 
 #endif
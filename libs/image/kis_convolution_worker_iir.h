@@ -0,0 +1,353 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KIS_CONVOLUTION_WORKER_IIR_H
+#define KIS_CONVOLUTION_WORKER_IIR_H
+
+#include <cmath>
+#include <QVector>
+
+#include <KoChannelInfo.h>
+#include <kis_assert.h>
+
+#include "kis_convolution_worker.h"
+#include "kis_math_toolbox.h"
+
+
+/**
+ * Convolves a device with a one-dimensional Gaussian kernel using the
+ * recursive (IIR) filter by Young and van Vliet ("Recursive
+ * implementation of the Gaussian filter", Signal Processing, 1995).
+ *
+ * Every line is filtered by a third-order causal pass followed by an
+ * anti-causal one, so the cost per pixel does not depend on the radius
+ * of the kernel. The result is an approximation of the spatial
+ * convolution, which differs from it by a few levels of an 8-bit
+ * channel at most.
+ *
+ * The worker is valid only for the Gaussian kernels, \p sigma is passed
+ * by the caller (see KisGaussianKernel::sigmaFromKernel()).
+ */
+template <class _IteratorFactory_>
+class KisConvolutionWorkerIIR : public KisConvolutionWorker<_IteratorFactory_>
+{
+public:
+    KisConvolutionWorkerIIR(KisPainter *painter, KoUpdater *progress, qreal sigma)
+        : KisConvolutionWorker<_IteratorFactory_>(painter, progress),
+          m_sigma(sigma)
+    {
+        initCoefficients();
+    }
+
+    ~KisConvolutionWorkerIIR() override {
+    }
+
+    void execute(const KisConvolutionKernelSP kernel, const KisPaintDeviceSP src, QPoint srcPos, QPoint dstPos, QSize areaSize, const QRect& dataRect) override {
+        KIS_SAFE_ASSERT_RECOVER_RETURN(kernel->width() == 1 || kernel->height() == 1);
+
+        const bool horizontal = kernel->width() > 1;
+        m_padding = (qMax(kernel->width(), kernel->height()) - 1) / 2;
+        m_pixelSize = src->colorSpace()->pixelSize();
+
+        // Make the area we cover as small as possible
+        if (this->m_painter->selection()) {
+            QRect r = this->m_painter->selection()->selectedRect().intersected(QRect(srcPos, areaSize));
+            dstPos += r.topLeft() - srcPos;
+            srcPos = r.topLeft();
+            areaSize = r.size();
+        }
+
+        if (areaSize.width() == 0 || areaSize.height() == 0)
+            return;
+
+        m_convChannelList = this->convolvableChannelList(src);
+        m_convolveChannelsNo = m_convChannelList.count();
+        m_alphaCachePos = -1;
+        m_alphaRealPos = -1;
+
+        for (int i = 0; i < m_convChannelList.size(); i++) {
+            if (m_convChannelList[i]->channelType() == KoChannelInfo::ALPHA) {
+                m_alphaCachePos = i;
+                m_alphaRealPos = m_convChannelList[i]->pos();
+            }
+        }
+
+        KisMathToolbox mathToolbox;
+        m_toDoubleFuncPtr = QVector<PtrToDouble>(m_convolveChannelsNo);
+        if (!mathToolbox.getToDoubleChannelPtr(m_convChannelList, m_toDoubleFuncPtr))
+            return;
+
+        m_fromDoubleFuncPtr = QVector<PtrFromDouble>(m_convolveChannelsNo);
+        if (!mathToolbox.getFromDoubleChannelPtr(m_convChannelList, m_fromDoubleFuncPtr))
+            return;
+
+        /**
+         * The recursive filter has unit gain, so the normalization of
+         * the kernel is applied as a separate multiplier
+         */
+        const qreal kernelFactor = kernel->factor() ? 1.0 / kernel->factor() : 1;
+        m_gain = kernel->data()->sum() * kernelFactor;
+
+        m_minClamp.resize(m_convolveChannelsNo);
+        m_maxClamp.resize(m_convolveChannelsNo);
+        m_absoluteOffset.resize(m_convolveChannelsNo);
+        for (quint32 i = 0; i < m_convolveChannelsNo; ++i) {
+            m_minClamp[i] = mathToolbox.minChannelValue(m_convChannelList[i]);
+            m_maxClamp[i] = mathToolbox.maxChannelValue(m_convChannelList[i]);
+            m_absoluteOffset[i] = (m_maxClamp[i] - m_minClamp[i]) * kernel->offset();
+        }
+
+        if (horizontal) {
+            executeHorizontal(src, srcPos, dstPos, areaSize, dataRect);
+        } else {
+            executeVertical(src, srcPos, dstPos, areaSize, dataRect);
+        }
+    }
+
+private:
+    void initCoefficients() {
+        const qreal sigma = qMax(m_sigma, qreal(0.5));
+
+        const qreal q = sigma >= 2.5 ?
+            0.98711 * sigma - 0.96330 :
+            3.97156 - 4.14554 * std::sqrt(1.0 - 0.26891 * sigma);
+
+        const qreal q2 = q * q;
+        const qreal q3 = q2 * q;
+
+        const qreal b0 = 1.57825 + 2.44413 * q + 1.4281 * q2 + 0.422205 * q3;
+
+        m_b1 = (2.44413 * q + 2.85619 * q2 + 1.26661 * q3) / b0;
+        m_b2 = -(1.4281 * q2 + 1.26661 * q3) / b0;
+        m_b3 = 0.422205 * q3 / b0;
+        m_B = 1.0 - (m_b1 + m_b2 + m_b3);
+    }
+
+    /**
+     * Filters \p length interleaved pixels in-place. The samples outside
+     * the line are considered equal to the border ones.
+     */
+    void filterLine(qreal *line, int length) {
+        const int stride = m_convolveChannelsNo;
+
+        for (int k = 0; k < stride; k++) {
+            qreal *ptr = line + k;
+
+            // causal pass
+            qreal w1 = ptr[0];
+            qreal w2 = w1;
+            qreal w3 = w1;
+
+            for (int i = 0; i < length; i++) {
+                const qreal w = m_B * ptr[i * stride] + m_b1 * w1 + m_b2 * w2 + m_b3 * w3;
+                ptr[i * stride] = w;
+                w3 = w2;
+                w2 = w1;
+                w1 = w;
+            }
+
+            // anti-causal pass
+            qreal y1 = ptr[(length - 1) * stride];
+            qreal y2 = y1;
+            qreal y3 = y1;
+
+            for (int i = length - 1; i >= 0; i--) {
+                const qreal y = m_B * ptr[i * stride] + m_b1 * y1 + m_b2 * y2 + m_b3 * y3;
+                ptr[i * stride] = y;
+                y3 = y2;
+                y2 = y1;
+                y1 = y;
+            }
+        }
+    }
+
+    inline void loadPixel(const quint8 *data, qreal *dst) {
+        // no alpha is rare case, so just multiply by 1.0 in that case
+        qreal alphaValue = m_alphaRealPos >= 0 ?
+            m_toDoubleFuncPtr[m_alphaCachePos](data, m_alphaRealPos) : 1.0;
+
+        for (quint32 k = 0; k < m_convolveChannelsNo; ++k) {
+            if (k != (quint32)m_alphaCachePos) {
+                const quint32 channelPos = m_convChannelList[k]->pos();
+                dst[k] = m_toDoubleFuncPtr[k](data, channelPos) * alphaValue;
+            } else {
+                dst[k] = alphaValue;
+            }
+        }
+    }
+
+    inline void limitValue(qreal *value, qreal lowBound, qreal highBound) {
+        if (*value > highBound) {
+            *value = highBound;
+        } else if (!(*value >= lowBound)) {  // value < lowBound or value == NaN
+            *value = lowBound;
+        }
+    }
+
+    inline qreal writeChannel(quint8 *dstPtr, quint32 channel, qreal value) {
+        limitValue(&value, m_minClamp[channel], m_maxClamp[channel]);
+
+        const quint32 channelPos = m_convChannelList[channel]->pos();
+        m_fromDoubleFuncPtr[channel](dstPtr, channelPos, value);
+
+        return value;
+    }
+
+    inline void storePixel(const qreal *filtered, quint8 *dstPtr) {
+        if (m_alphaCachePos >= 0) {
+            const qreal alphaValue =
+                writeChannel(dstPtr, m_alphaCachePos,
+                             filtered[m_alphaCachePos] * m_gain + m_absoluteOffset[m_alphaCachePos]);
+
+            if (alphaValue != 0.0) {
+                const qreal alphaValueInv = 1.0 / alphaValue;
+
+                for (quint32 k = 0; k < m_convolveChannelsNo; ++k) {
+                    if (k == (quint32)m_alphaCachePos) continue;
+                    writeChannel(dstPtr, k, filtered[k] * m_gain * alphaValueInv + m_absoluteOffset[k]);
+                }
+            } else {
+                for (quint32 k = 0; k < m_convolveChannelsNo; ++k) {
+                    if (k == (quint32)m_alphaCachePos) continue;
+
+                    const qreal zeroValue = 0.0;
+                    const quint32 channelPos = m_convChannelList[k]->pos();
+                    m_fromDoubleFuncPtr[k](dstPtr, channelPos, zeroValue);
+                }
+            }
+        } else {
+            for (quint32 k = 0; k < m_convolveChannelsNo; ++k) {
+                writeChannel(dstPtr, k, filtered[k] * m_gain + m_absoluteOffset[k]);
+            }
+        }
+    }
+
+    void executeHorizontal(const KisPaintDeviceSP src, QPoint srcPos, QPoint dstPos, QSize areaSize, const QRect& dataRect) {
+        const int lineLength = areaSize.width() + 2 * m_padding;
+
+        QVector<qreal> line(lineLength * m_convolveChannelsNo);
+        QVector<quint8> rawLine(lineLength * m_pixelSize);
+
+        bool hasProgressUpdater = this->m_progress;
+        if (hasProgressUpdater) {
+            this->m_progress->setProgress(0);
+            this->m_progress->setRange(0, areaSize.height());
+        }
+
+        typename _IteratorFactory_::HLineIterator hitDst = _IteratorFactory_::createHLineIterator(this->m_painter->device(), dstPos.x(), dstPos.y(), areaSize.width(), dataRect);
+        typename _IteratorFactory_::HLineConstIterator hitSrc = _IteratorFactory_::createHLineConstIterator(src, srcPos.x() - m_padding, srcPos.y(), lineLength, dataRect);
+
+        for (int prow = 0; prow < areaSize.height(); ++prow) {
+            int i = 0;
+            do {
+                const quint8 *data = hitSrc->oldRawData();
+                memcpy(rawLine.data() + i * m_pixelSize, data, m_pixelSize);
+                loadPixel(data, line.data() + i * m_convolveChannelsNo);
+                i++;
+            } while (hitSrc->nextPixel());
+
+            filterLine(line.data(), lineLength);
+
+            i = m_padding;
+            do {
+                // write original channel values
+                memcpy(hitDst->rawData(), rawLine.constData() + i * m_pixelSize, m_pixelSize);
+                storePixel(line.constData() + i * m_convolveChannelsNo, hitDst->rawData());
+                i++;
+            } while (hitDst->nextPixel());
+
+            hitSrc->nextRow();
+            hitDst->nextRow();
+
+            if (hasProgressUpdater) {
+                this->m_progress->setValue(prow);
+
+                if (this->m_progress->interrupted()) {
+                    return;
+                }
+            }
+        }
+    }
+
+    void executeVertical(const KisPaintDeviceSP src, QPoint srcPos, QPoint dstPos, QSize areaSize, const QRect& dataRect) {
+        const int lineLength = areaSize.height() + 2 * m_padding;
+
+        QVector<qreal> line(lineLength * m_convolveChannelsNo);
+        QVector<quint8> rawLine(lineLength * m_pixelSize);
+
+        bool hasProgressUpdater = this->m_progress;
+        if (hasProgressUpdater) {
+            this->m_progress->setProgress(0);
+            this->m_progress->setRange(0, areaSize.width());
+        }
+
+        typename _IteratorFactory_::VLineIterator vitDst = _IteratorFactory_::createVLineIterator(this->m_painter->device(), dstPos.x(), dstPos.y(), areaSize.height(), dataRect);
+        typename _IteratorFactory_::VLineConstIterator vitSrc = _IteratorFactory_::createVLineConstIterator(src, srcPos.x(), srcPos.y() - m_padding, lineLength, dataRect);
+
+        for (int pcol = 0; pcol < areaSize.width(); ++pcol) {
+            int i = 0;
+            do {
+                const quint8 *data = vitSrc->oldRawData();
+                memcpy(rawLine.data() + i * m_pixelSize, data, m_pixelSize);
+                loadPixel(data, line.data() + i * m_convolveChannelsNo);
+                i++;
+            } while (vitSrc->nextPixel());
+
+            filterLine(line.data(), lineLength);
+
+            i = m_padding;
+            do {
+                // write original channel values
+                memcpy(vitDst->rawData(), rawLine.constData() + i * m_pixelSize, m_pixelSize);
+                storePixel(line.constData() + i * m_convolveChannelsNo, vitDst->rawData());
+                i++;
+            } while (vitDst->nextPixel());
+
+            vitSrc->nextColumn();
+            vitDst->nextColumn();
+
+            if (hasProgressUpdater) {
+                this->m_progress->setValue(pcol);
+
+                if (this->m_progress->interrupted()) {
+                    return;
+                }
+            }
+        }
+    }
+
+private:
+    qreal m_sigma;
+    qreal m_B, m_b1, m_b2, m_b3;
+
+    int m_padding;
+    quint32 m_pixelSize;
+    quint32 m_convolveChannelsNo;
+
+    int m_alphaCachePos;
+    int m_alphaRealPos;
+
+    qreal m_gain;
+    QVector<qreal> m_minClamp, m_maxClamp, m_absoluteOffset;
+
+    QList<KoChannelInfo *> m_convChannelList;
+    QVector<PtrToDouble> m_toDoubleFuncPtr;
+    QVector<PtrFromDouble> m_fromDoubleFuncPtr;
+};
+
+#endif /* KIS_CONVOLUTION_WORKER_IIR_H */
@@ -0,0 +1,173 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_fftw_plan_cache.h"
+
+#ifdef HAVE_FFTW3
+
+#include <QGlobalStatic>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QHash>
+#include <QLinkedList>
+#include <QPair>
+
+#include "kis_assert.h"
+
+/**
+ * Different sizes of the transforms are rare: every filter
+ * mask uses one or two of them for its whole life
+ */
+#define MAX_CACHED_PLANS 32
+
+Q_GLOBAL_STATIC(KisFFTWPlanCache, s_instance)
+Q_GLOBAL_STATIC(QMutex, s_plannerMutex)
+
+
+KisFFTWPlanCache::Plans::Plans(int _width, int _height)
+    : width(_width),
+      height(_height)
+{
+    const int length = height * (width / 2 + 1);
+
+    /**
+     * FFTW_ESTIMATE doesn't touch the data, the buffer is needed
+     * only to define the layout and the alignment of the plans
+     */
+    fftw_complex *buffer = (fftw_complex *)fftw_malloc(sizeof(fftw_complex) * length);
+
+    QMutexLocker l(plannerMutex());
+    forward = fftw_plan_dft_r2c_2d(height, width, (double*)buffer, buffer, FFTW_ESTIMATE);
+    backward = fftw_plan_dft_c2r_2d(height, width, buffer, (double*)buffer, FFTW_ESTIMATE);
+
+    fftw_free(buffer);
+}
+
+KisFFTWPlanCache::Plans::~Plans()
+{
+    QMutexLocker l(plannerMutex());
+    fftw_destroy_plan(forward);
+    fftw_destroy_plan(backward);
+}
+
+
+typedef QPair<int, int> PlansKey;
+
+struct KisFFTWPlanCache::Private
+{
+    Private() : numHits(0), numMisses(0) {}
+
+    mutable QMutex mutex;
+    QHash<PlansKey, PlansSP> plans;
+
+    // the most recently used plans are at the end
+    QLinkedList<PlansKey> usageOrder;
+
+    qint64 numHits;
+    qint64 numMisses;
+};
+
+KisFFTWPlanCache::KisFFTWPlanCache()
+    : m_d(new Private)
+{
+}
+
+KisFFTWPlanCache::~KisFFTWPlanCache()
+{
+}
+
+KisFFTWPlanCache* KisFFTWPlanCache::instance()
+{
+    return s_instance;
+}
+
+QMutex* KisFFTWPlanCache::plannerMutex()
+{
+    return s_plannerMutex;
+}
+
+KisFFTWPlanCache::PlansSP KisFFTWPlanCache::plans(int width, int height)
+{
+    const PlansKey key(width, height);
+
+    {
+        QMutexLocker l(&m_d->mutex);
+
+        PlansSP plans = m_d->plans.value(key);
+        if (plans) {
+            m_d->usageOrder.removeOne(key);
+            m_d->usageOrder.append(key);
+            m_d->numHits++;
+            return plans;
+        }
+    }
+
+    /**
+     * The plans are created outside the cache lock, so the threads
+     * that hit the cache don't wait for the planner. Two threads may
+     * create the same plans at once, then the first one wins.
+     */
+    PlansSP newPlans(new Plans(width, height));
+    KIS_SAFE_ASSERT_RECOVER_NOOP(newPlans->forward && newPlans->backward);
+
+    QMutexLocker l(&m_d->mutex);
+
+    PlansSP plans = m_d->plans.value(key);
+    if (plans) {
+        m_d->numHits++;
+        return plans;
+    }
+
+    m_d->numMisses++;
+
+    m_d->plans.insert(key, newPlans);
+    m_d->usageOrder.append(key);
+
+    while (m_d->usageOrder.size() > MAX_CACHED_PLANS) {
+        m_d->plans.remove(m_d->usageOrder.takeFirst());
+    }
+
+    return newPlans;
+}
+
+int KisFFTWPlanCache::numCachedPlans() const
+{
+    QMutexLocker l(&m_d->mutex);
+    return m_d->plans.size();
+}
+
+qint64 KisFFTWPlanCache::numHits() const
+{
+    QMutexLocker l(&m_d->mutex);
+    return m_d->numHits;
+}
+
+qint64 KisFFTWPlanCache::numMisses() const
+{
+    QMutexLocker l(&m_d->mutex);
+    return m_d->numMisses;
+}
+
+void KisFFTWPlanCache::clear()
+{
+    QMutexLocker l(&m_d->mutex);
+    m_d->plans.clear();
+    m_d->usageOrder.clear();
+}
+
+#endif /* HAVE_FFTW3 */
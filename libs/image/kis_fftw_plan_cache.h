@@ -0,0 +1,98 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_FFTW_PLAN_CACHE_H
+#define __KIS_FFTW_PLAN_CACHE_H
+
+#include "config_convolution.h"
+
+#ifdef HAVE_FFTW3
+
+#include <QSharedPointer>
+#include <QScopedPointer>
+#include <fftw3.h>
+
+#include "kritaimage_export.h"
+
+class QMutex;
+
+/**
+ * A process-wide cache of the FFTW plans used by the FFT convolution.
+ *
+ * The plans are two-dimensional in-place real-to-complex and
+ * complex-to-real transforms over the rows padded to
+ * 2 * (width / 2 + 1) doubles, so they are fully defined by the size
+ * of the transform. They are created on the buffers allocated with
+ * fftw_malloc(), so they can be executed on any other buffer of the
+ * same size and layout allocated the same way, using
+ * fftw_execute_dft_r2c()/fftw_execute_dft_c2r().
+ *
+ * FFTW's planner is not reentrant, so the plans are created and
+ * destroyed under plannerMutex(). Executing a plan is thread-safe
+ * and needs no locking, so the threads which reuse a cached plan
+ * never wait for each other.
+ */
+class KRITAIMAGE_EXPORT KisFFTWPlanCache
+{
+public:
+    struct KRITAIMAGE_EXPORT Plans {
+        Plans(int width, int height);
+        ~Plans();
+
+        const int width;
+        const int height;
+
+        fftw_plan forward;
+        fftw_plan backward;
+    };
+
+    typedef QSharedPointer<Plans> PlansSP;
+
+public:
+    KisFFTWPlanCache();
+    ~KisFFTWPlanCache();
+
+    static KisFFTWPlanCache* instance();
+
+    /**
+     * The mutex that protects FFTW's planner. Every direct call to
+     * fftw_plan_* or fftw_destroy_plan() must hold it.
+     */
+    static QMutex* plannerMutex();
+
+    /**
+     * Returns the plans for the transform of \p width x \p height
+     * doubles. The plans stay valid while the returned pointer is
+     * alive, even if they have already been dropped from the cache.
+     */
+    PlansSP plans(int width, int height);
+
+    int numCachedPlans() const;
+    qint64 numHits() const;
+    qint64 numMisses() const;
+
+    void clear();
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* HAVE_FFTW3 */
+
+#endif /* __KIS_FFTW_PLAN_CACHE_H */
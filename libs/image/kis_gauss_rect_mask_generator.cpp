@@ -31,6 +31,9 @@
 
 #include "kis_base_mask_generator.h"
 #include "kis_gauss_rect_mask_generator.h"
+#include "kis_gauss_rect_mask_generator_p.h"
+#include "kis_brush_mask_applicator_factories.h"
+#include "kis_brush_mask_applicator_base.h"
 #include "kis_antialiasing_fade_maker.h"
 
 #define M_SQRT_2 1.41421356237309504880
@@ -41,42 +44,19 @@
 #define erf(x) boost::math::erf(x)
 #endif
 
-struct Q_DECL_HIDDEN KisGaussRectangleMaskGenerator::Private
-{
-    Private(bool enableAntialiasing)
-        : fadeMaker(*this, enableAntialiasing)
-    {
-    }
-
-    Private(const Private &rhs)
-        : xfade(rhs.xfade),
-        yfade(rhs.yfade),
-        halfWidth(rhs.halfWidth),
-        halfHeight(rhs.halfHeight),
-        alphafactor(rhs.alphafactor),
-        fadeMaker(rhs.fadeMaker, *this)
-    {
-    }
-
-    qreal xfade, yfade;
-    qreal halfWidth, halfHeight;
-    qreal alphafactor;
-
-    KisAntialiasingFadeMaker2D <Private> fadeMaker;
-
-    inline quint8 value(qreal x, qreal y) const;
-};
-
 KisGaussRectangleMaskGenerator::KisGaussRectangleMaskGenerator(qreal diameter, qreal ratio, qreal fh, qreal fv, int spikes, bool antialiasEdges)
     : KisMaskGenerator(diameter, ratio, fh, fv, spikes, antialiasEdges, RECTANGLE, GaussId), d(new Private(antialiasEdges))
 {
     setScale(1.0, 1.0);
+
+    d->applicator.reset(createOptimizedClass<MaskApplicatorFactory<KisGaussRectangleMaskGenerator, KisBrushMaskVectorApplicator> >(this));
 }
 
 KisGaussRectangleMaskGenerator::KisGaussRectangleMaskGenerator(const KisGaussRectangleMaskGenerator &rhs)
     : KisMaskGenerator(rhs),
       d(new Private(*rhs.d))
 {
+    d->applicator.reset(createOptimizedClass<MaskApplicatorFactory<KisGaussRectangleMaskGenerator, KisBrushMaskVectorApplicator> >(this));
 }
 
 KisMaskGenerator* KisGaussRectangleMaskGenerator::clone() const
@@ -106,6 +86,16 @@ KisGaussRectangleMaskGenerator::~KisGaussRectangleMaskGenerator()
 {
 }
 
+bool KisGaussRectangleMaskGenerator::shouldVectorize() const
+{
+    return !shouldSupersample() && spikes() == 2;
+}
+
+KisBrushMaskApplicatorBase* KisGaussRectangleMaskGenerator::applicator()
+{
+    return d->applicator.data();
+}
+
 inline quint8 KisGaussRectangleMaskGenerator::Private::value(qreal xr, qreal yr) const
 {
     return (quint8) 255 - (quint8) (alphafactor * (erf((halfWidth + xr) * xfade) + erf((halfWidth - xr) * xfade))
@@ -29,7 +29,8 @@
  */
 class KRITAIMAGE_EXPORT KisGaussRectangleMaskGenerator : public KisMaskGenerator
 {
-
+public:
+    struct FastRowProcessor;
 public:
 
     KisGaussRectangleMaskGenerator(qreal diameter, qreal ratio, qreal fh, qreal fv, int spikes, bool antialiasEdges);
@@ -40,6 +41,9 @@ public:
     quint8 valueAt(qreal x, qreal y) const override;
     void setScale(qreal scaleX, qreal scaleY) override;
 
+    bool shouldVectorize() const override;
+    KisBrushMaskApplicatorBase* applicator() override;
+
 private:
     struct Private;
     const QScopedPointer<Private> d;
@@ -34,6 +34,41 @@ int KisGaussianKernel::kernelSizeFromRadius(qreal radius)
     return 6 * ceil(sigmaFromRadius(radius)) + 1;
 }
 
+qreal KisGaussianKernel::sigmaFromKernel(const KisConvolutionKernelSP kernel)
+{
+    if (kernel->width() != 1 && kernel->height() != 1) return 0.0;
+
+    const Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> &matrix = *kernel->data();
+    const int size = matrix.size();
+
+    if (size < 3 || !(size & 0x1)) return 0.0;
+
+    const int center = size / 2;
+    const qreal centerValue = matrix(center);
+    const qreal nextValue = matrix(center + 1);
+
+    if (centerValue <= 0.0 || nextValue <= 0.0 || nextValue >= centerValue) return 0.0;
+
+    // exp(-1 / (2 * sigma^2)) == nextValue / centerValue
+    const qreal sigma = std::sqrt(-0.5 / std::log(nextValue / centerValue));
+
+    /**
+     * All the other values must follow the same Gaussian
+     */
+    const qreal exponentMultiplicand = 1 / (2 * sigma * sigma);
+    const qreal tolerance = 1e-3 * centerValue;
+
+    for (int i = 0; i < size; i++) {
+        const qreal distance = center - i;
+        const qreal expectedValue = centerValue * exp(-distance * distance * exponentMultiplicand);
+
+        if (qAbs(matrix(i) - expectedValue) > tolerance) {
+            return 0.0;
+        }
+    }
+
+    return sigma;
+}
 
 Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic>
 KisGaussianKernel::createHorizontalMatrix(qreal radius)
@@ -99,11 +134,29 @@ KisGaussianKernel::createVerticalKernel(qreal radius)
     return KisConvolutionKernel::fromMatrix(matrix, 0, matrix.sum());
 }
 
+namespace {
+
+/**
+ * The recursive filter wins over the other engines only
+ * when the kernel is big
+ */
+const qreal IIR_THRESHOLD_SIGMA = 16.0;
+
+KisConvolutionPainter::EnginePreference gaussianEngine(qreal radius, bool allowApproximation)
+{
+    return allowApproximation &&
+        KisGaussianKernel::sigmaFromRadius(radius) >= IIR_THRESHOLD_SIGMA ?
+        KisConvolutionPainter::IIR_GAUSSIAN : KisConvolutionPainter::NONE;
+}
+
+}
+
 void KisGaussianKernel::applyGaussian(KisPaintDeviceSP device,
                                       const QRect& rect,
                                       qreal xRadius, qreal yRadius,
                                       const QBitArray &channelFlags,
-                                      KoUpdater *progressUpdater)
+                                      KoUpdater *progressUpdater,
+                                      bool allowApproximation)
 {
     QPoint srcTopLeft = rect.topLeft();
 
@@ -115,7 +168,7 @@ void KisGaussianKernel::applyGaussian(KisPaintDeviceSP device,
 
         qreal verticalCenter = qreal(kernelVertical->height()) / 2.0;
 
-        KisConvolutionPainter horizPainter(interm);
+        KisConvolutionPainter horizPainter(interm, gaussianEngine(xRadius, allowApproximation));
         horizPainter.setChannelFlags(channelFlags);
         horizPainter.setProgress(progressUpdater);
         horizPainter.applyMatrix(kernelHoriz, device,
@@ -124,13 +177,13 @@ void KisGaussianKernel::applyGaussian(KisPaintDeviceSP device,
                                  rect.size() + QSize(0, 2 * ceil(verticalCenter)), BORDER_REPEAT);
 
 
-        KisConvolutionPainter verticalPainter(device);
+        KisConvolutionPainter verticalPainter(device, gaussianEngine(yRadius, allowApproximation));
         verticalPainter.setChannelFlags(channelFlags);
         verticalPainter.setProgress(progressUpdater);
         verticalPainter.applyMatrix(kernelVertical, interm, srcTopLeft, srcTopLeft, rect.size(), BORDER_REPEAT);
 
     } else if (xRadius > 0.0) {
-        KisConvolutionPainter painter(device);
+        KisConvolutionPainter painter(device, gaussianEngine(xRadius, allowApproximation));
         painter.setChannelFlags(channelFlags);
         painter.setProgress(progressUpdater);
 
@@ -138,7 +191,7 @@ void KisGaussianKernel::applyGaussian(KisPaintDeviceSP device,
         painter.applyMatrix(kernelHoriz, device, srcTopLeft, srcTopLeft, rect.size(), BORDER_REPEAT);
 
     } else if (yRadius > 0.0) {
-        KisConvolutionPainter painter(device);
+        KisConvolutionPainter painter(device, gaussianEngine(yRadius, allowApproximation));
         painter.setChannelFlags(channelFlags);
         painter.setProgress(progressUpdater);
 
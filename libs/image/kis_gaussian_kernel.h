@@ -44,11 +44,30 @@ public:
     static qreal sigmaFromRadius(qreal radius);
     static int kernelSizeFromRadius(qreal radius);
 
+    /**
+     * Checks if \p kernel is a one-dimensional sampled Gaussian (like
+     * the ones created by createHorizontalKernel() and
+     * createVerticalKernel()) and returns its sigma. Returns 0.0 if
+     * the kernel is not a Gaussian one.
+     */
+    static qreal sigmaFromKernel(const KisConvolutionKernelSP kernel);
+
+    /**
+     * Blurs \p rect of \p device with a separable Gaussian kernel.
+     *
+     * If \p allowApproximation is true, the big kernels are applied
+     * with the recursive IIR engine (see
+     * KisConvolutionPainter::IIR_GAUSSIAN), whose cost doesn't depend
+     * on the radius. The result is slightly different from the exact
+     * convolution, so it should be enabled only by the users that
+     * don't need the exact values.
+     */
     static void applyGaussian(KisPaintDeviceSP device,
                               const QRect& rect,
                               qreal xRadius, qreal yRadius,
                               const QBitArray &channelFlags,
-                              KoUpdater *updater);
+                              KoUpdater *updater,
+                              bool allowApproximation = false);
 
     static Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> createLoGMatrix(qreal radius, qreal coeff = 1.0);
 
@@ -23,6 +23,9 @@
 #include <algorithm>
 
 #include <QImage>
+#include <QHash>
+#include <QPair>
+#include <QtConcurrent>
 
 #include "kis_algebra_2d.h"
 #include "kis_four_point_interpolator_forward.h"
@@ -184,7 +187,19 @@ struct PaintDevicePolygonOp
     }
 
     void operator() (const QPolygonF &srcPolygon, const QPolygonF &dstPolygon, const QPolygonF &clipDstPolygon) {
+        this->operator() (srcPolygon, dstPolygon, clipDstPolygon, QRect());
+    }
+
+    /**
+     * Resamples only the part of the polygon that lays inside \p limitRect
+     * (a null rect means no limit). Calls with non-overlapping limit rects
+     * may be done concurrently.
+     */
+    void operator() (const QPolygonF &srcPolygon, const QPolygonF &dstPolygon, const QPolygonF &clipDstPolygon, const QRect &limitRect) {
         QRect boundRect = clipDstPolygon.boundingRect().toAlignedRect();
+        if (!limitRect.isNull()) {
+            boundRect &= limitRect;
+        }
         if (boundRect.isEmpty()) return;
 
         KisSequentialIterator dstIt(m_dstDev, boundRect);
@@ -238,8 +253,18 @@ struct QImagePolygonOp
           m_srcImageOffset(srcImageOffset),
           m_dstImageOffset(dstImageOffset),
           m_srcImageRect(m_srcImage.rect()),
-          m_dstImageRect(m_dstImage.rect())
+          m_dstImageRect(m_dstImage.rect()),
+          m_srcBits(reinterpret_cast<const QRgb*>(m_srcImage.constBits())),
+          m_dstBits(reinterpret_cast<QRgb*>(m_dstImage.bits())),
+          m_srcPixelsPerLine(m_srcImage.bytesPerLine() / sizeof(QRgb)),
+          m_dstPixelsPerLine(m_dstImage.bytesPerLine() / sizeof(QRgb))
     {
+        /**
+         * The pixels are accessed directly (QImage::setPixel() is not
+         * reentrant), so only 32-bit images are supported
+         */
+        KIS_ASSERT_RECOVER_NOOP(m_srcImage.depth() == 32);
+        KIS_ASSERT_RECOVER_NOOP(m_dstImage.depth() == 32);
     }
 
     void operator() (const QPolygonF &srcPolygon, const QPolygonF &dstPolygon) {
@@ -247,7 +272,21 @@ struct QImagePolygonOp
     }
 
     void operator() (const QPolygonF &srcPolygon, const QPolygonF &dstPolygon, const QPolygonF &clipDstPolygon) {
+        this->operator() (srcPolygon, dstPolygon, clipDstPolygon, QRect());
+    }
+
+    /**
+     * Resamples only the part of the polygon that lays inside \p limitRect
+     * (a null rect means no limit). Calls with non-overlapping limit rects
+     * may be done concurrently.
+     */
+    void operator() (const QPolygonF &srcPolygon, const QPolygonF &dstPolygon, const QPolygonF &clipDstPolygon, const QRect &limitRect) {
         QRect boundRect = clipDstPolygon.boundingRect().toAlignedRect();
+        if (!limitRect.isNull()) {
+            boundRect &= limitRect;
+        }
+        if (boundRect.isEmpty()) return;
+
         KisFourPointInterpolatorBackward interp(srcPolygon, dstPolygon);
 
         for (int y = boundRect.top(); y <= boundRect.bottom(); y++) {
@@ -272,7 +311,8 @@ struct QImagePolygonOp
                     if (!m_dstImageRect.contains(srcPointI)) continue;
                     if (!m_srcImageRect.contains(dstPointI)) continue;
 
-                    m_dstImage.setPixel(srcPointI, m_srcImage.pixel(dstPointI));
+                    m_dstBits[srcPointI.y() * m_dstPixelsPerLine + srcPointI.x()] =
+                        m_srcBits[dstPointI.y() * m_srcPixelsPerLine + dstPointI.x()];
                 }
             }
         }
@@ -299,6 +339,125 @@ struct QImagePolygonOp
 
     QRect m_srcImageRect;
     QRect m_dstImageRect;
+
+    const QRgb *m_srcBits;
+    QRgb *m_dstBits;
+    int m_srcPixelsPerLine;
+    int m_dstPixelsPerLine;
+};
+
+/**
+ * A wrapper around PaintDevicePolygonOp or QImagePolygonOp that resamples
+ * the polygons concurrently.
+ *
+ * The incoming polygons are collected into batches. Every batch is split
+ * into tile-aligned destination patches, and the patches are processed in
+ * the global thread pool. Inside a patch the polygons are processed in the
+ * order they arrived, and the batches are processed one after another, so
+ * every pixel is written by the same polygon as in the serial processing.
+ * That is, the result is bit-identical to calling the wrapped op directly.
+ *
+ * If \p limitRect is not null, only the pixels inside it are processed.
+ * It is used for partial updates of the previously rendered image.
+ *
+ * Don't forget to call flush() after the iteration is completed.
+ */
+template <class PolygonOp>
+struct MultithreadedPolygonOp
+{
+    MultithreadedPolygonOp(PolygonOp &polygonOp,
+                           const QRect &limitRect = QRect(),
+                           bool useMultithreading = true)
+        : m_polygonOp(polygonOp),
+          m_limitRect(limitRect),
+          m_useMultithreading(useMultithreading)
+    {
+    }
+
+    ~MultithreadedPolygonOp() {
+        flush();
+    }
+
+    void operator() (const QPolygonF &srcPolygon, const QPolygonF &dstPolygon) {
+        this->operator() (srcPolygon, dstPolygon, dstPolygon);
+    }
+
+    void operator() (const QPolygonF &srcPolygon, const QPolygonF &dstPolygon, const QPolygonF &clipDstPolygon) {
+        QRect boundRect = clipDstPolygon.boundingRect().toAlignedRect();
+        if (!m_limitRect.isNull()) {
+            boundRect &= m_limitRect;
+        }
+        if (boundRect.isEmpty()) return;
+
+        if (!m_useMultithreading) {
+            m_polygonOp(srcPolygon, dstPolygon, clipDstPolygon, m_limitRect);
+            return;
+        }
+
+        const int index = m_polygons.size();
+        m_polygons.append({srcPolygon, dstPolygon, clipDstPolygon});
+
+        const int firstCol = divideFloor(boundRect.left());
+        const int lastCol = divideFloor(boundRect.right());
+        const int firstRow = divideFloor(boundRect.top());
+        const int lastRow = divideFloor(boundRect.bottom());
+
+        for (int row = firstRow; row <= lastRow; row++) {
+            for (int col = firstCol; col <= lastCol; col++) {
+                m_patches[qMakePair(col, row)].append(index);
+            }
+        }
+
+        if (m_polygons.size() >= BatchSize) {
+            flush();
+        }
+    }
+
+    void flush() {
+        if (m_polygons.isEmpty()) return;
+
+        QVector<PatchIndex> patches = m_patches.keys().toVector();
+
+        QtConcurrent::blockingMap(patches,
+            [this] (const PatchIndex &patch) {
+                QRect patchRect(patch.first * PatchSize, patch.second * PatchSize, PatchSize, PatchSize);
+                if (!m_limitRect.isNull()) {
+                    patchRect &= m_limitRect;
+                }
+
+                Q_FOREACH (int index, m_patches.value(patch)) {
+                    const Polygon &p = m_polygons.at(index);
+                    m_polygonOp(p.srcPolygon, p.dstPolygon, p.clipDstPolygon, patchRect);
+                }
+            });
+
+        m_polygons.clear();
+        m_patches.clear();
+    }
+
+private:
+    static inline int divideFloor(int value) {
+        return value >= 0 ? value / PatchSize : -((-value + PatchSize - 1) / PatchSize);
+    }
+
+private:
+    static const int PatchSize = 256;
+    static const int BatchSize = 8192;
+
+    typedef QPair<int, int> PatchIndex;
+
+    struct Polygon {
+        QPolygonF srcPolygon;
+        QPolygonF dstPolygon;
+        QPolygonF clipDstPolygon;
+    };
+
+    PolygonOp &m_polygonOp;
+    QRect m_limitRect;
+    bool m_useMultithreading;
+
+    QVector<Polygon> m_polygons;
+    QHash<PatchIndex, QVector<int>> m_patches;
 };
 
 /*************************************************************/
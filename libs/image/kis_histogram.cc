@@ -27,11 +27,13 @@
 #include "KoColorSpace.h"
 #include "kis_debug.h"
 #include "kis_iterator_ng.h"
+#include "kis_histogram_cache.h"
 
 KisHistogram::KisHistogram(const KisPaintLayerSP layer,
                            KoHistogramProducer *producer,
                            const enumHistogramType type)
-    : m_paintDevice(layer->projection())
+    : m_paintDevice(layer->projection()),
+      m_cache(0)
 {
     Q_ASSERT(producer);
 
@@ -50,8 +52,10 @@ KisHistogram::KisHistogram(const KisPaintLayerSP layer,
 KisHistogram::KisHistogram(const KisPaintDeviceSP paintdev,
                            const QRect &bounds,
                            KoHistogramProducer *producer,
-                           const enumHistogramType type)
-    : m_paintDevice(paintdev)
+                           const enumHistogramType type,
+                           KisHistogramCache *cache)
+    : m_paintDevice(paintdev),
+      m_cache(cache)
 {
     Q_ASSERT(producer);
 
@@ -85,6 +89,12 @@ void KisHistogram::updateHistogram()
         return;
     }
 
+    if (m_cache) {
+        m_cache->computeHistogram(m_paintDevice, m_bounds, m_producer);
+        computeHistogram();
+        return;
+    }
+
     KisSequentialConstIterator srcIt(m_paintDevice, m_bounds);
     const KoColorSpace* cs = m_paintDevice->colorSpace();
 
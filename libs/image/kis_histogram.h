@@ -28,6 +28,8 @@
 #include "kis_types.h"
 #include "kritaimage_export.h"
 
+class KisHistogramCache;
+
 enum enumHistogramType {
     LINEAR,
     LOGARITHMIC
@@ -109,10 +111,17 @@ public:
                  KoHistogramProducer *producer,
                  const enumHistogramType type);
 
+    /**
+     * If \p cache is not null, the histogram is computed with the
+     * cache, so only the changed parts of \p paintdev are rescanned.
+     * The cache should create the producers of the same kind as
+     * \p producer and must outlive the histogram.
+     */
     KisHistogram(KisPaintDeviceSP paintdev,
                  const QRect &bounds,
                  KoHistogramProducer *producer,
-                 const enumHistogramType type);
+                 const enumHistogramType type,
+                 KisHistogramCache *cache = 0);
 
     virtual ~KisHistogram();
 
@@ -182,6 +191,7 @@ private:
     const KisPaintDeviceSP m_paintDevice;
     QRect m_bounds;
     KoHistogramProducer *m_producer;
+    KisHistogramCache *m_cache;
     enumHistogramType m_type;
 
     qint32 m_channel;
@@ -0,0 +1,250 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_histogram_cache.h"
+
+#include <QHash>
+#include <QPair>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QtConcurrent>
+
+#include <KoColorSpace.h>
+#include <KoHistogramProducer.h>
+
+#include "kis_paint_device.h"
+#include "kis_datamanager.h"
+#include "kis_iterator_ng.h"
+
+
+struct KisHistogramCache::Private
+{
+    /**
+     * The size of a cell must be a multiple of the tile size. A cell
+     * of 4x4 tiles keeps the cache of a 100 MPx image within a few
+     * megabytes, while a stroke still invalidates only a small part
+     * of the image.
+     */
+    static const int CELL_SIZE = 256;
+
+    struct Cell {
+        QRect rect;
+        QVector<quint64> versions;
+        QSharedPointer<KoHistogramProducer> producer;
+    };
+
+    typedef QPair<int, int> CellIndex;
+
+    Private(ProducerFactory _producerFactory)
+        : producerFactory(_producerFactory),
+          colorSpace(0),
+          viewFrom(0.0),
+          viewWidth(1.0)
+    {
+    }
+
+    ProducerFactory producerFactory;
+
+    QHash<CellIndex, Cell> cells;
+    const KoColorSpace *colorSpace;
+    QString producerId;
+    QPoint offset;
+    qreal viewFrom;
+    qreal viewWidth;
+
+    /**
+     * Guards the cached cells only, the cells are scanned with
+     * the mutex unlocked
+     */
+    QMutex mutex;
+
+    bool isCompatible(KisPaintDeviceSP device, KoHistogramProducer *producer) const {
+        return colorSpace == device->colorSpace() &&
+            offset == QPoint(device->x(), device->y()) &&
+            producerId == producer->id().id() &&
+            viewFrom == producer->viewFrom() &&
+            viewWidth == producer->viewWidth();
+    }
+
+    static bool isStable(const QVector<quint64> &versions) {
+        // zero version means the tile is being written right now
+        return !versions.contains(0);
+    }
+
+    static int divideRoundDown(int x, int y) {
+        return x >= 0 ? x / y : -(((-x - 1) / y) + 1);
+    }
+
+    static void addRectToBins(KisPaintDeviceSP device, const QRect &rect, KoHistogramProducer *producer);
+};
+
+void KisHistogramCache::Private::addRectToBins(KisPaintDeviceSP device, const QRect &rect, KoHistogramProducer *producer)
+{
+    const KoColorSpace *cs = device->colorSpace();
+    KisSequentialConstIterator it(device, rect);
+
+    int numConseqPixels = it.nConseqPixels();
+    while (it.nextPixels(numConseqPixels)) {
+        numConseqPixels = it.nConseqPixels();
+        producer->addRegionToBin(it.rawDataConst(), 0, numConseqPixels, cs);
+    }
+}
+
+KisHistogramCache::KisHistogramCache(ProducerFactory producerFactory)
+    : m_d(new Private(producerFactory))
+{
+}
+
+KisHistogramCache::~KisHistogramCache()
+{
+}
+
+void KisHistogramCache::clear()
+{
+    QMutexLocker l(&m_d->mutex);
+    m_d->cells.clear();
+}
+
+void KisHistogramCache::computeHistogram(KisPaintDeviceSP device, const QRect &rect, KoHistogramProducer *producer)
+{
+    producer->clear();
+    if (rect.isEmpty()) return;
+
+    /**
+     * The producer may be different on every call, so check if it
+     * can accept the bins of the cached ones every time. Creating
+     * an empty producer is cheap compared to the scan.
+     */
+    {
+        QScopedPointer<KoHistogramProducer> emptyProducer(m_d->producerFactory());
+        emptyProducer->setView(producer->viewFrom(), producer->viewWidth());
+
+        if (!producer->addBinsFrom(emptyProducer.data())) {
+            Private::addRectToBins(device, rect, producer);
+            return;
+        }
+    }
+
+    const QPoint offset(device->x(), device->y());
+    KisDataManagerSP dataManager = device->dataManager();
+
+    /**
+     * The cells are aligned to the tiles of the data manager,
+     * which is shifted by the offset of the device
+     */
+    const QRect dmRect = rect.translated(-offset);
+
+    const int firstColumn = Private::divideRoundDown(dmRect.left(), Private::CELL_SIZE);
+    const int lastColumn = Private::divideRoundDown(dmRect.right(), Private::CELL_SIZE);
+    const int firstRow = Private::divideRoundDown(dmRect.top(), Private::CELL_SIZE);
+    const int lastRow = Private::divideRoundDown(dmRect.bottom(), Private::CELL_SIZE);
+
+    QHash<Private::CellIndex, Private::Cell> cells;
+    cells.reserve((lastColumn - firstColumn + 1) * (lastRow - firstRow + 1));
+
+    {
+        QMutexLocker l(&m_d->mutex);
+
+        if (!m_d->isCompatible(device, producer)) {
+            m_d->cells.clear();
+            m_d->colorSpace = device->colorSpace();
+            m_d->offset = offset;
+            m_d->producerId = producer->id().id();
+            m_d->viewFrom = producer->viewFrom();
+            m_d->viewWidth = producer->viewWidth();
+        }
+
+        for (int row = firstRow; row <= lastRow; row++) {
+            for (int column = firstColumn; column <= lastColumn; column++) {
+                const Private::CellIndex index(column, row);
+
+                const QRect cellDmRect =
+                    QRect(column * Private::CELL_SIZE, row * Private::CELL_SIZE,
+                          Private::CELL_SIZE, Private::CELL_SIZE) & dmRect;
+
+                Private::Cell cell;
+                cell.rect = cellDmRect.translated(offset);
+
+                /**
+                 * The versions are fetched before the cell is scanned.
+                 * A tile being written has zero version and every write
+                 * assigns a new version on completion, so if the device
+                 * is changed in the meantime, the cell will be rescanned
+                 * on the next call.
+                 */
+                cell.versions = dataManager->contentsVersions(cellDmRect);
+
+                auto it = m_d->cells.constFind(index);
+                if (it != m_d->cells.constEnd() &&
+                    it->rect == cell.rect &&
+                    it->versions == cell.versions) {
+
+                    cell.producer = it->producer;
+                }
+
+                cells.insert(index, cell);
+            }
+        }
+
+        // the cells outside the rect are dropped to limit memory usage
+        QHash<Private::CellIndex, Private::Cell> cleanCells;
+        for (auto it = cells.constBegin(); it != cells.constEnd(); ++it) {
+            if (it->producer) {
+                cleanCells.insert(it.key(), it.value());
+            }
+        }
+        m_d->cells.swap(cleanCells);
+    }
+
+    QVector<Private::Cell*> dirtyCells;
+    for (auto it = cells.begin(); it != cells.end(); ++it) {
+        if (!it->producer) {
+            it->producer.reset(m_d->producerFactory());
+            it->producer->setView(producer->viewFrom(), producer->viewWidth());
+            dirtyCells.append(&it.value());
+        }
+    }
+
+    QtConcurrent::blockingMap(dirtyCells,
+        [device] (Private::Cell *cell) {
+            Private::addRectToBins(device, cell->rect, cell->producer.data());
+        });
+
+    {
+        QMutexLocker l(&m_d->mutex);
+
+        /**
+         * Someone could have requested a histogram with different
+         * settings while we were scanning
+         */
+        if (m_d->isCompatible(device, producer)) {
+            Q_FOREACH (Private::Cell *cell, dirtyCells) {
+                if (Private::isStable(cell->versions)) {
+                    m_d->cells.insert(Private::CellIndex(
+                                          Private::divideRoundDown(cell->rect.x() - offset.x(), Private::CELL_SIZE),
+                                          Private::divideRoundDown(cell->rect.y() - offset.y(), Private::CELL_SIZE)),
+                                      *cell);
+                }
+            }
+        }
+    }
+
+    Q_FOREACH (const Private::Cell &cell, cells) {
+        producer->addBinsFrom(cell.producer.data());
+    }
+}
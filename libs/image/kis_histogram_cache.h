@@ -0,0 +1,82 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_HISTOGRAM_CACHE_H
+#define __KIS_HISTOGRAM_CACHE_H
+
+#include <functional>
+
+#include <QScopedPointer>
+#include <QRect>
+
+#include "kis_types.h"
+#include "kritaimage_export.h"
+
+class KoHistogramProducer;
+
+
+/**
+ * KisHistogramCache keeps partial histograms of the cells of a
+ * paint device and computes the histogram of a rect by merging
+ * them. The cells are aligned to the tiles of the device, so after
+ * a stroke only the cells with changed tiles are rescanned, the
+ * rest are taken from the cache (see KisTileData::contentsVersion()).
+ *
+ * The partial histograms are collected by the producers created by
+ * the factory passed to the constructor, they should be configured
+ * in the same way as the producer passed to computeHistogram(). If
+ * the producer cannot merge the bins (see
+ * KoHistogramProducer::addBinsFrom()), the whole rect is scanned
+ * every time.
+ *
+ * The device may be modified while the histogram is being computed.
+ * The cells with tiles being written are not cached, and a write
+ * finishing during the scan makes the scanned cell stale, so the
+ * histogram catches up on the next call. A clone of the device
+ * shares the tiles with the original, so the cached cells stay
+ * valid for it as well.
+ *
+ * The cells are scanned without holding the internal lock, so the
+ * cache can be used from several threads at once.
+ */
+class KRITAIMAGE_EXPORT KisHistogramCache
+{
+public:
+    typedef std::function<KoHistogramProducer*()> ProducerFactory;
+
+public:
+    KisHistogramCache(ProducerFactory producerFactory);
+    ~KisHistogramCache();
+
+    /**
+     * Clears \p producer and fills it with the histogram of \p rect
+     * of \p device. The dirty cells are scanned in parallel.
+     */
+    void computeHistogram(KisPaintDeviceSP device, const QRect &rect, KoHistogramProducer *producer);
+
+    /**
+     * Drops all the cached partial histograms
+     */
+    void clear();
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif /* __KIS_HISTOGRAM_CACHE_H */
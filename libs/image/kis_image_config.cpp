@@ -33,6 +33,7 @@
 #include <QDir>
 
 #include "kis_global.h"
+#include "tiles3/swap/kis_compression_factory.h"
 #include <cmath>
 
 #ifdef Q_OS_OSX
@@ -485,6 +486,105 @@ void KisImageConfig::setUseLodForColorizeMask(bool value)
     m_config.writeEntry("useLodForColorizeMask", value);
 }
 
+QString KisImageConfig::swapTileCompression(bool requestDefault) const
+{
+    /**
+     * The swap file is never read by other versions of Krita,
+     * so we can use the fastest codec available
+     */
+    const QString defaultValue =
+        KisCompressionFactory::isAvailable("LZ4") ?
+        "LZ4" : KisCompressionFactory::defaultCompression();
+
+    return !requestDefault ?
+        m_config.readEntry("swapTileCompression", defaultValue) : defaultValue;
+}
+
+void KisImageConfig::setSwapTileCompression(const QString &value)
+{
+    m_config.writeEntry("swapTileCompression", value);
+}
+
+QString KisImageConfig::fileTileCompression(bool requestDefault) const
+{
+    /**
+     * Older versions of Krita can read LZF-compressed tiles only,
+     * so we don't change the default for the files
+     */
+    const QString defaultValue = KisCompressionFactory::defaultCompression();
+
+    return !requestDefault ?
+        m_config.readEntry("fileTileCompression", defaultValue) : defaultValue;
+}
+
+void KisImageConfig::setFileTileCompression(const QString &value)
+{
+    m_config.writeEntry("fileTileCompression", value);
+}
+
+bool KisImageConfig::useParallelFileLoading(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("useParallelFileLoading", true) : true;
+}
+
+void KisImageConfig::setUseParallelFileLoading(bool value)
+{
+    m_config.writeEntry("useParallelFileLoading", value);
+}
+
+bool KisImageConfig::useTileSwapPriorities(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("useTileSwapPriorities", true) : true;
+}
+
+void KisImageConfig::setUseTileSwapPriorities(bool value)
+{
+    m_config.writeEntry("useTileSwapPriorities", value);
+}
+
+int KisImageConfig::tileSwapRecencyThreshold(bool requestDefault) const
+{
+    /**
+     * The number of swapper cycles a tile should stay untouched
+     * before it is considered as not recently used
+     */
+    return !requestDefault ?
+        m_config.readEntry("tileSwapRecencyThreshold", 1) : 1;
+}
+
+void KisImageConfig::setTileSwapRecencyThreshold(int value)
+{
+    m_config.writeEntry("tileSwapRecencyThreshold", value);
+}
+
+int KisImageConfig::compressedTileTierPercent(bool requestDefault) const
+{
+    /**
+     * The size of the in-memory storage for compressed tiles
+     * in percents of the tiles hard limit. Zero disables it.
+     */
+    return !requestDefault ?
+        m_config.readEntry("compressedTileTierPercent", 25) : 25;
+}
+
+void KisImageConfig::setCompressedTileTierPercent(int value)
+{
+    m_config.writeEntry("compressedTileTierPercent", value);
+}
+
+bool KisImageConfig::shareUniformTiles(bool requestDefault) const
+{
+    return !requestDefault ?
+        m_config.readEntry("shareUniformTiles", true) : true;
+}
+
+void KisImageConfig::setShareUniformTiles(bool value)
+{
+    m_config.writeEntry("shareUniformTiles", value);
+}
+
 int KisImageConfig::maxNumberOfThreads(bool defaultValue) const
 {
     return (defaultValue ? QThread::idealThreadCount() : m_config.readEntry("maxNumberOfThreads", QThread::idealThreadCount()));
@@ -519,3 +619,18 @@ void KisImageConfig::setFpsLimit(int value)
 {
     m_config.writeEntry("fpsLimit", value);
 }
+
+int KisImageConfig::frameCacheMemoryLimit(bool defaultValue) const
+{
+    /**
+     * The animation frames are stored compressed, so a quarter of
+     * RAM is usually enough for the whole playback range
+     */
+    const int defaultLimit = qMax(256, totalRAM() / 4);
+    return defaultValue ? defaultLimit : m_config.readEntry("frameCacheMemoryLimit", defaultLimit);
+}
+
+void KisImageConfig::setFrameCacheMemoryLimit(int value)
+{
+    m_config.writeEntry("frameCacheMemoryLimit", value);
+}
@@ -111,6 +111,27 @@ public:
     bool useLodForColorizeMask(bool requestDefault = false) const;
     void setUseLodForColorizeMask(bool value);
 
+    QString swapTileCompression(bool requestDefault = false) const;
+    void setSwapTileCompression(const QString &value);
+
+    QString fileTileCompression(bool requestDefault = false) const;
+    void setFileTileCompression(const QString &value);
+
+    bool useParallelFileLoading(bool requestDefault = false) const;
+    void setUseParallelFileLoading(bool value);
+
+    bool useTileSwapPriorities(bool requestDefault = false) const;
+    void setUseTileSwapPriorities(bool value);
+
+    int tileSwapRecencyThreshold(bool requestDefault = false) const;
+    void setTileSwapRecencyThreshold(int value);
+
+    int compressedTileTierPercent(bool requestDefault = false) const;
+    void setCompressedTileTierPercent(int value);
+
+    bool shareUniformTiles(bool requestDefault = false) const;
+    void setShareUniformTiles(bool value);
+
     int maxNumberOfThreads(bool defaultValue = false) const;
     void setMaxNumberOfThreads(int value);
 
@@ -120,6 +141,9 @@ public:
     int fpsLimit(bool defaultValue = false) const;
     void setFpsLimit(int value);
 
+    int frameCacheMemoryLimit(bool defaultValue = false) const; // MiB
+    void setFrameCacheMemoryLimit(int value);
+
 private:
     Q_DISABLE_COPY(KisImageConfig)
 
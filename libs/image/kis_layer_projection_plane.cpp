@@ -23,6 +23,7 @@
 #include <KoChannelInfo.h>
 #include <KoCompositeOpRegistry.h>
 #include "kis_painter.h"
+#include "kis_paint_device.h"
 #include "kis_projection_leaf.h"
 
 
@@ -104,6 +105,23 @@ KisPaintDeviceList KisLayerProjectionPlane::getLodCapableDevices() const
     return KisPaintDeviceList() << m_d->layer->projection();
 }
 
+bool KisLayerProjectionPlane::isOpaque(const QRect &rect) const
+{
+    /**
+     * Only the Normal blending mode with full opacity and all the
+     * channels enabled copies the opaque pixels over the projection
+     * as they are.
+     */
+    if (m_d->layer->compositeOpId() != COMPOSITE_OVER) return false;
+    if (m_d->layer->projectionLeaf()->opacity() != OPACITY_OPAQUE_U8) return false;
+
+    const QBitArray channelFlags = m_d->layer->projectionLeaf()->channelFlags();
+    if (!channelFlags.isEmpty() && channelFlags.count(true) != channelFlags.size()) return false;
+
+    KisPaintDeviceSP device = m_d->layer->projection();
+    return device && device->isOpaque(rect);
+}
+
 QRect KisLayerProjectionPlane::needRect(const QRect &rect, KisLayer::PositionToFilthy pos) const
 {
     return m_d->layer->needRect(rect, pos);
@@ -43,6 +43,8 @@ public:
 
     KisPaintDeviceList getLodCapableDevices() const override;
 
+    bool isOpaque(const QRect &rect) const override;
+
 private:
     struct Private;
     const QScopedPointer<Private> m_d;
@@ -22,6 +22,9 @@
 #include "kis_dom_utils.h"
 #include "krita_utils.h"
 
+#include <QImage>
+#include <QTransform>
+
 
 struct Q_DECL_HIDDEN KisLiquifyTransformWorker::Private
 {
@@ -43,8 +46,29 @@ struct Q_DECL_HIDDEN KisLiquifyTransformWorker::Private
     int pixelPrecision;
     QSize gridSize;
 
+    /**
+     * The result of the last runOnQImage() call. When only a few grid
+     * points are moved, only the area covered by the cells around them
+     * is re-rendered.
+     */
+    struct QImageCache {
+        QImageCache() : srcImageKey(0) {}
+
+        qint64 srcImageKey;
+        QPointF srcImageOffset;
+        QTransform imageToThumbTransform;
+        QPointF dstImageOffset;
+        QVector<QPointF> transformedPoints;
+        QImage dstImage;
+    };
+
+    QImageCache qimageCache;
+
     void preparePoints();
 
+    QRect calculateDirtyRect(const QVector<QPointF> &oldPoints,
+                             const QVector<QPointF> &newPoints) const;
+
     struct MapIndexesOp;
 
     template <class ProcessOp>
@@ -438,11 +462,13 @@ void KisLiquifyTransformWorker::run(KisPaintDeviceSP device)
     using namespace GridIterationTools;
 
     PaintDevicePolygonOp polygonOp(srcDev, device);
+    MultithreadedPolygonOp<PaintDevicePolygonOp> threadedOp(polygonOp);
     Private::MapIndexesOp indexesOp(m_d.data());
-    iterateThroughGrid<AlwaysCompletePolygonPolicy>(polygonOp, indexesOp,
+    iterateThroughGrid<AlwaysCompletePolygonPolicy>(threadedOp, indexesOp,
                                                     m_d->gridSize,
                                                     m_d->originalPoints,
                                                     m_d->transformedPoints);
+    threadedOp.flush();
 }
 
 QRect KisLiquifyTransformWorker::approxChangeRect(const QRect &rc)
@@ -478,6 +504,14 @@ QRect KisLiquifyTransformWorker::approxNeedRect(const QRect &rc, const QRect &fu
 using PointMapFunction = std::function<QPointF (const QPointF&)>;
 
 
+/**
+ * QPointF::operator==() does a fuzzy comparison, which is not enough
+ * for deciding whether the cached image can be reused
+ */
+inline bool exactlyEqual(const QPointF &lhs, const QPointF &rhs) {
+    return lhs.x() == rhs.x() && lhs.y() == rhs.y();
+}
+
 PointMapFunction bindPointMapTransform(const QTransform &transform) {
     using namespace std::placeholders;
 
@@ -526,19 +560,109 @@ QImage KisLiquifyTransformWorker::runOnQImage(const QImage &srcImage,
 
     QRect dstBoundsI = dstBounds.toAlignedRect();
 
-    QImage dstImage(dstBoundsI.size(), srcImage.format());
-    dstImage.fill(0);
+    Private::QImageCache &cache = m_d->qimageCache;
+
+    const bool canUpdatePartially =
+        cache.srcImageKey == srcImage.cacheKey() &&
+        exactlyEqual(cache.srcImageOffset, srcImageOffset) &&
+        cache.imageToThumbTransform == imageToThumbTransform &&
+        exactlyEqual(cache.dstImageOffset, dstQImageOffset) &&
+        cache.dstImage.size() == dstBoundsI.size() &&
+        cache.transformedPoints.size() == transformedPointsLocal.size();
+
+    QImage dstImage;
+    QRect limitRect;
+
+    if (canUpdatePartially) {
+        /**
+         * All the polygons intersecting the dirty rect are rendered
+         * again in the usual order, so the pixels inside it become
+         * exactly the same as after the full update.
+         */
+        limitRect = m_d->calculateDirtyRect(cache.transformedPoints, transformedPointsLocal);
+        if (limitRect.isNull()) {
+            return cache.dstImage;
+        }
+
+        dstImage = cache.dstImage;
+
+        const QRect clearRect =
+            QRect((QPointF(limitRect.topLeft()) - dstQImageOffset).toPoint(), limitRect.size()) &
+            dstImage.rect();
+
+        for (int y = clearRect.top(); y <= clearRect.bottom(); y++) {
+            QRgb *line = reinterpret_cast<QRgb*>(dstImage.scanLine(y));
+            std::fill(line + clearRect.left(), line + clearRect.left() + clearRect.width(), 0);
+        }
+    } else {
+        dstImage = QImage(dstBoundsI.size(), srcImage.format());
+        dstImage.fill(0);
+    }
 
     GridIterationTools::QImagePolygonOp polygonOp(srcImage, dstImage, srcImageOffset, dstQImageOffset);
+    GridIterationTools::MultithreadedPolygonOp<GridIterationTools::QImagePolygonOp> threadedOp(polygonOp, limitRect);
     Private::MapIndexesOp indexesOp(m_d.data());
     GridIterationTools::iterateThroughGrid
-        <GridIterationTools::AlwaysCompletePolygonPolicy>(polygonOp, indexesOp,
+        <GridIterationTools::AlwaysCompletePolygonPolicy>(threadedOp, indexesOp,
                                                           m_d->gridSize,
                                                           originalPointsLocal,
                                                           transformedPointsLocal);
+    threadedOp.flush();
+
+    cache.srcImageKey = srcImage.cacheKey();
+    cache.srcImageOffset = srcImageOffset;
+    cache.imageToThumbTransform = imageToThumbTransform;
+    cache.dstImageOffset = dstQImageOffset;
+    cache.transformedPoints = transformedPointsLocal;
+    cache.dstImage = dstImage;
+
     return dstImage;
 }
 
+QRect KisLiquifyTransformWorker::Private::calculateDirtyRect(const QVector<QPointF> &oldPoints,
+                                                             const QVector<QPointF> &newPoints) const
+{
+    bool hasChanges = false;
+    qreal left = 0, top = 0, right = 0, bottom = 0;
+
+    const int width = gridSize.width();
+    const int height = gridSize.height();
+
+    for (int i = 0; i < newPoints.size(); i++) {
+        if (exactlyEqual(oldPoints[i], newPoints[i])) continue;
+
+        // a moved point changes the four cells around it
+        const int col = i % width;
+        const int row = i / width;
+
+        for (int r = qMax(0, row - 1); r <= qMin(height - 1, row + 1); r++) {
+            for (int c = qMax(0, col - 1); c <= qMin(width - 1, col + 1); c++) {
+                const int index = c + r * width;
+
+                const QPointF &oldPt = oldPoints[index];
+                const QPointF &newPt = newPoints[index];
+
+                if (!hasChanges) {
+                    left = right = oldPt.x();
+                    top = bottom = oldPt.y();
+                    hasChanges = true;
+                }
+
+                left = qMin(left, qMin(oldPt.x(), newPt.x()));
+                right = qMax(right, qMax(oldPt.x(), newPt.x()));
+                top = qMin(top, qMin(oldPt.y(), newPt.y()));
+                bottom = qMax(bottom, qMax(oldPt.y(), newPt.y()));
+            }
+        }
+    }
+
+    if (!hasChanges) return QRect();
+
+    // the margin covers the epsilon adjustments of the polygons
+    return QRectF(QPointF(left, top), QPointF(right, bottom))
+        .toAlignedRect().adjusted(-2, -2, 2, 2);
+}
+
 void KisLiquifyTransformWorker::toXML(QDomElement *e) const
 {
     QDomDocument doc = e->ownerDocument();
@@ -156,6 +156,20 @@ KisMemoryStatisticsServer::fetchMemoryStatistics(KisImageSP image) const
     stats.poolSize = tileStats.poolSize;
 
     stats.swapSize = tileStats.swapSize;
+    stats.swapInCount = tileStats.numSwapIns;
+    stats.swapInAverageLatency =
+        tileStats.numSwapIns > 0 ? tileStats.totalSwapInTime / tileStats.numSwapIns : 0;
+    stats.swapInMaxLatency = tileStats.maxSwapInTime;
+    stats.prefetchedTiles = tileStats.numPrefetchedTiles;
+
+    stats.compressedTierSize = tileStats.compressedTierSize;
+    stats.compressedTierUncompressedSize = tileStats.compressedTierUncompressedSize;
+    stats.compressedTierHits = tileStats.numCompressedTierHits;
+    stats.compressedTierMisses = tileStats.numCompressedTierMisses;
+
+    const qint64 numSwapIns = stats.compressedTierHits + stats.compressedTierMisses;
+    stats.compressedTierHitRate =
+        numSwapIns > 0 ? qreal(stats.compressedTierHits) / numSwapIns : 0.0;
 
     KisImageConfig cfg;
 
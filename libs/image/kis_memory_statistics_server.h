@@ -45,6 +45,15 @@ public:
               poolSize(0),
 
               swapSize(0),
+              swapInCount(0),
+              swapInAverageLatency(0),
+              swapInMaxLatency(0),
+              prefetchedTiles(0),
+              compressedTierSize(0),
+              compressedTierUncompressedSize(0),
+              compressedTierHits(0),
+              compressedTierMisses(0),
+              compressedTierHitRate(0.0),
 
               totalMemoryLimit(0),
               tilesHardLimit(0),
@@ -65,6 +74,36 @@ public:
 
         qint64 swapSize;
 
+        /**
+         * Number of tiles that were loaded back from the swap file
+         * synchronously, i.e. while the user was waiting for them,
+         * and the latency of these loads in microseconds
+         */
+        qint64 swapInCount;
+        qint64 swapInAverageLatency;
+        qint64 swapInMaxLatency;
+
+        /**
+         * Number of tiles loaded from the swap file in background
+         * before anyone requested them
+         */
+        qint64 prefetchedTiles;
+
+        /**
+         * The memory occupied by the tiles stored compressed in
+         * memory, and the size they would take uncompressed
+         */
+        qint64 compressedTierSize;
+        qint64 compressedTierUncompressedSize;
+
+        /**
+         * The swap-ins served from the compressed tiles and the ones
+         * that had to read the swap file. The hit rate is in [0, 1].
+         */
+        qint64 compressedTierHits;
+        qint64 compressedTierMisses;
+        qreal compressedTierHitRate;
+
         qint64 totalMemoryLimit;
         qint64 tilesHardLimit;
         qint64 tilesSoftLimit;
@@ -1412,6 +1412,36 @@ void KisPaintDevice::purgeDefaultPixels()
     dm->purge(dm->extent());
 }
 
+void KisPaintDevice::prefetchSwappedData(const QRect &rc) const
+{
+    m_d->dataManager()->prefetchRect(rc.translated(-m_d->x(), -m_d->y()));
+}
+
+bool KisPaintDevice::isOpaque(const QRect &rc) const
+{
+    const KoColorSpace *cs = colorSpace();
+
+    qint32 alphaOffset = -1;
+    qint32 alphaSize = 0;
+
+    Q_FOREACH (const KoChannelInfo *channel, cs->channels()) {
+        if (channel->channelType() == KoChannelInfo::ALPHA) {
+            alphaOffset = channel->pos();
+            alphaSize = channel->size();
+            break;
+        }
+    }
+
+    if (alphaOffset < 0) return false;
+
+    QByteArray opaquePixel(cs->pixelSize(), 0);
+    cs->setOpacity(reinterpret_cast<quint8*>(opaquePixel.data()), OPACITY_OPAQUE_U8, 1);
+
+    return m_d->dataManager()->isOpaque(rc.translated(-m_d->x(), -m_d->y()),
+                                        alphaOffset, alphaSize,
+                                        reinterpret_cast<const quint8*>(opaquePixel.constData()) + alphaOffset);
+}
+
 void KisPaintDevice::setDefaultPixel(const KoColor &defPixel)
 {
     KoColor color(defPixel);
@@ -281,6 +281,23 @@ public:
      */
     void purgeDefaultPixels();
 
+    /**
+     * Hints the tile engine that the pixels in \p rc are going to be
+     * accessed soon. If some of them have been swapped out to disk,
+     * they will be loaded back asynchronously. The call returns
+     * immediately.
+     */
+    void prefetchSwappedData(const QRect &rc) const;
+
+    /**
+     * Returns true if all the pixels of the tiles intersecting \p rc
+     * are fully opaque. The opacity is tracked per tile and reset on
+     * every write into the tile, so checking an unchanged device is
+     * cheap. The check is conservative: a tile that has transparent
+     * pixels outside \p rc makes the method return false.
+     */
+    bool isOpaque(const QRect &rc) const;
+
     /**
      * Sets the default pixel. New data will be initialised with this pixel. The pixel is copied: the
      * caller still owns the pointer and needs to delete it to avoid memory leaks.
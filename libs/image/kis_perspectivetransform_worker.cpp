@@ -25,6 +25,8 @@
 #include <QTransform>
 #include <QVector3D>
 #include <QPolygonF>
+#include <QMutex>
+#include <QtConcurrent>
 
 #include <KoUpdater.h>
 #include <KoColor.h>
@@ -43,7 +45,7 @@
 
 
 KisPerspectiveTransformWorker::KisPerspectiveTransformWorker(KisPaintDeviceSP dev, QPointF center, double aX, double aY, double distance, KoUpdaterPtr progress)
-        : m_dev(dev), m_progressUpdater(progress)
+        : m_dev(dev), m_progressUpdater(progress), m_useMultithreading(false)
 
 {
     QMatrix4x4 m;
@@ -59,7 +61,7 @@ KisPerspectiveTransformWorker::KisPerspectiveTransformWorker(KisPaintDeviceSP de
 }
 
 KisPerspectiveTransformWorker::KisPerspectiveTransformWorker(KisPaintDeviceSP dev, const QTransform &transform, KoUpdaterPtr progress)
-    : m_dev(dev), m_progressUpdater(progress)
+    : m_dev(dev), m_progressUpdater(progress), m_useMultithreading(false)
 {
     init(transform);
 }
@@ -108,6 +110,73 @@ void KisPerspectiveTransformWorker::setForwardTransform(const QTransform &transf
     init(transform);
 }
 
+void KisPerspectiveTransformWorker::setUseMultithreading(bool value)
+{
+    m_useMultithreading = value;
+}
+
+bool KisPerspectiveTransformWorker::useMultithreading() const
+{
+    return m_useMultithreading;
+}
+
+namespace {
+void transformRect(KisPaintDeviceSP srcDev,
+                   KisPaintDeviceSP dstDev,
+                   const QRect &rect,
+                   const QRectF &srcClipRect,
+                   const QTransform &backwardTransform)
+{
+    KisRandomSubAccessorSP srcAcc = srcDev->createRandomSubAccessor();
+    KisRandomAccessorSP accessor = dstDev->createRandomAccessorNG(rect.x(), rect.y());
+
+    for (int y = rect.y(); y < rect.y() + rect.height(); ++y) {
+        for (int x = rect.x(); x < rect.x() + rect.width(); ++x) {
+
+            QPointF dstPoint(x, y);
+            QPointF srcPoint = backwardTransform.map(dstPoint);
+
+            if (srcClipRect.contains(srcPoint)) {
+                accessor->moveTo(dstPoint.x(), dstPoint.y());
+                srcAcc->moveTo(srcPoint.x(), srcPoint.y());
+                srcAcc->sampledOldRawData(accessor->rawData());
+            }
+        }
+    }
+}
+}
+
+void KisPerspectiveTransformWorker::processRects(KisPaintDeviceSP srcDev,
+                                                 KisPaintDeviceSP dstDev,
+                                                 const QVector<QRect> &rects,
+                                                 const QRectF &srcClipRect)
+{
+    KisProgressUpdateHelper progressHelper(m_progressUpdater, 100, rects.size());
+
+    if (m_useMultithreading && rects.size() > 1) {
+        /**
+         * Every destination pixel is sampled independently and the
+         * source device is only read, so the rects may be processed
+         * in any order.
+         */
+        QMutex progressMutex;
+        QVector<QRect> patches = rects;
+
+        QtConcurrent::blockingMap(patches,
+            [&] (const QRect &rect) {
+                transformRect(srcDev, dstDev, rect, srcClipRect, m_backwardTransform);
+
+                QMutexLocker l(&progressMutex);
+                progressHelper.step();
+            });
+    } else {
+        Q_FOREACH (const QRect &rect, rects) {
+            transformRect(srcDev, dstDev, rect, srcClipRect, m_backwardTransform);
+            progressHelper.step();
+        }
+    }
+}
+
 void KisPerspectiveTransformWorker::run()
 {
     KIS_ASSERT_RECOVER_RETURN(m_dev);
@@ -122,27 +191,11 @@ void KisPerspectiveTransformWorker::run()
 
     KIS_ASSERT_RECOVER_NOOP(!m_isIdentity);
 
-    KisProgressUpdateHelper progressHelper(m_progressUpdater, 100, m_dstRegion.rectCount());
-
-    KisRandomSubAccessorSP srcAcc = cloneDevice->createRandomSubAccessor();
-    KisRandomAccessorSP accessor = m_dev->createRandomAccessorNG(0, 0);
-
-    Q_FOREACH (const QRect &rect, m_dstRegion.rects()) {
-        for (int y = rect.y(); y < rect.y() + rect.height(); ++y) {
-            for (int x = rect.x(); x < rect.x() + rect.width(); ++x) {
+    const QVector<QRect> rects = m_useMultithreading ?
+        KritaUtils::splitRegionIntoPatches(m_dstRegion, KritaUtils::optimalPatchSize()) :
+        m_dstRegion.rects();
 
-                QPointF dstPoint(x, y);
-                QPointF srcPoint = m_backwardTransform.map(dstPoint);
-
-                if (m_srcRect.contains(srcPoint)) {
-                    accessor->moveTo(dstPoint.x(), dstPoint.y());
-                    srcAcc->moveTo(srcPoint.x(), srcPoint.y());
-                    srcAcc->sampledOldRawData(accessor->rawData());
-                }
-            }
-        }
-        progressHelper.step();
-    }
+    processRects(cloneDevice, m_dev, rects, m_srcRect);
 }
 
 void KisPerspectiveTransformWorker::runPartialDst(KisPaintDeviceSP srcDev,
@@ -157,26 +210,11 @@ void KisPerspectiveTransformWorker::runPartialDst(KisPaintDeviceSP srcDev,
     QRectF srcClipRect = srcDev->exactBounds();
     if (srcClipRect.isEmpty()) return;
 
-    KisProgressUpdateHelper progressHelper(m_progressUpdater, 100, dstRect.height());
-
-    KisRandomSubAccessorSP srcAcc = srcDev->createRandomSubAccessor();
-    KisRandomAccessorSP accessor = dstDev->createRandomAccessorNG(dstRect.x(), dstRect.y());
-
-    for (int y = dstRect.y(); y < dstRect.y() + dstRect.height(); ++y) {
-        for (int x = dstRect.x(); x < dstRect.x() + dstRect.width(); ++x) {
-
-            QPointF dstPoint(x, y);
-            QPointF srcPoint = m_backwardTransform.map(dstPoint);
-
-            if (srcClipRect.contains(srcPoint)) {
-                accessor->moveTo(dstPoint.x(), dstPoint.y());
-                srcAcc->moveTo(srcPoint.x(), srcPoint.y());
-                srcAcc->sampledOldRawData(accessor->rawData());
-            }
-        }
-        progressHelper.step();
-    }
+    const QVector<QRect> rects = m_useMultithreading ?
+        KritaUtils::splitRectIntoPatches(dstRect, KritaUtils::optimalPatchSize()) :
+        QVector<QRect>({dstRect});
 
+    processRects(srcDev, dstDev, rects, srcClipRect);
 }
 
 QTransform KisPerspectiveTransformWorker::forwardTransform() const
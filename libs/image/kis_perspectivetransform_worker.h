@@ -45,6 +45,16 @@ public:
 
     void setForwardTransform(const QTransform &transform);
 
+    /**
+     * When enabled, the destination area is split into tile-aligned
+     * patches, which are resampled concurrently in the global thread
+     * pool. The result is bit-identical to the serial mode.
+     *
+     * Disabled by default.
+     */
+    void setUseMultithreading(bool value);
+    bool useMultithreading() const;
+
     QTransform forwardTransform() const;
     QTransform backwardTransform() const;
 
@@ -56,6 +66,11 @@ private:
                     QRegion *dstRegion,
                     QPolygonF *dstClipPolygon);
 
+    void processRects(KisPaintDeviceSP srcDev,
+                      KisPaintDeviceSP dstDev,
+                      const QVector<QRect> &rects,
+                      const QRectF &srcClipRect);
+
 private:
     KisPaintDeviceSP m_dev;
     KoUpdaterPtr m_progressUpdater;
@@ -64,6 +79,7 @@ private:
     QTransform m_backwardTransform;
     QTransform m_forwardTransform;
     bool m_isIdentity;
+    bool m_useMultithreading;
 };
 
 #endif
@@ -24,20 +24,13 @@
 #include "kis_fast_math.h"
 
 #include "kis_rect_mask_generator.h"
+#include "kis_rect_mask_generator_p.h"
 #include "kis_base_mask_generator.h"
+#include "kis_brush_mask_applicator_factories.h"
+#include "kis_brush_mask_applicator_base.h"
 
 #include <qnumeric.h>
 
-struct Q_DECL_HIDDEN KisRectangleMaskGenerator::Private {
-    double m_c;
-    qreal xcoeff;
-    qreal ycoeff;
-    qreal xfadecoeff;
-    qreal yfadecoeff;
-    qreal transformedFadeX;
-    qreal transformedFadeY;
-};
-
 KisRectangleMaskGenerator::KisRectangleMaskGenerator(qreal radius, qreal ratio, qreal fh, qreal fv, int spikes, bool antialiasEdges)
     : KisMaskGenerator(radius, ratio, fh, fv, spikes, antialiasEdges, RECTANGLE, DefaultId), d(new Private)
 {
@@ -50,12 +43,18 @@ KisRectangleMaskGenerator::KisRectangleMaskGenerator(qreal radius, qreal ratio,
     }
 
     setScale(1.0, 1.0);
+
+    // store the variable locally to allow vector implementation read it easily
+    d->copyOfAntialiasEdges = antialiasEdges;
+
+    d->applicator.reset(createOptimizedClass<MaskApplicatorFactory<KisRectangleMaskGenerator, KisBrushMaskVectorApplicator> >(this));
 }
 
 KisRectangleMaskGenerator::KisRectangleMaskGenerator(const KisRectangleMaskGenerator &rhs)
     : KisMaskGenerator(rhs),
       d(new Private(*rhs.d))
 {
+    d->applicator.reset(createOptimizedClass<MaskApplicatorFactory<KisRectangleMaskGenerator, KisBrushMaskVectorApplicator> >(this));
 }
 
 KisMaskGenerator* KisRectangleMaskGenerator::clone() const
@@ -92,6 +91,16 @@ bool KisRectangleMaskGenerator::shouldSupersample() const
     return effectiveSrcWidth() < 10 || effectiveSrcHeight() < 10;
 }
 
+bool KisRectangleMaskGenerator::shouldVectorize() const
+{
+    return !shouldSupersample() && spikes() == 2;
+}
+
+KisBrushMaskApplicatorBase* KisRectangleMaskGenerator::applicator()
+{
+    return d->applicator.data();
+}
+
 quint8 KisRectangleMaskGenerator::valueAt(qreal x, qreal y) const
 {
     if (isEmpty()) return 255;
@@ -26,6 +26,8 @@
 #include <klocalizedstring.h>
 
 #include <QTransform>
+#include <QMutex>
+#include <QtConcurrent>
 
 #include <KoColorSpace.h>
 #include <KoCompositeOpRegistry.h>
@@ -43,6 +45,13 @@
 #include "kis_pixel_selection.h"
 #include "kis_image.h"
 
+/**
+ * The number of lines processed by a single job in the multithreaded
+ * mode. It is a multiple of the tile size, so that two jobs never write
+ * into the same tile, unless the device has a non-aligned offset.
+ */
+static const int MULTITHREADED_STRIP_SIZE = 256;
+
 
 KisTransformWorker::KisTransformWorker(KisPaintDeviceSP dev,
                                        double xscale, double yscale,
@@ -65,12 +74,23 @@ KisTransformWorker::KisTransformWorker(KisPaintDeviceSP dev,
     m_ytranslate = ytranslate;
     m_progressUpdater = progress;
     m_filter = filter;
+    m_useMultithreading = false;
 }
 
 KisTransformWorker::~KisTransformWorker()
 {
 }
 
+void KisTransformWorker::setUseMultithreading(bool value)
+{
+    m_useMultithreading = value;
+}
+
+bool KisTransformWorker::useMultithreading() const
+{
+    return m_useMultithreading;
+}
+
 QTransform KisTransformWorker::transform() const
 {
     QTransform TS = QTransform::fromTranslate(m_xshearOrigin, m_yshearOrigin);
@@ -206,12 +226,60 @@ void KisTransformWorker::transformPass(KisPaintDevice *src, KisPaintDevice *dst,
     qint32 srcStart, srcLen, firstLine, numLines;
     calcDimensions<T>(m_boundRect, srcStart, srcLen, firstLine, numLines);
 
-    KisProgressUpdateHelper progressHelper(m_progressUpdater, portion, numLines);
     KisFilterWeightsBuffer buf(filterStrategy, qAbs(floatscale));
     KisFilterWeightsApplicator applicator(src, dst, floatscale, shear, dx, clampToEdge);
 
     KisFilterWeightsApplicator::LinePos dstBounds;
 
+    if (m_useMultithreading && numLines > MULTITHREADED_STRIP_SIZE) {
+        /**
+         * Every line reads and writes only its own pixels, so the lines
+         * can be resampled in any order. The strips are aligned to the
+         * tile grid and the resulting line positions are united in the
+         * original order afterwards, which keeps the result identical
+         * to the serial path below.
+         */
+        QVector<QPair<int, int>> strips;
+
+        int stripStart = firstLine;
+        while (stripStart < firstLine + numLines) {
+            const int alignedEnd =
+                qFloor(qreal(stripStart) / MULTITHREADED_STRIP_SIZE) * MULTITHREADED_STRIP_SIZE +
+                MULTITHREADED_STRIP_SIZE;
+            const int stripEnd = qMin(alignedEnd, firstLine + numLines);
+
+            strips << qMakePair(stripStart, stripEnd);
+            stripStart = stripEnd;
+        }
+
+        QVector<KisFilterWeightsApplicator::LinePos> linePositions(numLines);
+        KisFilterWeightsApplicator::LinePos *linePositionsPtr = linePositions.data();
+
+        KisProgressUpdateHelper progressHelper(m_progressUpdater, portion, strips.size());
+        QMutex progressMutex;
+
+        QtConcurrent::blockingMap(strips,
+            [&] (const QPair<int, int> &strip) {
+                for (int i = strip.first; i < strip.second; i++) {
+                    KisFilterWeightsApplicator::LinePos srcPos(srcStart, srcLen);
+                    linePositionsPtr[i - firstLine] =
+                        applicator.processLine<T>(srcPos, i, &buf, filterStrategy->support());
+                }
+
+                QMutexLocker l(&progressMutex);
+                progressHelper.step();
+            });
+
+        Q_FOREACH (const KisFilterWeightsApplicator::LinePos &pos, linePositions) {
+            dstBounds.unite(pos);
+        }
+
+        updateBounds<T>(m_boundRect, dstBounds);
+        return;
+    }
+
+    KisProgressUpdateHelper progressHelper(m_progressUpdater, portion, numLines);
+
     for (int i = firstLine; i < firstLine + numLines; i++) {
         KisFilterWeightsApplicator::LinePos dstPos;
         KisFilterWeightsApplicator::LinePos srcPos(srcStart, srcLen);
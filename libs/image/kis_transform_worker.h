@@ -92,6 +92,17 @@ public:
     bool run();
     bool runPartial(const QRect &processRect);
 
+    /**
+     * When enabled, the lines of every resampling pass are split into
+     * strips of whole tiles, which are processed concurrently in the
+     * global thread pool. Every line is resampled independently from
+     * the others, so the result is bit-identical to the serial mode.
+     *
+     * Disabled by default.
+     */
+    void setUseMultithreading(bool value);
+    bool useMultithreading() const;
+
     /**
      * Returns a matrix of the transformation executed by the worker.
      * Resulting transformation has the following form (in Qt's matrix
@@ -155,6 +166,7 @@ private:
     KoUpdaterPtr m_progressUpdater;
     KisFilterStrategy *m_filter;
     QRect m_boundRect;
+    bool m_useMultithreading;
 };
 
 #endif // KIS_TRANSFORM_VISITOR_H_
@@ -258,8 +258,10 @@ void KisWarpTransformWorker::run()
 
     FunctionTransformOp functionOp(m_warpMathFunction, m_origPoint, m_transfPoint, m_alpha);
     GridIterationTools::PaintDevicePolygonOp polygonOp(srcdev, m_dev);
-    GridIterationTools::processGrid(polygonOp, functionOp,
+    GridIterationTools::MultithreadedPolygonOp<GridIterationTools::PaintDevicePolygonOp> threadedOp(polygonOp);
+    GridIterationTools::processGrid(threadedOp, functionOp,
                                     srcBounds, pixelPrecision);
+    threadedOp.flush();
 }
 
 #include "krita_utils.h"
@@ -359,7 +361,9 @@ QImage KisWarpTransformWorker::transformQImage(WarpType warpType,
 
     const int pixelPrecision = 32;
     GridIterationTools::QImagePolygonOp polygonOp(srcImage, dstImage, srcQImageOffset, dstQImageOffset);
-    GridIterationTools::processGrid(polygonOp, functionOp, srcBounds.toAlignedRect(), pixelPrecision);
+    GridIterationTools::MultithreadedPolygonOp<GridIterationTools::QImagePolygonOp> threadedOp(polygonOp);
+    GridIterationTools::processGrid(threadedOp, functionOp, srcBounds.toAlignedRect(), pixelPrecision);
+    threadedOp.flush();
 
     return dstImage;
 }
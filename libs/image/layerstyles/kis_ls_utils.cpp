@@ -115,7 +115,7 @@ namespace KisLsUtils
     {
         KisGaussianKernel::applyGaussian(selection, applyRect,
                                          radius, radius,
-                                         QBitArray(), 0);
+                                         QBitArray(), 0, true);
     }
 
     namespace Private {
@@ -192,6 +192,7 @@ void KisTransformProcessingVisitor::transformPaintDevice(KisPaintDeviceSP device
                           m_shearOrigin.x(), m_shearOrigin.y(),
                           m_angle, m_tx, m_ty, helper.updater(),
                           m_filter);
+    tw.setUseMultithreading(true);
     tw.run();
     transaction.commit(adapter);
 }
@@ -32,6 +32,8 @@
 #include "kis_adjustment_layer.h"
 #include "kis_filter_mask.h"
 #include "kis_selection.h"
+#include "krita_utils.h"
+#include "kis_sequential_iterator.h"
 
 #include "filter/kis_filter.h"
 #include "filter/kis_filter_configuration.h"
@@ -287,5 +289,119 @@ void KisAsyncMergerTest::testSubgraphingWithoutUpdatingParent()
     }
 }
 
+    /*
+      +--------------+
+      |root          |
+      | paint 3      |
+      | paint 2      |
+      | paint 1      |
+      +--------------+
+     */
+
+void KisAsyncMergerTest::testOcclusionCulling()
+{
+    const KoColorSpace *colorSpace = KoColorSpaceRegistry::instance()->rgb8();
+    KisImageSP image = new KisImage(0, 256, 256, colorSpace, "occlusion test");
+
+    KisPaintDeviceSP device1 = new KisPaintDevice(colorSpace);
+    device1->fill(image->bounds(), KoColor(Qt::red, colorSpace));
+    KisLayerSP paintLayer1 = new KisPaintLayer(image, "paint1", OPACITY_OPAQUE_U8, device1);
+
+    // opaque only in the left half of the image
+    KisPaintDeviceSP device2 = new KisPaintDevice(colorSpace);
+    device2->fill(QRect(0, 0, 128, 256), KoColor(Qt::white, colorSpace));
+    KisLayerSP paintLayer2 = new KisPaintLayer(image, "paint2", OPACITY_OPAQUE_U8, device2);
+
+    KisPaintDeviceSP device3 = new KisPaintDevice(colorSpace);
+    device3->fill(QRect(64, 64, 128, 128), KoColor(Qt::blue, colorSpace));
+    KisLayerSP paintLayer3 = new KisPaintLayer(image, "paint3", OPACITY_OPAQUE_U8 / 2, device3);
+
+    image->addNode(paintLayer1, image->rootLayer());
+    image->addNode(paintLayer2, image->rootLayer());
+    image->addNode(paintLayer3, image->rootLayer());
+
+    QRect cropRect(image->bounds());
+    KisMergeWalker walker(cropRect);
+
+    // the occlusion is checked per tile, so merge in small patches
+    const QVector<QRect> patches =
+        KritaUtils::splitRectIntoPatches(image->bounds(), QSize(64, 64));
+
+    int numOccludedLeaves = 0;
+
+    auto mergeAndCompare = [&] (KisLayerSP filthyLayer) {
+        KisAsyncMerger merger;
+
+        merger.setUseOcclusionCulling(false);
+        Q_FOREACH (const QRect &rc, patches) {
+            walker.collectRects(filthyLayer, rc);
+            merger.startMerge(walker);
+        }
+
+        KisPaintDeviceSP reference = new KisPaintDevice(*image->projection());
+
+        merger.setUseOcclusionCulling(true);
+        Q_FOREACH (const QRect &rc, patches) {
+            walker.collectRects(filthyLayer, rc);
+            merger.startMerge(walker);
+        }
+
+        numOccludedLeaves = merger.numOccludedLeaves();
+
+        QPoint pt;
+        return TestUtil::comparePaintDevices(pt, reference, image->projection());
+    };
+
+    // paint 1 is hidden under the left half of paint 2
+    QVERIFY(mergeAndCompare(paintLayer1));
+    QCOMPARE(numOccludedLeaves, 8);
+    QVERIFY(mergeAndCompare(paintLayer3));
+    QCOMPARE(numOccludedLeaves, 8);
+
+    // make a hole in the occluding layer
+    device2->clear(QRect(10, 10, 5, 5));
+
+    // the projection of the filthy layer cannot be used
+    QVERIFY(mergeAndCompare(paintLayer2));
+    QCOMPARE(numOccludedLeaves, 0);
+
+    QVERIFY(mergeAndCompare(paintLayer1));
+    QCOMPARE(numOccludedLeaves, 7);
+
+    KoColor pixel(colorSpace);
+    image->projection()->pixel(12, 12, &pixel);
+    QCOMPARE(pixel, KoColor(Qt::red, colorSpace));
+
+    image->projection()->pixel(20, 20, &pixel);
+    QCOMPARE(pixel, KoColor(Qt::white, colorSpace));
+
+    /**
+     * Now the tiles of paint 2 are cached as opaque. Make one of
+     * them transparent through an iterator, the culling should
+     * notice that.
+     */
+    {
+        KisSequentialIterator it(device2, QRect(0, 192, 64, 64));
+        while (it.nextPixel()) {
+            colorSpace->setOpacity(it.rawData(), OPACITY_TRANSPARENT_U8, 1);
+        }
+    }
+
+    {
+        KisAsyncMerger merger;
+        Q_FOREACH (const QRect &rc, patches) {
+            walker.collectRects(paintLayer1, rc);
+            merger.startMerge(walker);
+        }
+        QCOMPARE(merger.numOccludedLeaves(), 6);
+    }
+
+    image->projection()->pixel(30, 220, &pixel);
+    QCOMPARE(pixel, KoColor(Qt::red, colorSpace));
+
+    image->projection()->pixel(100, 220, &pixel);
+    QCOMPARE(pixel, KoColor(Qt::white, colorSpace));
+}
+
 QTEST_MAIN(KisAsyncMergerTest)
 
@@ -333,7 +333,7 @@ void KisConvolutionPainterTest::testGaussianBase(KisPaintDeviceSP dev, bool useF
 
            const QRect applyRect = dev->exactBounds();
 
-           KisConvolutionPainter::TestingEnginePreference enginePreference =
+           KisConvolutionPainter::EnginePreference enginePreference =
                useFftw ?
                KisConvolutionPainter::FFTW :
                KisConvolutionPainter::SPATIAL;
@@ -437,4 +437,132 @@ void KisConvolutionPainterTest::testGaussianDetailsFFTW()
     testGaussianDetails(true);
 }
 
+void KisConvolutionPainterTest::testGaussianKernelSigma()
+{
+    QList<qreal> radii;
+    radii << 1 << 5 << 20 << 60;
+
+    Q_FOREACH (qreal radius, radii) {
+        const qreal expectedSigma = KisGaussianKernel::sigmaFromRadius(radius);
+
+        QVERIFY(qAbs(KisGaussianKernel::sigmaFromKernel(
+                         KisGaussianKernel::createHorizontalKernel(radius)) - expectedSigma) < 1e-6);
+        QVERIFY(qAbs(KisGaussianKernel::sigmaFromKernel(
+                         KisGaussianKernel::createVerticalKernel(radius)) - expectedSigma) < 1e-6);
+    }
+
+    // a box kernel is not a Gaussian one
+    Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> box(1, 9);
+    box.fill(1.0);
+    QCOMPARE(KisGaussianKernel::sigmaFromKernel(KisConvolutionKernel::fromMatrix(box, 0, 9)), 0.0);
+
+    // neither is a two-dimensional one
+    Eigen::Matrix<qreal, Eigen::Dynamic, Eigen::Dynamic> matrix =
+        KisGaussianKernel::createVerticalMatrix(5) * KisGaussianKernel::createHorizontalMatrix(5);
+    QCOMPARE(KisGaussianKernel::sigmaFromKernel(KisConvolutionKernel::fromMatrix(matrix, 0, matrix.sum())), 0.0);
+}
+
+void KisConvolutionPainterTest::testGaussianIIRAccuracy()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    const QRect applyRect(0, 0, 300, 200);
+
+    /**
+     * An opaque image with sharp edges is the worst case
+     * for the approximation
+     */
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->fill(applyRect, KoColor(Qt::white, cs));
+    dev->fill(QRect(30, 20, 100, 60), KoColor(Qt::black, cs));
+    dev->fill(QRect(150, 50, 3, 120), KoColor(Qt::red, cs));
+    dev->fill(QRect(200, 100, 80, 80), KoColor(Qt::blue, cs));
+    dev->fill(QRect(10, 150, 100, 1), KoColor(Qt::green, cs));
+
+    QList<qreal> radii;
+    radii << 10 << 30 << 60;
+
+    Q_FOREACH (qreal radius, radii) {
+        for (int i = 0; i < 2; i++) {
+            const bool horizontal = i == 0;
+
+            KisConvolutionKernelSP kernel =
+                horizontal ?
+                KisGaussianKernel::createHorizontalKernel(radius) :
+                KisGaussianKernel::createVerticalKernel(radius);
+
+            KisPaintDeviceSP spatialDev = new KisPaintDevice(cs);
+            KisConvolutionPainter spatialPainter(spatialDev, KisConvolutionPainter::SPATIAL);
+            spatialPainter.applyMatrix(kernel, dev, applyRect.topLeft(), applyRect.topLeft(), applyRect.size(), BORDER_REPEAT);
+
+            KisPaintDeviceSP iirDev = new KisPaintDevice(cs);
+            KisConvolutionPainter iirPainter(iirDev, KisConvolutionPainter::IIR_GAUSSIAN);
+            iirPainter.applyMatrix(kernel, dev, applyRect.topLeft(), applyRect.topLeft(), applyRect.size(), BORDER_REPEAT);
+
+            const int numBytes = applyRect.width() * applyRect.height() * cs->pixelSize();
+            QVector<quint8> spatialData(numBytes);
+            QVector<quint8> iirData(numBytes);
+            spatialDev->readBytes(spatialData.data(), applyRect);
+            iirDev->readBytes(iirData.data(), applyRect);
+
+            int maxDifference = 0;
+            qint64 totalDifference = 0;
+
+            for (int j = 0; j < numBytes; j++) {
+                const int difference = qAbs(int(spatialData[j]) - int(iirData[j]));
+                maxDifference = qMax(maxDifference, difference);
+                totalDifference += difference;
+            }
+
+            const qreal meanDifference = qreal(totalDifference) / numBytes;
+
+            dbgKrita << "Radius:" << radius << (horizontal ? "horizontal" : "vertical")
+                     << "max difference:" << maxDifference
+                     << "mean difference:" << meanDifference;
+
+            QVERIFY(maxDifference <= 4);
+            QVERIFY(meanDifference < 0.5);
+        }
+    }
+}
+
+void KisConvolutionPainterTest::testApplyGaussianApproximation()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    const QRect applyRect(0, 0, 300, 200);
+    const qreal radius = 60;
+
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->fill(applyRect, KoColor(Qt::white, cs));
+    dev->fill(QRect(30, 20, 100, 60), KoColor(Qt::black, cs));
+    dev->fill(QRect(200, 100, 80, 80), KoColor(Qt::blue, cs));
+
+    KisPaintDeviceSP exactDev = new KisPaintDevice(*dev);
+    KisGaussianKernel::applyGaussian(exactDev, applyRect, radius, radius, QBitArray(), 0);
+
+    KisPaintDeviceSP approxDev = new KisPaintDevice(*dev);
+    KisGaussianKernel::applyGaussian(approxDev, applyRect, radius, radius, QBitArray(), 0, true);
+
+    const int numBytes = applyRect.width() * applyRect.height() * cs->pixelSize();
+    QVector<quint8> exactData(numBytes);
+    QVector<quint8> approxData(numBytes);
+    exactDev->readBytes(exactData.data(), applyRect);
+    approxDev->readBytes(approxData.data(), applyRect);
+
+    // the big kernel has been applied with the recursive filter...
+    QVERIFY(exactData != approxData);
+
+    int maxDifference = 0;
+    qint64 totalDifference = 0;
+
+    for (int j = 0; j < numBytes; j++) {
+        const int difference = qAbs(int(exactData[j]) - int(approxData[j]));
+        maxDifference = qMax(maxDifference, difference);
+        totalDifference += difference;
+    }
+
+    // ...which stays close to the exact convolution
+    QVERIFY(maxDifference <= 8);
+    QVERIFY(qreal(totalDifference) / numBytes < 0.5);
+}
+
 QTEST_MAIN(KisConvolutionPainterTest)
@@ -22,8 +22,12 @@
 #include <KoColorSpace.h>
 #include <KoColorSpaceRegistry.h>
 #include <KoHistogramProducer.h>
+#include <KoBasicHistogramProducers.h>
+#include <KoColor.h>
 #include "kis_paint_device.h"
 #include "kis_histogram.h"
+#include "kis_histogram_cache.h"
+#include "kis_random_accessor_ng.h"
 #include "kis_paint_layer.h"
 #include "kis_types.h"
 
@@ -46,4 +50,71 @@ void KisHistogramTest::testCreation()
 }
 
 
+void compareHistograms(KoHistogramProducer *producer, KoHistogramProducer *referenceProducer)
+{
+    QCOMPARE(producer->count(), referenceProducer->count());
+
+    for (int channel = 0; channel < producer->channels().size(); channel++) {
+        for (int bin = 0; bin < producer->numberOfBins(); bin++) {
+            QCOMPARE(producer->getBinAt(channel, bin), referenceProducer->getBinAt(channel, bin));
+        }
+    }
+}
+
+void KisHistogramTest::testHistogramCache()
+{
+    const KoColorSpace * cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+    dev->setX(10);
+    dev->setY(-7);
+
+    dev->fill(QRect(0, 0, 700, 500), KoColor(Qt::red, cs));
+    dev->fill(QRect(300, 200, 100, 100), KoColor(Qt::blue, cs));
+
+    KisHistogramCache cache([cs] () { return new KoBasicU8HistogramProducer(KoID("test"), cs); });
+
+    const QRect rect(-20, 30, 800, 400);
+
+    KoBasicU8HistogramProducer producer(KoID("test"), cs);
+
+    // KisHistogram owns its producer
+    KisHistogram referenceHistogram(dev, rect, new KoBasicU8HistogramProducer(KoID("test"), cs), LINEAR);
+
+    cache.computeHistogram(dev, rect, &producer);
+    compareHistograms(&producer, referenceHistogram.producer());
+    QVERIFY(producer.count() > 0);
+
+    // only the changed cells are rescanned, the rest come from the cache
+    dev->fill(QRect(350, 250, 300, 30), KoColor(Qt::green, cs));
+
+    cache.computeHistogram(dev, rect, &producer);
+    referenceHistogram.updateHistogram();
+    compareHistograms(&producer, referenceHistogram.producer());
+
+    // the cells on the border of the rect are clipped differently
+    const QRect shiftedRect = rect.translated(33, 17);
+    KisHistogram shiftedReferenceHistogram(dev, shiftedRect, new KoBasicU8HistogramProducer(KoID("test"), cs), LINEAR);
+
+    cache.computeHistogram(dev, shiftedRect, &producer);
+    compareHistograms(&producer, shiftedReferenceHistogram.producer());
+
+    /**
+     * A cell scanned while one of its tiles is being written
+     * should be rescanned when the write is finished
+     */
+    {
+        KisRandomAccessorSP it = dev->createRandomAccessorNG(0, 0);
+        it->moveTo(100, 100);
+
+        cache.computeHistogram(dev, rect, &producer);
+
+        memcpy(it->rawData(), KoColor(Qt::white, cs).data(), cs->pixelSize());
+    }
+
+    cache.computeHistogram(dev, rect, &producer);
+    referenceHistogram.updateHistogram();
+    compareHistograms(&producer, referenceHistogram.producer());
+}
+
+
 QTEST_MAIN(KisHistogramTest)
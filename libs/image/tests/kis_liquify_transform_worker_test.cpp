@@ -154,4 +154,37 @@ void KisLiquifyTransformWorkerTest::testIdentityTransform()
     TestUtil::checkQImage(result, "liquify_transform_test", "liquify_dev", "identity");
 }
 
+void KisLiquifyTransformWorkerTest::testIncrementalQImageUpdate()
+{
+    QImage image(TestUtil::fetchDataFileLazy("test_transform_quality_second.png"));
+    image = image.convertToFormat(QImage::Format_ARGB32);
+
+    const QRect srcBounds = image.rect();
+    const QTransform imageToThumbTransform = QTransform::fromScale(0.5, 0.5);
+    const QImage thumb = image.scaled(image.size() / 2);
+
+    KisLiquifyTransformWorker worker(srcBounds, 0, 8);
+
+    for (int i = 0; i < 10; i++) {
+        worker.translatePoints(QPointF(100 + 20 * i, 100 + 5 * i),
+                               QPointF(10, 0),
+                               30, false, 0.2);
+
+        QPointF incrementalOffset;
+        QImage incrementalResult =
+            worker.runOnQImage(thumb, QPointF(), imageToThumbTransform, &incrementalOffset);
+
+        // a new worker has no cached image, so it renders everything
+        KisLiquifyTransformWorker freshWorker(srcBounds, 0, 8);
+        freshWorker.transformedPoints() = worker.transformedPoints();
+
+        QPointF fullOffset;
+        QImage fullResult =
+            freshWorker.runOnQImage(thumb, QPointF(), imageToThumbTransform, &fullOffset);
+
+        QCOMPARE(incrementalOffset, fullOffset);
+        QVERIFY(incrementalResult == fullResult);
+    }
+}
+
 QTEST_MAIN(KisLiquifyTransformWorkerTest)
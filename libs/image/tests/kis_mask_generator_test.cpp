@@ -25,6 +25,13 @@
 
 #include <QDomDocument>
 #include <QImage>
+#include <QtMath>
+
+#include <KoColor.h>
+#include <KoColorSpace.h>
+#include <KoColorSpaceRegistry.h>
+#include "kis_fixed_paint_device.h"
+#include "kis_brush_mask_applicator_base.h"
 
 QImage createQImageFromMask(const KisMaskGenerator& generator)
 {
@@ -181,5 +188,95 @@ void KisMaskGeneratorTest::testCopyCtorGaussRect()
     testCopyCtor(&gen);
 }
 
+KisFixedPaintDeviceSP applyMask(KisMaskGenerator *gen, KisBrushMaskApplicatorBase *applicator, qreal angle)
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    const QRect bounds(0, 0, qCeil(gen->width()) + 2, qCeil(gen->height()) + 2);
+
+    KisFixedPaintDeviceSP dev = new KisFixedPaintDevice(cs);
+    dev->setRect(bounds);
+    dev->initialize();
+    dev->fill(bounds, KoColor(Qt::black, cs));
+
+    MaskProcessingData data(dev, cs,
+                            0.0, 1.0,
+                            0.5 * bounds.width(), 0.5 * bounds.height(), angle);
+
+    applicator->initializeData(&data);
+    applicator->process(bounds);
+
+    return dev;
+}
+
+void testVectorApplicator(KisMaskGenerator *gen)
+{
+    /**
+     * The vectorized row processors use single precision math and do
+     * not round the intermediate values to 8-bit, so the result may
+     * differ from the scalar version by a few units in the last place.
+     */
+    const int tolerance = 3;
+
+    Q_FOREACH (qreal angle, QList<qreal>() << 0.0 << 0.3 * M_PI) {
+        KisFixedPaintDeviceSP vectorDev = applyMask(gen, gen->applicator(), angle);
+        KisFixedPaintDeviceSP scalarDev = applyMask(gen, gen->KisMaskGenerator::applicator(), angle);
+
+        const int numPixels = vectorDev->bounds().width() * vectorDev->bounds().height();
+        const int pixelSize = vectorDev->pixelSize();
+
+        const quint8 *vectorPtr = vectorDev->data();
+        const quint8 *scalarPtr = scalarDev->data();
+
+        for (int i = 0; i < numPixels; i++) {
+            const int vectorAlpha = vectorDev->colorSpace()->opacityU8(vectorPtr);
+            const int scalarAlpha = scalarDev->colorSpace()->opacityU8(scalarPtr);
+
+            if (qAbs(vectorAlpha - scalarAlpha) > tolerance) {
+                qDebug() << ppVar(i) << ppVar(angle) << ppVar(vectorAlpha) << ppVar(scalarAlpha);
+                QFAIL("vector and scalar applicators gave different results");
+            }
+
+            vectorPtr += pixelSize;
+            scalarPtr += pixelSize;
+        }
+    }
+}
+
+void KisMaskGeneratorTest::testVectorApplicatorCircle()
+{
+    KisCircleMaskGenerator gen(50, 0.8, 0.75, 0.85, 2, true);
+    testVectorApplicator(&gen);
+}
+
+void KisMaskGeneratorTest::testVectorApplicatorRect()
+{
+    KisRectangleMaskGenerator gen(50, 0.8, 0.75, 0.85, 2, true);
+    testVectorApplicator(&gen);
+}
+
+void KisMaskGeneratorTest::testVectorApplicatorGaussCircle()
+{
+    KisGaussCircleMaskGenerator gen(50, 0.8, 0.75, 0.85, 2, true);
+    gen.setScale(1.0, 1.0);
+    testVectorApplicator(&gen);
+}
+
+void KisMaskGeneratorTest::testVectorApplicatorGaussRect()
+{
+    KisGaussRectangleMaskGenerator gen(50, 0.8, 0.75, 0.85, 2, true);
+    testVectorApplicator(&gen);
+}
+
+void KisMaskGeneratorTest::testVectorApplicatorCurveCircle()
+{
+    KisCurveCircleMaskGenerator gen(50, 0.8, 0.75, 0.85, 2, KisCubicCurve(), true);
+    testVectorApplicator(&gen);
+}
+
+void KisMaskGeneratorTest::testVectorApplicatorCurveRect()
+{
+    KisCurveRectangleMaskGenerator gen(50, 0.8, 0.75, 0.85, 2, KisCubicCurve(), true);
+    testVectorApplicator(&gen);
+}
 
 QTEST_MAIN(KisMaskGeneratorTest)
@@ -2266,4 +2266,75 @@ void KisPaintDeviceTest::testCompositionAssociativity()
     }
 }
 
+void KisPaintDeviceTest::testIsOpaque()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+
+    const QRect rc(0, 0, 128, 128);
+
+    QVERIFY(!dev->isOpaque(rc));
+
+    dev->fill(rc, KoColor(Qt::white, cs));
+    QVERIFY(dev->isOpaque(rc));
+    QVERIFY(dev->isOpaque(QRect(10, 10, 20, 20)));
+    QVERIFY(!dev->isOpaque(QRect(100, 100, 50, 50)));
+
+    // the cached state is reset on write
+    dev->setPixel(70, 70, QColor(255, 255, 255, 128));
+    QVERIFY(dev->isOpaque(QRect(10, 10, 20, 20)));
+    QVERIFY(!dev->isOpaque(rc));
+
+    dev->setPixel(70, 70, QColor(Qt::black));
+    QVERIFY(dev->isOpaque(rc));
+
+    // the offset of the device is taken into account
+    dev->setX(64);
+    QVERIFY(!dev->isOpaque(rc));
+    QVERIFY(dev->isOpaque(rc.translated(64, 0)));
+
+    // opaque default pixel
+    KisPaintDeviceSP background = new KisPaintDevice(cs);
+    background->setDefaultPixel(KoColor(Qt::white, cs));
+    QVERIFY(background->isOpaque(QRect(-1000, -1000, 3000, 3000)));
+
+    // the same data in a different color space
+    const KoColorSpace *cs16 = KoColorSpaceRegistry::instance()->rgb16();
+    KisPaintDeviceSP dev16 = new KisPaintDevice(cs16);
+    dev16->fill(rc, KoColor(Qt::white, cs16));
+    QVERIFY(dev16->isOpaque(rc));
+
+    dev16->setPixel(10, 10, QColor(255, 255, 255, 254));
+    QVERIFY(!dev16->isOpaque(rc));
+}
+
+void KisPaintDeviceTest::testIsOpaqueDuringWrite()
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+    KisPaintDeviceSP dev = new KisPaintDevice(cs);
+
+    const QRect tileRect(0, 0, 64, 64);
+
+    dev->fill(tileRect, KoColor(Qt::white, cs));
+    QVERIFY(dev->isOpaque(tileRect));
+
+    {
+        KisRandomAccessorSP it = dev->createRandomAccessorNG(0, 0);
+        it->moveTo(5, 5);
+
+        /**
+         * The tile is locked for writing, so the old opaque
+         * pixels should neither be reported nor be cached
+         */
+        QVERIFY(!dev->isOpaque(tileRect));
+
+        cs->setOpacity(it->rawData(), OPACITY_TRANSPARENT_U8, 1);
+    }
+
+    QVERIFY(!dev->isOpaque(tileRect));
+
+    dev->setPixel(5, 5, QColor(Qt::white));
+    QVERIFY(dev->isOpaque(tileRect));
+}
+
 QTEST_MAIN(KisPaintDeviceTest)
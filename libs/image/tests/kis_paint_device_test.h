@@ -79,6 +79,9 @@ private Q_SLOTS:
     void testCopyPaintDeviceWithFrames();
 
     void testCompositionAssociativity();
+
+    void testIsOpaque();
+    void testIsOpaqueDuringWrite();
 };
 
 #endif
@@ -70,4 +70,26 @@ void KisPerspectiveTransformWorkerTest::testSimpleTransform()
     t.checkLayer("simple_transform");
 }
 
+void KisPerspectiveTransformWorkerTest::testMultithreadedTransform()
+{
+    PerspectiveWorkerTester t;
+    KisPaintDeviceSP dev = t.paintDevice();
+    KisPaintDeviceSP threadedDev = new KisPaintDevice(*dev);
+
+    QPointF dx(326, 214);
+    qreal aX = 1.32;
+    qreal aY = 0.8;
+    qreal z = 1024;
+
+    KisPerspectiveTransformWorker worker(dev, dx, aX, aY, z, 0);
+    worker.run();
+
+    KisPerspectiveTransformWorker threadedWorker(threadedDev, dx, aX, aY, z, 0);
+    threadedWorker.setUseMultithreading(true);
+    threadedWorker.run();
+
+    QCOMPARE(threadedDev->exactBounds(), dev->exactBounds());
+    QVERIFY(threadedDev->convertToQImage(0) == dev->convertToQImage(0));
+}
+
 QTEST_MAIN(KisPerspectiveTransformWorkerTest)
@@ -994,4 +994,54 @@ void KisTransformWorkerTest::testPartialProcessing()
     TestUtil::checkQImage(result, "transform_test", "partial", "single");
 }
 
+void KisTransformWorkerTest::testMultithreadedProcessing()
+{
+    const KoColorSpace * cs = KoColorSpaceRegistry::instance()->rgb8();
+    QImage image(QString(FILES_DATA_DIR) + QDir::separator() + "hakonepa.png");
+
+    struct Params {
+        qreal scale;
+        qreal rotation;
+        qreal shear;
+    };
+
+    const QVector<Params> params({
+        {1.379, 0.0, 0.0},
+        {0.734, 0.0, 0.0},
+        {1.0, M_PI / 6.0, 0.0},
+        {1.0, 2 * M_PI / 3.0, 0.0},
+        {1.0, 0.0, 0.479},
+        {1.379, M_PI / 6.0, 0.479}});
+
+    Q_FOREACH (const Params &p, params) {
+        KisPaintDeviceSP serialDev = new KisPaintDevice(cs);
+        serialDev->convertFromQImage(image, 0);
+
+        KisPaintDeviceSP threadedDev = new KisPaintDevice(cs);
+        threadedDev->convertFromQImage(image, 0);
+
+        KisBicubicFilterStrategy filter;
+
+        KisTransformWorker serialWorker(serialDev, p.scale, p.scale,
+                                        p.shear, 0.0,
+                                        0.0, 0.0,
+                                        p.rotation,
+                                        0, 0,
+                                        0, &filter);
+        serialWorker.run();
+
+        KisTransformWorker threadedWorker(threadedDev, p.scale, p.scale,
+                                          p.shear, 0.0,
+                                          0.0, 0.0,
+                                          p.rotation,
+                                          0, 0,
+                                          0, &filter);
+        threadedWorker.setUseMultithreading(true);
+        threadedWorker.run();
+
+        QCOMPARE(threadedDev->exactBounds(), serialDev->exactBounds());
+        QVERIFY(threadedDev->convertToQImage(0) == serialDev->convertToQImage(0));
+    }
+}
+
 QTEST_MAIN(KisTransformWorkerTest)
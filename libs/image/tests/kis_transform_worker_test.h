@@ -63,6 +63,7 @@ private Q_SLOTS:
     void benchmarkScaleRotateShear();
 
     void testPartialProcessing();
+    void testMultithreadedProcessing();
 
 private:
     void generateTestImages();
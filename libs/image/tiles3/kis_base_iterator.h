@@ -54,6 +54,12 @@ protected:
         tile->lockForRead();
     }
     inline void unlockTile(KisTileSP &tile) {
+        if (m_writable)
+            tile->unlockForWrite();
+        else
+            tile->unlock();
+    }
+    inline void unlockOldTile(KisTileSP &tile) {
         tile->unlock();
     }
 
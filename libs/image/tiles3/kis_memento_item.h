@@ -143,6 +143,20 @@ public:
         m_committedFlag = true;
     }
 
+    /**
+     * Replaces the data of a committed item with the \p tileData
+     * of the same content
+     */
+    void replaceCommittedTileData(KisTileData *tileData) {
+        Q_ASSERT(m_committedFlag);
+
+        tileData->acquire();
+        tileData->setMementoed(true);
+
+        releaseTileData();
+        m_tileData = tileData;
+    }
+
     inline KisTileSP tile(KisMementoManager *mm) {
         Q_ASSERT(m_tileData);
         return KisTileSP(new KisTile(m_col, m_row, m_tileData, mm));
@@ -215,6 +215,16 @@ void KisMementoManager::commit()
     KisTileDataStore::instance()->kickPooler();
 }
 
+void KisMementoManager::replaceCommittedTileData(qint32 col, qint32 row,
+                                                 KisTileData *oldData, KisTileData *newData)
+{
+    KisMementoItemSP mi = m_headsHashTable.getExistingTile(col, row);
+
+    if (mi && mi->tileData() == oldData) {
+        mi->replaceCommittedTileData(newData);
+    }
+}
+
 KisTileSP KisMementoManager::getCommitedTile(qint32 col, qint32 row)
 {
     /**
@@ -77,6 +77,16 @@ public:
      */
     void commit();
 
+    /**
+     * Makes the committed version of the tile (col, row) reference
+     * \p newData instead of \p oldData. It is used when the data of
+     * the tile is replaced by an equal shared one, so that the history
+     * doesn't keep the old copy alive. Does nothing if the committed
+     * version doesn't reference \p oldData.
+     */
+    void replaceCommittedTileData(qint32 col, qint32 row,
+                                  KisTileData *oldData, KisTileData *newData);
+
     /**
      * Undo and Redo stuff respectively.
      *
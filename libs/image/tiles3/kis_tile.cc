@@ -19,6 +19,9 @@
 
 //#define DEAD_TILES_SANITY_CHECK
 
+#include <string.h>
+#include <QByteArray>
+
 #include "kis_tile_data.h"
 #include "kis_tile_data_store.h"
 #include "kis_tile.h"
@@ -32,6 +35,7 @@ void KisTile::init(qint32 col, qint32 row,
     m_col = col;
     m_row = row;
     m_lockCounter = 0;
+    m_writersCounter = 0;
 
     m_extent = QRect(m_col * KisTileData::WIDTH, m_row * KisTileData::HEIGHT,
                      KisTileData::WIDTH, KisTileData::HEIGHT);
@@ -134,6 +138,15 @@ inline void KisTile::unblockSwapping() const
     Q_ASSERT(m_lockCounter > 0);
 
     if(--m_lockCounter == 0) {
+        /**
+         * The write lock might have been released with a plain
+         * unlock(). No one holds the tile now, so the write is over.
+         */
+        if (m_writersCounter > 0) {
+            m_writersCounter = 0;
+            m_tileData->endWrite();
+        }
+
         m_tileData->unblockSwapping();
 
         if(!m_oldTileData.isEmpty()) {
@@ -188,7 +201,18 @@ void KisTile::lockForWrite()
             tileData->acquire();
             tileData->blockSwapping();
             KisTileData *oldTileData = m_tileData;
-            m_tileData = tileData;
+
+            {
+                QMutexLocker locker(&m_swapBarrierLock);
+                m_tileData = tileData;
+
+                // the writers already holding the tile move to the new data
+                if (m_writersCounter > 0) {
+                    tileData->beginWrite();
+                    oldTileData->endWrite();
+                }
+            }
+
             safeReleaseOldTileData(oldTileData);
 
             DEBUG_COWING(tileData);
@@ -199,6 +223,14 @@ void KisTile::lockForWrite()
         m_COWMutex.unlock();
     }
 
+    {
+        QMutexLocker locker(&m_swapBarrierLock);
+
+        if (!m_writersCounter++) {
+            m_tileData->beginWrite();
+        }
+    }
+
     DEBUG_LOG_ACTION("lock [W]");
 }
 
@@ -208,6 +240,93 @@ void KisTile::unlock() const
     DEBUG_LOG_ACTION("unlock");
 }
 
+void KisTile::unlockForWrite()
+{
+    {
+        QMutexLocker locker(&m_swapBarrierLock);
+        Q_ASSERT(m_writersCounter > 0);
+
+        if (m_writersCounter > 0 && !--m_writersCounter) {
+            m_tileData->endWrite();
+        }
+    }
+
+    unlock();
+}
+
+void KisTile::prefetchSwappedData() const
+{
+    /**
+     * The barrier lock guarantees the tile data will not be
+     * released by a concurrent COW until the store takes
+     * its own reference to it
+     */
+    QMutexLocker locker(&m_swapBarrierLock);
+
+    if (!m_tileData->data()) {
+        KisTileDataStore::instance()->prefetchTileData(m_tileData);
+    }
+}
+
+
+bool KisTile::tryShareUniformData(KisTileData *defaultTileData)
+{
+    /**
+     * Keep the same lock ordering as in lockForWrite(). When no one
+     * holds the tile locked, no one can write into it, so the data
+     * will not change under our feet.
+     */
+    QMutexLocker cowLocker(&m_COWMutex);
+    QMutexLocker locker(&m_swapBarrierLock);
+
+    if (m_lockCounter > 0 || m_tileData == defaultTileData) return false;
+
+    const qint32 pixelSize = m_tileData->pixelSize();
+    const qint32 tileSize = pixelSize * KisTileData::WIDTH * KisTileData::HEIGHT;
+
+    m_tileData->blockSwapping();
+    const quint8 *data = m_tileData->data();
+
+    /**
+     * The buffer is uniform iff it is equal to
+     * itself shifted by one pixel
+     */
+    const bool isUniform = !memcmp(data, data + pixelSize, tileSize - pixelSize);
+    QByteArray pixel;
+
+    if (isUniform) {
+        pixel = QByteArray((const char*)data, pixelSize);
+    }
+
+    m_tileData->unblockSwapping();
+
+    if (!isUniform) return false;
+
+    KisTileData *sharedTileData = 0;
+
+    defaultTileData->blockSwapping();
+    const bool isDefault = !memcmp(defaultTileData->data(), pixel.constData(), pixelSize);
+    defaultTileData->unblockSwapping();
+
+    if (isDefault) {
+        sharedTileData = defaultTileData;
+        sharedTileData->acquire();
+    } else {
+        sharedTileData = KisTileDataStore::instance()->
+            acquireUniformTileData(pixelSize, (const quint8*) pixel.constData());
+    }
+
+    if (sharedTileData == m_tileData) {
+        sharedTileData->release();
+        return false;
+    }
+
+    KisTileData *oldTileData = m_tileData;
+    m_tileData = sharedTileData;
+    oldTileData->release();
+
+    return true;
+}
 
 #include <stdio.h>
 void KisTile::debugPrintInfo()
@@ -75,6 +75,33 @@ public:
     void lockForWrite();
     void unlock() const;
 
+    /**
+     * Releases the lock taken by lockForWrite(). The tile data is
+     * notified about the end of the write as soon as the last writer
+     * leaves. If the write lock is released with a plain unlock(),
+     * the write is considered finished only when the tile gets
+     * unlocked by everyone.
+     */
+    void unlockForWrite();
+
+    /**
+     * Hints the tile data store that the data of this tile will be
+     * accessed soon. If the data has been swapped out, it will be
+     * loaded back by the swapper thread asynchronously.
+     */
+    void prefetchSwappedData() const;
+
+    /**
+     * If all the pixels of the tile have the same color, replaces
+     * its data with a tile data shared among all the uniform tiles
+     * of this color. \p defaultTileData is used when the color is
+     * the same as the one of the default tile data. Nothing happens
+     * if the tile is locked by anyone.
+     *
+     * \return true if the tile data has been replaced
+     */
+    bool tryShareUniformData(KisTileData *defaultTileData);
+
     /* this allows us work directly on tile's data */
     inline quint8 *data() const {
         return m_tileData->data();
@@ -127,6 +154,12 @@ private:
     mutable QStack<KisTileData*> m_oldTileData;
     mutable volatile int m_lockCounter;
 
+    /**
+     * The number of the write locks held, guarded by
+     * m_swapBarrierLock
+     */
+    mutable int m_writersCounter;
+
     qint32 m_col;
     qint32 m_row;
 
@@ -20,6 +20,7 @@
 #include "kis_tile_data.h"
 #include "kis_tile_data_store.h"
 
+#include <QHash>
 #include <kis_debug.h>
 
 #include <boost/pool/singleton_pool.hpp>
@@ -35,15 +36,22 @@ typedef boost::singleton_pool<KisTileData, TILE_SIZE_8BPP, boost::default_user_a
 const qint32 KisTileData::WIDTH = __TILE_DATA_WIDTH;
 const qint32 KisTileData::HEIGHT = __TILE_DATA_HEIGHT;
 
+QAtomicInt KisTileData::s_lastId(0);
+
 
 KisTileData::KisTileData(qint32 pixelSize, const quint8 *defPixel, KisTileDataStore *store)
     : m_state(NORMAL),
       m_mementoFlag(0),
       m_age(0),
+      m_swapPriority(NORMAL_PRIORITY),
       m_usersCount(0),
       m_refCount(0),
       m_pixelSize(pixelSize),
-      m_store(store)
+      m_store(store),
+      m_opacityCache(0),
+      m_writersCount(0),
+      m_id(s_lastId.fetchAndAddRelaxed(1) + 1),
+      m_contentsCounter(0)
 {
     m_store->checkFreeMemory();
     m_data = allocateData(m_pixelSize);
@@ -67,10 +75,15 @@ KisTileData::KisTileData(const KisTileData& rhs, bool checkFreeMemory)
     : m_state(NORMAL),
       m_mementoFlag(0),
       m_age(0),
+      m_swapPriority(rhs.m_swapPriority),
       m_usersCount(0),
       m_refCount(0),
       m_pixelSize(rhs.m_pixelSize),
-      m_store(rhs.m_store)
+      m_store(rhs.m_store),
+      m_opacityCache(0),
+      m_writersCount(0),
+      m_id(s_lastId.fetchAndAddRelaxed(1) + 1),
+      m_contentsCounter(0)
 {
     if(checkFreeMemory) {
         m_store->checkFreeMemory();
@@ -93,6 +106,94 @@ void KisTileData::fillWithPixel(const quint8 *defPixel)
     for (int i = 0; i < WIDTH*HEIGHT; i++, it += m_pixelSize) {
         memcpy(it, defPixel, m_pixelSize);
     }
+
+    notifyDataChanged();
+}
+
+namespace {
+
+template <typename T>
+bool checkAlphaEquals(const quint8 *alphaIt, qint32 pixelSize, qint32 numPixels, const quint8 *opaqueAlpha)
+{
+    T opaqueValue;
+    memcpy(&opaqueValue, opaqueAlpha, sizeof(T));
+
+    for (qint32 i = 0; i < numPixels; i++, alphaIt += pixelSize) {
+        T value;
+        memcpy(&value, alphaIt, sizeof(T));
+
+        if (value != opaqueValue) return false;
+    }
+
+    return true;
+}
+
+}
+
+bool KisTileData::isOpaque(qint32 alphaOffset, qint32 alphaSize, const quint8 *opaqueAlpha) const
+{
+    enum {
+        STATE_OPAQUE = 0x1,
+        STATE_TRANSPARENT = 0x2,
+        STATE_MASK = 0x3
+    };
+
+    const quint32 key = quint32(qHashBits(opaqueAlpha, alphaSize, alphaOffset) & 0x0fffffff) << 2;
+
+    /**
+     * The counter should be fetched before checking for the writers,
+     * so that any write started after this point changes it
+     */
+    const quint32 counter = m_contentsCounter.loadAcquire();
+
+    // the pixels may change at any moment, so we cannot say anything
+    if (m_writersCount.loadAcquire() > 0) return false;
+
+    const quint64 cachedState = m_opacityCache.loadAcquire();
+    if (quint32(cachedState >> 32) == counter &&
+        (cachedState & STATE_MASK) &&
+        (quint32(cachedState) & ~quint32(STATE_MASK)) == key) {
+
+        return (cachedState & STATE_MASK) == STATE_OPAQUE;
+    }
+
+    const quint8 *alphaIt = m_data + alphaOffset;
+    const qint32 numPixels = WIDTH * HEIGHT;
+    bool result = true;
+
+    switch (alphaSize) {
+    case 1:
+        result = checkAlphaEquals<quint8>(alphaIt, m_pixelSize, numPixels, opaqueAlpha);
+        break;
+    case 2:
+        result = checkAlphaEquals<quint16>(alphaIt, m_pixelSize, numPixels, opaqueAlpha);
+        break;
+    case 4:
+        result = checkAlphaEquals<quint32>(alphaIt, m_pixelSize, numPixels, opaqueAlpha);
+        break;
+    default:
+        for (qint32 i = 0; i < numPixels; i++, alphaIt += m_pixelSize) {
+            if (memcmp(alphaIt, opaqueAlpha, alphaSize)) {
+                result = false;
+                break;
+            }
+        }
+    }
+
+    /**
+     * Don't trust the result if someone has written into the data
+     * while we were checking it. The cached state is tagged with the
+     * counter it was calculated for, so if a write starts right after
+     * this check, the stored state will just never match again.
+     */
+    if (m_contentsCounter.loadAcquire() == int(counter) && !m_writersCount.loadAcquire()) {
+        m_opacityCache.storeRelease((quint64(counter) << 32) |
+                                    key | (result ? STATE_OPAQUE : STATE_TRANSPARENT));
+    } else {
+        result = false;
+    }
+
+    return result;
 }
 
 void KisTileData::releaseMemory()
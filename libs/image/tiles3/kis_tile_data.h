@@ -38,6 +38,28 @@ inline quint8* KisTileData::data() const {
 void KisTileData::setData(const quint8 *data) {
     Q_ASSERT(m_data);
     memcpy(m_data, data, m_pixelSize*WIDTH*HEIGHT);
+    notifyDataChanged();
+}
+
+inline quint64 KisTileData::contentsVersion() const {
+    const quint32 counter = m_contentsCounter.loadAcquire();
+
+    return m_writersCount.loadAcquire() > 0 ? 0 :
+        (quint64(m_id) << 32) | counter;
+}
+
+inline void KisTileData::notifyDataChanged() {
+    m_contentsCounter.fetchAndAddOrdered(1);
+}
+
+inline void KisTileData::beginWrite() {
+    m_writersCount.ref();
+    m_contentsCounter.fetchAndAddOrdered(1);
+}
+
+inline void KisTileData::endWrite() {
+    m_contentsCounter.fetchAndAddOrdered(1);
+    m_writersCount.deref();
 }
 
 inline quint32 KisTileData::pixelSize() const {
@@ -129,6 +151,13 @@ inline void KisTileData::markOld() {
     m_age++;
 }
 
+inline KisTileData::EnumSwapPriority KisTileData::swapPriority() const {
+    return EnumSwapPriority(m_swapPriority);
+}
+inline void KisTileData::setSwapPriority(EnumSwapPriority priority) {
+    m_swapPriority = priority;
+}
+
 inline qint32 KisTileData::numUsers() const {
     return m_usersCount;
 }
@@ -20,6 +20,7 @@
 
 #include <QReadWriteLock>
 #include <QAtomicInt>
+#include <QMutex>
 
 #include "kis_lockless_stack.h"
 #include "swap/kis_chunk_allocator.h"
@@ -61,6 +62,17 @@ public:
         SWAPPED
     };
 
+    /**
+     * A hint for the swapper about the importance of the data.
+     * Low priority data leaves memory first, high priority data
+     * is swapped out only when there is nothing else left.
+     */
+    enum EnumSwapPriority {
+        LOW_PRIORITY = 0,
+        NORMAL_PRIORITY,
+        HIGH_PRIORITY
+    };
+
     /**
      * Information about data stored
      */
@@ -125,6 +137,13 @@ public:
     inline void resetAge();
     inline void markOld();
 
+    /**
+     * The swap priority of the tile data. It is inherited
+     * by the clones of the tile data.
+     */
+    inline EnumSwapPriority swapPriority() const;
+    inline void setSwapPriority(EnumSwapPriority priority);
+
     /**
      * Returns number of tiles (or memento items),
      * referencing the tile data.
@@ -139,6 +158,55 @@ public:
      */
      inline bool historical() const;
 
+    /**
+     * Returns true if the alpha channel of every pixel of the tile is
+     * equal to \p opaqueAlpha. The alpha channel is \p alphaSize
+     * bytes long and starts at \p alphaOffset of every pixel.
+     *
+     * The result is cached together with the contentsVersion() it was
+     * calculated for, so the repeated checks are cheap and any write
+     * access invalidates the cache. While someone writes into the tile
+     * data (see beginWrite()), the tile is reported as non-opaque and
+     * nothing is cached.
+     *
+     * The data should be loaded into memory by the caller
+     * (that is the swapping should be blocked).
+     */
+    bool isOpaque(qint32 alphaOffset, qint32 alphaSize, const quint8 *opaqueAlpha) const;
+
+    /**
+     * Returns the version of the tile data contents. It consists of
+     * the unique id of the tile data and a counter bumped by every
+     * write access, so two equal versions mean the pixels are the
+     * same. Used by caches of derived data, e.g. KisHistogramCache.
+     *
+     * While the data is being written (see beginWrite()), the version
+     * is zero. Such data should not be cached. The version is changed
+     * again when the write finishes, so anything computed from the
+     * data during the write gets a stale version.
+     */
+    inline quint64 contentsVersion() const;
+
+    /**
+     * Assigns a new contentsVersion(), which also invalidates the
+     * cached result of isOpaque()
+     */
+    inline void notifyDataChanged();
+
+    /**
+     * Called by KisTile when the first writer locks the tile. Until the
+     * matching endWrite() call the pixels may change at any moment, so
+     * isOpaque() doesn't cache anything.
+     */
+    inline void beginWrite();
+
+    /**
+     * Called by KisTile when the last writer releases the tile. Assigns
+     * a new contentsVersion(), so the results computed during the write
+     * become invalid.
+     */
+    inline void endWrite();
+
     /**
      * Used for swapping purposes only.
      * Frees the memory occupied by the tile data.
@@ -229,6 +297,12 @@ private:
     //FIXME: make memory aligned
     int m_age;
 
+    /**
+     * \see EnumSwapPriority. Is just a hint, so it is
+     * not protected by any lock
+     */
+    int m_swapPriority;
+
 
     /**
      * The primitive for controlling swapping of the tile.
@@ -264,6 +338,28 @@ private:
     //qint32 m_timeStamp;
 
     KisTileDataStore *m_store;
+
+    /**
+     * The cached result of isOpaque(). The higher 32 bits store the
+     * m_contentsCounter the result is valid for. Of the lower ones,
+     * two bits store the result (zero means unknown) and the rest is
+     * the key of the checked alpha channel layout.
+     */
+    mutable QAtomicInteger<quint64> m_opacityCache;
+
+    /**
+     * The number of the tiles holding this data locked for writing
+     */
+    QAtomicInt m_writersCount;
+
+    /**
+     * Unique id of the tile data and the counter of the write accesses,
+     * which form contentsVersion()
+     */
+    const quint32 m_id;
+    QAtomicInt m_contentsCounter;
+    static QAtomicInt s_lastId;
+
 public:
     static const qint32 WIDTH;
     static const qint32 HEIGHT;
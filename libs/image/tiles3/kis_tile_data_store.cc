@@ -20,8 +20,10 @@
 #include "config-memory-leak-tracker.h"
 
 #include <QGlobalStatic>
+#include <QElapsedTimer>
 
 #include "kis_tile_data_store.h"
+#include "kis_image_config.h"
 #include "kis_tile_data.h"
 #include "kis_debug.h"
 
@@ -29,6 +31,18 @@
 
 Q_GLOBAL_STATIC(KisTileDataStore, s_instance)
 
+/**
+ * Do not let the prefetch requests pile up if the
+ * swapper cannot keep up with them
+ */
+const int MAX_PREFETCH_QUEUE_SIZE = 4096;
+
+/**
+ * The number of colors of the shared uniform tiles, after which
+ * we try to clean up the ones not used anymore
+ */
+const int MAX_UNIFORM_TILES = 1024;
+
 //#define DEBUG_PRECLONE
 
 #ifdef DEBUG_PRECLONE
@@ -70,7 +84,14 @@ KisTileDataStore::KisTileDataStore()
     : m_pooler(this),
       m_swapper(this),
       m_numTiles(0),
-      m_memoryMetric(0)
+      m_memoryMetric(0),
+      m_numCompressedTierHits(0),
+      m_numCompressedTierMisses(0),
+      m_shareUniformTiles(KisImageConfig().shareUniformTiles()),
+      m_numSwapIns(0),
+      m_totalSwapInTime(0),
+      m_maxSwapInTime(0),
+      m_numPrefetchedTiles(0)
 {
     m_clockIterator = m_tileDataList.end();
     m_pooler.start();
@@ -82,6 +103,16 @@ KisTileDataStore::~KisTileDataStore()
     m_pooler.terminatePooler();
     m_swapper.terminateSwapper();
 
+    Q_FOREACH (KisTileData *td, m_prefetchQueue) {
+        td->deref();
+    }
+    m_prefetchQueue.clear();
+
+    Q_FOREACH (KisTileData *td, m_uniformTiles) {
+        td->release();
+    }
+    m_uniformTiles.clear();
+
     if(numTiles() > 0) {
          errKrita << "Warning: some tiles have leaked:";
          errKrita << "\tTiles in memory:" << numTilesInMemory() << "\n"
@@ -112,10 +143,23 @@ KisTileDataStore::MemoryStatistics KisTileDataStore::memoryStatistics()
     stats.historicalMemorySize = m_pooler.lastHistoricalMemoryMetric() * metricCoeff;
     stats.poolSize = m_pooler.lastPoolMemoryMetric() * metricCoeff;
 
-    stats.totalMemorySize = memoryMetric() * metricCoeff + stats.poolSize;
+    stats.totalMemorySize = memoryMetricImpl() * metricCoeff + stats.poolSize;
 
     stats.swapSize = m_swappedStore.totalMemoryMetric() * metricCoeff;
 
+    stats.compressedTierSize = m_compressedStore.compressedMemorySize();
+    stats.compressedTierUncompressedSize = m_compressedStore.totalMemoryMetric() * metricCoeff;
+    stats.numCompressedTierHits = m_numCompressedTierHits;
+    stats.numCompressedTierMisses = m_numCompressedTierMisses;
+
+    {
+        QMutexLocker statsLocker(&m_swapStatsLock);
+        stats.numSwapIns = m_numSwapIns;
+        stats.totalSwapInTime = m_totalSwapInTime;
+        stats.maxSwapInTime = m_maxSwapInTime;
+        stats.numPrefetchedTiles = m_numPrefetchedTiles;
+    }
+
     return stats;
 }
 
@@ -188,7 +232,11 @@ void KisTileDataStore::freeTileData(KisTileData *td)
     td->m_swapLock.lockForWrite();
 
     if(!td->data()) {
-        m_swappedStore.forgetTileData(td);
+        if (td->m_state == KisTileData::COMPRESSED) {
+            m_compressedStore.forgetTileData(td);
+        } else {
+            m_swappedStore.forgetTileData(td);
+        }
     }
     else {
         unregisterTileDataImp(td);
@@ -203,6 +251,9 @@ void KisTileDataStore::freeTileData(KisTileData *td)
 void KisTileDataStore::ensureTileDataLoaded(KisTileData *td)
 {
 //    dbgKrita << "#### SWAP MISS! ####" << td << ppVar(td->mementoed()) << ppVar(td->age()) << ppVar(td->numUsers());
+    QElapsedTimer timer;
+    timer.start();
+
     checkFreeMemory();
 
     td->m_swapLock.lockForRead();
@@ -232,7 +283,15 @@ void KisTileDataStore::ensureTileDataLoaded(KisTileData *td)
         if(!td->data()) {
             td->m_swapLock.lockForWrite();
 
-            m_swappedStore.swapInTileData(td);
+            if (td->m_state == KisTileData::COMPRESSED) {
+                m_compressedStore.decompressTileData(td);
+                m_numCompressedTierHits++;
+            } else {
+                m_swappedStore.swapInTileData(td);
+                m_numCompressedTierMisses++;
+            }
+
+            td->m_state = KisTileData::NORMAL;
             registerTileDataImp(td);
 
             td->m_swapLock.unlock();
@@ -246,6 +305,106 @@ void KisTileDataStore::ensureTileDataLoaded(KisTileData *td)
 
         td->m_swapLock.lockForRead();
     }
+
+    // prefetching happens in background, so it doesn't stall anyone
+    if (QThread::currentThread() != &m_swapper) {
+        registerSwapIn(timer.nsecsElapsed() / 1000);
+    }
+}
+
+void KisTileDataStore::registerSwapIn(qint64 time)
+{
+    QMutexLocker locker(&m_swapStatsLock);
+
+    m_numSwapIns++;
+    m_totalSwapInTime += time;
+    m_maxSwapInTime = qMax(m_maxSwapInTime, time);
+}
+
+void KisTileDataStore::prefetchTileData(KisTileData *td)
+{
+    if (td->data()) return;
+
+    {
+        QMutexLocker locker(&m_prefetchLock);
+        if (m_prefetchQueue.size() >= MAX_PREFETCH_QUEUE_SIZE) return;
+
+        // keep the tile data alive until the swapper reaches it
+        td->ref();
+        m_prefetchQueue.append(td);
+    }
+
+    m_swapper.kickPrefetch();
+}
+
+void KisTileDataStore::processPrefetchQueue(qint64 memoryLimit)
+{
+    QVector<KisTileData*> queue;
+
+    {
+        QMutexLocker locker(&m_prefetchLock);
+        queue.swap(m_prefetchQueue);
+    }
+
+    qint64 numPrefetched = 0;
+
+    Q_FOREACH (KisTileData *td, queue) {
+        /**
+         * Swapping in a tile may trigger swapping out of other ones,
+         * which are needed by the user, so we stop prefetching at
+         * the limit and just drop the rest of the queue. The tiles
+         * kept in the compressed tier count against the limit too.
+         */
+        if (!td->data() && memoryMetric() + td->pixelSize() < memoryLimit) {
+            td->blockSwapping();
+            td->unblockSwapping();
+            numPrefetched++;
+        }
+
+        td->deref();
+    }
+
+    QMutexLocker locker(&m_swapStatsLock);
+    m_numPrefetchedTiles += numPrefetched;
+}
+
+KisTileData* KisTileDataStore::acquireUniformTileData(qint32 pixelSize, const quint8 *pixel)
+{
+    QMutexLocker locker(&m_uniformTilesLock);
+
+    const QByteArray key((const char*)pixel, pixelSize);
+    KisTileData *td = m_uniformTiles.value(key, 0);
+
+    if (!td) {
+        if (m_uniformTiles.size() >= MAX_UNIFORM_TILES) {
+            purgeUniformTileData();
+        }
+
+        td = allocTileData(pixelSize, pixel);
+        td->acquire();
+        m_uniformTiles.insert(key, td);
+    }
+
+    td->acquire();
+    return td;
+}
+
+void KisTileDataStore::purgeUniformTileData()
+{
+    /**
+     * Drop the colors not used by any tile. Called
+     * with m_uniformTilesLock acquired.
+     */
+
+    QHash<QByteArray, KisTileData*>::iterator it = m_uniformTiles.begin();
+    while (it != m_uniformTiles.end()) {
+        if ((*it)->numUsers() <= 1) {
+            (*it)->release();
+            it = m_uniformTiles.erase(it);
+        } else {
+            ++it;
+        }
+    }
 }
 
 bool KisTileDataStore::trySwapTileData(KisTileData *td)
@@ -259,7 +418,18 @@ bool KisTileDataStore::trySwapTileData(KisTileData *td)
 
     if(td->data()) {
         unregisterTileDataImp(td);
-        if (m_swappedStore.trySwapOutTileData(td)) {
+
+        /**
+         * Cold tiles are first kept compressed in memory, only the
+         * tiles that compress badly go to the swap file directly
+         */
+        if (m_compressedStore.isEnabled() &&
+            m_compressedStore.tryCompressTileData(td)) {
+
+            td->m_state = KisTileData::COMPRESSED;
+            result = true;
+        } else if (m_swappedStore.trySwapOutTileData(td)) {
+            td->m_state = KisTileData::SWAPPED;
             result = true;
         } else {
             result = false;
@@ -268,9 +438,39 @@ bool KisTileDataStore::trySwapTileData(KisTileData *td)
     }
     td->m_swapLock.unlock();
 
+    if (result && m_compressedStore.isOverLimit()) {
+        flushCompressedTiles();
+    }
+
     return result;
 }
 
+void KisTileDataStore::flushCompressedTiles()
+{
+    /**
+     * This function is called with m_listLock acquired, so no one
+     * can load the tiles back while we are moving them to disk.
+     * The data is written as it is, without recompression.
+     */
+
+    while (m_compressedStore.isOverLimit()) {
+        KisTileData *td = m_compressedStore.oldestTileData();
+        if (!td || !td->m_swapLock.tryLockForWrite()) break;
+
+        const bool result =
+            m_swappedStore.trySwapOutCompressedTileData(td, m_compressedStore.compressedData(td));
+
+        if (result) {
+            m_compressedStore.forgetTileData(td);
+            td->m_state = KisTileData::SWAPPED;
+        }
+
+        td->m_swapLock.unlock();
+
+        if (!result) break;
+    }
+}
+
 KisTileDataStoreIterator* KisTileDataStore::beginIteration()
 {
     m_listLock.lock();
@@ -349,6 +549,12 @@ void KisTileDataStore::debugClear()
 void KisTileDataStore::testingRereadConfig() {
     m_pooler.testingRereadConfig();
     m_swapper.testingRereadConfig();
+
+    {
+        QMutexLocker lock(&m_listLock);
+        m_compressedStore.testingRereadConfig();
+    }
+
     kickPooler();
 }
 
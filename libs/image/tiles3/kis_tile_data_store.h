@@ -21,11 +21,16 @@
 #include "kritaimage_export.h"
 
 #include <QReadWriteLock>
+#include <QMutex>
+#include <QVector>
+#include <QHash>
+#include <QByteArray>
 #include "kis_tile_data_interface.h"
 
 #include "kis_tile_data_pooler.h"
 #include "swap/kis_tile_data_swapper.h"
 #include "swap/kis_swapped_data_store.h"
+#include "swap/kis_compressed_data_store.h"
 
 class KisTileDataStoreIterator;
 class KisTileDataStoreReverseIterator;
@@ -51,6 +56,27 @@ public:
         qint64 poolSize;
 
         qint64 swapSize;
+
+        /**
+         * Swap-in statistics. Only the tiles loaded synchronously,
+         * that is, by the threads that actually needed the data,
+         * are counted in the latency values. Times are in microseconds.
+         */
+        qint64 numSwapIns;
+        qint64 totalSwapInTime;
+        qint64 maxSwapInTime;
+
+        qint64 numPrefetchedTiles;
+
+        /**
+         * The in-memory storage of compressed tiles. The hits are
+         * the swap-ins served by it, the misses are the ones that
+         * had to read the swap file.
+         */
+        qint64 compressedTierSize;
+        qint64 compressedTierUncompressedSize;
+        qint64 numCompressedTierHits;
+        qint64 numCompressedTierMisses;
     };
 
     MemoryStatistics memoryStatistics();
@@ -59,8 +85,9 @@ public:
      * Returns total number of tiles present: in memory
      * or in a swap file
      */
-    inline qint32 numTiles() const {
-        return m_numTiles + m_swappedStore.numTiles();
+    inline qint32 numTiles() {
+        QMutexLocker lock(&m_listLock);
+        return m_numTiles + m_compressedStore.numTiles() + m_swappedStore.numTiles();
     }
 
     /**
@@ -77,8 +104,9 @@ public:
     /**
      * \see m_memoryMetric
      */
-    inline qint64 memoryMetric() const {
-        return m_memoryMetric;
+    inline qint64 memoryMetric() {
+        QMutexLocker lock(&m_listLock);
+        return memoryMetricImpl();
     }
 
     KisTileDataStoreIterator* beginIteration();
@@ -131,6 +159,36 @@ public:
      */
     void ensureTileDataLoaded(KisTileData *td);
 
+    /**
+     * Asks the swapper thread to load a swapped out \p td back into
+     * memory before anybody needs it. The request is dropped if the
+     * memory is close to the limits. Doesn't block.
+     */
+    void prefetchTileData(KisTileData *td);
+
+    /**
+     * Loads all the tile data requested with prefetchTileData().
+     * Called by the swapper thread only.
+     */
+    void processPrefetchQueue(qint64 memoryLimit);
+
+    /**
+     * Returns a tile data filled with \p pixel, which is shared
+     * among all the uniform tiles of this color. The tile data is
+     * acquired on behalf of the caller, who must release() it when
+     * it is not needed anymore. Since the store keeps its own user
+     * of the tile data, any write to it will cause a COW.
+     */
+    KisTileData* acquireUniformTileData(qint32 pixelSize, const quint8 *pixel);
+
+    /**
+     * Returns true if the uniform tiles should be shared.
+     * \see KisImageConfig::shareUniformTiles()
+     */
+    inline bool shareUniformTiles() const {
+        return m_shareUniformTiles;
+    }
+
 private:
     KisTileData *allocTileData(qint32 pixelSize, const quint8 *defPixel);
 
@@ -138,8 +196,20 @@ private:
     void unregisterTileData(KisTileData *td);
     inline void registerTileDataImp(KisTileData *td);
     inline void unregisterTileDataImp(KisTileData *td);
+
+    /**
+     * Should be called with m_listLock held
+     */
+    inline qint64 memoryMetricImpl() const {
+        // the compressed tiles occupy the same RAM
+        return m_memoryMetric + m_compressedStore.compressedMemoryMetric();
+    }
     void freeRegisteredTiles();
 
+    void registerSwapIn(qint64 time);
+    void flushCompressedTiles();
+    void purgeUniformTileData();
+
     friend class DeadlockyThread;
     friend class KisLowMemoryTests;
     void debugSwapAll();
@@ -158,6 +228,7 @@ private:
     friend class KisTileDataStoreTest;
     friend class KisTileDataPoolerTest;
     KisSwappedDataStore m_swappedStore;
+    KisCompressedDataStore m_compressedStore;
 
     KisTileDataListIterator m_clockIterator;
 
@@ -171,6 +242,25 @@ private:
      * metric = num_bytes / (KisTileData::WIDTH * KisTileData::HEIGHT)
      */
     qint64 m_memoryMetric;
+
+    /**
+     * Counted under m_listLock
+     */
+    qint64 m_numCompressedTierHits;
+    qint64 m_numCompressedTierMisses;
+
+    bool m_shareUniformTiles;
+    QMutex m_uniformTilesLock;
+    QHash<QByteArray, KisTileData*> m_uniformTiles;
+
+    QMutex m_prefetchLock;
+    QVector<KisTileData*> m_prefetchQueue;
+
+    QMutex m_swapStatsLock;
+    qint64 m_numSwapIns;
+    qint64 m_totalSwapInTime;
+    qint64 m_maxSwapInTime;
+    qint64 m_numPrefetchedTiles;
 };
 
 template<typename T>
@@ -20,8 +20,10 @@
 #ifndef KIS_TILEHASHTABLE_H_
 #define KIS_TILEHASHTABLE_H_
 
-#include "kis_tile.h"
+#include <QAtomicPointer>
+#include <QVector>
 
+#include "kis_tile.h"
 
 
 /**
@@ -97,25 +99,66 @@ public:
     void debugMaxListLength(qint32 &min, qint32 &max);
 
 private:
+    /**
+     * An array of buckets of the hash table. The size of the array
+     * is always a power of two.
+     *
+     * When the table grows, the old array is not deleted right away,
+     * because lockless readers (see getTileMinefieldWalk()) may still
+     * be walking through it. Retired arrays are kept till the
+     * destruction of the table. Since the table grows twice every
+     * time, retired arrays never take more memory than the current
+     * one.
+     */
+    struct Table {
+        Table(qint32 _size)
+            : size(_size),
+              buckets(new TileTypeSP[_size])
+        {
+        }
+
+        ~Table() {
+            delete[] buckets;
+        }
 
-    TileTypeSP getTileMinefieldWalk(qint32 col, qint32 row, qint32 idx);
-    TileTypeSP getTile(qint32 col, qint32 row, qint32 idx);
-    void linkTile(TileTypeSP tile, qint32 idx);
-    TileTypeSP unlinkTile(qint32 col, qint32 row, qint32 idx);
+        inline qint32 index(quint32 hash) const {
+            return hash & (size - 1);
+        }
+
+        const qint32 size;
+        TileTypeSP *buckets;
+
+    private:
+        Q_DISABLE_COPY(Table)
+    };
+
+    TileTypeSP getTileMinefieldWalk(qint32 col, qint32 row, quint32 hash);
+    TileTypeSP getTile(qint32 col, qint32 row, quint32 hash);
+    void linkTile(TileTypeSP tile, quint32 hash);
+    TileTypeSP unlinkTile(qint32 col, qint32 row, quint32 hash);
+    void growTable();
 
     inline void setDefaultTileDataImp(KisTileData *defaultTileData);
     inline KisTileData* defaultTileDataImp() const;
 
     static inline quint32 calculateHash(qint32 col, qint32 row);
 
-    inline qint32 debugChainLen(qint32 idx);
+    inline qint32 debugChainLen(Table *table, qint32 idx);
     void debugListLengthDistibution();
     void sanityChecksumCheck();
 private:
     template<class U, class LockerType> friend class KisTileHashTableIteratorTraits;
 
-    static const qint32 TABLE_SIZE = 1024;
-    TileTypeSP *m_hashTable;
+    static const qint32 INITIAL_TABLE_SIZE = 1024;
+
+    /**
+     * The table is grown when the average length of the
+     * chains becomes longer than this value
+     */
+    static const qint32 MAX_LOAD_FACTOR = 2;
+
+    QAtomicPointer<Table> m_table;
+    QVector<Table*> m_retiredTables;
     qint32 m_numTiles;
 
     KisTileData *m_defaultTileData;
@@ -147,10 +190,15 @@ public:
     KisTileHashTableIteratorTraits(KisTileHashTableTraits<T> *ht)
         : m_locker(&ht->m_lock)
     {
+        /**
+         * The table cannot grow while we hold the lock,
+         * so we can cache the pointer to the buckets
+         */
         m_hashTable = ht;
+        m_table = ht->m_table.load();
         m_index = nextNonEmptyList(0);
-        if (m_index < KisTileHashTableTraits<T>::TABLE_SIZE)
-            m_tile = m_hashTable->m_hashTable[m_index];
+        if (m_index < m_table->size)
+            m_tile = m_table->buckets[m_index];
     }
 
     ~KisTileHashTableIteratorTraits() {
@@ -161,9 +209,9 @@ public:
             m_tile = m_tile->next();
             if (!m_tile) {
                 qint32 idx = nextNonEmptyList(m_index + 1);
-                if (idx < KisTileHashTableTraits<T>::TABLE_SIZE) {
+                if (idx < m_table->size) {
                     m_index = idx;
-                    m_tile = m_hashTable->m_hashTable[idx];
+                    m_tile = m_table->buckets[idx];
                 } else {
                     //EOList reached
                     m_index = -1;
@@ -187,8 +235,8 @@ public:
         TileTypeSP tile = m_tile;
         next();
 
-        const qint32 idx = m_hashTable->calculateHash(tile->col(), tile->row());
-        m_hashTable->unlinkTile(tile->col(), tile->row(), idx);
+        const quint32 hash = m_hashTable->calculateHash(tile->col(), tile->row());
+        m_hashTable->unlinkTile(tile->col(), tile->row(), hash);
     }
 
     // disable the method if we didn't lock for writing
@@ -198,8 +246,8 @@ public:
         TileTypeSP tile = m_tile;
         next();
 
-        const qint32 idx = m_hashTable->calculateHash(tile->col(), tile->row());
-        m_hashTable->unlinkTile(tile->col(), tile->row(), idx);
+        const quint32 hash = m_hashTable->calculateHash(tile->col(), tile->row());
+        m_hashTable->unlinkTile(tile->col(), tile->row(), hash);
 
         newHashTable->addTile(tile);
     }
@@ -208,14 +256,15 @@ protected:
     TileTypeSP m_tile;
     qint32 m_index;
     KisTileHashTableTraits<T> *m_hashTable;
+    typename KisTileHashTableTraits<T>::Table *m_table;
     LockerType m_locker;
 
 protected:
     qint32 nextNonEmptyList(qint32 startIdx) {
         qint32 idx = startIdx;
 
-        while (idx < KisTileHashTableTraits<T>::TABLE_SIZE &&
-                !m_hashTable->m_hashTable[idx]) {
+        while (idx < m_table->size &&
+                !m_table->buckets[idx]) {
             idx++;
         }
 
@@ -28,8 +28,7 @@ template<class T>
 KisTileHashTableTraits<T>::KisTileHashTableTraits(KisMementoManager *mm)
         : m_lock(QReadWriteLock::NonRecursive)
 {
-    m_hashTable = new TileTypeSP [TABLE_SIZE];
-    Q_CHECK_PTR(m_hashTable);
+    m_table.store(new Table(INITIAL_TABLE_SIZE));
 
     m_numTiles = 0;
     m_defaultTileData = 0;
@@ -47,17 +46,17 @@ KisTileHashTableTraits<T>::KisTileHashTableTraits(const KisTileHashTableTraits<T
     m_defaultTileData = 0;
     setDefaultTileDataImp(ht.m_defaultTileData);
 
-    m_hashTable = new TileTypeSP [TABLE_SIZE];
-    Q_CHECK_PTR(m_hashTable);
-
+    Table *foreignTable = ht.m_table.load();
+    Table *table = new Table(foreignTable->size);
+    m_table.store(table);
 
     TileTypeSP foreignTile;
     TileTypeSP nativeTile;
     TileTypeSP nativeTileHead;
-    for (qint32 i = 0; i < TABLE_SIZE; i++) {
+    for (qint32 i = 0; i < table->size; i++) {
         nativeTileHead = 0;
 
-        foreignTile = ht.m_hashTable[i];
+        foreignTile = foreignTable->buckets[i];
         while (foreignTile) {
             nativeTile = TileTypeSP(new TileType(*foreignTile, m_mementoManager));
             nativeTile->setNext(nativeTileHead);
@@ -66,7 +65,7 @@ KisTileHashTableTraits<T>::KisTileHashTableTraits(const KisTileHashTableTraits<T
             foreignTile = foreignTile->next();
         }
 
-        m_hashTable[i] = nativeTileHead;
+        table->buckets[i] = nativeTileHead;
     }
     m_numTiles = ht.m_numTiles;
 }
@@ -75,19 +74,26 @@ template<class T>
 KisTileHashTableTraits<T>::~KisTileHashTableTraits()
 {
     clear();
-    delete[] m_hashTable;
+    delete m_table.load();
+    qDeleteAll(m_retiredTables);
     setDefaultTileDataImp(0);
 }
 
 template<class T>
 quint32 KisTileHashTableTraits<T>::calculateHash(qint32 col, qint32 row)
 {
-    return ((row << 5) + (col & 0x1F)) & 0x3FF;
+    /**
+     * The size of the table is not fixed, so all the bits of the
+     * hash should be significant. Multiplying by two big primes
+     * spreads both wide and tall devices over the whole table.
+     */
+    const quint32 hash = (quint32(col) * 73856093U) ^ (quint32(row) * 19349663U);
+    return hash ^ (hash >> 16);
 }
 
 template<class T>
 typename KisTileHashTableTraits<T>::TileTypeSP
-KisTileHashTableTraits<T>::getTileMinefieldWalk(qint32 col, qint32 row, qint32 idx)
+KisTileHashTableTraits<T>::getTileMinefieldWalk(qint32 col, qint32 row, quint32 hash)
 {
     /**
      * This is a special method for dangerous and unsafe access to
@@ -96,16 +102,25 @@ KisTileHashTableTraits<T>::getTileMinefieldWalk(qint32 col, qint32 row, qint32 i
      * having any locks help. In the worst case, we will miss the needed
      * tile. In that case, the higher level code will do the proper
      * locking and do the second try with all the needed locks held.
+     *
+     * The bucket array may be replaced by a bigger one while we are
+     * walking, but the old array is never deleted before the table
+     * itself (see growTable()), so the walk is still safe.
      */
 
-    TileTypeSP headTile = m_hashTable[idx];
+    Table *table = m_table.loadAcquire();
+    const qint32 idx = table->index(hash);
+
+    TileTypeSP headTile = table->buckets[idx];
     TileTypeSP tile = headTile;
 
     for (; tile; tile = tile->next()) {
         if (tile->col() == col &&
             tile->row() == row) {
 
-            if (m_hashTable[idx] != headTile) {
+            if (m_table.loadAcquire() != table ||
+                table->buckets[idx] != headTile) {
+
                 tile.clear();
             }
 
@@ -118,9 +133,10 @@ KisTileHashTableTraits<T>::getTileMinefieldWalk(qint32 col, qint32 row, qint32 i
 
 template<class T>
 typename KisTileHashTableTraits<T>::TileTypeSP
-KisTileHashTableTraits<T>::getTile(qint32 col, qint32 row, qint32 idx)
+KisTileHashTableTraits<T>::getTile(qint32 col, qint32 row, quint32 hash)
 {
-    TileTypeSP tile = m_hashTable[idx];
+    Table *table = m_table.load();
+    TileTypeSP tile = table->buckets[table->index(hash)];
 
     for (; tile; tile = tile->next()) {
         if (tile->col() == col &&
@@ -134,9 +150,11 @@ KisTileHashTableTraits<T>::getTile(qint32 col, qint32 row, qint32 idx)
 }
 
 template<class T>
-void KisTileHashTableTraits<T>::linkTile(TileTypeSP tile, qint32 idx)
+void KisTileHashTableTraits<T>::linkTile(TileTypeSP tile, quint32 hash)
 {
-    TileTypeSP firstTile = m_hashTable[idx];
+    Table *table = m_table.load();
+    const qint32 idx = table->index(hash);
+    TileTypeSP firstTile = table->buckets[idx];
 
 #ifdef SHARED_TILES_SANITY_CHECK
     Q_ASSERT_X(!tile->next(), "KisTileHashTableTraits<T>::linkTile",
@@ -144,15 +162,60 @@ void KisTileHashTableTraits<T>::linkTile(TileTypeSP tile, qint32 idx)
 #endif
 
     tile->setNext(firstTile);
-    m_hashTable[idx] = tile;
+    table->buckets[idx] = tile;
     m_numTiles++;
+
+    if (m_numTiles > MAX_LOAD_FACTOR * table->size) {
+        growTable();
+    }
+}
+
+template<class T>
+void KisTileHashTableTraits<T>::growTable()
+{
+    /**
+     * Should be called with the write lock held
+     */
+
+    Table *oldTable = m_table.load();
+    Table *newTable = new Table(2 * oldTable->size);
+
+    for (qint32 i = 0; i < oldTable->size; i++) {
+        TileTypeSP tile = oldTable->buckets[i];
+
+        while (tile) {
+            TileTypeSP nextTile = tile->next();
+
+            const qint32 idx = newTable->index(calculateHash(tile->col(), tile->row()));
+            tile->setNext(newTable->buckets[idx]);
+            newTable->buckets[idx] = tile;
+
+            tile = nextTile;
+        }
+    }
+
+    m_table.storeRelease(newTable);
+
+    /**
+     * Lockless readers may still be walking through the old
+     * array, so we cannot delete it. Just drop the references
+     * to the tiles, they are owned by the new array now.
+     */
+    for (qint32 i = 0; i < oldTable->size; i++) {
+        oldTable->buckets[i] = TileTypeSP();
+    }
+
+    m_retiredTables.append(oldTable);
 }
 
 template<class T>
 typename KisTileHashTableTraits<T>::TileTypeSP
-KisTileHashTableTraits<T>::unlinkTile(qint32 col, qint32 row, qint32 idx)
+KisTileHashTableTraits<T>::unlinkTile(qint32 col, qint32 row, quint32 hash)
 {
-    TileTypeSP tile = m_hashTable[idx];
+    Table *table = m_table.load();
+    const qint32 idx = table->index(hash);
+
+    TileTypeSP tile = table->buckets[idx];
     TileTypeSP prevTile;
 
     for (; tile; tile = tile->next()) {
@@ -163,7 +226,7 @@ KisTileHashTableTraits<T>::unlinkTile(qint32 col, qint32 row, qint32 idx)
                 prevTile->setNext(tile->next());
             else
                 /* optimize here*/
-                m_hashTable[idx] = tile->next();
+                table->buckets[idx] = tile->next();
 
             /**
              * The shared pointer may still be accessed by someone, so
@@ -214,15 +277,15 @@ template<class T>
 typename KisTileHashTableTraits<T>::TileTypeSP
 KisTileHashTableTraits<T>::getExistingTile(qint32 col, qint32 row)
 {
-    const qint32 idx = calculateHash(col, row);
+    const quint32 hash = calculateHash(col, row);
 
     // first quick and non-guaranteed way
-    TileTypeSP tile = getTileMinefieldWalk(col, row, idx);
+    TileTypeSP tile = getTileMinefieldWalk(col, row, hash);
     if (tile) return tile;
 
     // then try with a proper locking
     QReadLocker locker(&m_lock);
-    return getTile(col, row, idx);
+    return getTile(col, row, hash);
 }
 
 template<class T>
@@ -230,20 +293,20 @@ typename KisTileHashTableTraits<T>::TileTypeSP
 KisTileHashTableTraits<T>::getTileLazy(qint32 col, qint32 row,
                                        bool& newTile)
 {
-    const qint32 idx = calculateHash(col, row);
+    const quint32 hash = calculateHash(col, row);
 
     // first quick and non-guaranteed way
     newTile = false;
-    TileTypeSP tile = getTileMinefieldWalk(col, row, idx);
+    TileTypeSP tile = getTileMinefieldWalk(col, row, hash);
 
     // then try with a proper locking
     if (!tile) {
         QWriteLocker locker(&m_lock);
-        tile = getTile(col, row, idx);
+        tile = getTile(col, row, hash);
 
         if (!tile) {
             tile = new TileType(col, row, m_defaultTileData, m_mementoManager);
-            linkTile(tile, idx);
+            linkTile(tile, hash);
             newTile = true;
         }
     }
@@ -255,10 +318,10 @@ template<class T>
 typename KisTileHashTableTraits<T>::TileTypeSP
 KisTileHashTableTraits<T>::getReadOnlyTileLazy(qint32 col, qint32 row)
 {
-    const qint32 idx = calculateHash(col, row);
+    const quint32 hash = calculateHash(col, row);
 
     // first quick and non-guaranteed way
-    TileTypeSP tile = getTileMinefieldWalk(col, row, idx);
+    TileTypeSP tile = getTileMinefieldWalk(col, row, hash);
     if (tile) return tile;
 
 
@@ -266,7 +329,7 @@ KisTileHashTableTraits<T>::getReadOnlyTileLazy(qint32 col, qint32 row)
     {
         QReadLocker locker(&m_lock);
 
-        tile = getTile(col, row, idx);
+        tile = getTile(col, row, hash);
         if (!tile) {
             tile = new TileType(col, row, m_defaultTileData, 0);
         }
@@ -278,19 +341,19 @@ KisTileHashTableTraits<T>::getReadOnlyTileLazy(qint32 col, qint32 row)
 template<class T>
 void KisTileHashTableTraits<T>::addTile(TileTypeSP tile)
 {
-    const qint32 idx = calculateHash(tile->col(), tile->row());
+    const quint32 hash = calculateHash(tile->col(), tile->row());
 
     QWriteLocker locker(&m_lock);
-    linkTile(tile, idx);
+    linkTile(tile, hash);
 }
 
 template<class T>
 void KisTileHashTableTraits<T>::deleteTile(qint32 col, qint32 row)
 {
-    const qint32 idx = calculateHash(col, row);
+    const quint32 hash = calculateHash(col, row);
 
     QWriteLocker locker(&m_lock);
-    TileTypeSP tile = unlinkTile(col, row, idx);
+    TileTypeSP tile = unlinkTile(col, row, hash);
 
     /* Done by KisSharedPtr */
     //if(tile)
@@ -308,11 +371,12 @@ template<class T>
 void KisTileHashTableTraits<T>::clear()
 {
     QWriteLocker locker(&m_lock);
+    Table *table = m_table.load();
     TileTypeSP tile = TileTypeSP();
     qint32 i;
 
-    for (i = 0; i < TABLE_SIZE; i++) {
-        tile = m_hashTable[i];
+    for (i = 0; i < table->size; i++) {
+        tile = table->buckets[i];
 
         while (tile) {
             TileTypeSP tmp = tile;
@@ -329,7 +393,7 @@ void KisTileHashTableTraits<T>::clear()
             m_numTiles--;
         }
 
-        m_hashTable[i] = 0;
+        table->buckets[i] = 0;
     }
 
     Q_ASSERT(!m_numTiles);
@@ -360,16 +424,17 @@ void KisTileHashTableTraits<T>::debugPrintInfo()
     qDebug() << "==========================\n"
              << "TileHashTable:"
              << "\n   def. data:\t\t" << m_defaultTileData
-             << "\n   numTiles:\t\t" << m_numTiles;
+             << "\n   numTiles:\t\t" << m_numTiles
+             << "\n   tableSize:\t\t" << m_table.load()->size;
     debugListLengthDistibution();
     qDebug() << "==========================\n";
 }
 
 template<class T>
-qint32 KisTileHashTableTraits<T>::debugChainLen(qint32 idx)
+qint32 KisTileHashTableTraits<T>::debugChainLen(Table *table, qint32 idx)
 {
     qint32 len = 0;
-    for (TileTypeSP it = m_hashTable[idx]; it; it = it->next(), len++) ;
+    for (TileTypeSP it = table->buckets[idx]; it; it = it->next(), len++) ;
     return len;
 }
 
@@ -380,9 +445,10 @@ void KisTileHashTableTraits<T>::debugMaxListLength(qint32 &min, qint32 &max)
     qint32 maxLen = 0;
     qint32 minLen = m_numTiles;
     qint32 tmp = 0;
+    Table *table = m_table.load();
 
-    for (qint32 i = 0; i < TABLE_SIZE; i++) {
-        tmp = debugChainLen(i);
+    for (qint32 i = 0; i < table->size; i++) {
+        tmp = debugChainLen(table, i);
         if (tmp > maxLen)
             maxLen = tmp;
         if (tmp < minLen)
@@ -406,8 +472,9 @@ void KisTileHashTableTraits<T>::debugListLengthDistibution()
     qint32 *array = new qint32[arraySize];
     memset(array, 0, sizeof(qint32)*arraySize);
 
-    for (qint32 i = 0; i < TABLE_SIZE; i++) {
-        tmp = debugChainLen(i);
+    Table *table = m_table.load();
+    for (qint32 i = 0; i < table->size; i++) {
+        tmp = debugChainLen(table, i);
         array[tmp-min]++;
     }
 
@@ -432,9 +499,10 @@ void KisTileHashTableTraits<T>::sanityChecksumCheck()
 
     TileTypeSP tile = 0;
     qint32 exactNumTiles = 0;
+    Table *table = m_table.load();
 
-    for (qint32 i = 0; i < TABLE_SIZE; i++) {
-        tile = m_hashTable[i];
+    for (qint32 i = 0; i < table->size; i++) {
+        tile = table->buckets[i];
         while (tile) {
             exactNumTiles++;
             tile = tile->next();
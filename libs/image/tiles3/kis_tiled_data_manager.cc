@@ -32,6 +32,7 @@
 #include "kis_paint_device_writer.h"
 
 #include "kis_global.h"
+#include "kis_image_config.h"
 
 
 /* The data area is divided into tiles each say 64x64 pixels (defined at compiletime)
@@ -130,19 +131,26 @@ bool KisTiledDataManager::write(KisPaintDeviceWriter &store)
     }
 
 
-    KisTileHashTableConstIterator iter(m_hashTable);
-    KisTileSP tile;
+    QVector<KisTileSP> tiles;
+    tiles.reserve(m_hashTable->numTiles());
 
-    KisAbstractTileCompressorSP compressor =
-        KisTileCompressorFactory::create(CURRENT_VERSION);
+    {
+        KisTileHashTableConstIterator iter(m_hashTable);
+        KisTileSP tile;
 
-    while ((tile = iter.tile())) {
-        retval = compressor->writeTile(tile, store);
-        if (!retval) {
-            warnFile << "Failed to write tile";
-            break;
+        while ((tile = iter.tile())) {
+            tiles.append(tile);
+            iter.next();
         }
-        iter.next();
+    }
+
+    KisAbstractTileCompressorSP compressor =
+        KisTileCompressorFactory::create(CURRENT_VERSION,
+                                         KisImageConfig(true).fileTileCompression());
+
+    retval = compressor->writeTiles(tiles, store);
+    if (!retval) {
+        warnFile << "Failed to write tiles";
     }
 
     return retval;
@@ -185,14 +193,14 @@ bool KisTiledDataManager::read(QIODevice *stream)
     KisAbstractTileCompressorSP compressor =
         KisTileCompressorFactory::create(tilesVersion);
 
-    bool readSuccess = true;
-    for (quint32 i = 0; i < numTiles; i++) {
-        if (!compressor->readTile(stream, this)) {
-            readSuccess = false;
-        }
-    }
+    bool readSuccess = compressor->readTiles(stream, this, numTiles);
 
     m_mementoManager->commit();
+
+    if (readSuccess && KisTileDataStore::instance()->shareUniformTiles()) {
+        shareUniformTiles();
+    }
+
     return readSuccess;
 }
 
@@ -462,6 +470,156 @@ void KisTiledDataManager::clear()
     m_extentMaxY = qint32_MIN;
 }
 
+void KisTiledDataManager::prefetchRect(const QRect &rect) const
+{
+    QReadLocker locker(&m_lock);
+
+    const QRect rc = rect & extentImpl();
+    if (rc.isEmpty()) return;
+
+    const qint32 firstColumn = xToCol(rc.left());
+    const qint32 lastColumn = xToCol(rc.right());
+
+    const qint32 firstRow = yToRow(rc.top());
+    const qint32 lastRow = yToRow(rc.bottom());
+
+    for (qint32 row = firstRow; row <= lastRow; ++row) {
+        for (qint32 column = firstColumn; column <= lastColumn; ++column) {
+            KisTileSP tile = m_hashTable->getExistingTile(column, row);
+            if (tile) {
+                tile->prefetchSwappedData();
+            }
+        }
+    }
+}
+
+int KisTiledDataManager::shareUniformTiles()
+{
+    QVector<KisTileSP> tiles;
+
+    {
+        KisTileHashTableConstIterator iter(m_hashTable);
+        KisTileSP tile;
+
+        while ((tile = iter.tile())) {
+            tiles.append(tile);
+            iter.next();
+        }
+    }
+
+    KisTileData *defaultTileData = m_hashTable->defaultTileData();
+    int numSharedTiles = 0;
+
+    Q_FOREACH (KisTileSP tile, tiles) {
+        KisTileData *oldTileData = tile->tileData();
+
+        if (tile->tryShareUniformData(defaultTileData)) {
+            /**
+             * The committed version still references the old data, if
+             * the tile hasn't been changed since the last transaction.
+             * The old data is kept alive by this reference, so it is
+             * safe to compare with it.
+             */
+            m_mementoManager->replaceCommittedTileData(tile->col(), tile->row(),
+                                                       oldTileData, tile->tileData());
+            numSharedTiles++;
+        }
+    }
+
+    return numSharedTiles;
+}
+
+bool KisTiledDataManager::isOpaque(const QRect &rect, qint32 alphaOffset, qint32 alphaSize, const quint8 *opaqueAlpha)
+{
+    if (rect.isEmpty()) return false;
+
+    QReadLocker locker(&m_lock);
+
+    const qint32 firstColumn = xToCol(rect.left());
+    const qint32 lastColumn = xToCol(rect.right());
+
+    const qint32 firstRow = yToRow(rect.top());
+    const qint32 lastRow = yToRow(rect.bottom());
+
+    for (qint32 row = firstRow; row <= lastRow; ++row) {
+        for (qint32 column = firstColumn; column <= lastColumn; ++column) {
+            KisTileSP tile = m_hashTable->getReadOnlyTileLazy(column, row);
+
+            tile->lockForRead();
+            const bool tileIsOpaque = tile->tileData()->isOpaque(alphaOffset, alphaSize, opaqueAlpha);
+            tile->unlock();
+
+            if (!tileIsOpaque) return false;
+        }
+    }
+
+    return true;
+}
+
+QVector<quint64> KisTiledDataManager::contentsVersions(const QRect &rect)
+{
+    QVector<quint64> versions;
+    if (rect.isEmpty()) return versions;
+
+    QReadLocker locker(&m_lock);
+
+    const qint32 firstColumn = xToCol(rect.left());
+    const qint32 lastColumn = xToCol(rect.right());
+
+    const qint32 firstRow = yToRow(rect.top());
+    const qint32 lastRow = yToRow(rect.bottom());
+
+    versions.reserve((lastColumn - firstColumn + 1) * (lastRow - firstRow + 1));
+
+    for (qint32 row = firstRow; row <= lastRow; ++row) {
+        for (qint32 column = firstColumn; column <= lastColumn; ++column) {
+            KisTileSP tile = m_hashTable->getReadOnlyTileLazy(column, row);
+            versions.append(tile->tileData()->contentsVersion());
+        }
+    }
+
+    return versions;
+}
+
+void KisTiledDataManager::setSwapPriority(KisTileData::EnumSwapPriority priority)
+{
+    QReadLocker locker(&m_lock);
+
+    // new tiles are cloned from the default tile data
+    m_hashTable->defaultTileData()->setSwapPriority(priority);
+
+    KisTileHashTableConstIterator iter(m_hashTable);
+    KisTileSP tile;
+
+    while ((tile = iter.tile())) {
+        tile->tileData()->setSwapPriority(priority);
+        iter.next();
+    }
+}
+
+void KisTiledDataManager::setSwapPriority(KisTileData::EnumSwapPriority priority, const QRect &rect)
+{
+    QReadLocker locker(&m_lock);
+
+    const QRect rc = rect & extentImpl();
+    if (rc.isEmpty()) return;
+
+    const qint32 firstColumn = xToCol(rc.left());
+    const qint32 lastColumn = xToCol(rc.right());
+
+    const qint32 firstRow = yToRow(rc.top());
+    const qint32 lastRow = yToRow(rc.bottom());
+
+    for (qint32 row = firstRow; row <= lastRow; ++row) {
+        for (qint32 column = firstColumn; column <= lastColumn; ++column) {
+            KisTileSP tile = m_hashTable->getExistingTile(column, row);
+            if (tile) {
+                tile->tileData()->setSwapPriority(priority);
+            }
+        }
+    }
+}
+
 
 template<bool useOldSrcData>
 void KisTiledDataManager::bitBltImpl(KisTiledDataManager *srcDM, const QRect &rect)
@@ -634,7 +792,7 @@ void KisTiledDataManager::setExtent(QRect newRect)
                         }
                     }
                 }
-                tile->unlock();
+                tile->unlockForWrite();
                 iter.next();
             } else {
                 iter.deleteCurrent();
@@ -145,6 +145,28 @@ public:
         m_mementoManager->commit();
     }
 
+    /**
+     * Returns true if all the tiles intersecting \p rect are fully
+     * opaque, that is the alpha channel of every pixel of these tiles
+     * is equal to \p opaqueAlpha. The alpha channel is \p alphaSize
+     * bytes long and starts at \p alphaOffset of every pixel.
+     *
+     * The opacity of every tile is cached until the tile is written
+     * into, so the check of the unchanged tiles is cheap. Note that
+     * the check is done per tile, so the tiles that are opaque in
+     * \p rect only are not considered opaque.
+     */
+    bool isOpaque(const QRect &rect, qint32 alphaOffset, qint32 alphaSize, const quint8 *opaqueAlpha);
+
+    /**
+     * Returns KisTileData::contentsVersion() of every tile intersecting
+     * \p rect, row by row. The tiles that don't exist are reported with
+     * the version of the default tile data. If the returned versions
+     * are equal to the ones returned by a previous call, the pixels in
+     * \p rect have not changed in the meantime.
+     */
+    QVector<quint64> contentsVersions(const QRect &rect);
+
     void rollback(KisMementoSP memento) {
         commit();
 
@@ -215,6 +237,28 @@ public:
     void clear(qint32 x, qint32 y,  qint32 w, qint32 h, const quint8 *clearPixel);
     void clear();
 
+    /**
+     * Asks the tile data store to load back the swapped out tiles
+     * intersecting \p rect in background. Tiles that are not
+     * allocated or are already in memory are ignored. The call
+     * never blocks on the swap file.
+     */
+    void prefetchRect(const QRect &rect) const;
+
+    /**
+     * Sets the swap priority of all the tiles of the data manager,
+     * including the ones that will be created later on. The tiles
+     * shared with other data managers through COW are affected as
+     * well, so the priority is only a hint for the swapper.
+     */
+    void setSwapPriority(KisTileData::EnumSwapPriority priority);
+
+    /**
+     * Sets the swap priority of the existing tiles
+     * intersecting \p rect only
+     */
+    void setSwapPriority(KisTileData::EnumSwapPriority priority, const QRect &rect);
+
     /**
      * Clones rect from another datamanager. The cloned area will be
      * shared between both datamanagers as much as possible using
@@ -343,6 +387,19 @@ private:
 
     QRect extentImpl() const;
 
+    /**
+     * Replaces the data of the tiles filled with a single color
+     * with the tile data shared among all the devices. The tiles
+     * of the default color share the default tile data. The
+     * committed history of the tiles is switched to the shared data
+     * as well, so the old copies are freed right away. It is done
+     * after read(), because the loaded tiles are never shared with
+     * anything yet.
+     *
+     * \return the number of tiles that started sharing their data
+     */
+    int shareUniformTiles();
+
     bool writeTilesHeader(KisPaintDeviceWriter &store, quint32 numTiles);
     bool processTilesHeader(QIODevice *stream, quint32 &numTiles);
 
@@ -25,3 +25,26 @@ KisAbstractTileCompressor::KisAbstractTileCompressor()
 KisAbstractTileCompressor::~KisAbstractTileCompressor()
 {
 }
+
+bool KisAbstractTileCompressor::writeTiles(const QVector<KisTileSP> &tiles, KisPaintDeviceWriter &store)
+{
+    Q_FOREACH (KisTileSP tile, tiles) {
+        if (!writeTile(tile, store)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool KisAbstractTileCompressor::readTiles(QIODevice *stream, KisTiledDataManager *dm, quint32 numTiles)
+{
+    bool readSuccess = true;
+    for (quint32 i = 0; i < numTiles; i++) {
+        if (!readTile(stream, dm)) {
+            readSuccess = false;
+        }
+    }
+
+    return readSuccess;
+}
@@ -0,0 +1,164 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "kis_compressed_data_store.h"
+
+#include "kis_image_config.h"
+#include "kis_debug.h"
+
+#include "tiles3/kis_tile_data.h"
+#include "kis_tile_compressor_2.h"
+#include "kis_chunk_allocator.h"
+
+/**
+ * The tiles that don't shrink at least this much are not worth
+ * keeping in memory, they go to the swap file directly
+ */
+const int MIN_COMPRESSION_RATIO = 2;
+
+namespace {
+qint64 calculateMemoryLimit(const KisImageConfig &config)
+{
+    return qint64(config.tilesHardLimit()) * MiB *
+        config.compressedTileTierPercent() / 100;
+}
+}
+
+
+KisCompressedDataStore::KisCompressedDataStore()
+    : m_compressedSize(0),
+      m_memoryMetric(0)
+{
+    KisImageConfig config;
+    m_memoryLimit = calculateMemoryLimit(config);
+
+    // the same codec as in the swap file, we move the data there as it is
+    m_compressor = new KisTileCompressor2(config.swapTileCompression());
+}
+
+KisCompressedDataStore::~KisCompressedDataStore()
+{
+    delete m_compressor;
+}
+
+bool KisCompressedDataStore::isEnabled() const
+{
+    return m_memoryLimit > 0;
+}
+
+quint64 KisCompressedDataStore::numTiles() const
+{
+    return m_entries.size();
+}
+
+bool KisCompressedDataStore::tryCompressTileData(KisTileData *td)
+{
+    Q_ASSERT(td->data());
+    KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(!m_entries.contains(td), false);
+
+    const qint32 expectedBufferSize = m_compressor->tileDataBufferSize(td);
+    if(m_buffer.size() < expectedBufferSize)
+        m_buffer.resize(expectedBufferSize);
+
+    qint32 bytesWritten;
+    m_compressor->compressTileData(td, (quint8*) m_buffer.data(), m_buffer.size(), bytesWritten);
+
+    const qint32 tileSize = td->pixelSize() * KisTileData::WIDTH * KisTileData::HEIGHT;
+    if (bytesWritten * MIN_COMPRESSION_RATIO > tileSize) {
+        return false;
+    }
+
+    Entry entry;
+    entry.data = QByteArray(m_buffer.constData(), bytesWritten);
+    entry.position = m_queue.insert(m_queue.end(), td);
+    m_entries.insert(td, entry);
+
+    td->releaseMemory();
+
+    m_compressedSize += bytesWritten;
+    m_memoryMetric += td->pixelSize();
+
+    return true;
+}
+
+void KisCompressedDataStore::decompressTileData(KisTileData *td)
+{
+    Q_ASSERT(!td->data());
+
+    QHash<KisTileData*, Entry>::iterator it = m_entries.find(td);
+    KIS_SAFE_ASSERT_RECOVER_RETURN(it != m_entries.end());
+
+    td->allocateMemory();
+    m_compressor->decompressTileData((quint8*) it->data.data(), it->data.size(), td);
+
+    removeEntry(td);
+}
+
+void KisCompressedDataStore::forgetTileData(KisTileData *td)
+{
+    removeEntry(td);
+}
+
+bool KisCompressedDataStore::isOverLimit() const
+{
+    return m_compressedSize > m_memoryLimit;
+}
+
+KisTileData* KisCompressedDataStore::oldestTileData() const
+{
+    return !m_queue.isEmpty() ? m_queue.first() : 0;
+}
+
+QByteArray KisCompressedDataStore::compressedData(KisTileData *td) const
+{
+    return m_entries.value(td).data;
+}
+
+void KisCompressedDataStore::removeEntry(KisTileData *td)
+{
+    QHash<KisTileData*, Entry>::iterator it = m_entries.find(td);
+    KIS_SAFE_ASSERT_RECOVER_RETURN(it != m_entries.end());
+
+    m_compressedSize -= it->data.size();
+    m_memoryMetric -= td->pixelSize();
+
+    m_queue.erase(it->position);
+    m_entries.erase(it);
+}
+
+qint64 KisCompressedDataStore::totalMemoryMetric() const
+{
+    return m_memoryMetric;
+}
+
+qint64 KisCompressedDataStore::compressedMemoryMetric() const
+{
+    const qint64 metricCoeff = KisTileData::WIDTH * KisTileData::HEIGHT;
+    return (m_compressedSize + metricCoeff - 1) / metricCoeff;
+}
+
+qint64 KisCompressedDataStore::compressedMemorySize() const
+{
+    return m_compressedSize;
+}
+
+void KisCompressedDataStore::testingRereadConfig()
+{
+    KisImageConfig config;
+    m_memoryLimit = calculateMemoryLimit(config);
+}
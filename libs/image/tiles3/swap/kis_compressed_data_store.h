@@ -0,0 +1,139 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_COMPRESSED_DATA_STORE_H
+#define __KIS_COMPRESSED_DATA_STORE_H
+
+#include "kritaimage_export.h"
+
+#include <QHash>
+#include <QByteArray>
+#include <QLinkedList>
+
+class KisTileData;
+class KisAbstractTileCompressor;
+
+/**
+ * An intermediate tier between the memory and the swap file. The
+ * data of the cold tiles is kept compressed in memory, so most of
+ * the swap-ins don't touch the disk at all. When the tier exceeds
+ * its limit, the oldest tiles are moved to the swap file in the
+ * compressed form without recompressing them.
+ *
+ * LOCKING: the store is not thread-safe by itself. All the calls
+ *          are done by KisTileDataStore under its list lock.
+ */
+class KRITAIMAGE_EXPORT KisCompressedDataStore
+{
+public:
+    KisCompressedDataStore();
+    ~KisCompressedDataStore();
+
+    /**
+     * The tier is disabled if its memory limit is zero
+     */
+    bool isEnabled() const;
+
+    /**
+     * Returns number of tile data objects stored in the tier
+     */
+    quint64 numTiles() const;
+
+    /**
+     * Compresses the data of \a td into the tier and frees
+     * memory occupied by td->data(). The tiles that compress
+     * badly are rejected, they should go to the swap file directly.
+     * LOCKING: the lock on the tile data should be taken
+     *          by the caller before making a call.
+     */
+    bool tryCompressTileData(KisTileData *td);
+
+    /**
+     * Restores the data of a \a td and removes it from the tier
+     * LOCKING: the lock on the tile data should be taken
+     *          by the caller before making a call.
+     */
+    void decompressTileData(KisTileData *td);
+
+    /**
+     * Forget all the information linked with the tile data.
+     * This should be done before deleting of the tile data.
+     */
+    void forgetTileData(KisTileData *td);
+
+    /**
+     * Returns true if the tier has grown over its limit
+     * and some tiles should be moved to the swap file
+     */
+    bool isOverLimit() const;
+
+    /**
+     * The tile data that has been stored in the tier for
+     * the longest time. Returns null if the tier is empty.
+     */
+    KisTileData* oldestTileData() const;
+
+    /**
+     * Returns the compressed data of \a td, so that it could be
+     * written to the swap file as it is
+     */
+    QByteArray compressedData(KisTileData *td) const;
+
+    /**
+     * Returns the metric of the memory stored in the
+     * tier in *uncompressed* form
+     */
+    qint64 totalMemoryMetric() const;
+
+    /**
+     * Returns the metric of the memory actually occupied by the tier
+     */
+    qint64 compressedMemoryMetric() const;
+
+    /**
+     * The size of the compressed data in bytes
+     */
+    qint64 compressedMemorySize() const;
+
+    /**
+     * Reads the limit of the tier from the config again. The tiles
+     * already stored in the tier are kept.
+     */
+    void testingRereadConfig();
+
+private:
+    void removeEntry(KisTileData *td);
+
+private:
+    struct Entry {
+        QByteArray data;
+        QLinkedList<KisTileData*>::iterator position;
+    };
+
+    QHash<KisTileData*, Entry> m_entries;
+    QLinkedList<KisTileData*> m_queue;
+
+    QByteArray m_buffer;
+    KisAbstractTileCompressor *m_compressor;
+
+    qint64 m_memoryLimit;
+    qint64 m_compressedSize;
+    qint64 m_memoryMetric;
+};
+
+#endif /* __KIS_COMPRESSED_DATA_STORE_H */
@@ -0,0 +1,53 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_COMPRESSION_FACTORY_H
+#define __KIS_COMPRESSION_FACTORY_H
+
+#include "kritaimage_export.h"
+#include <QStringList>
+
+class KisAbstractCompression;
+
+/**
+ * Creates compression algorithms by the names that are written into
+ * the headers of the tiles, e.g. "LZF" or "LZ4". Some of the
+ * algorithms are optional and may be missing in the current build.
+ */
+class KRITAIMAGE_EXPORT KisCompressionFactory
+{
+public:
+    /**
+     * Returns a new compression object or null if \p name is
+     * not supported by this build of Krita
+     */
+    static KisAbstractCompression* create(const QString &name);
+
+    static bool isAvailable(const QString &name);
+    static QStringList availableCompressions();
+
+    /**
+     * The algorithm every version of Krita can read
+     */
+    static QString defaultCompression();
+
+private:
+    KisCompressionFactory();
+};
+
+#endif /* __KIS_COMPRESSION_FACTORY_H */
@@ -37,7 +37,7 @@ KisSwappedDataStore::KisSwappedDataStore()
     m_swapSpace = new KisMemoryWindow(config.swapDir(), swapWindowSize);
 
     // FIXME: use a factory after the patch is committed
-    m_compressor = new KisTileCompressor2();
+    m_compressor = new KisTileCompressor2(config.swapTileCompression());
 }
 
 KisSwappedDataStore::~KisSwappedDataStore()
@@ -89,6 +89,27 @@ bool KisSwappedDataStore::trySwapOutTileData(KisTileData *td)
     return true;
 }
 
+bool KisSwappedDataStore::trySwapOutCompressedTileData(KisTileData *td, const QByteArray &compressedData)
+{
+    Q_ASSERT(!td->data());
+    QMutexLocker locker(&m_lock);
+
+    KisChunk chunk = m_allocator->getChunk(compressedData.size());
+    quint8 *ptr = m_swapSpace->getWriteChunkPtr(chunk);
+    if (!ptr) {
+        qWarning() << "swap out of compressed tile failed";
+        m_allocator->freeChunk(chunk);
+        return false;
+    }
+    memcpy(ptr, compressedData.constData(), compressedData.size());
+
+    td->setSwapChunk(chunk);
+
+    m_memoryMetric += td->pixelSize();
+
+    return true;
+}
+
 void KisSwappedDataStore::swapInTileData(KisTileData *td)
 {
     Q_ASSERT(!td->data());
@@ -50,6 +50,15 @@ public:
      */
     bool trySwapOutTileData(KisTileData *td);
 
+    /**
+     * Writes the data of \a td, which has already been compressed
+     * by KisCompressedDataStore, to the swap file. The tile data
+     * itself should not have any data in memory.
+     * LOCKING: the lock on the tile data should be taken
+     *          by the caller before making a call.
+     */
+    bool trySwapOutCompressedTileData(KisTileData *td, const QByteArray &compressedData);
+
     /**
      * Restore the data of a \a td basing on information
      * stored in the swap file.
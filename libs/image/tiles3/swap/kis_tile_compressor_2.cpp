@@ -17,24 +17,104 @@
  */
 
 #include "kis_tile_compressor_2.h"
-#include "kis_lzf_compression.h"
+#include "kis_compression_factory.h"
+#include "kis_abstract_compression.h"
 #include <QIODevice>
+#include <QThread>
+#include <QtConcurrent>
 #include "kis_paint_device_writer.h"
 #define TILE_DATA_SIZE(pixelSize) ((pixelSize) * KisTileData::WIDTH * KisTileData::HEIGHT)
 
-const QString KisTileCompressor2::m_compressionName = "LZF";
+KisTileCompressor2::KisTileCompressor2(const QString &compressionName)
+    : m_compressionName(compressionName),
+      m_compression(0)
+{
+    if (m_compressionName.isEmpty()) {
+        m_compressionName = KisCompressionFactory::defaultCompression();
+    }
 
+    m_compression = KisCompressionFactory::create(m_compressionName);
 
-KisTileCompressor2::KisTileCompressor2()
-{
-    m_compression = new KisLzfCompression();
+    if (!m_compression) {
+        warnFile << "Tile compression" << m_compressionName
+                 << "is not available, falling back to the default one";
+
+        m_compressionName = KisCompressionFactory::defaultCompression();
+        m_compression = KisCompressionFactory::create(m_compressionName);
+    }
 }
 
 KisTileCompressor2::~KisTileCompressor2()
 {
+    qDeleteAll(m_extraCompressions);
     delete m_compression;
 }
 
+QString KisTileCompressor2::compressionName() const
+{
+    return m_compressionName;
+}
+
+KisAbstractCompression* KisTileCompressor2::compressionByName(const QString &name)
+{
+    if (name == m_compressionName) {
+        return m_compression;
+    }
+
+    if (!m_extraCompressions.contains(name)) {
+        KisAbstractCompression *compression = KisCompressionFactory::create(name);
+        if (!compression) {
+            warnFile << "Unsupported tile compression:" << name;
+        }
+        m_extraCompressions.insert(name, compression);
+    }
+
+    return m_extraCompressions.value(name);
+}
+
+/**
+ * A tile and all the buffers needed for compressing it
+ * on a worker thread. The jobs are reused for the following
+ * windows of tiles, so the buffers are allocated only once
+ */
+struct KisTileCompressor2::CompressionJob
+{
+    CompressionJob() : bytesWritten(0) {}
+
+    KisTileSP tile;
+    QByteArray streamingBuffer;
+    QByteArray linearizationBuffer;
+    QByteArray compressionBuffer;
+    qint32 bytesWritten;
+};
+
+struct KisTileCompressor2::CompressionJobFunctor
+{
+    typedef void result_type;
+
+    CompressionJobFunctor(KisAbstractCompression *compression)
+        : m_compression(compression)
+    {
+    }
+
+    void operator() (CompressionJob &job) {
+        const qint32 tileDataSize = TILE_DATA_SIZE(job.tile->pixelSize());
+
+        job.streamingBuffer.resize(tileDataSize + 1);
+        job.linearizationBuffer.resize(tileDataSize);
+        job.compressionBuffer.resize(m_compression->outputBufferSize(tileDataSize));
+
+        job.tile->lockForRead();
+        compressTileDataImpl(m_compression, job.tile->tileData(),
+                             (quint8*)job.streamingBuffer.data(),
+                             job.linearizationBuffer, job.compressionBuffer,
+                             job.bytesWritten);
+        job.tile->unlock();
+    }
+
+    KisAbstractCompression *m_compression;
+};
+
 bool KisTileCompressor2::writeTile(KisTileSP tile, KisPaintDeviceWriter &store)
 {
     const qint32 tileDataSize = TILE_DATA_SIZE(tile->pixelSize());
@@ -47,13 +127,89 @@ bool KisTileCompressor2::writeTile(KisTileSP tile, KisPaintDeviceWriter &store)
                      m_streamingBuffer.size(), bytesWritten);
     tile->unlock();
 
-    QString header = getHeader(tile, bytesWritten);
+    return writeCompressedTile(tile, m_streamingBuffer.data(), bytesWritten, store);
+}
+
+bool KisTileCompressor2::writeTiles(const QVector<KisTileSP> &tiles, KisPaintDeviceWriter &store)
+{
+    const int numThreads = QThread::idealThreadCount();
+
+    /**
+     * Spreading just a few tiles over the thread
+     * pool costs more than it gains
+     */
+    if (numThreads <= 1 || tiles.size() < 2 * numThreads) {
+        return KisAbstractTileCompressor::writeTiles(tiles, store);
+    }
+
+    /**
+     * The tiles are processed in windows. While the pool compresses
+     * the next window, the current thread writes the previous one
+     * into the store, so compression overlaps with I/O. The tiles
+     * are written in the same order as the serial version does,
+     * therefore the output is exactly the same.
+     */
+    const int windowSize = 4 * numThreads;
+    const int numWindows = (tiles.size() + windowSize - 1) / windowSize;
+
+    QVector<CompressionJob> windows[2];
+    CompressionJobFunctor functor(m_compression);
+
+    auto startWindow = [&] (int windowIndex) -> QFuture<void> {
+        QVector<CompressionJob> &jobs = windows[windowIndex & 1];
+
+        const int start = windowIndex * windowSize;
+        const int size = qMin(windowSize, tiles.size() - start);
+
+        jobs.resize(size);
+        for (int i = 0; i < size; i++) {
+            jobs[i].tile = tiles[start + i];
+        }
+
+        return QtConcurrent::map(jobs, functor);
+    };
+
+    bool retval = true;
+    QFuture<void> currentWindow = startWindow(0);
+
+    for (int w = 0; w < numWindows; w++) {
+        currentWindow.waitForFinished();
+
+        QFuture<void> nextWindow;
+        if (w + 1 < numWindows) {
+            nextWindow = startWindow(w + 1);
+        }
+
+        QVector<CompressionJob> &jobs = windows[w & 1];
+        for (int i = 0; i < jobs.size(); i++) {
+            CompressionJob &job = jobs[i];
+
+            if (retval) {
+                retval = writeCompressedTile(job.tile, job.streamingBuffer.data(),
+                                             job.bytesWritten, store);
+            }
+            job.tile.clear();
+        }
+
+        currentWindow = nextWindow;
+    }
+
+    // in case we failed in the middle, the pool may still be working
+    currentWindow.waitForFinished();
+
+    return retval;
+}
+
+bool KisTileCompressor2::writeCompressedTile(KisTileSP tile, const char *data,
+                                             qint32 dataSize, KisPaintDeviceWriter &store)
+{
+    QString header = getHeader(tile, dataSize);
     bool retval = true;
     retval = store.write(header.toLatin1());
     if (!retval) {
         warnFile << "Failed to write the tile header";
     }
-    retval = store.write(m_streamingBuffer.data(), bytesWritten);
+    retval = store.write(data, dataSize);
     if (!retval) {
         warnFile << "Failed to write the tile datak";
     }
@@ -65,6 +221,137 @@ bool KisTileCompressor2::readTile(QIODevice *stream, KisTiledDataManager *dm)
     const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize(dm));
     prepareStreamingBuffer(tileDataSize);
 
+    KisTileSP tile;
+    KisAbstractCompression *compression;
+    qint32 dataSize;
+
+    if (readTileHeader(stream, dm, tile, compression, dataSize)) {
+        stream->read(m_streamingBuffer.data(), dataSize);
+
+        // the data has been skipped, but we cannot decode it
+        if (!compression) return false;
+
+        prepareWorkBuffers(tileDataSize);
+
+        tile->lockForWrite();
+        bool res = decompressTileDataImpl(compression,
+                                          (quint8*)m_streamingBuffer.data(), dataSize,
+                                          tile->tileData(), m_linearizationBuffer);
+        tile->unlockForWrite();
+        return res;
+    }
+    return false;
+}
+
+/**
+ * A tile read from the stream together with its still
+ * compressed data and the buffer for delinearization
+ */
+struct KisTileCompressor2::DecompressionJob
+{
+    DecompressionJob() : compression(0), dataSize(0), result(false) {}
+
+    KisTileSP tile;
+    KisAbstractCompression *compression;
+    QByteArray streamingBuffer;
+    QByteArray linearizationBuffer;
+    qint32 dataSize;
+    bool result;
+};
+
+struct KisTileCompressor2::DecompressionJobFunctor
+{
+    typedef void result_type;
+
+    void operator() (DecompressionJob &job) {
+        if (!job.compression) {
+            job.result = false;
+            return;
+        }
+
+        job.linearizationBuffer.resize(TILE_DATA_SIZE(job.tile->pixelSize()));
+
+        job.tile->lockForWrite();
+        job.result = decompressTileDataImpl(job.compression,
+                                            (quint8*)job.streamingBuffer.data(),
+                                            job.dataSize,
+                                            job.tile->tileData(),
+                                            job.linearizationBuffer);
+        job.tile->unlockForWrite();
+    }
+};
+
+bool KisTileCompressor2::readTiles(QIODevice *stream, KisTiledDataManager *dm, quint32 numTiles)
+{
+    const int numThreads = QThread::idealThreadCount();
+
+    if (numThreads <= 1 || numTiles < quint32(2 * numThreads)) {
+        return KisAbstractTileCompressor::readTiles(stream, dm, numTiles);
+    }
+
+    /**
+     * The same pipeline as in writeTiles(), but reversed: the current
+     * thread reads the compressed data of the next window of tiles
+     * while the pool decompresses the previous one. The stream is
+     * touched by the current thread only.
+     */
+    const int windowSize = 4 * numThreads;
+    const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize(dm));
+
+    QVector<DecompressionJob> windows[2];
+    QFuture<void> pendingWindows[2];
+    DecompressionJobFunctor functor;
+
+    bool readSuccess = true;
+    int windowIndex = 0;
+
+    auto collectResults = [&] (int index) {
+        pendingWindows[index].waitForFinished();
+
+        QVector<DecompressionJob> &jobs = windows[index];
+        for (int i = 0; i < jobs.size(); i++) {
+            if (jobs[i].tile && !jobs[i].result) {
+                readSuccess = false;
+            }
+            jobs[i].tile.clear();
+        }
+    };
+
+    for (quint32 start = 0; start < numTiles; start += windowSize) {
+        const int index = windowIndex++ & 1;
+        collectResults(index);
+
+        QVector<DecompressionJob> &jobs = windows[index];
+        jobs.resize(qMin(quint32(windowSize), numTiles - start));
+
+        int numJobs = 0;
+        for (int i = 0; i < jobs.size(); i++) {
+            DecompressionJob &job = jobs[numJobs];
+
+            if (!readTileHeader(stream, dm, job.tile, job.compression, job.dataSize)) {
+                readSuccess = false;
+                continue;
+            }
+
+            job.streamingBuffer.resize(qMax(job.dataSize, tileDataSize + 1));
+            stream->read(job.streamingBuffer.data(), job.dataSize);
+            numJobs++;
+        }
+        jobs.resize(numJobs);
+
+        pendingWindows[index] = QtConcurrent::map(jobs, functor);
+    }
+
+    collectResults(0);
+    collectResults(1);
+
+    return readSuccess;
+}
+
+bool KisTileCompressor2::readTileHeader(QIODevice *stream, KisTiledDataManager *dm,
+                                        KisTileSP &tile, KisAbstractCompression *&compression,
+                                        qint32 &dataSize)
+{
     QByteArray header = stream->readLine(maxHeaderLength());
 
     QList<QByteArray> headerItems = header.trimmed().split(',');
@@ -72,22 +359,21 @@ bool KisTileCompressor2::readTile(QIODevice *stream, KisTiledDataManager *dm)
         qint32 x = headerItems.takeFirst().toInt();
         qint32 y = headerItems.takeFirst().toInt();
         QString compressionName = headerItems.takeFirst();
-        qint32 dataSize = headerItems.takeFirst().toInt();
+        dataSize = headerItems.takeFirst().toInt();
 
         Q_ASSERT(headerItems.isEmpty());
-        Q_ASSERT(compressionName == m_compressionName);
+
+        /**
+         * Every tile stores the name of its codec, so the files
+         * written with any of the supported codecs can be read
+         */
+        compression = compressionByName(compressionName);
 
         qint32 row = yToRow(dm, y);
         qint32 col = xToCol(dm, x);
 
-        KisTileSP tile = dm->getTile(col, row, true);
-
-        stream->read(m_streamingBuffer.data(), dataSize);
-
-        tile->lockForWrite();
-        bool res = decompressTileData((quint8*)m_streamingBuffer.data(), dataSize, tile->tileData());
-        tile->unlock();
-        return res;
+        tile = dm->getTile(col, row, true);
+        return true;
     }
     return false;
 }
@@ -114,24 +400,37 @@ void KisTileCompressor2::compressTileData(KisTileData *tileData,
                                           qint32 bufferSize,
                                           qint32 &bytesWritten)
 {
-    const qint32 pixelSize = tileData->pixelSize();
-    const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize);
-    qint32 compressedBytes;
+    const qint32 tileDataSize = TILE_DATA_SIZE(tileData->pixelSize());
 
     Q_UNUSED(bufferSize);
     Q_ASSERT(bufferSize >= tileDataSize + 1);
 
     prepareWorkBuffers(tileDataSize);
 
-    KisAbstractCompression::linearizeColors(tileData->data(), (quint8*)m_linearizationBuffer.data(),
+    compressTileDataImpl(m_compression, tileData, buffer,
+                         m_linearizationBuffer, m_compressionBuffer,
+                         bytesWritten);
+}
+
+void KisTileCompressor2::compressTileDataImpl(KisAbstractCompression *compression,
+                                              KisTileData *tileData, quint8 *buffer,
+                                              QByteArray &linearizationBuffer,
+                                              QByteArray &compressionBuffer,
+                                              qint32 &bytesWritten)
+{
+    const qint32 pixelSize = tileData->pixelSize();
+    const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize);
+    qint32 compressedBytes;
+
+    KisAbstractCompression::linearizeColors(tileData->data(), (quint8*)linearizationBuffer.data(),
                                             tileDataSize, pixelSize);
 
-    compressedBytes = m_compression->compress((quint8*)m_linearizationBuffer.data(), tileDataSize,
-                                              (quint8*)m_compressionBuffer.data(), m_compressionBuffer.size());
+    compressedBytes = compression->compress((quint8*)linearizationBuffer.data(), tileDataSize,
+                                            (quint8*)compressionBuffer.data(), compressionBuffer.size());
 
     if(compressedBytes < tileDataSize) {
         buffer[0] = COMPRESSED_DATA_FLAG;
-        memcpy(buffer + 1, m_compressionBuffer.data(), compressedBytes);
+        memcpy(buffer + 1, compressionBuffer.data(), compressedBytes);
         bytesWritten = compressedBytes + 1;
     }
     else {
@@ -144,18 +443,29 @@ void KisTileCompressor2::compressTileData(KisTileData *tileData,
 bool KisTileCompressor2::decompressTileData(quint8 *buffer,
                                             qint32 bufferSize,
                                             KisTileData *tileData)
+{
+    if(buffer[0] == COMPRESSED_DATA_FLAG) {
+        prepareWorkBuffers(TILE_DATA_SIZE(tileData->pixelSize()));
+    }
+
+    return decompressTileDataImpl(m_compression, buffer, bufferSize,
+                                  tileData, m_linearizationBuffer);
+}
+
+bool KisTileCompressor2::decompressTileDataImpl(KisAbstractCompression *compression,
+                                                quint8 *buffer, qint32 bufferSize,
+                                                KisTileData *tileData,
+                                                QByteArray &linearizationBuffer)
 {
     const qint32 pixelSize = tileData->pixelSize();
     const qint32 tileDataSize = TILE_DATA_SIZE(pixelSize);
 
     if(buffer[0] == COMPRESSED_DATA_FLAG) {
-        prepareWorkBuffers(tileDataSize);
-
         qint32 bytesWritten;
-        bytesWritten = m_compression->decompress(buffer + 1, bufferSize - 1,
-                                                 (quint8*)m_linearizationBuffer.data(), tileDataSize);
+        bytesWritten = compression->decompress(buffer + 1, bufferSize - 1,
+                                               (quint8*)linearizationBuffer.data(), tileDataSize);
         if (bytesWritten == tileDataSize) {
-            KisAbstractCompression::delinearizeColors((quint8*)m_linearizationBuffer.data(),
+            KisAbstractCompression::delinearizeColors((quint8*)linearizationBuffer.data(),
                                                       tileData->data(),
                                                       tileDataSize, pixelSize);
             return true;
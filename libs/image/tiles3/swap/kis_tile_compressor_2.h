@@ -20,18 +20,41 @@
 #define __KIS_TILE_COMPRESSOR_2_H
 
 #include "kis_abstract_tile_compressor.h"
+#include <QHash>
 
 class KisAbstractCompression;
 
 class KRITAIMAGE_EXPORT KisTileCompressor2 : public KisAbstractTileCompressor
 {
 public:
-    KisTileCompressor2();
+    /**
+     * Creates a compressor that writes the tiles with the codec
+     * \p compressionName (see KisCompressionFactory). When the name
+     * is empty or the codec is not available in this build, the
+     * default LZF codec is used. The tiles can be read back
+     * regardless of the codec they have been written with.
+     */
+    explicit KisTileCompressor2(const QString &compressionName = QString());
     ~KisTileCompressor2() override;
 
+    QString compressionName() const;
+
     bool writeTile(KisTileSP tile, KisPaintDeviceWriter &store) override;
+
+    /**
+     * Compresses the tiles on the global thread pool and writes them
+     * into the \a store in the order of \a tiles. The result is
+     * byte-to-byte equal to calling writeTile() for every tile.
+     */
+    bool writeTiles(const QVector<KisTileSP> &tiles, KisPaintDeviceWriter &store) override;
     bool readTile(QIODevice *io, KisTiledDataManager *dm) override;
 
+    /**
+     * Reads the compressed tiles from the \a stream in the calling
+     * thread and decompresses them on the global thread pool.
+     */
+    bool readTiles(QIODevice *stream, KisTiledDataManager *dm, quint32 numTiles) override;
+
 
     void compressTileData(KisTileData *tileData,quint8 *buffer,
                           qint32 bufferSize, qint32 &bytesWritten) override;
@@ -39,6 +62,49 @@ public:
     qint32 tileDataBufferSize(KisTileData *tileData) override;
 
 private:
+    struct CompressionJob;
+    struct CompressionJobFunctor;
+    struct DecompressionJob;
+    struct DecompressionJobFunctor;
+
+    /**
+     * Compresses \p tileData into \p buffer using the work buffers
+     * passed by the caller. Doesn't touch any members of the class,
+     * so it can be called from several threads at once.
+     */
+    static void compressTileDataImpl(KisAbstractCompression *compression,
+                                     KisTileData *tileData, quint8 *buffer,
+                                     QByteArray &linearizationBuffer,
+                                     QByteArray &compressionBuffer,
+                                     qint32 &bytesWritten);
+
+    /**
+     * Thread-safe counterpart of decompressTileData()
+     */
+    static bool decompressTileDataImpl(KisAbstractCompression *compression,
+                                       quint8 *buffer, qint32 bufferSize,
+                                       KisTileData *tileData,
+                                       QByteArray &linearizationBuffer);
+
+    /**
+     * Reads the header of the next tile in the \p stream and creates
+     * the corresponding tile in \p dm. The compressed data itself
+     * is left in the stream. \p compression is set to null if the
+     * codec of the tile is not supported.
+     */
+    bool readTileHeader(QIODevice *stream, KisTiledDataManager *dm,
+                        KisTileSP &tile, KisAbstractCompression *&compression,
+                        qint32 &dataSize);
+
+    /**
+     * Returns the codec for decompressing the tiles written with
+     * \p name or null if it is not supported
+     */
+    KisAbstractCompression* compressionByName(const QString &name);
+
+    bool writeCompressedTile(KisTileSP tile, const char *data,
+                             qint32 dataSize, KisPaintDeviceWriter &store);
+
     /**
      * Quite self describing
      */
@@ -57,8 +123,9 @@ private:
     QByteArray m_linearizationBuffer;
     QByteArray m_compressionBuffer;
     QByteArray m_streamingBuffer;
+    QString m_compressionName;
     KisAbstractCompression *m_compression;
-    static const QString m_compressionName;
+    QHash<QString, KisAbstractCompression*> m_extraCompressions;
 };
 
 #endif /* __KIS_TILE_COMPRESSOR_2_H */
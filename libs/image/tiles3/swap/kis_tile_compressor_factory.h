@@ -25,13 +25,18 @@
 class KRITAIMAGE_EXPORT KisTileCompressorFactory
 {
 public:
-    static KisAbstractTileCompressorSP create(qint32 version) {
+    /**
+     * \p compressionName selects the codec used for writing
+     * the tiles, it is ignored by the legacy compressor
+     */
+    static KisAbstractTileCompressorSP create(qint32 version,
+                                              const QString &compressionName = QString()) {
         switch(version) {
         case 1:
             return KisAbstractTileCompressorSP(new KisLegacyTileCompressor());
             break;
         case 2:
-            return KisAbstractTileCompressorSP(new KisTileCompressor2());
+            return KisAbstractTileCompressorSP(new KisTileCompressor2(compressionName));
             break;
         default:
             qFatal("Unknown version of the tiles");
@@ -49,8 +49,10 @@ struct Q_DECL_HIDDEN KisTileDataSwapper::Private
 public:
     QSemaphore semaphore;
     QAtomicInt shouldExitFlag;
+    QAtomicInt pendingSwapJobs;
     KisTileDataStore *store;
     KisStoreLimits limits;
+    KisSwapPolicy policy;
     QMutex cycleLock;
 };
 
@@ -59,6 +61,7 @@ KisTileDataSwapper::KisTileDataSwapper(KisTileDataStore *store)
       m_d(new Private())
 {
     m_d->shouldExitFlag = 0;
+    m_d->pendingSwapJobs = 0;
     m_d->store = store;
 }
 
@@ -68,6 +71,12 @@ KisTileDataSwapper::~KisTileDataSwapper()
 }
 
 void KisTileDataSwapper::kick()
+{
+    m_d->pendingSwapJobs.ref();
+    m_d->semaphore.release();
+}
+
+void KisTileDataSwapper::kickPrefetch()
 {
     m_d->semaphore.release();
 }
@@ -94,12 +103,30 @@ void KisTileDataSwapper::run()
         if (m_d->shouldExitFlag)
             return;
 
+        doPrefetch();
+
+        if (m_d->pendingSwapJobs.fetchAndAddOrdered(-1) <= 0) {
+            // we have been woken up for prefetching only
+            m_d->pendingSwapJobs.ref();
+            continue;
+        }
+
         QThread::msleep(DELAY);
 
         doJob();
     }
 }
 
+void KisTileDataSwapper::doPrefetch()
+{
+    /**
+     * Never prefetch more than the swapper itself would let stay in
+     * memory, otherwise the prefetched tiles would push the ones
+     * being painted on out of memory
+     */
+    m_d->store->processPrefetchQueue(m_d->limits.hardLimit());
+}
+
 void KisTileDataSwapper::checkFreeMemory()
 {
 //    dbgKrita <<"check memory: high limit -" << m_d->limits.emergencyThreshold() <<"in mem -" << m_d->store->numTilesInMemory();
@@ -157,13 +184,11 @@ public:
         store->endIteration(iter);
     }
 
-    static inline bool isInteresting(KisTileData *td) {
-        // We are working with mementoed tiles only...
-        return td->historical();
-    }
-
-    static inline bool swapOutFirst(KisTileData *td) {
-        return td->age() > 0;
+    static inline bool isInteresting(KisTileData *td, const KisSwapPolicy &policy) {
+        // We are working with mementoed and low-priority tiles only...
+        return td->historical() ||
+            (policy.usePriorities() &&
+             td->swapPriority() == KisTileData::LOW_PRIORITY);
     }
 };
 
@@ -180,23 +205,30 @@ public:
         store->endIteration(iter);
     }
 
-    static inline bool isInteresting(KisTileData *td) {
+    static inline bool isInteresting(KisTileData *td, const KisSwapPolicy &policy) {
         // Add some aggression...
         Q_UNUSED(td);
+        Q_UNUSED(policy);
         return true; // >:)
     }
-
-    static inline bool swapOutFirst(KisTileData *td) {
-        return td->age() > 0;
-    }
 };
 
 
 template<class strategy>
 qint64 KisTileDataSwapper::pass(qint64 needToFreeMetric)
 {
+    const KisSwapPolicy &policy = m_d->policy;
+
+    /**
+     * Old tiles of the lowest priority are swapped out right
+     * away, the others are sorted into buckets by their priority
+     * and recency. The buckets are processed in order after the
+     * walk over the store is finished.
+     */
+    const int numBuckets = 2 * (KisTileData::HIGH_PRIORITY + 1);
+    QList<KisTileData*> additionalCandidates[numBuckets];
+
     qint64 freedMetric = 0;
-    QList<KisTileData*> additionalCandidates;
 
     typename strategy::iterator *iter =
         strategy::beginIteration(m_d->store);
@@ -209,25 +241,30 @@ qint64 KisTileDataSwapper::pass(qint64 needToFreeMetric)
         if(freedMetric >= needToFreeMetric) break;
 
 
-        if(!strategy::isInteresting(item)) continue;
+        if(!strategy::isInteresting(item, policy)) continue;
+
+        const int priority = policy.priority(item);
+        const bool isOld = policy.isOld(item);
 
-        if(strategy::swapOutFirst(item)) {
+        if(isOld && priority == KisTileData::LOW_PRIORITY) {
             if(iter->trySwapOut(item)) {
                 freedMetric += item->pixelSize();
             }
         }
         else {
             item->markOld();
-            additionalCandidates.append(item);
+            additionalCandidates[2 * priority + !isOld].append(item);
         }
 
     }
 
-    Q_FOREACH (item, additionalCandidates) {
-        if(freedMetric >= needToFreeMetric) break;
+    for (int i = 0; i < numBuckets; i++) {
+        Q_FOREACH (item, additionalCandidates[i]) {
+            if(freedMetric >= needToFreeMetric) break;
 
-        if(iter->trySwapOut(item)) {
-            freedMetric += item->pixelSize();
+            if(iter->trySwapOut(item)) {
+                freedMetric += item->pixelSize();
+            }
         }
     }
 
@@ -239,4 +276,5 @@ qint64 KisTileDataSwapper::pass(qint64 needToFreeMetric)
 void KisTileDataSwapper::testingRereadConfig()
 {
     m_d->limits = KisStoreLimits();
+    m_d->policy = KisSwapPolicy();
 }
@@ -37,6 +37,13 @@ public:
     ~KisTileDataSwapper() override;
 
     void kick();
+
+    /**
+     * Wakes up the swapper to process the prefetch queue of the
+     * store. Unlike kick(), the queue is processed immediately.
+     */
+    void kickPrefetch();
+
     void terminateSwapper();
     void checkFreeMemory();
 
@@ -47,6 +54,7 @@ private:
     void run() override;
 
     void doJob();
+    void doPrefetch();
     template<class strategy> qint64 pass(qint64 needToFreeMetric);
 
 private:
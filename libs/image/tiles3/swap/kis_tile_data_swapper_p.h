@@ -104,6 +104,70 @@ private:
 };
 
 
+/**
+ * Defines the order in which the tiles leave memory.
+ *
+ * When priorities are enabled, the tiles are swapped out in
+ * the following order:
+ *
+ *   1) undo information and tiles with low priority (hidden and
+ *      locked layers) that haven't been accessed recently
+ *   2) recently used undo and low priority tiles
+ *   3) normal tiles that haven't been accessed recently
+ *   4) recently used normal tiles
+ *   5) high priority tiles (the active layer and the visible part
+ *      of the projection), old ones first
+ *
+ * A tile is "not recently used" when it has stayed untouched
+ * for recencyThreshold() swapper cycles.
+ */
+class KisSwapPolicy
+{
+public:
+    KisSwapPolicy() {
+        KisImageConfig config;
+
+        m_usePriorities = config.useTileSwapPriorities();
+        m_recencyThreshold = qMax(1, config.tileSwapRecencyThreshold());
+    }
+
+    /**
+     * Builds a policy that doesn't depend on the user's config,
+     * used by the unittests
+     */
+    KisSwapPolicy(bool usePriorities, int recencyThreshold)
+        : m_usePriorities(usePriorities),
+          m_recencyThreshold(qMax(1, recencyThreshold))
+    {
+    }
+
+    inline bool usePriorities() const {
+        return m_usePriorities;
+    }
+
+    inline int recencyThreshold() const {
+        return m_recencyThreshold;
+    }
+
+    inline bool isOld(KisTileData *td) const {
+        return td->age() >= m_recencyThreshold;
+    }
+
+    /**
+     * Returns the effective priority of the tile data. Undo
+     * information always has the lowest priority.
+     */
+    inline KisTileData::EnumSwapPriority priority(KisTileData *td) const {
+        return !m_usePriorities || td->historical() ?
+            KisTileData::LOW_PRIORITY : td->swapPriority();
+    }
+
+private:
+    bool m_usePriorities;
+    int m_recencyThreshold;
+};
+
+
 
 
 #endif /* KIS_TILE_DATA_SWAPPER_P_H_ */
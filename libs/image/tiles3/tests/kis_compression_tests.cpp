@@ -23,6 +23,7 @@
 
 #include "../../../sdk/tests/testutil.h"
 #include "tiles3/swap/kis_lzf_compression.h"
+#include "tiles3/swap/kis_compression_factory.h"
 #include <kis_debug.h>
 
 #define TEST_FILE "tile.png"
@@ -262,5 +263,56 @@ void KisCompressionTests::benchmarkDecompressionLzfTwoPass()
     delete compression;
 }
 
+KisAbstractCompression* createLz4Compression()
+{
+    return KisCompressionFactory::create("LZ4");
+}
+
+void KisCompressionTests::testLz4RoundTrip()
+{
+    KisAbstractCompression *compression = createLz4Compression();
+    if (!compression) {
+        QSKIP("LZ4 is not available in this build");
+    }
+
+    roundTrip(compression);
+    roundTripTwoPass(compression);
+
+    delete compression;
+}
+
+void KisCompressionTests::testLz4Overflow()
+{
+    KisAbstractCompression *compression = createLz4Compression();
+    if (!compression) {
+        QSKIP("LZ4 is not available in this build");
+    }
+
+    testOverflow(compression);
+    delete compression;
+}
+
+void KisCompressionTests::benchmarkCompressionLz4TwoPass()
+{
+    KisAbstractCompression *compression = createLz4Compression();
+    if (!compression) {
+        QSKIP("LZ4 is not available in this build");
+    }
+
+    benchmarkCompressionTwoPass(compression);
+    delete compression;
+}
+
+void KisCompressionTests::benchmarkDecompressionLz4TwoPass()
+{
+    KisAbstractCompression *compression = createLz4Compression();
+    if (!compression) {
+        QSKIP("LZ4 is not available in this build");
+    }
+
+    benchmarkDecompressionTwoPass(compression);
+    delete compression;
+}
+
 QTEST_MAIN(KisCompressionTests)
 
@@ -48,6 +48,11 @@ private Q_SLOTS:
     void benchmarkCompressionLzfTwoPass();
     void benchmarkDecompressionLzf();
     void benchmarkDecompressionLzfTwoPass();
+
+    void testLz4RoundTrip();
+    void testLz4Overflow();
+    void benchmarkCompressionLz4TwoPass();
+    void benchmarkDecompressionLz4TwoPass();
 };
 
 #endif /* KIS_COMPRESSION_TESTS_H */
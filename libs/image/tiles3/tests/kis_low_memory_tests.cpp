@@ -68,7 +68,7 @@ public:
                     KisTileSP voidTile = m_srcDM.getTile(i, 0, true);
                     voidTile->lockForWrite();
                     QTest::qSleep(1);
-                    voidTile->unlock();
+                    voidTile->unlockForWrite();
                 }
 
                 QRect cloneRect(0, 0, m_numTiles * 64, 64);
@@ -190,7 +190,7 @@ void KisLowMemoryTests::hangingTilesTest()
 
     QCOMPARE((int)weirdTileData->m_usersCount, 2);
 
-    srcTile->unlock();
+    srcTile->unlockForWrite();
     srcTile->unlock();
     srcTile = 0;
 
@@ -207,7 +207,7 @@ void KisLowMemoryTests::hangingTilesTest()
 
     QCOMPARE((int)weirdTileData->m_usersCount, 1);
 
-    dstTile->unlock();
+    dstTile->unlockForWrite();
     dstTile->unlock();
     dstTile = 0;
 }
@@ -131,7 +131,7 @@ void KisTileDataStoreTest::testLeaks()
 
     KisTileSP tile = dm->getTile(0, 0, true);
     tile->lockForWrite();
-    tile->unlock();
+    tile->unlockForWrite();
 
     tile = 0;
 
@@ -166,7 +166,7 @@ void KisTileDataStoreTest::testSwapping()
         memset(td->data(), COLUMN2COLOR(col), TILESIZE);
         QVERIFY(memoryIsFilled(COLUMN2COLOR(col), td->data(), TILESIZE));
 
-        tile->unlock();
+        tile->unlockForWrite();
     }
 
     //KisTileDataStore::instance()->debugSwapAll();
@@ -20,6 +20,11 @@
 #include <QTest>
 
 #include "tiles3/kis_tiled_data_manager.h"
+#include "tiles3/kis_tile_data_store.h"
+#include "tiles3/swap/kis_tile_data_swapper_p.h"
+#include "tiles3/swap/kis_tile_compressor_2.h"
+#include "tiles3/swap/kis_compression_factory.h"
+#include "kis_image_config.h"
 
 #include "tiles_test_utils.h"
 
@@ -604,7 +609,7 @@ void KisTiledDataManagerTest::benchmarkCOWImpl()
         for (int j = 0; j < 64; j++) {
             KisTileSP tile = dm.getTile(j, i, true);
             tile->lockForWrite();
-            tile->unlock();
+            tile->unlockForWrite();
         }
     }
 
@@ -620,7 +625,7 @@ void KisTiledDataManagerTest::benchmarkCOWImpl()
             for (int j = 0; j < 64; j++) {
                 KisTileSP tile = dm.getTile(j, i, true);
                 tile->lockForWrite();
-                tile->unlock();
+                tile->unlockForWrite();
             }
         }
 
@@ -707,7 +712,7 @@ public:
                     tile = dm.getTile(m_accessRect.x() / TILE_DIMENSION,
                                       m_accessRect.y() / TILE_DIMENSION, true);
                     tile->lockForWrite();
-                    tile->unlock();
+                    tile->unlockForWrite();
 
                     tile = dm.getOldTile(m_accessRect.x() / TILE_DIMENSION,
                                          m_accessRect.y() / TILE_DIMENSION);
@@ -807,5 +812,432 @@ void KisTiledDataManagerTest::stressTest()
     pool.waitForDone();
 }
 
+void KisTiledDataManagerTest::testHashTableGrowth()
+{
+    quint8 defaultPixel = 0;
+    KisTiledDataManager dm(1, &defaultPixel);
+
+    // much more tiles than the initial size of the hash table,
+    // so the table will have to grow a few times
+    const qint32 numCols = 100;
+    const qint32 numRows = 60;
+
+    auto tileValue = [] (qint32 col, qint32 row) {
+        return quint8((col * 7 + row * 13) % 254 + 1);
+    };
+
+    for (qint32 row = 0; row < numRows; row++) {
+        for (qint32 col = 0; col < numCols; col++) {
+            const quint8 value = tileValue(col, row);
+            dm.clear(QRect(col * 64, row * 64, 64, 64), &value);
+        }
+    }
+
+    quint8 pixel = 0;
+
+    for (qint32 row = 0; row < numRows; row++) {
+        for (qint32 col = 0; col < numCols; col++) {
+            KisTileSP tile = dm.getTile(col, row, false);
+            QCOMPARE(tile->col(), col);
+            QCOMPARE(tile->row(), row);
+
+            dm.readBytes(&pixel, col * 64 + 10, row * 64 + 20, 1, 1);
+            QCOMPARE(pixel, tileValue(col, row));
+        }
+    }
+
+    QCOMPARE(dm.extent(), QRect(0, 0, numCols * 64, numRows * 64));
+}
+
+void KisTiledDataManagerTest::testParallelTilesWriting()
+{
+    const qint32 pixelSize = 4;
+    const quint8 defaultPixel[pixelSize] = {0, 0, 0, 0};
+    KisTiledDataManager dm(pixelSize, defaultPixel);
+
+    const QRect rc(0, 0, 40 * 64, 30 * 64);
+
+    /**
+     * Every tile gets its own content, every third
+     * tile is filled with incompressible noise
+     */
+    QByteArray data(rc.width() * rc.height() * pixelSize, 0);
+    quint8 *ptr = reinterpret_cast<quint8*>(data.data());
+    quint32 seed = 1;
+
+    for (qint32 y = 0; y < rc.height(); y++) {
+        for (qint32 x = 0; x < rc.width(); x++) {
+            const qint32 col = x / 64;
+            const qint32 row = y / 64;
+
+            for (qint32 ch = 0; ch < pixelSize; ch++) {
+                seed = seed * 1103515245U + 12345U;
+                *ptr++ = (col + row) % 3 ?
+                    quint8(col * 13 + row * 7 + ch) : quint8(seed >> 16);
+            }
+        }
+    }
+
+    dm.writeBytes(reinterpret_cast<const quint8*>(data.constData()),
+                  rc.x(), rc.y(), rc.width(), rc.height());
+
+    QVector<KisTileSP> tiles;
+    for (qint32 row = 0; row < rc.height() / 64; row++) {
+        for (qint32 col = 0; col < rc.width() / 64; col++) {
+            tiles << dm.getTile(col, row, false);
+        }
+    }
+
+    KoStoreFake serialStore;
+    KisFakePaintDeviceWriter serialWriter(&serialStore);
+    KisTileCompressor2 serialCompressor;
+    Q_FOREACH (KisTileSP tile, tiles) {
+        QVERIFY(serialCompressor.writeTile(tile, serialWriter));
+    }
+
+    KoStoreFake parallelStore;
+    KisFakePaintDeviceWriter parallelWriter(&parallelStore);
+    KisTileCompressor2 parallelCompressor;
+    QVERIFY(parallelCompressor.writeTiles(tiles, parallelWriter));
+
+    serialStore.startReading();
+    parallelStore.startReading();
+
+    // the parallel version must be byte-compatible with the serial one
+    QVERIFY(parallelStore.device()->readAll() == serialStore.device()->readAll());
+
+    KoStoreFake store;
+    KisFakePaintDeviceWriter writer(&store);
+    QVERIFY(dm.write(writer));
+    store.startReading();
+
+    KisTiledDataManager dm2(pixelSize, defaultPixel);
+    QVERIFY(dm2.read(store.device()));
+
+    QByteArray result(data.size(), 0);
+    dm2.readBytes(reinterpret_cast<quint8*>(result.data()),
+                  rc.x(), rc.y(), rc.width(), rc.height());
+
+    QVERIFY(result == data);
+}
+
+void KisTiledDataManagerTest::testTileCompressionCodecs()
+{
+    const qint32 pixelSize = 8;
+    const quint8 defaultPixel[pixelSize] = {0, 0, 0, 0, 0, 0, 0, 0};
+
+    const QRect rc(0, 0, 5 * 64, 3 * 64);
+
+    QByteArray data(rc.width() * rc.height() * pixelSize, 0);
+    quint32 seed = 1;
+    for (int i = 0; i < data.size(); i++) {
+        seed = seed * 1103515245U + 12345U;
+        data[i] = (i / pixelSize) % 7 ? char(i % 251) : char(seed >> 16);
+    }
+
+    Q_FOREACH (const QString &codec, KisCompressionFactory::availableCompressions()) {
+        KisTiledDataManager srcDM(pixelSize, defaultPixel);
+        srcDM.writeBytes(reinterpret_cast<const quint8*>(data.constData()),
+                         rc.x(), rc.y(), rc.width(), rc.height());
+
+        KoStoreFake store;
+        KisFakePaintDeviceWriter writer(&store);
+
+        KisTileCompressor2 writingCompressor(codec);
+        QCOMPARE(writingCompressor.compressionName(), codec);
+
+        QVector<KisTileSP> tiles;
+        for (qint32 row = 0; row < rc.height() / 64; row++) {
+            for (qint32 col = 0; col < rc.width() / 64; col++) {
+                tiles << srcDM.getTile(col, row, false);
+            }
+        }
+        QVERIFY(writingCompressor.writeTiles(tiles, writer));
+
+        store.startReading();
+
+        /**
+         * The reading compressor uses the default codec, but
+         * it must pick up the one written in the tile headers
+         */
+        KisTiledDataManager dstDM(pixelSize, defaultPixel);
+        KisTileCompressor2 readingCompressor;
+        QVERIFY(readingCompressor.readTiles(store.device(), &dstDM, tiles.size()));
+
+        QByteArray result(data.size(), 0);
+        dstDM.readBytes(reinterpret_cast<quint8*>(result.data()),
+                        rc.x(), rc.y(), rc.width(), rc.height());
+
+        QVERIFY(result == data);
+    }
+
+    // unknown codecs fall back to the default one
+    KisTileCompressor2 compressor("NONEXISTENT");
+    QCOMPARE(compressor.compressionName(), KisCompressionFactory::defaultCompression());
+}
+
+void KisTiledDataManagerTest::testSwapPrefetch()
+{
+    const qint32 pixelSize = 4;
+    const quint8 defaultPixel[pixelSize] = {0, 0, 0, 0};
+    KisTiledDataManager dm(pixelSize, defaultPixel);
+
+    const QRect rc(0, 0, 6 * 64, 4 * 64);
+
+    QByteArray data(rc.width() * rc.height() * pixelSize, 0);
+    for (int i = 0; i < data.size(); i++) {
+        data[i] = char((i / 7) % 253);
+    }
+
+    dm.writeBytes(reinterpret_cast<const quint8*>(data.constData()),
+                  rc.x(), rc.y(), rc.width(), rc.height());
+
+    QVector<KisTileSP> tiles;
+    for (qint32 row = 0; row < rc.height() / 64; row++) {
+        for (qint32 col = 0; col < rc.width() / 64; col++) {
+            tiles << dm.getTile(col, row, false);
+        }
+    }
+
+    KisTileDataStore *store = KisTileDataStore::instance();
+    store->debugSwapAll();
+
+    Q_FOREACH (KisTileSP tile, tiles) {
+        QVERIFY(!tile->tileData()->data());
+    }
+
+    const qint64 prefetchedBefore = store->memoryStatistics().numPrefetchedTiles;
+
+    dm.prefetchRect(rc);
+
+    auto allTilesLoaded = [&tiles] () -> bool {
+        Q_FOREACH (KisTileSP tile, tiles) {
+            if (!tile->tileData()->data()) return false;
+        }
+        return true;
+    };
+
+    for (int i = 0; i < 100 && !allTilesLoaded(); i++) {
+        QTest::qWait(100);
+    }
+
+    QVERIFY(allTilesLoaded());
+    QCOMPARE(store->memoryStatistics().numPrefetchedTiles - prefetchedBefore,
+             qint64(tiles.size()));
+
+    QByteArray result(data.size(), 0);
+    dm.readBytes(reinterpret_cast<quint8*>(result.data()),
+                 rc.x(), rc.y(), rc.width(), rc.height());
+
+    QVERIFY(result == data);
+}
+
+void KisTiledDataManagerTest::testSwapPriorities()
+{
+    const qint32 pixelSize = 1;
+    const quint8 defaultPixel = 0;
+    KisTiledDataManager dm(pixelSize, &defaultPixel);
+
+    dm.clear(QRect(0, 0, 128, 64), 1);
+
+    dm.setSwapPriority(KisTileData::LOW_PRIORITY);
+    QCOMPARE(dm.getTile(0, 0, false)->tileData()->swapPriority(), KisTileData::LOW_PRIORITY);
+    QCOMPARE(dm.getTile(1, 0, false)->tileData()->swapPriority(), KisTileData::LOW_PRIORITY);
+
+    // new tiles inherit the priority of the data manager
+    dm.clear(QRect(0, 64, 64, 64), 2);
+    QCOMPARE(dm.getTile(0, 1, false)->tileData()->swapPriority(), KisTileData::LOW_PRIORITY);
+
+    dm.setSwapPriority(KisTileData::HIGH_PRIORITY, QRect(10, 10, 10, 10));
+    QCOMPARE(dm.getTile(0, 0, false)->tileData()->swapPriority(), KisTileData::HIGH_PRIORITY);
+    QCOMPARE(dm.getTile(1, 0, false)->tileData()->swapPriority(), KisTileData::LOW_PRIORITY);
+    QCOMPARE(dm.getTile(0, 1, false)->tileData()->swapPriority(), KisTileData::LOW_PRIORITY);
+
+    // the undo information always has the lowest priority
+    KisSwapPolicy policy(true, 1);
+    QVERIFY(policy.usePriorities());
+
+    KisTileData *td = dm.getTile(0, 0, false)->tileData();
+    QCOMPARE(policy.priority(td), KisTileData::HIGH_PRIORITY);
+
+    KisSwapPolicy noPriorities(false, 1);
+    QCOMPARE(noPriorities.priority(td), KisTileData::LOW_PRIORITY);
+
+    KisMementoSP memento = dm.getMemento();
+    dm.clear(QRect(0, 0, 64, 64), 3);
+    dm.commit();
+
+    QVERIFY(td->historical());
+    QCOMPARE(policy.priority(td), KisTileData::LOW_PRIORITY);
+}
+
+void KisTiledDataManagerTest::testCompressedTier()
+{
+    KisImageConfig config;
+    config.setCompressedTileTierPercent(25);
+
+    KisTileDataStore *store = KisTileDataStore::instance();
+    store->testingRereadConfig();
+    QVERIFY(store->m_compressedStore.isEnabled());
+
+    const qint32 pixelSize = 4;
+    const quint8 defaultPixel[pixelSize] = {0, 0, 0, 0};
+    KisTiledDataManager dm(pixelSize, defaultPixel);
+
+    // the first tile is flat, the second one is noise
+    const QRect rc(0, 0, 2 * 64, 64);
+
+    QByteArray data(rc.width() * rc.height() * pixelSize, 0);
+    quint32 seed = 1;
+    for (int y = 0; y < rc.height(); y++) {
+        for (int x = 0; x < rc.width(); x++) {
+            for (int ch = 0; ch < pixelSize; ch++) {
+                seed = seed * 1103515245U + 12345U;
+                data[(y * rc.width() + x) * pixelSize + ch] =
+                    x < 64 ? char(ch + 10) : char(seed >> 16);
+            }
+        }
+    }
+
+    dm.writeBytes(reinterpret_cast<const quint8*>(data.constData()),
+                  rc.x(), rc.y(), rc.width(), rc.height());
+
+    KisTileData *flatTile = dm.getTile(0, 0, false)->tileData();
+    KisTileData *noiseTile = dm.getTile(1, 0, false)->tileData();
+
+    store->debugSwapAll();
+
+    QVERIFY(!flatTile->data());
+    QVERIFY(!noiseTile->data());
+
+    KisTileDataStore::MemoryStatistics statsBefore = store->memoryStatistics();
+    QVERIFY(statsBefore.compressedTierSize > 0);
+    QVERIFY(statsBefore.compressedTierSize < statsBefore.compressedTierUncompressedSize);
+
+    QByteArray result(data.size(), 0);
+    dm.readBytes(reinterpret_cast<quint8*>(result.data()),
+                 rc.x(), rc.y(), rc.width(), rc.height());
+
+    QVERIFY(result == data);
+
+    KisTileDataStore::MemoryStatistics statsAfter = store->memoryStatistics();
+    QCOMPARE(statsAfter.numCompressedTierHits - statsBefore.numCompressedTierHits, qint64(1));
+    QCOMPARE(statsAfter.numCompressedTierMisses - statsBefore.numCompressedTierMisses, qint64(1));
+}
+
+void KisTiledDataManagerTest::testUniformTilesSharing()
+{
+    const qint32 pixelSize = 4;
+    const quint8 defaultPixel[pixelSize] = {0, 0, 0, 0};
+    const quint8 flatPixel[pixelSize] = {10, 20, 30, 255};
+
+    QByteArray flatData(64 * 64 * pixelSize, 0);
+    for (int i = 0; i < flatData.size(); i++) {
+        flatData[i] = flatPixel[i % pixelSize];
+    }
+    QByteArray defaultData(64 * 64 * pixelSize, 0);
+
+    KisTiledDataManager srcDM(pixelSize, defaultPixel);
+
+    srcDM.writeBytes((const quint8*)flatData.constData(), 0, 0, 64, 64);
+    srcDM.writeBytes((const quint8*)defaultData.constData(), 64, 0, 64, 64);
+    srcDM.writeBytes((const quint8*)flatData.constData(), 128, 0, 64, 64);
+    srcDM.setPixel(130, 10, defaultPixel);
+
+    KoStoreFake store;
+    KisFakePaintDeviceWriter writer(&store);
+    QVERIFY(srcDM.write(writer));
+
+    // the written tiles are left untouched...
+    QVERIFY(srcDM.getTile(1, 0, false)->tileData() != srcDM.getTile(10, 10, false)->tileData());
+
+    // ...and the loaded ones are shared automatically
+    KisTiledDataManager dm1(pixelSize, defaultPixel);
+    store.startReading();
+    QVERIFY(dm1.read(store.device()));
+
+    KisTiledDataManager dm2(pixelSize, defaultPixel);
+    store.startReading();
+    QVERIFY(dm2.read(store.device()));
+
+    KisTileData *td1 = dm1.getTile(0, 0, false)->tileData();
+    QVERIFY(dm2.getTile(0, 0, false)->tileData() == td1);
+
+    // the tile of the default color shares the default tile data
+    QVERIFY(dm1.getTile(1, 0, false)->tileData() == dm1.getTile(10, 10, false)->tileData());
+
+    // the non-uniform tile is left untouched
+    QVERIFY(dm1.getTile(2, 0, false)->tileData() != td1);
+    QVERIFY(dm1.getTile(2, 0, false)->tileData() != dm2.getTile(2, 0, false)->tileData());
+
+    // writing to the shared tile must not affect other devices
+    KisMementoSP memento = dm1.getMemento();
+
+    const quint8 otherPixel[pixelSize] = {1, 2, 3, 4};
+    dm1.setPixel(5, 5, otherPixel);
+    dm1.commit();
+
+    quint8 pixel[pixelSize];
+    dm2.readBytes(pixel, 5, 5, 1, 1);
+    QVERIFY(!memcmp(pixel, flatPixel, pixelSize));
+
+    dm1.readBytes(pixel, 5, 5, 1, 1);
+    QVERIFY(!memcmp(pixel, otherPixel, pixelSize));
+
+    dm1.readBytes(pixel, 6, 5, 1, 1);
+    QVERIFY(!memcmp(pixel, flatPixel, pixelSize));
+
+    // undo still restores the shared data correctly
+    dm1.rollback(memento);
+    dm1.readBytes(pixel, 5, 5, 1, 1);
+    QVERIFY(!memcmp(pixel, flatPixel, pixelSize));
+}
+
+void KisTiledDataManagerTest::testTileWriteLocks()
+{
+    const qint32 pixelSize = 1;
+    quint8 defaultPixel = 0;
+    KisTiledDataManager dm(pixelSize, &defaultPixel);
+
+    KisTileSP tile = dm.getTile(0, 0, true);
+
+    tile->lockForWrite();
+    tile->unlockForWrite();
+
+    const quint64 version = tile->tileData()->contentsVersion();
+    QVERIFY(version != 0);
+
+    // the data is unstable until the last writer leaves
+    tile->lockForWrite();
+    tile->lockForWrite();
+    QCOMPARE(tile->tileData()->contentsVersion(), quint64(0));
+
+    tile->unlockForWrite();
+    QCOMPARE(tile->tileData()->contentsVersion(), quint64(0));
+
+    tile->unlockForWrite();
+    const quint64 newVersion = tile->tileData()->contentsVersion();
+    QVERIFY(newVersion != 0);
+    QVERIFY(newVersion != version);
+
+    // the write released by a plain unlock() finishes with the last lock
+    tile->lockForRead();
+    tile->lockForWrite();
+    tile->unlock();
+    QCOMPARE(tile->tileData()->contentsVersion(), quint64(0));
+
+    tile->unlock();
+    QVERIFY(tile->tileData()->contentsVersion() != 0);
+    QVERIFY(tile->tileData()->contentsVersion() != newVersion);
+
+    // different datas never share a version
+    KisTileSP otherTile = dm.getTile(1, 0, true);
+    otherTile->lockForWrite();
+    otherTile->unlockForWrite();
+
+    QVERIFY(otherTile->tileData() != tile->tileData());
+    QVERIFY(otherTile->tileData()->contentsVersion() != tile->tileData()->contentsVersion());
+}
+
 QTEST_MAIN(KisTiledDataManagerTest)
 
@@ -52,6 +52,14 @@ private Q_SLOTS:
     void testTransactions();
     void testPurgeHistory();
     void testUndoSetDefaultPixel();
+    void testHashTableGrowth();
+    void testParallelTilesWriting();
+    void testTileCompressionCodecs();
+    void testSwapPrefetch();
+    void testSwapPriorities();
+    void testCompressedTier();
+    void testUniformTilesSharing();
+    void testTileWriteLocks();
 
     void benchmarkReadOnlyTileLazy();
     void benchmarkSharedPointers();
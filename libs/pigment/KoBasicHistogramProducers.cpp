@@ -80,6 +80,32 @@ void KoBasicHistogramProducer::clear()
     }
 }
 
+bool KoBasicHistogramProducer::addBinsFrom(KoHistogramProducer *other)
+{
+    KoBasicHistogramProducer *basic = dynamic_cast<KoBasicHistogramProducer*>(other);
+
+    if (!basic ||
+        basic->m_id != m_id ||
+        basic->m_channels != m_channels ||
+        basic->m_nrOfBins != m_nrOfBins ||
+        basic->m_from != m_from ||
+        basic->m_width != m_width) {
+
+        return false;
+    }
+
+    m_count += basic->m_count;
+    for (int i = 0; i < m_channels; i++) {
+        for (int j = 0; j < m_nrOfBins; j++) {
+            m_bins[i][j] += basic->m_bins[i][j];
+        }
+        m_outRight[i] += basic->m_outRight[i];
+        m_outLeft[i] += basic->m_outLeft[i];
+    }
+
+    return true;
+}
+
 void KoBasicHistogramProducer::makeExternalToInternal()
 {
     // This function assumes that the pixel is has no 'gaps'. That is to say: if we start
@@ -39,6 +39,8 @@ public:
 
     void clear() override;
 
+    bool addBinsFrom(KoHistogramProducer *other) override;
+
     void setView(qreal from, qreal size) override {
         m_from = from; m_width = size;
     }
@@ -70,6 +70,19 @@ public:
      */
     virtual void addRegionToBin(const quint8 * pixels, const quint8 * selectionMask, quint32 nPixels, const KoColorSpace* colorSpace) = 0;
 
+    /**
+     * Adds the bins of \p other to the bins of this producer. Used for
+     * merging the partial histograms computed for parts of a device.
+     *
+     * @param other a producer of the same kind, with the same view
+     * @return false if the producers cannot be merged; the bins are
+     *         left unchanged in such a case
+     */
+    virtual bool addBinsFrom(KoHistogramProducer *other) {
+        Q_UNUSED(other);
+        return false;
+    }
+
     // Methods to set what exactly is being added to the bins
     virtual void setView(qreal from, qreal width) = 0;
     virtual void setSkipTransparent(bool set) {
@@ -0,0 +1,136 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation; either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KoColorConversionsMTBenchmark.h"
+
+#include <QTest>
+#include <QThread>
+#include <QColor>
+#include <QtConcurrent>
+#include <KoColorSpaceRegistry.h>
+#include <KoColorSpace.h>
+#include <KoColorProfile.h>
+
+#define NB_CONVERSIONS 200000
+
+void KoColorConversionsMTBenchmark::createRowsColumns()
+{
+    QTest::addColumn<QString>("depthID");
+    QTest::addColumn<bool>("useCustomProfile");
+    QTest::addColumn<int>("numThreads");
+
+    QList<int> threadCounts;
+    threadCounts << 1;
+    if (QThread::idealThreadCount() > 1) {
+        threadCounts << QThread::idealThreadCount();
+    }
+
+    QStringList depths;
+    depths << Integer8BitsColorDepthID.id() << Integer16BitsColorDepthID.id();
+
+    Q_FOREACH (const QString &depth, depths) {
+        for (int i = 0; i < 2; i++) {
+            const bool useCustomProfile = i;
+
+            Q_FOREACH (int numThreads, threadCounts) {
+                QString name = QString("%1, %2, %3 threads")
+                    .arg(depth)
+                    .arg(useCustomProfile ? "custom profile" : "default profile")
+                    .arg(numThreads);
+
+                QTest::newRow(name.toLatin1().data()) << depth << useCustomProfile << numThreads;
+            }
+        }
+    }
+}
+
+#define START_BENCHMARK \
+    QFETCH(QString, depthID); \
+    QFETCH(bool, useCustomProfile); \
+    QFETCH(int, numThreads); \
+    \
+    const KoColorSpace* colorSpace = KoColorSpaceRegistry::instance()->colorSpace(RGBAColorModelID.id(), depthID, 0); \
+    QVERIFY(colorSpace); \
+    /* any explicit profile goes through the cached transforms path */ \
+    const KoColorProfile *profile = useCustomProfile ? colorSpace->profile() : 0; \
+    const int pixelSize = colorSpace->pixelSize(); \
+    \
+    const int conversionsPerThread = NB_CONVERSIONS / numThreads; \
+    QThreadPool pool; \
+    pool.setMaxThreadCount(numThreads);
+
+#define RUN_THREADS(func) \
+    { \
+        QList<QFuture<void>> futures; \
+        for (int i = 0; i < numThreads; i++) { \
+            futures << QtConcurrent::run(&pool, func, conversionsPerThread); \
+        } \
+        Q_FOREACH (QFuture<void> future, futures) { \
+            future.waitForFinished(); \
+        } \
+    }
+
+void KoColorConversionsMTBenchmark::benchmarkFromQColor_data()
+{
+    createRowsColumns();
+}
+
+void KoColorConversionsMTBenchmark::benchmarkFromQColor()
+{
+    START_BENCHMARK
+
+    auto convert = [colorSpace, profile, pixelSize] (int numConversions) {
+        QVector<quint8> pixel(pixelSize);
+
+        for (int i = 0; i < numConversions; i++) {
+            QColor color(i & 0xff, (i >> 8) & 0xff, (i >> 16) & 0xff);
+            colorSpace->fromQColor(color, pixel.data(), profile);
+        }
+    };
+
+    QBENCHMARK {
+        RUN_THREADS(convert);
+    }
+}
+
+void KoColorConversionsMTBenchmark::benchmarkToQColor_data()
+{
+    createRowsColumns();
+}
+
+void KoColorConversionsMTBenchmark::benchmarkToQColor()
+{
+    START_BENCHMARK
+
+    QVector<quint8> source(pixelSize);
+    colorSpace->fromQColor(QColor(10, 128, 200), source.data());
+
+    auto convert = [colorSpace, profile, source] (int numConversions) {
+        QColor color;
+
+        for (int i = 0; i < numConversions; i++) {
+            colorSpace->toQColor(source.constData(), &color, profile);
+        }
+    };
+
+    QBENCHMARK {
+        RUN_THREADS(convert);
+    }
+}
+
+QTEST_MAIN(KoColorConversionsMTBenchmark)
@@ -0,0 +1,42 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This library is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU Lesser General Public License as published by
+ *  the Free Software Foundation; either version 2.1 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef _KO_COLOR_CONVERSIONS_MT_BENCHMARK_H_
+#define _KO_COLOR_CONVERSIONS_MT_BENCHMARK_H_
+
+#include <QObject>
+
+/**
+ * Measures the throughput of single-color conversions
+ * (fromQColor()/toQColor()) when several threads use the
+ * same color space at once. Compare the results for one thread
+ * and for all the cores to see how much the threads contend.
+ */
+class KoColorConversionsMTBenchmark : public QObject
+{
+    Q_OBJECT
+private:
+    void createRowsColumns();
+private Q_SLOTS:
+    void benchmarkFromQColor_data();
+    void benchmarkFromQColor();
+    void benchmarkToQColor_data();
+    void benchmarkToQColor();
+};
+
+#endif
@@ -20,6 +20,8 @@
 #include "KoOptimizedCompositeOpFactoryPerArch.h" // vc.h must come first
 #include "KoOptimizedCompositeOpFactory.h"
 
+#include "KoColorSpaceTraits.h"
+
 #if defined(__clang__)
 #pragma GCC diagnostic ignored "-Wundef"
 #endif
@@ -44,3 +46,18 @@ KoCompositeOp* KoOptimizedCompositeOpFactory::createOverOp128(const KoColorSpace
 {
     return createOptimizedClass<KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver128> >(cs);
 }
+
+KoCompositeOp* KoOptimizedCompositeOpFactory::createSeparableOp32(const KoColorSpace *cs, const QString &id, const QString &description, const QString &category)
+{
+    return createOptimizedClass<KoOptimizedSeparableOpFactoryPerArch<KoBgrU8Traits> >(KoOptimizedSeparableOpInfo(cs, id, description, category));
+}
+
+KoCompositeOp* KoOptimizedCompositeOpFactory::createSeparableOp64(const KoColorSpace *cs, const QString &id, const QString &description, const QString &category)
+{
+    return createOptimizedClass<KoOptimizedSeparableOpFactoryPerArch<KoBgrU16Traits> >(KoOptimizedSeparableOpInfo(cs, id, description, category));
+}
+
+KoCompositeOp* KoOptimizedCompositeOpFactory::createSeparableOp128(const KoColorSpace *cs, const QString &id, const QString &description, const QString &category)
+{
+    return createOptimizedClass<KoOptimizedSeparableOpFactoryPerArch<KoRgbF32Traits> >(KoOptimizedSeparableOpInfo(cs, id, description, category));
+}
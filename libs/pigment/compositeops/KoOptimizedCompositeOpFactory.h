@@ -22,6 +22,7 @@
 
 #include "kritapigment_export.h"
 
+class QString;
 class KoCompositeOp;
 class KoColorSpace;
 
@@ -44,6 +45,19 @@ public:
     static KoCompositeOp* createOverOp32(const KoColorSpace *cs);
     static KoCompositeOp* createAlphaDarkenOp128(const KoColorSpace *cs);
     static KoCompositeOp* createOverOp128(const KoColorSpace *cs);
+
+    /**
+     * Create a vectorized version of a separable blending op (Multiply,
+     * Screen, Overlay, Addition, Color Dodge, Color Burn, Darken and
+     * Lighten) for 8-bit, 16-bit and 32-bit float RGBA colorspaces.
+     *
+     * \return null if there is no optimized version for the op \p id
+     *         or the CPU doesn't support vector instructions. The caller
+     *         should create a generic op in such a case.
+     */
+    static KoCompositeOp* createSeparableOp32(const KoColorSpace *cs, const QString &id, const QString &description, const QString &category);
+    static KoCompositeOp* createSeparableOp64(const KoColorSpace *cs, const QString &id, const QString &description, const QString &category);
+    static KoCompositeOp* createSeparableOp128(const KoColorSpace *cs, const QString &id, const QString &description, const QString &category);
 };
 
 #endif /* KOOPTIMIZEDCOMPOSITEOPFACTORY_H */
@@ -26,11 +26,14 @@
 #include "KoOptimizedCompositeOpAlphaDarken128.h"
 #include "KoOptimizedCompositeOpOver32.h"
 #include "KoOptimizedCompositeOpOver128.h"
+#include "KoOptimizedCompositeOpGenericSC.h"
 
 #include <QString>
 #include "DebugPigment.h"
 
 #include <KoCompositeOpRegistry.h>
+#include <KoColorSpaceTraits.h>
+#include <KoCompositeOpFunctions.h>
 
 #if defined(__clang__)
 #pragma GCC diagnostic ignored "-Wlocal-type-template-args"
@@ -67,3 +70,68 @@ KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver128>::create<Vc::
 {
     return new KoOptimizedCompositeOpOver128<Vc::CurrentImplementation::current()>(param);
 }
+
+namespace {
+
+template<Vc::Implementation _impl, class Traits,
+         typename Traits::channels_type compositeFunc(typename Traits::channels_type, typename Traits::channels_type),
+         class BlendFunc>
+KoCompositeOp* createSeparableOp(const KoOptimizedSeparableOpInfo &info)
+{
+    return new KoOptimizedCompositeOpGenericSC<_impl, Traits, compositeFunc, BlendFunc>(info.cs, info.id, info.description, info.category);
+}
+
+template<Vc::Implementation _impl, class Traits>
+KoCompositeOp* createSeparableOpForTraits(const KoOptimizedSeparableOpInfo &info)
+{
+    typedef typename Traits::channels_type Arg;
+    using namespace KoVcBlendFunctions;
+
+    KoCompositeOp *op = 0;
+
+    if (info.id == COMPOSITE_MULT) {
+        op = createSeparableOp<_impl, Traits, &cfMultiply<Arg>, Multiply>(info);
+    } else if (info.id == COMPOSITE_SCREEN) {
+        op = createSeparableOp<_impl, Traits, &cfScreen<Arg>, Screen>(info);
+    } else if (info.id == COMPOSITE_OVERLAY) {
+        op = createSeparableOp<_impl, Traits, &cfOverlay<Arg>, Overlay>(info);
+    } else if (info.id == COMPOSITE_ADD || info.id == COMPOSITE_LINEAR_DODGE) {
+        op = createSeparableOp<_impl, Traits, &cfAddition<Arg>, Addition>(info);
+    } else if (info.id == COMPOSITE_DODGE) {
+        op = createSeparableOp<_impl, Traits, &cfColorDodge<Arg>, ColorDodge>(info);
+    } else if (info.id == COMPOSITE_BURN) {
+        op = createSeparableOp<_impl, Traits, &cfColorBurn<Arg>, ColorBurn>(info);
+    } else if (info.id == COMPOSITE_DARKEN) {
+        op = createSeparableOp<_impl, Traits, &cfDarkenOnly<Arg>, Darken>(info);
+    } else if (info.id == COMPOSITE_LIGHTEN) {
+        op = createSeparableOp<_impl, Traits, &cfLightenOnly<Arg>, Lighten>(info);
+    }
+
+    return op;
+}
+
+}
+
+template<>
+template<>
+KoOptimizedSeparableOpFactoryPerArch<KoBgrU8Traits>::ReturnType
+KoOptimizedSeparableOpFactoryPerArch<KoBgrU8Traits>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return createSeparableOpForTraits<Vc::CurrentImplementation::current(), KoBgrU8Traits>(param);
+}
+
+template<>
+template<>
+KoOptimizedSeparableOpFactoryPerArch<KoBgrU16Traits>::ReturnType
+KoOptimizedSeparableOpFactoryPerArch<KoBgrU16Traits>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return createSeparableOpForTraits<Vc::CurrentImplementation::current(), KoBgrU16Traits>(param);
+}
+
+template<>
+template<>
+KoOptimizedSeparableOpFactoryPerArch<KoRgbF32Traits>::ReturnType
+KoOptimizedSeparableOpFactoryPerArch<KoRgbF32Traits>::create<Vc::CurrentImplementation::current()>(ParamType param)
+{
+    return createSeparableOpForTraits<Vc::CurrentImplementation::current(), KoRgbF32Traits>(param);
+}
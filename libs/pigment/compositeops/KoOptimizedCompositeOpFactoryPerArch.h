@@ -23,6 +23,7 @@
 
 #include <compositeops/KoVcMultiArchBuildSupport.h>
 
+#include <QString>
 
 class KoCompositeOp;
 class KoColorSpace;
@@ -50,5 +51,33 @@ struct KoOptimizedCompositeOpFactoryPerArch
     static ReturnType create(ParamType param);
 };
 
+/**
+ * Parameters of a separable (KoCompositeOpGenericSC-like) composite op.
+ * The op is selected by its \p id, returns null if there is no
+ * optimized version of the op for the given colorspace traits.
+ */
+struct KoOptimizedSeparableOpInfo
+{
+    KoOptimizedSeparableOpInfo(const KoColorSpace *_cs, const QString &_id,
+                               const QString &_description, const QString &_category)
+        : cs(_cs), id(_id), description(_description), category(_category)
+    {
+    }
+
+    const KoColorSpace *cs;
+    QString id;
+    QString description;
+    QString category;
+};
+
+template<class Traits>
+struct KoOptimizedSeparableOpFactoryPerArch
+{
+    typedef const KoOptimizedSeparableOpInfo& ParamType;
+    typedef KoCompositeOp* ReturnType;
+
+    template<Vc::Implementation _impl>
+    static ReturnType create(ParamType param);
+};
 
 #endif /* KOOPTIMIZEDCOMPOSITEOPFACTORYPERARCH_H */
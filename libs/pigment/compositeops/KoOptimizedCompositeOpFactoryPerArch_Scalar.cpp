@@ -55,3 +55,34 @@ KoOptimizedCompositeOpFactoryPerArch<KoOptimizedCompositeOpOver128>::create<Vc::
 {
     return new KoCompositeOpOver<KoRgbF32Traits>(param);
 }
+
+/**
+ * The scalar version of separable ops is exactly KoCompositeOpGenericSC,
+ * so we return null to let the caller create the generic op itself.
+ */
+template<>
+template<>
+KoOptimizedSeparableOpFactoryPerArch<KoBgrU8Traits>::ReturnType
+KoOptimizedSeparableOpFactoryPerArch<KoBgrU8Traits>::create<Vc::ScalarImpl>(ParamType param)
+{
+    Q_UNUSED(param);
+    return 0;
+}
+
+template<>
+template<>
+KoOptimizedSeparableOpFactoryPerArch<KoBgrU16Traits>::ReturnType
+KoOptimizedSeparableOpFactoryPerArch<KoBgrU16Traits>::create<Vc::ScalarImpl>(ParamType param)
+{
+    Q_UNUSED(param);
+    return 0;
+}
+
+template<>
+template<>
+KoOptimizedSeparableOpFactoryPerArch<KoRgbF32Traits>::ReturnType
+KoOptimizedSeparableOpFactoryPerArch<KoRgbF32Traits>::create<Vc::ScalarImpl>(ParamType param)
+{
+    Q_UNUSED(param);
+    return 0;
+}
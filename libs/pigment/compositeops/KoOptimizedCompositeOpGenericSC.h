@@ -0,0 +1,379 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public License
+ * along with this library; see the file COPYING.LIB.  If not, write to
+ * the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KOOPTIMIZEDCOMPOSITEOPGENERICSC_H
+#define KOOPTIMIZEDCOMPOSITEOPGENERICSC_H
+
+#include <limits>
+
+#include "KoCompositeOpBase.h"
+#include "KoCompositeOpGeneric.h"
+#include "KoCompositeOpRegistry.h"
+#include "KoStreamedMath.h"
+
+/**
+ * Vectorized counterparts of the separable blending functions from
+ * KoCompositeOpFunctions.h. All the functions operate on normalized
+ * values (0.0...1.0 for integer colorspaces) and accept both plain
+ * floats and Vc::float_v, so the scalar and the vector paths of the
+ * compositor share exactly the same math.
+ *
+ * \p clampToUnit is true for integer colorspaces, where the result
+ * of the function must be limited to the unit range the same way
+ * Arithmetic::clamp() does it in the generic version.
+ */
+namespace KoVcBlendFunctions {
+
+ALWAYS_INLINE float vmin(float a, float b) { return qMin(a, b); }
+ALWAYS_INLINE float vmax(float a, float b) { return qMax(a, b); }
+ALWAYS_INLINE float iif(bool cond, float a, float b) { return cond ? a : b; }
+
+ALWAYS_INLINE Vc::float_v vmin(Vc::float_v::AsArg a, Vc::float_v::AsArg b) { return Vc::min(a, b); }
+ALWAYS_INLINE Vc::float_v vmax(Vc::float_v::AsArg a, Vc::float_v::AsArg b) { return Vc::max(a, b); }
+ALWAYS_INLINE Vc::float_v iif(const Vc::float_m &cond, Vc::float_v::AsArg a, Vc::float_v::AsArg b) { return Vc::iif(cond, a, b); }
+
+template<bool clampToUnit, typename V>
+ALWAYS_INLINE V clampUnit(V value) {
+    return clampToUnit ? vmin(vmax(value, V(0.0f)), V(1.0f)) : value;
+}
+
+struct Multiply {
+    template<bool clampToUnit, typename V>
+    static ALWAYS_INLINE V apply(V src, V dst) {
+        return src * dst;
+    }
+};
+
+struct Screen {
+    template<bool clampToUnit, typename V>
+    static ALWAYS_INLINE V apply(V src, V dst) {
+        return src + dst - src * dst;
+    }
+};
+
+struct Addition {
+    template<bool clampToUnit, typename V>
+    static ALWAYS_INLINE V apply(V src, V dst) {
+        return clampUnit<clampToUnit>(src + dst);
+    }
+};
+
+struct Darken {
+    template<bool clampToUnit, typename V>
+    static ALWAYS_INLINE V apply(V src, V dst) {
+        return vmin(src, dst);
+    }
+};
+
+struct Lighten {
+    template<bool clampToUnit, typename V>
+    static ALWAYS_INLINE V apply(V src, V dst) {
+        return vmax(src, dst);
+    }
+};
+
+/**
+ * Overlay is a hard light with swapped arguments, see cfOverlay()
+ */
+struct Overlay {
+    template<bool clampToUnit, typename V>
+    static ALWAYS_INLINE V apply(V src, V dst) {
+        const V one(1.0f);
+        const V dst2 = dst + dst;
+        const V dst2m1 = dst2 - one;
+
+        return iif(dst > V(0.5f),
+                   dst2m1 + src - dst2m1 * src,
+                   dst2 * src);
+    }
+};
+
+struct ColorDodge {
+    template<bool clampToUnit, typename V>
+    static ALWAYS_INLINE V apply(V src, V dst) {
+        const V zero(0.0f);
+        const V one(1.0f);
+        const V invSrc = one - src;
+
+        // division by zero may happen only in the lanes
+        // that are dropped by the conditions below
+        return iif(dst == zero, zero,
+                   iif(invSrc < dst, one,
+                       clampUnit<clampToUnit>(dst / invSrc)));
+    }
+};
+
+struct ColorBurn {
+    template<bool clampToUnit, typename V>
+    static ALWAYS_INLINE V apply(V src, V dst) {
+        const V zero(0.0f);
+        const V one(1.0f);
+        const V invDst = one - dst;
+
+        return iif(dst == one, one,
+                   iif(src < invDst, zero,
+                       one - clampUnit<clampToUnit>(invDst / src)));
+    }
+};
+
+}
+
+/**
+ * Reads and writes pixels of 4-channel colorspaces with alpha
+ * placed in the last channel, converting them into normalized
+ * floats. Each channel type has its own memory layout trick.
+ */
+template<typename channels_type>
+struct KoSeparableOpPixelIO;
+
+template<>
+struct KoSeparableOpPixelIO<quint8>
+{
+    template<bool aligned, Vc::Implementation _impl>
+    static ALWAYS_INLINE void read(const quint8 *data, Vc::float_v &c1, Vc::float_v &c2, Vc::float_v &c3, Vc::float_v &alpha) {
+        const Vc::float_v uint8MaxRec1(1.0f / 255.0f);
+
+        KoStreamedMath<_impl>::template fetch_colors_32<aligned>(data, c1, c2, c3);
+        alpha = KoStreamedMath<_impl>::template fetch_alpha_32<aligned>(data) * uint8MaxRec1;
+        c1 *= uint8MaxRec1;
+        c2 *= uint8MaxRec1;
+        c3 *= uint8MaxRec1;
+    }
+
+    template<Vc::Implementation _impl>
+    static ALWAYS_INLINE void write(quint8 *data, Vc::float_v::AsArg c1, Vc::float_v::AsArg c2, Vc::float_v::AsArg c3, Vc::float_v::AsArg alpha) {
+        const Vc::float_v uint8Max(255.0f);
+        KoStreamedMath<_impl>::write_channels_32(data, alpha * uint8Max, c1 * uint8Max, c2 * uint8Max, c3 * uint8Max);
+    }
+};
+
+template<>
+struct KoSeparableOpPixelIO<quint16>
+{
+    template<bool aligned, Vc::Implementation _impl>
+    static ALWAYS_INLINE void read(const quint8 *data, Vc::float_v &c1, Vc::float_v &c2, Vc::float_v &c3, Vc::float_v &alpha) {
+        const Vc::float_v uint16MaxRec1(1.0f / 65535.0f);
+        const Vc::float_v::IndexType indexes = Vc::float_v::IndexType::IndexesFromZero() * 4;
+        const quint16 *ptr = reinterpret_cast<const quint16*>(data);
+
+        c1 = Vc::float_v(ptr + 0, indexes) * uint16MaxRec1;
+        c2 = Vc::float_v(ptr + 1, indexes) * uint16MaxRec1;
+        c3 = Vc::float_v(ptr + 2, indexes) * uint16MaxRec1;
+        alpha = Vc::float_v(ptr + 3, indexes) * uint16MaxRec1;
+    }
+
+    template<Vc::Implementation _impl>
+    static ALWAYS_INLINE void write(quint8 *data, Vc::float_v::AsArg c1, Vc::float_v::AsArg c2, Vc::float_v::AsArg c3, Vc::float_v::AsArg alpha) {
+        const Vc::float_v uint16Max(65535.0f);
+        const Vc::float_v::IndexType indexes = Vc::float_v::IndexType::IndexesFromZero() * 4;
+        quint16 *ptr = reinterpret_cast<quint16*>(data);
+
+        Vc::round(c1 * uint16Max).scatter(ptr + 0, indexes);
+        Vc::round(c2 * uint16Max).scatter(ptr + 1, indexes);
+        Vc::round(c3 * uint16Max).scatter(ptr + 2, indexes);
+        Vc::round(alpha * uint16Max).scatter(ptr + 3, indexes);
+    }
+};
+
+template<>
+struct KoSeparableOpPixelIO<float>
+{
+    struct Pixel {
+        float c1;
+        float c2;
+        float c3;
+        float alpha;
+    };
+
+    template<bool aligned, Vc::Implementation _impl>
+    static ALWAYS_INLINE void read(const quint8 *data, Vc::float_v &c1, Vc::float_v &c2, Vc::float_v &c3, Vc::float_v &alpha) {
+        const Vc::float_v::IndexType indexes(Vc::IndexesFromZero);
+        Vc::InterleavedMemoryWrapper<Pixel, Vc::float_v> wrapper(reinterpret_cast<Pixel*>(const_cast<quint8*>(data)));
+        tie(c1, c2, c3, alpha) = wrapper[indexes];
+    }
+
+    template<Vc::Implementation _impl>
+    static ALWAYS_INLINE void write(quint8 *data, Vc::float_v::AsArg c1, Vc::float_v::AsArg c2, Vc::float_v::AsArg c3, Vc::float_v::AsArg alpha) {
+        const Vc::float_v::IndexType indexes(Vc::IndexesFromZero);
+        Vc::InterleavedMemoryWrapper<Pixel, Vc::float_v> wrapper(reinterpret_cast<Pixel*>(data));
+        wrapper[indexes] = tie(c1, c2, c3, alpha);
+    }
+};
+
+/**
+ * A compositor for KoStreamedMath::genericComposite() implementing
+ * the same formula as KoCompositeOpGenericSC for the case when all
+ * the channel flags are set and alpha is not locked:
+ *
+ * newAlpha = srcAlpha + dstAlpha - srcAlpha * dstAlpha
+ * dst = (dst * dstAlpha * (1 - srcAlpha) +
+ *        src * srcAlpha * (1 - dstAlpha) +
+ *        blend(src, dst) * srcAlpha * dstAlpha) / newAlpha
+ */
+template<typename channels_type, class BlendFunc>
+struct SeparableCompositor
+{
+    struct OptionalParams {
+        OptionalParams(const KoCompositeOp::ParameterInfo& params) {
+            Q_UNUSED(params);
+        }
+    };
+
+    static const bool clampToUnit = std::numeric_limits<channels_type>::is_integer;
+    static const qint32 alpha_pos = 3;
+
+    typedef KoSeparableOpPixelIO<channels_type> PixelIO;
+
+    template<typename V>
+    static ALWAYS_INLINE V blendChannel(V src, V srcAlpha, V dst, V dstAlpha, V alphaRec) {
+        const V one(1.0f);
+        const V result =
+            dst * dstAlpha * (one - srcAlpha) +
+            src * srcAlpha * (one - dstAlpha) +
+            BlendFunc::template apply<clampToUnit>(src, dst) * srcAlpha * dstAlpha;
+
+        return KoVcBlendFunctions::clampUnit<clampToUnit>(result * alphaRec);
+    }
+
+    template<bool haveMask, bool src_aligned, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeVector(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const OptionalParams &oparams)
+    {
+        Q_UNUSED(oparams);
+
+        Vc::float_v src_c1;
+        Vc::float_v src_c2;
+        Vc::float_v src_c3;
+        Vc::float_v src_alpha;
+
+        PixelIO::template read<src_aligned, _impl>(src, src_c1, src_c2, src_c3, src_alpha);
+
+        src_alpha *= Vc::float_v(opacity);
+
+        if (haveMask) {
+            const Vc::float_v uint8MaxRec1(1.0f / 255.0f);
+            src_alpha *= KoStreamedMath<_impl>::fetch_mask_8(mask) * uint8MaxRec1;
+        }
+
+        const Vc::float_v zeroValue(Vc::Zero);
+
+        // fully transparent source doesn't change the destination
+        if ((src_alpha == zeroValue).isFull()) {
+            return;
+        }
+
+        Vc::float_v dst_c1;
+        Vc::float_v dst_c2;
+        Vc::float_v dst_c3;
+        Vc::float_v dst_alpha;
+
+        PixelIO::template read<true, _impl>(dst, dst_c1, dst_c2, dst_c3, dst_alpha);
+
+        const Vc::float_v new_alpha = src_alpha + dst_alpha - src_alpha * dst_alpha;
+        const Vc::float_m nonZeroAlpha = new_alpha != zeroValue;
+
+        // the color of the fully transparent pixels is left untouched,
+        // the same way KoCompositeOpGenericSC does
+        if (!nonZeroAlpha.isEmpty()) {
+            const Vc::float_v alphaRec = Vc::float_v(Vc::One) / new_alpha;
+
+            dst_c1(nonZeroAlpha) = blendChannel(src_c1, src_alpha, dst_c1, dst_alpha, alphaRec);
+            dst_c2(nonZeroAlpha) = blendChannel(src_c2, src_alpha, dst_c2, dst_alpha, alphaRec);
+            dst_c3(nonZeroAlpha) = blendChannel(src_c3, src_alpha, dst_c3, dst_alpha, alphaRec);
+        }
+
+        PixelIO::template write<_impl>(dst, dst_c1, dst_c2, dst_c3,
+                                       KoVcBlendFunctions::clampUnit<clampToUnit>(new_alpha));
+    }
+
+    template <bool haveMask, Vc::Implementation _impl>
+    static ALWAYS_INLINE void compositeOnePixelScalar(const quint8 *src, quint8 *dst, const quint8 *mask, float opacity, const OptionalParams &oparams)
+    {
+        Q_UNUSED(oparams);
+        using namespace Arithmetic;
+
+        const channels_type *s = reinterpret_cast<const channels_type*>(src);
+        channels_type *d = reinterpret_cast<channels_type*>(dst);
+
+        float srcAlpha = scale<float>(s[alpha_pos]) * opacity;
+
+        if (haveMask) {
+            srcAlpha *= scale<float>(*mask);
+        }
+
+        if (srcAlpha == 0.0f) {
+            return;
+        }
+
+        const float dstAlpha = scale<float>(d[alpha_pos]);
+        const float newAlpha = srcAlpha + dstAlpha - srcAlpha * dstAlpha;
+
+        if (newAlpha != 0.0f) {
+            const float alphaRec = 1.0f / newAlpha;
+
+            for (qint32 i = 0; i < alpha_pos; i++) {
+                d[i] = scale<channels_type>(
+                    blendChannel(scale<float>(s[i]), srcAlpha,
+                                 scale<float>(d[i]), dstAlpha, alphaRec));
+            }
+        }
+
+        d[alpha_pos] = scale<channels_type>(KoVcBlendFunctions::clampUnit<clampToUnit>(newAlpha));
+    }
+};
+
+/**
+ * An optimized version of KoCompositeOpGenericSC for 4-channel
+ * colorspaces with alpha placed in the last channel (8-bit, 16-bit
+ * integer and 32-bit float). \p BlendFunc must implement the same
+ * math as \p compositeFunc. When alpha is locked or some of the
+ * channel flags are disabled the op falls back to the generic
+ * implementation.
+ */
+template<Vc::Implementation _impl, class Traits,
+         typename Traits::channels_type compositeFunc(typename Traits::channels_type, typename Traits::channels_type),
+         class BlendFunc>
+class KoOptimizedCompositeOpGenericSC : public KoCompositeOpGenericSC<Traits, compositeFunc>
+{
+    typedef KoCompositeOpGenericSC<Traits, compositeFunc> base_class;
+    typedef typename Traits::channels_type channels_type;
+    typedef SeparableCompositor<channels_type, BlendFunc> Compositor;
+
+public:
+    KoOptimizedCompositeOpGenericSC(const KoColorSpace* cs, const QString& id, const QString& description, const QString& category)
+        : base_class(cs, id, description, category) {}
+
+    using base_class::composite;
+
+    void composite(const KoCompositeOp::ParameterInfo& params) const override
+    {
+        const QBitArray &flags = params.channelFlags;
+
+        if (flags.isEmpty() || flags == QBitArray(Traits::channels_nb, true)) {
+            if (params.maskRowStart) {
+                KoStreamedMath<_impl>::template genericComposite<true, false, Compositor, Traits::pixelSize>(params);
+            } else {
+                KoStreamedMath<_impl>::template genericComposite<false, false, Compositor, Traits::pixelSize>(params);
+            }
+        } else {
+            base_class::composite(params);
+        }
+    }
+};
+
+#endif // KOOPTIMIZEDCOMPOSITEOPGENERICSC_H
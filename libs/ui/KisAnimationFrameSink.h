@@ -0,0 +1,47 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KISANIMATIONFRAMESINK_H
+#define KISANIMATIONFRAMESINK_H
+
+class QImage;
+
+/**
+ * KisAnimationFrameSink is an interface for the consumers of the
+ * frames rendered by KisAsyncAnimationFramesStreamDialog, e.g. an
+ * encoder reading raw frames from a pipe.
+ *
+ * The frames are passed in the order of the rendered range. The sink
+ * is called from the GUI thread only.
+ */
+class KisAnimationFrameSink
+{
+public:
+    virtual ~KisAnimationFrameSink() {}
+
+    /**
+     * Consumes \p image of the frame \p frame. The image has
+     * QImage::Format_RGBA8888 format and sRGB colors.
+     *
+     * @return false if the frame could not be consumed; the rendering
+     *         is cancelled in such a case
+     */
+    virtual bool writeFrame(int frame, const QImage &image) = 0;
+};
+
+#endif // KISANIMATIONFRAMESINK_H
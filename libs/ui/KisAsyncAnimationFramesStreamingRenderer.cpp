@@ -0,0 +1,95 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisAsyncAnimationFramesStreamingRenderer.h"
+
+#include <QImage>
+
+#include "kis_image.h"
+#include "kis_paint_device.h"
+#include "KisAnimationFrameSink.h"
+#include "kis_assert.h"
+
+
+struct KisAsyncAnimationFramesStreamingRenderer::Private
+{
+    Private(KisAnimationFrameSink *_sink)
+        : sink(_sink)
+    {
+    }
+
+    KisAnimationFrameSink *sink;
+    QImage frameImage;
+};
+
+KisAsyncAnimationFramesStreamingRenderer::KisAsyncAnimationFramesStreamingRenderer(KisAnimationFrameSink *sink)
+    : m_d(new Private(sink))
+{
+    connect(this, SIGNAL(sigCompleteRegenerationInternal(int)), SLOT(slotCompleteRegenerationInternal(int)));
+}
+
+KisAsyncAnimationFramesStreamingRenderer::~KisAsyncAnimationFramesStreamingRenderer()
+{
+}
+
+void KisAsyncAnimationFramesStreamingRenderer::frameCompletedCallback(int frame)
+{
+    KisImageSP image = requestedImage();
+    if (!image) return;
+
+    /**
+     * The conversion is done in the context of the image worker
+     * thread, so the GUI thread only pushes the ready bytes to the sink
+     */
+    m_d->frameImage =
+        image->projection()->convertToQImage(0, image->bounds())
+            .convertToFormat(QImage::Format_RGBA8888);
+
+    emit sigCompleteRegenerationInternal(frame);
+}
+
+void KisAsyncAnimationFramesStreamingRenderer::slotCompleteRegenerationInternal(int frame)
+{
+    if (!isActive()) return;
+
+    KIS_SAFE_ASSERT_RECOVER(!m_d->frameImage.isNull()) {
+        frameCancelledCallback(frame);
+        return;
+    }
+
+    const QImage frameImage = m_d->frameImage;
+    m_d->frameImage = QImage();
+
+    if (m_d->sink->writeFrame(frame, frameImage)) {
+        notifyFrameCompleted(frame);
+    } else {
+        notifyFrameCancelled(frame);
+    }
+}
+
+void KisAsyncAnimationFramesStreamingRenderer::frameCancelledCallback(int frame)
+{
+    notifyFrameCancelled(frame);
+}
+
+void KisAsyncAnimationFramesStreamingRenderer::clearFrameRegenerationState(bool isCancelled)
+{
+    m_d->frameImage = QImage();
+
+    KisAsyncAnimationRendererBase::clearFrameRegenerationState(isCancelled);
+}
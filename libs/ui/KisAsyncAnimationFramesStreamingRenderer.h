@@ -0,0 +1,53 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KISASYNCANIMATIONFRAMESSTREAMINGRENDERER_H
+#define KISASYNCANIMATIONFRAMESSTREAMINGRENDERER_H
+
+#include <KisAsyncAnimationRendererBase.h>
+
+class KisAnimationFrameSink;
+
+/**
+ * Converts every rendered frame into a raw RGBA image and passes it
+ * to a KisAnimationFrameSink, without writing any intermediate files
+ */
+class KisAsyncAnimationFramesStreamingRenderer : public KisAsyncAnimationRendererBase
+{
+    Q_OBJECT
+public:
+    KisAsyncAnimationFramesStreamingRenderer(KisAnimationFrameSink *sink);
+    ~KisAsyncAnimationFramesStreamingRenderer();
+
+protected:
+    void frameCompletedCallback(int frame) override;
+    void frameCancelledCallback(int frame) override;
+    void clearFrameRegenerationState(bool isCancelled) override;
+
+Q_SIGNALS:
+    void sigCompleteRegenerationInternal(int frame);
+
+private Q_SLOTS:
+    void slotCompleteRegenerationInternal(int frame);
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif // KISASYNCANIMATIONFRAMESSTREAMINGRENDERER_H
@@ -0,0 +1,327 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisAsyncAnimationMultiFrameRenderer.h"
+
+#include <QList>
+#include <QtMath>
+
+#include "KisViewManager.h"
+#include "KisAsyncAnimationRendererBase.h"
+#include "kis_image.h"
+#include "kis_image_config.h"
+#include "kis_memory_statistics_server.h"
+
+#include <algorithm>
+#include <vector>
+#include <memory>
+
+namespace {
+struct RendererPair {
+    std::unique_ptr<KisAsyncAnimationRendererBase> renderer;
+    KisImageSP image;
+
+    RendererPair() {}
+    RendererPair(KisAsyncAnimationRendererBase *_renderer, KisImageSP _image)
+        : renderer(_renderer),
+          image(_image)
+    {
+    }
+    RendererPair(RendererPair &&rhs)
+        : renderer(std::move(rhs.renderer)),
+          image(rhs.image)
+    {
+    }
+};
+
+int calculateNumberMemoryAllowedClones(KisImageSP image)
+{
+    KisMemoryStatisticsServer::Statistics stats =
+        KisMemoryStatisticsServer::instance()
+        ->fetchMemoryStatistics(image);
+
+    const qint64 allowedMemory = 0.8 * stats.tilesHardLimit - stats.realMemorySize;
+    const qint64 cloneSize = qMax(qint64(1), stats.projectionsSize);
+
+    return allowedMemory > 0 ? allowedMemory / cloneSize : 0;
+}
+
+}
+
+struct KisAsyncAnimationMultiFrameRenderer::Private
+{
+    Private(RendererFactory _createRenderer, RendererInitializer _initializeRenderer)
+        : createRenderer(_createRenderer),
+          initializeRenderer(_initializeRenderer)
+    {
+    }
+
+    RendererFactory createRenderer;
+    RendererInitializer initializeRenderer;
+
+    KisImageSP image;
+    int oldWorkingThreadsLimit = -1;
+    int numThreadsPerWorker = -1;
+
+    std::vector<RendererPair> asyncRenderers;
+    int maxFramesAhead = -1;
+    bool keepWorkers = false;
+    bool memoryLimitReached = false;
+
+    QList<int> stillDirtyFrames;
+    QList<int> framesInProgress;
+    bool isRendering = false;
+
+    int numDirtyFramesLeft() const {
+        return stillDirtyFrames.size() + framesInProgress.size();
+    }
+};
+
+KisAsyncAnimationMultiFrameRenderer::KisAsyncAnimationMultiFrameRenderer(RendererFactory createRenderer,
+                                                                         RendererInitializer initializeRenderer,
+                                                                         QObject *parent)
+    : QObject(parent),
+      m_d(new Private(createRenderer, initializeRenderer))
+{
+}
+
+KisAsyncAnimationMultiFrameRenderer::~KisAsyncAnimationMultiFrameRenderer()
+{
+    // the receivers might already be half-destroyed
+    blockSignals(true);
+
+    cancelRendering();
+    releaseWorkers();
+}
+
+void KisAsyncAnimationMultiFrameRenderer::startRendering(KisImageSP image, const QList<int> &frames)
+{
+    KIS_SAFE_ASSERT_RECOVER(!isActive()) {
+        cancelRendering();
+    }
+
+    /**
+     * The kept workers are reused unless the previous batch was too
+     * small to create as many of them as this one could use
+     */
+    const int numKeptWorkers = int(m_d->asyncRenderers.size());
+    const bool canReuseWorkers =
+        m_d->keepWorkers && m_d->image == image && numKeptWorkers > 0 &&
+        (m_d->memoryLimitReached ||
+         numKeptWorkers >= qMin(frames.size(), KisImageConfig().frameRenderingClones()));
+
+    if (!canReuseWorkers) {
+        releaseWorkers();
+        m_d->memoryLimitReached = false;
+    }
+
+    m_d->stillDirtyFrames = frames;
+    m_d->framesInProgress.clear();
+
+    if (frames.isEmpty()) return;
+
+    m_d->isRendering = true;
+
+    if (canReuseWorkers) {
+        m_d->oldWorkingThreadsLimit = image->workingThreadsLimit();
+        image->setWorkingThreadsLimit(m_d->numThreadsPerWorker);
+
+        tryInitiateFrameRegeneration();
+        return;
+    }
+
+    m_d->image = image;
+
+    KisImageConfig cfg;
+
+    const int maxThreads = cfg.maxNumberOfThreads();
+    const int numAllowedWorker = 1 + calculateNumberMemoryAllowedClones(image);
+    const int proposedNumWorkers = qMin(frames.size(), cfg.frameRenderingClones());
+    int numWorkers = qMin(proposedNumWorkers, numAllowedWorker);
+
+    m_d->memoryLimitReached = numWorkers < proposedNumWorkers;
+
+    /**
+     * The image can be cloned only when it is idle. Otherwise just
+     * render everything on the image itself.
+     */
+    if (numWorkers > 1) {
+        if (image->tryBarrierLock(true)) {
+            image->unlock();
+        } else {
+            numWorkers = 1;
+        }
+    }
+
+    const int numThreadsPerWorker = qMax(1, qCeil(qreal(maxThreads) / numWorkers));
+
+    m_d->numThreadsPerWorker = numThreadsPerWorker;
+    m_d->oldWorkingThreadsLimit = image->workingThreadsLimit();
+
+    for (int i = 0; i < numWorkers; i++) {
+        // reuse the image for one of the workers
+        KisImageSP workerImage = i == numWorkers - 1 ? image : image->clone(true);
+
+        workerImage->setWorkingThreadsLimit(numThreadsPerWorker);
+        KisAsyncAnimationRendererBase *renderer = m_d->createRenderer(workerImage);
+
+        connect(renderer, SIGNAL(sigFrameCompleted(int)), SLOT(slotFrameCompleted(int)));
+        connect(renderer, SIGNAL(sigFrameCancelled(int)), SLOT(slotFrameCancelled(int)));
+
+        m_d->asyncRenderers.push_back(RendererPair(renderer, workerImage));
+    }
+
+    tryInitiateFrameRegeneration();
+}
+
+void KisAsyncAnimationMultiFrameRenderer::cancelRendering()
+{
+    for (auto &pair : m_d->asyncRenderers) {
+        if (pair.renderer->isActive()) {
+            pair.renderer->cancelCurrentFrameRendering();
+        }
+        KIS_SAFE_ASSERT_RECOVER_NOOP(!pair.renderer->isActive());
+    }
+
+    m_d->stillDirtyFrames.clear();
+    m_d->framesInProgress.clear();
+    finishIfDone();
+}
+
+void KisAsyncAnimationMultiFrameRenderer::releaseWorkers(KisViewManager *viewManager)
+{
+    for (auto &pair : m_d->asyncRenderers) {
+        KIS_SAFE_ASSERT_RECOVER_NOOP(!pair.renderer->isActive());
+
+        // the original image is not ours, so we shouldn't block on it
+        if (pair.image == m_d->image) continue;
+
+        if (viewManager) {
+            viewManager->blockUntilOperationsFinishedForced(pair.image);
+        } else {
+            pair.image->barrierLock(true);
+            pair.image->unlock();
+        }
+    }
+    m_d->asyncRenderers.clear();
+
+    if (m_d->image) {
+        m_d->image->setWorkingThreadsLimit(m_d->oldWorkingThreadsLimit);
+        m_d->image.clear();
+    }
+}
+
+void KisAsyncAnimationMultiFrameRenderer::setKeepWorkers(bool value)
+{
+    m_d->keepWorkers = value;
+}
+
+void KisAsyncAnimationMultiFrameRenderer::setMaxFramesAhead(int value)
+{
+    m_d->maxFramesAhead = value;
+}
+
+bool KisAsyncAnimationMultiFrameRenderer::isActive() const
+{
+    return m_d->numDirtyFramesLeft() > 0;
+}
+
+int KisAsyncAnimationMultiFrameRenderer::numFramesLeft() const
+{
+    return m_d->numDirtyFramesLeft();
+}
+
+int KisAsyncAnimationMultiFrameRenderer::numWorkers() const
+{
+    return int(m_d->asyncRenderers.size());
+}
+
+bool KisAsyncAnimationMultiFrameRenderer::memoryLimitReached() const
+{
+    return m_d->memoryLimitReached;
+}
+
+void KisAsyncAnimationMultiFrameRenderer::slotFrameCompleted(int frame)
+{
+    m_d->framesInProgress.removeOne(frame);
+
+    tryInitiateFrameRegeneration();
+
+    emit sigFrameCompleted(frame);
+    finishIfDone();
+}
+
+void KisAsyncAnimationMultiFrameRenderer::slotFrameCancelled(int frame)
+{
+    emit sigFrameCancelled(frame);
+
+    /**
+     * The cancellation of the other renderers will call this slot
+     * recursively, which is fine, since the renderers are already
+     * inactive by that moment.
+     */
+    cancelRendering();
+}
+
+void KisAsyncAnimationMultiFrameRenderer::tryInitiateFrameRegeneration()
+{
+    bool hadWorkOnPreviousCycle = false;
+
+    while (!m_d->stillDirtyFrames.isEmpty()) {
+        if (m_d->maxFramesAhead > 0 && !m_d->framesInProgress.isEmpty()) {
+            const int oldestFrame =
+                *std::min_element(m_d->framesInProgress.constBegin(),
+                                  m_d->framesInProgress.constEnd());
+
+            // slotFrameCompleted() will continue when the oldest frame is done
+            if (m_d->stillDirtyFrames.first() - oldestFrame > m_d->maxFramesAhead) break;
+        }
+
+        for (auto &pair : m_d->asyncRenderers) {
+            if (!pair.renderer->isActive()) {
+                const int currentDirtyFrame = m_d->stillDirtyFrames.takeFirst();
+
+                m_d->initializeRenderer(pair.renderer.get(), pair.image, currentDirtyFrame);
+                pair.renderer->startFrameRegeneration(pair.image, currentDirtyFrame);
+                hadWorkOnPreviousCycle = true;
+                m_d->framesInProgress.append(currentDirtyFrame);
+                break;
+            }
+        }
+
+        if (!hadWorkOnPreviousCycle) break;
+        hadWorkOnPreviousCycle = false;
+    }
+}
+
+void KisAsyncAnimationMultiFrameRenderer::finishIfDone()
+{
+    if (m_d->isRendering && !m_d->numDirtyFramesLeft()) {
+        m_d->isRendering = false;
+
+        /**
+         * The kept workers may stay idle for a long time, so the
+         * original image gets all its threads back meanwhile
+         */
+        if (m_d->keepWorkers && m_d->image) {
+            m_d->image->setWorkingThreadsLimit(m_d->oldWorkingThreadsLimit);
+        }
+
+        emit sigRenderingFinished();
+    }
+}
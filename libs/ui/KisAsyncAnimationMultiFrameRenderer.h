@@ -0,0 +1,145 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KISASYNCANIMATIONMULTIFRAMERENDERER_H
+#define KISASYNCANIMATIONMULTIFRAMERENDERER_H
+
+#include <QObject>
+#include <functional>
+#include "kis_types.h"
+#include "kritaui_export.h"
+
+class KisAsyncAnimationRendererBase;
+class KisViewManager;
+
+/**
+ * KisAsyncAnimationMultiFrameRenderer keeps a pool of renderers working on
+ * several independent copies of the image, so that different frames can be
+ * regenerated at the same time.
+ *
+ *   - the number of workers is limited by the "frame rendering clones" setting
+ *     and by the amount of memory left in the tiles hard limit (the overhead of
+ *     every clone is estimated using the "projections" metric of the statistics
+ *     server)
+ *   - the original image is reused for one of the workers, the rest are clones
+ *   - the frames are fed to the workers until all of them are done; a frame
+ *     failed by any of the workers cancels the whole rendering
+ *
+ * The clones are kept until releaseWorkers() is called, so the caller should
+ * release them when the frames of the original image are changed. Please note
+ * that releaseWorkers() destroys the renderers, so it must not be called from
+ * a slot connected to sigFrameCompleted() or sigFrameCancelled().
+ */
+class KRITAUI_EXPORT KisAsyncAnimationMultiFrameRenderer : public QObject
+{
+    Q_OBJECT
+public:
+    typedef std::function<KisAsyncAnimationRendererBase* (KisImageSP)> RendererFactory;
+    typedef std::function<void (KisAsyncAnimationRendererBase*, KisImageSP, int)> RendererInitializer;
+
+    /**
+     * @param createRenderer creates a renderer for a worker image
+     * @param initializeRenderer is called for a renderer right before it starts
+     *                           regeneration of a frame
+     */
+    KisAsyncAnimationMultiFrameRenderer(RendererFactory createRenderer,
+                                        RendererInitializer initializeRenderer,
+                                        QObject *parent = 0);
+    ~KisAsyncAnimationMultiFrameRenderer() override;
+
+    /**
+     * Starts regeneration of \p frames of \p image and returns immediately.
+     * The workers of the previous call are released, unless they are kept
+     * for the same image (see setKeepWorkers()). If \p image is not idle,
+     * no clones are created and all the frames are regenerated by the image
+     * itself.
+     */
+    void startRendering(KisImageSP image, const QList<int> &frames);
+
+    /**
+     * Cancels regeneration of all the frames. The workers are kept alive
+     * until releaseWorkers() is called.
+     */
+    void cancelRendering();
+
+    /**
+     * Waits until the cloned images finish their work and destroys them
+     * together with the renderers. The link to view manager is used to
+     * barrier lock the clones with visual feedback.
+     */
+    void releaseWorkers(KisViewManager *viewManager = 0);
+
+    /**
+     * When enabled, startRendering() called for the same image reuses the
+     * workers of the previous call instead of cloning the image again. The
+     * caller must call releaseWorkers() as soon as the image is changed or
+     * is going to be deleted. Disabled by default.
+     */
+    void setKeepWorkers(bool value);
+
+    /**
+     * Stops feeding the workers with new frames while they are more than
+     * \p value frames ahead of the oldest frame being regenerated. It limits
+     * the number of frames a consumer that needs them in order has to keep
+     * waiting for the slow one. By default there is no limit.
+     */
+    void setMaxFramesAhead(int value);
+
+    /**
+     * @return true if some frames are still being regenerated
+     */
+    bool isActive() const;
+
+    /**
+     * @return the number of frames that are waiting for regeneration or
+     *         are being regenerated right now
+     */
+    int numFramesLeft() const;
+
+    int numWorkers() const;
+
+    /**
+     * @return true if the number of workers has been limited by the amount
+     *         of memory available
+     */
+    bool memoryLimitReached() const;
+
+Q_SIGNALS:
+    void sigFrameCompleted(int frame);
+    void sigFrameCancelled(int frame);
+
+    /**
+     * Emitted when all the frames have been regenerated or the
+     * rendering has been cancelled
+     */
+    void sigRenderingFinished();
+
+private Q_SLOTS:
+    void slotFrameCompleted(int frame);
+    void slotFrameCancelled(int frame);
+
+private:
+    void tryInitiateFrameRegeneration();
+    void finishIfDone();
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif // KISASYNCANIMATIONMULTIFRAMERENDERER_H
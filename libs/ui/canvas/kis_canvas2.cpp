@@ -28,8 +28,13 @@
 #include <QLabel>
 #include <QMouseEvent>
 #include <QDesktopWidget>
+#include <QHash>
+#include <QMutex>
+#include <QRegion>
+#include <QSharedPointer>
 
 #include <kis_debug.h>
+#include <kis_global.h>
 
 #include <KoUnit.h>
 #include <KoShapeManager.h>
@@ -45,7 +50,11 @@
 #include "kis_coordinates_converter.h"
 #include "kis_prescaled_projection.h"
 #include "kis_image.h"
+#include "kis_paint_device.h"
+#include "kis_datamanager.h"
+#include "kis_layer_utils.h"
 #include "kis_image_barrier_locker.h"
+#include "kis_spontaneous_job.h"
 #include "kis_undo_adapter.h"
 #include "KisDocument.h"
 #include "flake/kis_shape_layer.h"
@@ -91,6 +100,123 @@
 #include <KisStrokeSpeedMonitor.h>
 #include "opengl/kis_opengl_canvas_debugger.h"
 
+namespace {
+
+/**
+ * The swap priorities that were last applied to the devices of the
+ * image. It is shared between the canvas and its swap priorities
+ * jobs, so that every job touches only the tiles whose priority has
+ * actually changed.
+ */
+struct SwapPrioritiesState
+{
+    QMutex lock;
+    QHash<KisPaintDevice*, QPair<KisPaintDeviceWSP, KisTileData::EnumSwapPriority>> devicePriorities;
+    KisPaintDeviceWSP projection;
+    QRect highPriorityRect;
+};
+
+typedef QSharedPointer<SwapPrioritiesState> SwapPrioritiesStateSP;
+
+/**
+ * Updates the swap priorities of the image's tiles. Setting the
+ * priority walks all the tiles of a device, so it is done on the
+ * image's threads, where spontaneous jobs never run in parallel
+ * with the updates and strokes that could change the node graph.
+ */
+class KisUpdateSwapPrioritiesJob : public KisSpontaneousJob
+{
+public:
+    KisUpdateSwapPrioritiesJob(KisImageSP image, KisNodeSP activeNode,
+                               const QRect &visibleRect,
+                               SwapPrioritiesStateSP state)
+        : m_image(image),
+          m_activeNode(activeNode),
+          m_visibleRect(visibleRect),
+          m_state(state)
+    {
+    }
+
+    bool overrides(const KisSpontaneousJob *_otherJob) override {
+        const KisUpdateSwapPrioritiesJob *otherJob =
+            dynamic_cast<const KisUpdateSwapPrioritiesJob*>(_otherJob);
+
+        // the job carries the full state, not a delta
+        return otherJob && otherJob->m_state == m_state;
+    }
+
+    void run() override {
+        KisImageSP image = m_image.toStrongRef();
+        if (!image) return;
+
+        QMutexLocker locker(&m_state->lock);
+
+        QHash<KisPaintDevice*, QPair<KisPaintDeviceWSP, KisTileData::EnumSwapPriority>> newPriorities;
+
+        KisLayerUtils::recursiveApplyNodes(image->root(),
+            [this, &newPriorities] (KisNodeSP node) {
+                KisPaintDeviceSP device = node->paintDevice();
+                if (!device) return;
+
+                const KisTileData::EnumSwapPriority priority =
+                    node == m_activeNode ? KisTileData::HIGH_PRIORITY :
+                    node->visible(true) && !node->userLocked() ? KisTileData::NORMAL_PRIORITY :
+                    KisTileData::LOW_PRIORITY;
+
+                // the weak pointer guards against the address being
+                // reused by a new device
+                auto it = m_state->devicePriorities.constFind(device.data());
+                if (it == m_state->devicePriorities.constEnd() ||
+                    !it->first.isValid() ||
+                    it->second != priority) {
+
+                    device->dataManager()->setSwapPriority(priority);
+                }
+
+                newPriorities.insert(device.data(), qMakePair(KisPaintDeviceWSP(device), priority));
+            });
+
+        m_state->devicePriorities = newPriorities;
+
+        KisPaintDeviceSP projection = image->projection();
+        const QRect highPriorityRect =
+            m_visibleRect.translated(-projection->x(), -projection->y());
+
+        if (!m_state->projection.isValid() || m_state->projection.data() != projection.data()) {
+            projection->dataManager()->setSwapPriority(KisTileData::NORMAL_PRIORITY);
+            m_state->projection = projection;
+            m_state->highPriorityRect = QRect();
+        }
+
+        const QRegion staleRegion = QRegion(m_state->highPriorityRect) - highPriorityRect;
+        Q_FOREACH (const QRect &rc, staleRegion.rects()) {
+            projection->dataManager()->setSwapPriority(KisTileData::NORMAL_PRIORITY, rc);
+        }
+
+        /**
+         * The visible area is small, so we reapply it every time to
+         * catch the tiles that have been created since the last run
+         */
+        if (!highPriorityRect.isEmpty()) {
+            projection->dataManager()->setSwapPriority(KisTileData::HIGH_PRIORITY, highPriorityRect);
+        }
+
+        m_state->highPriorityRect = highPriorityRect;
+    }
+
+    int levelOfDetail() const override {
+        return 0;
+    }
+
+private:
+    KisImageWSP m_image;
+    KisNodeSP m_activeNode;
+    QRect m_visibleRect;
+    SwapPrioritiesStateSP m_state;
+};
+
+}
+
 class Q_DECL_HIDDEN KisCanvas2::KisCanvas2Private
 {
 
@@ -120,6 +246,9 @@ public:
     KisSignalCompressor updateSignalCompressor;
     QRect savedUpdateRect;
 
+    KisSignalCompressor swapPrioritiesCompressor;
+    SwapPrioritiesStateSP swapPrioritiesState = SwapPrioritiesStateSP(new SwapPrioritiesState());
+
     QBitArray channelFlags;
     KisProofingConfigurationSP proofingConfig;
     bool softProofing = false;
@@ -185,6 +314,9 @@ KisCanvas2::KisCanvas2(KisCoordinatesConverter *coordConverter, KoCanvasResource
 
     m_d->updateSignalCompressor.setDelay(1000 / config.fpsLimit());
     m_d->updateSignalCompressor.setMode(KisSignalCompressor::FIRST_ACTIVE);
+
+    m_d->swapPrioritiesCompressor.setDelay(500);
+    m_d->swapPrioritiesCompressor.setMode(KisSignalCompressor::POSTPONE);
 }
 
 void KisCanvas2::setup()
@@ -225,6 +357,7 @@ void KisCanvas2::setup()
             globalShapeManager()->selection(), SIGNAL(currentLayerChanged(const KoShapeLayer*)));
 
     connect(&m_d->updateSignalCompressor, SIGNAL(timeout()), SLOT(slotDoCanvasUpdate()));
+    connect(&m_d->swapPrioritiesCompressor, SIGNAL(timeout()), SLOT(slotUpdateSwapPriorities()));
 
     initializeFpsDecoration();
 }
@@ -525,6 +658,9 @@ void KisCanvas2::initializeImage()
     connect(this, SIGNAL(sigContinueResizeImage(qint32,qint32)), SLOT(finishResizingImage(qint32,qint32)));
     connect(image->undoAdapter(), SIGNAL(selectionChanged()), SLOT(slotTrySwitchShapeManager()));
 
+    connect(image, SIGNAL(sigNodeChanged(KisNodeSP)), &m_d->swapPrioritiesCompressor, SLOT(start()));
+    connect(image, SIGNAL(sigLayersChangedAsync()), &m_d->swapPrioritiesCompressor, SLOT(start()));
+
     connectCurrentCanvas();
 }
 
@@ -789,11 +925,60 @@ void KisCanvas2::notifyZoomChanged()
     }
 
     notifyLevelOfDetailChange();
+    prefetchVisibleArea();
     updateCanvas(); // update the canvas, because that isn't done when zooming using KoZoomAction
 }
 
+QRect KisCanvas2::visibleImageRectWithMargin() const
+{
+    KisImageSP image = this->image();
+    if (!image || !canvasWidget()) return QRect();
+
+    /**
+     * The user is likely to continue panning in the same direction,
+     * so take a bit more than what is actually visible
+     */
+    const int margin = 256;
+
+    QRect visibleRect =
+        m_d->coordinatesConverter->widgetToImage(QRectF(QPointF(), canvasWidget()->size())).toAlignedRect();
+    return kisGrowRect(visibleRect, margin) & image->bounds();
+}
+
+void KisCanvas2::prefetchVisibleArea()
+{
+    const QRect visibleRect = visibleImageRectWithMargin();
+    if (visibleRect.isEmpty()) return;
+
+    image()->projection()->prefetchSwappedData(visibleRect);
+
+    KisNodeSP node = m_d->view->currentNode();
+    if (node && node->paintDevice()) {
+        node->paintDevice()->prefetchSwappedData(visibleRect);
+    }
+
+    m_d->swapPrioritiesCompressor.start();
+}
+
+void KisCanvas2::slotUpdateSwapPriorities()
+{
+    KisImageConfig config;
+    if (!config.useTileSwapPriorities()) return;
+
+    KisImageSP image = this->image();
+    if (!image) return;
+
+    image->addSpontaneousJob(
+        new KisUpdateSwapPrioritiesJob(image,
+                                       m_d->view->currentNode(),
+                                       visibleImageRectWithMargin(),
+                                       m_d->swapPrioritiesState));
+}
+
 void KisCanvas2::slotTrySwitchShapeManager()
 {
+    m_d->swapPrioritiesCompressor.start();
+
     QPointer<KoShapeManager> oldManager = m_d->currentlyActiveShapeManager;
 
     KisNodeSP node = m_d->view->currentNode();
@@ -864,6 +1049,7 @@ void KisCanvas2::documentOffsetMoved(const QPoint &documentOffset)
 
     emit documentOffsetUpdateFinished();
 
+    prefetchVisibleArea();
     updateCanvas();
 }
 
@@ -258,6 +258,13 @@ private Q_SLOTS:
     void startUpdateCanvasProjection(const QRect & rc);
     void updateCanvasProjection();
 
+    /**
+     * Tells the swapper which data should stay in memory: the
+     * active layer and the visible part of the projection are kept,
+     * hidden and locked layers are swapped out first
+     */
+    void slotUpdateSwapPriorities();
+
 
     /**
      * Called whenever the view widget needs to show a different part of
@@ -302,6 +309,20 @@ private:
 
     void notifyLevelOfDetailChange();
 
+    /**
+     * Asks the tile engine to load back the swapped out data of
+     * the visible area of the image and the current layer, so that
+     * the user doesn't have to wait for the swap file on the next
+     * update or stroke
+     */
+    void prefetchVisibleArea();
+
+    /**
+     * The visible area of the image with some margin around it,
+     * the part of the image the user is most likely to access
+     */
+    QRect visibleImageRectWithMargin() const;
+
     // Completes construction of canvas.
     // To be called by KisView in its constructor, once it has been setup enough
     // (to be defined what that means) for things KisCanvas2 expects from KisView
@@ -18,6 +18,7 @@
 #include "kis_image_pyramid.h"
 
 #include <QBitArray>
+#include <QtConcurrent>
 #include <KoChannelInfo.h>
 #include <KoCompositeOp.h>
 #include <KoColorSpaceRegistry.h>
@@ -32,6 +33,7 @@
 #include "kis_debug.h"
 #include "kis_config.h"
 #include "kis_image_config.h"
+#include "krita_utils.h"
 
 //#define DEBUG_PYRAMID
 
@@ -41,6 +43,10 @@
 #include <OpenColorIO/OpenColorTransforms.h>
 #endif
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #define ORIGINAL_INDEX           0
 #define FIRST_NOT_ORIGINAL_INDEX 1
 #define SCALE_FROM_INDEX(idx) (1./qreal(1<<(idx)))
@@ -104,6 +110,7 @@ KisImagePyramid::KisImagePyramid(qint32 pyramidHeight)
         : m_monitorProfile(0)
         , m_monitorColorSpace(0)
         , m_pyramidHeight(pyramidHeight)
+        , m_useMultithreading(true)
 {
     configChanged();
     connect(KisConfigNotifier::instance(), SIGNAL(configChanged()), this, SLOT(configChanged()));
@@ -156,6 +163,16 @@ void KisImagePyramid::setDisplayFilter(QSharedPointer<KisDisplayFilter> displayF
     m_displayFilter = displayFilter;
 }
 
+void KisImagePyramid::setUseMultithreading(bool value)
+{
+    m_useMultithreading = value;
+}
+
+bool KisImagePyramid::useMultithreading() const
+{
+    return m_useMultithreading;
+}
+
 void KisImagePyramid::rebuildPyramid()
 {
     m_pyramid.clear();
@@ -182,33 +199,14 @@ void KisImagePyramid::setImage(KisImageWSP newImage)
         // Get the full image size
         QRect rc = m_originalImage->projection()->exactBounds();
 
-        KisImageConfig config;
-
-        int patchWidth = config.updatePatchWidth();
-        int patchHeight = config.updatePatchHeight();
-
-        if (rc.width() * rc.height() <= patchWidth * patchHeight) {
+        if (rc.width() * rc.height() <= m_patchSize.width() * m_patchSize.height()) {
             retrieveImageData(rc);
         }
         else {
-            qint32 firstCol = rc.x() / patchWidth;
-            qint32 firstRow = rc.y() / patchHeight;
-
-            qint32 lastCol = (rc.x() + rc.width()) / patchWidth;
-            qint32 lastRow = (rc.y() + rc.height()) / patchHeight;
-
-            for(qint32 i = firstRow; i <= lastRow; i++) {
-                for(qint32 j = firstCol; j <= lastCol; j++) {
-                    QRect maxPatchRect(j * patchWidth,
-                                       i * patchHeight,
-                                       patchWidth, patchHeight);
-                    QRect patchRect = rc & maxPatchRect;
-                    retrieveImageData(patchRect);
-                }
-            }
-
+            retrieveImageData(KritaUtils::splitRectIntoPatches(rc, m_patchSize));
         }
-        //TODO: check whether there is needed recalculateCache()
+
+        rebuildLevels(rc);
     }
 }
 
@@ -225,6 +223,50 @@ void KisImagePyramid::updateCache(const QRect &dirtyImageRect)
 }
 
 void KisImagePyramid::retrieveImageData(const QRect &rect)
+{
+    retrieveImageData(QVector<QRect>() << rect);
+}
+
+void KisImagePyramid::retrieveImageData(QVector<QRect> rects)
+{
+    const KoColorSpace *projectionCs = m_originalImage->projection()->colorSpace();
+
+    const bool useDisplayFilter =
+        m_displayFilter &&
+        m_useOcio &&
+        projectionCs->colorModelId() == RGBAColorModelID;
+
+    bool showSingleChannelAsColor = false;
+
+    /**
+     * Channel flags and the config are shared by all the patches, so
+     * prepare them before the conversion is spread over the threads
+     */
+    if (!useDisplayFilter) {
+        QList<KoChannelInfo*> channelInfo = projectionCs->channels();
+        if (m_channelFlags.size() != channelInfo.size()) {
+            setChannelFlags(QBitArray());
+        }
+
+        if (!m_channelFlags.isEmpty() && !m_allChannelsSelected) {
+            KisConfig cfg;
+            showSingleChannelAsColor = cfg.showSingleChannelAsColor();
+        }
+    }
+
+    if (m_useMultithreading && rects.size() > 1) {
+        QtConcurrent::blockingMap(rects,
+            [this, showSingleChannelAsColor] (const QRect &rc) {
+                convertImageData(rc, showSingleChannelAsColor);
+            });
+    } else {
+        Q_FOREACH (const QRect &rc, rects) {
+            convertImageData(rc, showSingleChannelAsColor);
+        }
+    }
+}
+
+void KisImagePyramid::convertImageData(const QRect &rect, bool showSingleChannelAsColor)
 {
     // XXX: use QThreadStorage to cache the two patches (512x512) of pixels. Note
     // that when we do that, we need to reset that cache when the projection's
@@ -277,18 +319,13 @@ void KisImagePyramid::retrieveImageData(const QRect &rect)
     }
     else {
         QList<KoChannelInfo*> channelInfo = projectionCs->channels();
-        if (m_channelFlags.size() != channelInfo.size()) {
-            setChannelFlags(QBitArray());
-        }
         if (!m_channelFlags.isEmpty() && !m_allChannelsSelected) {
             QScopedArrayPointer<quint8> dst(new quint8[projectionCs->pixelSize() * numPixels]);
 
             int channelSize = channelInfo[m_selectedChannelIndex]->size();
             int pixelSize = projectionCs->pixelSize();
 
-            KisConfig cfg;
-
-            if (m_onlyOneChannelSelected && !cfg.showSingleChannelAsColor()) {
+            if (m_onlyOneChannelSelected && !showSingleChannelAsColor) {
                 int selectedChannelPos = channelInfo[m_selectedChannelIndex]->pos();
                 for (uint pixelIndex = 0; pixelIndex < numPixels; ++pixelIndex) {
                     for (uint channelIndex = 0; channelIndex < projectionCs->channelCount(); ++channelIndex) {
@@ -329,14 +366,20 @@ void KisImagePyramid::retrieveImageData(const QRect &rect)
         originalBytes.swap(dst);
     }
 
-    m_pyramid[ORIGINAL_INDEX]->writeBytes(originalBytes.data(), rect);
+    KisPaintDeviceSP baseLevel = m_pyramid.at(ORIGINAL_INDEX);
+    baseLevel->writeBytes(originalBytes.data(), rect);
 }
 
 void KisImagePyramid::recalculateCache(KisPPUpdateInfoSP info)
+{
+    rebuildLevels(info->dirtyImageRectVar);
+}
+
+void KisImagePyramid::rebuildLevels(const QRect &dirtyImageRect)
 {
     KisPaintDevice *src;
     KisPaintDevice *dst;
-    QRect currentSrcRect = info->dirtyImageRectVar;
+    QRect currentSrcRect = dirtyImageRect;
 
     for (int i = FIRST_NOT_ORIGINAL_INDEX; i < m_pyramidHeight; i++) {
         src = m_pyramid[i-1].data();
@@ -372,10 +415,39 @@ QRect KisImagePyramid::downsampleByFactor2(const QRect& srcRect,
     if (srcWidth < 1) return QRect();
     if (srcHeight < 1) return QRect();
 
-    qint32 dstX = srcX / 2;
-    qint32 dstY = srcY / 2;
-    qint32 dstWidth = srcWidth / 2;
-    qint32 dstHeight = srcHeight / 2;
+    QRect dstRect(srcX / 2, srcY / 2, srcWidth / 2, srcHeight / 2);
+
+    /**
+     * Every destination pixel depends on four source pixels only, so
+     * the patches can be filled in any order
+     */
+    QVector<QRect> patches;
+    if (m_useMultithreading) {
+        patches = KritaUtils::splitRectIntoPatches(dstRect, m_patchSize);
+    }
+
+    if (patches.size() > 1) {
+        QtConcurrent::blockingMap(patches,
+            [src, dst] (const QRect &rc) {
+                downsampleRect(rc, src, dst);
+            });
+    } else {
+        downsampleRect(dstRect, src, dst);
+    }
+
+    return dstRect;
+}
+
+void KisImagePyramid::downsampleRect(const QRect &dstRect,
+                                     KisPaintDevice* src,
+                                     KisPaintDevice* dst)
+{
+    qint32 dstX, dstY, dstWidth, dstHeight;
+    dstRect.getRect(&dstX, &dstY, &dstWidth, &dstHeight);
+
+    qint32 srcX = 2 * dstX;
+    qint32 srcY = 2 * dstY;
+    qint32 srcWidth = 2 * dstWidth;
 
     KisHLineConstIteratorSP srcIt0 = src->createHLineConstIteratorNG(srcX, srcY, srcWidth);
     KisHLineConstIteratorSP srcIt1 = src->createHLineConstIteratorNG(srcX, srcY + 1, srcWidth);
@@ -403,35 +475,60 @@ QRect KisImagePyramid::downsampleByFactor2(const QRect& srcRect,
         srcIt1->nextRow();
         dstIt->nextRow();
     }
-    return QRect(dstX, dstY, dstWidth, dstHeight);
 }
 
-void  KisImagePyramid::downsamplePixels(const quint8 *srcRow0,
-                                        const quint8 *srcRow1,
-                                        quint8 *dstRow,
-                                        qint32 numSrcPixels)
+void KisImagePyramid::downsamplePixels(const quint8 *srcRow0,
+                                       const quint8 *srcRow1,
+                                       quint8 *dstRow,
+                                       qint32 numSrcPixels)
 {
-    /**
-     * FIXME (mandatory): Use SSE and friends here.
-     */
+    static const qint32 pixelSize = 4; // This is preview argb8 mode
 
-    qint16 b = 0;
-    qint16 g = 0;
-    qint16 r = 0;
-    qint16 a = 0;
+    const qint32 numDstPixels = numSrcPixels / 2;
+    qint32 i = 0;
 
-    static const qint32 pixelSize = 4; // This is preview argb8 mode
+#if defined(__SSE2__)
+    /**
+     * Four destination pixels per iteration: the source bytes are
+     * widened to 16 bits, summed vertically, then horizontally and
+     * packed back. The result is exactly the same as the one of
+     * the scalar loop below.
+     */
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 4 <= numDstPixels; i += 4) {
+        const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcRow0));
+        const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcRow0 + 4 * pixelSize));
+        const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcRow1));
+        const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(srcRow1 + 4 * pixelSize));
+
+        // source pixels {0, 1}, {2, 3}, {4, 5} and {6, 7} summed vertically
+        const __m128i v01 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+        const __m128i v23 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+        const __m128i v45 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+        const __m128i v67 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+
+        // even pixels plus odd pixels
+        const __m128i h0 = _mm_add_epi16(_mm_unpacklo_epi64(v01, v23), _mm_unpackhi_epi64(v01, v23));
+        const __m128i h1 = _mm_add_epi16(_mm_unpacklo_epi64(v45, v67), _mm_unpackhi_epi64(v45, v67));
+
+        const __m128i result = _mm_packus_epi16(_mm_srli_epi16(h0, 2), _mm_srli_epi16(h1, 2));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dstRow), result);
+
+        dstRow += 4 * pixelSize;
+        srcRow0 += 8 * pixelSize;
+        srcRow1 += 8 * pixelSize;
+    }
+#endif
 
-    for (qint32 i = 0; i < numSrcPixels / 2; i++) {
-        b = srcRow0[0] + srcRow1[0] + srcRow0[4] + srcRow1[4];
-        g = srcRow0[1] + srcRow1[1] + srcRow0[5] + srcRow1[5];
-        r = srcRow0[2] + srcRow1[2] + srcRow0[6] + srcRow1[6];
-        a = srcRow0[3] + srcRow1[3] + srcRow0[7] + srcRow1[7];
+    for (; i < numDstPixels; i++) {
+        for (qint32 ch = 0; ch < pixelSize; ch++) {
+            const quint16 sum =
+                srcRow0[ch] + srcRow1[ch] +
+                srcRow0[ch + pixelSize] + srcRow1[ch + pixelSize];
 
-        dstRow[0] = b / 4;
-        dstRow[1] = g / 4;
-        dstRow[2] = r / 4;
-        dstRow[3] = a / 4;
+            dstRow[ch] = sum >> 2;
+        }
 
         dstRow += pixelSize;
         srcRow0 += 2 * pixelSize;
@@ -524,7 +621,31 @@ QImage KisImagePyramid::convertToQImageFast(KisPaintDeviceSP paintDevice,
 
     QImage image = QImage(w, h, QImage::Format_ARGB32);
 
-    paintDevice->dataManager()->readBytes(image.bits(), x, y, w, h);
+    /**
+     * Big rects are read in horizontal strips, each of them going
+     * into its own rows of the image, so they can be read concurrently
+     */
+    const int stripHeight = m_patchSize.height();
+    quint8 *bits = image.bits();
+
+    if (m_useMultithreading && h > stripHeight) {
+        QVector<QRect> strips;
+        for (int row = 0; row < h; row += stripHeight) {
+            strips << QRect(x, y + row, w, qMin(stripHeight, h - row));
+        }
+
+        KisDataManagerSP dataManager = paintDevice->dataManager();
+        const int bytesPerLine = image.bytesPerLine();
+
+        QtConcurrent::blockingMap(strips,
+            [dataManager, bits, bytesPerLine, y] (const QRect &rc) {
+                dataManager->readBytes(bits + (rc.y() - y) * bytesPerLine,
+                                       rc.x(), rc.y(), rc.width(), rc.height(),
+                                       bytesPerLine);
+            });
+    } else {
+        paintDevice->dataManager()->readBytes(bits, x, y, w, h);
+    }
 
     return image;
 }
@@ -533,5 +654,7 @@ void KisImagePyramid::configChanged()
 {
     KisConfig cfg;
     m_useOcio = cfg.useOcio();
+
+    m_patchSize = KritaUtils::optimalPatchSize();
 }
 
@@ -27,9 +27,10 @@
 #include <kis_image.h>
 #include <kis_paint_device.h>
 #include "kis_projection_backend.h"
+#include "kritaui_export.h"
 
 
-class KisImagePyramid : QObject, public KisProjectionBackend
+class KRITAUI_EXPORT KisImagePyramid : QObject, public KisProjectionBackend
 {
     Q_OBJECT
 
@@ -73,12 +74,35 @@ public:
 
     void alignSourceRect(QRect& rect, qreal scale) override;
 
+    /**
+     * Enables or disables spreading of the color conversion and the
+     * rebuilding of the pyramid levels over the global thread pool.
+     * The result is exactly the same in both modes. Enabled by default.
+     */
+    void setUseMultithreading(bool value);
+    bool useMultithreading() const;
+
 private:
 
     void retrieveImageData(const QRect &rect);
+    void retrieveImageData(QVector<QRect> rects);
+
+    /**
+     * Reads @rect from the projection and writes it, converted into
+     * the monitor color space, into the base plane of the pyramid.
+     * Doesn't modify any members, so can be called concurrently for
+     * non-overlapping rects.
+     */
+    void convertImageData(const QRect &rect, bool showSingleChannelAsColor);
     void rebuildPyramid();
     void clearPyramid();
 
+    /**
+     * Propagates @dirtyImageRect of the base plane down to all the
+     * smaller planes of the pyramid
+     */
+    void rebuildLevels(const QRect &dirtyImageRect);
+
     /**
      * Downsamples @srcRect from @src paint device and writes
      * result into proper place of @dst paint device
@@ -87,13 +111,20 @@ private:
     QRect downsampleByFactor2(const QRect& srcRect,
                               KisPaintDevice* src, KisPaintDevice* dst);
 
+    /**
+     * Fills @dstRect of @dst paint device with the downsampled
+     * pixels of the twice as big rect of @src paint device
+     */
+    static void downsampleRect(const QRect &dstRect,
+                               KisPaintDevice* src, KisPaintDevice* dst);
+
     /**
      * Auxiliary function. Downsamples two lines in @srcRow0
      * and @srcRow1 into one line @dstRow
      * Note: @numSrcPixels must be EVEN
      */
-    void downsamplePixels(const quint8 *srcRow0, const quint8 *srcRow1,
-                          quint8 *dstRow, qint32 numSrcPixels);
+    static void downsamplePixels(const quint8 *srcRow0, const quint8 *srcRow1,
+                                 quint8 *dstRow, qint32 numSrcPixels);
 
     /**
      * Searches for the last pyramid plane that can cover
@@ -133,6 +164,8 @@ private:
     qint32 m_pyramidHeight;
 
     bool m_useOcio;
+    bool m_useMultithreading;
+    QSize m_patchSize;
 
     QBitArray m_channelFlags;
     bool m_allChannelsSelected;
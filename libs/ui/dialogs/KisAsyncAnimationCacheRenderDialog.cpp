@@ -24,9 +24,7 @@
 #include <kis_image.h>
 #include <kis_image_animation_interface.h>
 
-namespace {
-
-QList<int> calcDirtyFramesList(KisAnimationFrameCacheSP cache, const KisTimeRange &playbackRange)
+QList<int> KisAsyncAnimationCacheRenderDialog::calcDirtyFramesList(KisAnimationFrameCacheSP cache, const KisTimeRange &playbackRange, const KisTimeRange &skipRange)
 {
     QList<int> result;
 
@@ -46,7 +44,14 @@ QList<int> calcDirtyFramesList(KisAnimationFrameCacheSP cache, const KisTimeRang
 
             KIS_SAFE_ASSERT_RECOVER_RETURN_VALUE(stillFrameRange.isValid(), result);
 
-            if (cache->frameStatus(stillFrameRange.start()) == KisAnimationFrameCache::Uncached) {
+            /**
+             * The frames evicted to fit into the memory limit are not
+             * regenerated, otherwise they would just evict other frames.
+             * The playback still regenerates them on demand.
+             */
+            if (!skipRange.contains(stillFrameRange.start()) &&
+                cache->frameStatus(stillFrameRange.start()) == KisAnimationFrameCache::Uncached) {
+
                 result.append(stillFrameRange.start());
             }
 
@@ -61,8 +66,6 @@ QList<int> calcDirtyFramesList(KisAnimationFrameCacheSP cache, const KisTimeRang
     return result;
 }
 
-}
-
 int KisAsyncAnimationCacheRenderDialog::calcFirstDirtyFrame(KisAnimationFrameCacheSP cache, const KisTimeRange &playbackRange, const KisTimeRange &skipRange)
 {
     int result = -1;
@@ -123,7 +126,7 @@ KisAsyncAnimationCacheRenderDialog::~KisAsyncAnimationCacheRenderDialog()
 
 QList<int> KisAsyncAnimationCacheRenderDialog::calcDirtyFrames() const
 {
-    return calcDirtyFramesList(m_d->cache, m_d->range);
+    return calcDirtyFramesList(m_d->cache, m_d->range, KisTimeRange());
 }
 
 KisAsyncAnimationRendererBase *KisAsyncAnimationCacheRenderDialog::createRenderer(KisImageSP image)
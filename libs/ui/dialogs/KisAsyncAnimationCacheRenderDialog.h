@@ -29,6 +29,13 @@ public:
     KisAsyncAnimationCacheRenderDialog(KisAnimationFrameCacheSP cache, const KisTimeRange &range, int busyWait = 200);
     ~KisAsyncAnimationCacheRenderDialog();
 
+    /**
+     * @return the first frames of all the uncached still-frame ranges in
+     *         \p playbackRange, the ranges starting inside \p skipRange
+     *         are not included
+     */
+    static QList<int> calcDirtyFramesList(KisAnimationFrameCacheSP cache, const KisTimeRange &playbackRange, const KisTimeRange &skipRange);
+
     static int calcFirstDirtyFrame(KisAnimationFrameCacheSP cache, const KisTimeRange &playbackRange, const KisTimeRange &skipRange);
 
 protected:
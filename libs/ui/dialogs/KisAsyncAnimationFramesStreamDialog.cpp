@@ -0,0 +1,125 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisAsyncAnimationFramesStreamDialog.h"
+
+#include <QMap>
+#include <QImage>
+
+#include <klocalizedstring.h>
+
+#include <kis_image.h>
+#include <kis_time_range.h>
+
+#include <KisAsyncAnimationFramesStreamingRenderer.h>
+#include <KisAnimationFrameSink.h>
+
+namespace {
+
+/**
+ * The number of frames the renderers may go ahead of the frame the
+ * sink is waiting for. Every frame kept by OrderedFrameSink is a full
+ * RGBA copy of the image, so it shouldn't grow unbounded.
+ */
+const int maxPendingFrames = 8;
+
+/**
+ * Passes the frames to the destination sink in the order of the
+ * range, keeping the frames that arrived too early
+ */
+class OrderedFrameSink : public KisAnimationFrameSink
+{
+public:
+    OrderedFrameSink(int firstFrame, KisAnimationFrameSink *sink)
+        : m_nextFrame(firstFrame),
+          m_sink(sink)
+    {
+    }
+
+    bool writeFrame(int frame, const QImage &image) override {
+        m_pendingFrames.insert(frame, image);
+
+        while (!m_pendingFrames.isEmpty() &&
+               m_pendingFrames.firstKey() == m_nextFrame) {
+
+            const QImage nextImage = m_pendingFrames.take(m_nextFrame);
+
+            if (!m_sink->writeFrame(m_nextFrame, nextImage)) {
+                m_pendingFrames.clear();
+                return false;
+            }
+
+            m_nextFrame++;
+        }
+
+        return true;
+    }
+
+private:
+    int m_nextFrame;
+    KisAnimationFrameSink *m_sink;
+    QMap<int, QImage> m_pendingFrames;
+};
+
+}
+
+struct KisAsyncAnimationFramesStreamDialog::Private {
+    Private(const KisTimeRange &_range, KisAnimationFrameSink *sink)
+        : range(_range),
+          orderedSink(_range.start(), sink)
+    {
+    }
+
+    KisTimeRange range;
+    OrderedFrameSink orderedSink;
+};
+
+KisAsyncAnimationFramesStreamDialog::KisAsyncAnimationFramesStreamDialog(KisImageSP image,
+                                                                         const KisTimeRange &range,
+                                                                         KisAnimationFrameSink *sink)
+    : KisAsyncAnimationRenderDialogBase(i18n("Encoding frames..."), image, 0),
+      m_d(new Private(range, sink))
+{
+    setMaxFramesAhead(maxPendingFrames);
+}
+
+KisAsyncAnimationFramesStreamDialog::~KisAsyncAnimationFramesStreamDialog()
+{
+}
+
+QList<int> KisAsyncAnimationFramesStreamDialog::calcDirtyFrames() const
+{
+    QList<int> result;
+    for (int i = m_d->range.start(); i <= m_d->range.end(); i++) {
+        result.append(i);
+    }
+    return result;
+}
+
+KisAsyncAnimationRendererBase *KisAsyncAnimationFramesStreamDialog::createRenderer(KisImageSP image)
+{
+    Q_UNUSED(image);
+    return new KisAsyncAnimationFramesStreamingRenderer(&m_d->orderedSink);
+}
+
+void KisAsyncAnimationFramesStreamDialog::initializeRendererForFrame(KisAsyncAnimationRendererBase *renderer, KisImageSP image, int frame)
+{
+    Q_UNUSED(renderer);
+    Q_UNUSED(image);
+    Q_UNUSED(frame);
+}
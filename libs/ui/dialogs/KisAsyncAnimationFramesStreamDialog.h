@@ -0,0 +1,55 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef KISASYNCANIMATIONFRAMESSTREAMDIALOG_H
+#define KISASYNCANIMATIONFRAMESSTREAMDIALOG_H
+
+#include "KisAsyncAnimationRenderDialogBase.h"
+#include "kis_types.h"
+
+class KisAnimationFrameSink;
+
+/**
+ * Renders the frames of \p range and passes them to a sink in the
+ * order of the range, e.g. to an encoder reading raw frames from
+ * its stdin. The frames are rendered by several image clones, the
+ * frames completed out of order are kept in memory until all the
+ * preceding ones are passed to the sink. The clones are not given
+ * new frames while too many of them are kept.
+ */
+class KRITAUI_EXPORT KisAsyncAnimationFramesStreamDialog : public KisAsyncAnimationRenderDialogBase
+{
+public:
+    KisAsyncAnimationFramesStreamDialog(KisImageSP image,
+                                        const KisTimeRange &range,
+                                        KisAnimationFrameSink *sink);
+
+    ~KisAsyncAnimationFramesStreamDialog();
+
+protected:
+    QList<int> calcDirtyFrames() const override;
+    KisAsyncAnimationRendererBase* createRenderer(KisImageSP image) override;
+    void initializeRendererForFrame(KisAsyncAnimationRendererBase *renderer,
+                                    KisImageSP image, int frame) override;
+
+private:
+    struct Private;
+    const QScopedPointer<Private> m_d;
+};
+
+#endif // KISASYNCANIMATIONFRAMESSTREAMDIALOG_H
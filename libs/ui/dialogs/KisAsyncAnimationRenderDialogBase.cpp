@@ -31,45 +31,9 @@
 
 #include "KisViewManager.h"
 #include "KisAsyncAnimationRendererBase.h"
+#include "KisAsyncAnimationMultiFrameRenderer.h"
 #include "kis_time_range.h"
 #include "kis_image.h"
-#include "kis_image_config.h"
-#include "kis_memory_statistics_server.h"
-
-#include <vector>
-#include <memory>
-
-namespace {
-struct RendererPair {
-    std::unique_ptr<KisAsyncAnimationRendererBase> renderer;
-    KisImageSP image;
-
-    RendererPair() {}
-    RendererPair(KisAsyncAnimationRendererBase *_renderer, KisImageSP _image)
-        : renderer(_renderer),
-          image(_image)
-    {
-    }
-    RendererPair(RendererPair &&rhs)
-        : renderer(std::move(rhs.renderer)),
-          image(rhs.image)
-    {
-    }
-};
-
-int calculateNumberMemoryAllowedClones(KisImageSP image)
-{
-    KisMemoryStatisticsServer::Statistics stats =
-        KisMemoryStatisticsServer::instance()
-        ->fetchMemoryStatistics(image);
-
-    const qint64 allowedMemory = 0.8 * stats.tilesHardLimit - stats.realMemorySize;
-    const qint64 cloneSize = stats.projectionsSize;
-
-    return allowedMemory > 0 ? allowedMemory / cloneSize : 0;
-}
-
-}
 
 
 struct KisAsyncAnimationRenderDialogBase::Private
@@ -86,20 +50,17 @@ struct KisAsyncAnimationRenderDialogBase::Private
     int busyWait;
     bool isBatchMode = false;
 
-    std::vector<RendererPair> asyncRenderers;
-    bool memoryLimitReached = false;
+    QScopedPointer<KisAsyncAnimationMultiFrameRenderer> renderer;
 
     QElapsedTimer processingTime;
     QScopedPointer<QProgressDialog> progressDialog;
     QEventLoop waitLoop;
 
-    QList<int> stillDirtyFrames;
-    QList<int> framesInProgress;
     int dirtyFramesCount = 0;
     Result result = RenderComplete;
 
     int numDirtyFramesLeft() const {
-        return stillDirtyFrames.size() + framesInProgress.size();
+        return renderer->numFramesLeft();
     }
 
 };
@@ -107,6 +68,17 @@ struct KisAsyncAnimationRenderDialogBase::Private
 KisAsyncAnimationRenderDialogBase::KisAsyncAnimationRenderDialogBase(const QString &actionTitle, KisImageSP image, int busyWait)
     : m_d(new Private(actionTitle, image, busyWait))
 {
+    m_d->renderer.reset(
+        new KisAsyncAnimationMultiFrameRenderer(
+            [this] (KisImageSP image) {
+                return createRenderer(image);
+            },
+            [this] (KisAsyncAnimationRendererBase *renderer, KisImageSP image, int frame) {
+                initializeRendererForFrame(renderer, image, frame);
+            }));
+
+    connect(m_d->renderer.data(), SIGNAL(sigFrameCompleted(int)), SLOT(slotFrameCompleted(int)));
+    connect(m_d->renderer.data(), SIGNAL(sigFrameCancelled(int)), SLOT(slotFrameCancelled(int)));
 }
 
 KisAsyncAnimationRenderDialogBase::~KisAsyncAnimationRenderDialogBase()
@@ -140,10 +112,9 @@ KisAsyncAnimationRenderDialogBase::regenerateRange(KisViewManager *viewManager)
         }
     }
 
-    m_d->stillDirtyFrames = calcDirtyFrames();
-    m_d->framesInProgress.clear();
+    const QList<int> dirtyFrames = calcDirtyFrames();
     m_d->result = RenderComplete;
-    m_d->dirtyFramesCount = m_d->stillDirtyFrames.size();
+    m_d->dirtyFramesCount = dirtyFrames.size();
 
     if (!m_d->isBatchMode) {
         QWidget *parentWidget = viewManager ? viewManager->mainWindow() : 0;
@@ -159,36 +130,11 @@ KisAsyncAnimationRenderDialogBase::regenerateRange(KisViewManager *viewManager)
 
     m_d->processingTime.start();
 
-    KisImageConfig cfg;
-
-    const int maxThreads = cfg.maxNumberOfThreads();
-    const int numAllowedWorker = 1 + calculateNumberMemoryAllowedClones(m_d->image);
-    const int proposedNumWorkers = qMin(m_d->dirtyFramesCount, cfg.frameRenderingClones());
-    const int numWorkers = qMin(proposedNumWorkers, numAllowedWorker);
-    const int numThreadsPerWorker = qMax(1, qCeil(qreal(maxThreads) / numWorkers));
-
-    m_d->memoryLimitReached = numWorkers < proposedNumWorkers;
-
-    const int oldWorkingThreadsLimit = m_d->image->workingThreadsLimit();
-
-    ENTER_FUNCTION() << ppVar(numWorkers) << ppVar(numThreadsPerWorker);
-
-    for (int i = 0; i < numWorkers; i++) {
-        // reuse the image for one of the workers
-        KisImageSP image = i == numWorkers - 1 ? m_d->image : m_d->image->clone(true);
-
-        image->setWorkingThreadsLimit(numThreadsPerWorker);
-        KisAsyncAnimationRendererBase *renderer = createRenderer(image);
-
-        connect(renderer, SIGNAL(sigFrameCompleted(int)), SLOT(slotFrameCompleted(int)));
-        connect(renderer, SIGNAL(sigFrameCancelled(int)), SLOT(slotFrameCancelled(int)));
-
-        m_d->asyncRenderers.push_back(RendererPair(renderer, image));
-    }
+    m_d->renderer->startRendering(m_d->image, dirtyFrames);
 
+    ENTER_FUNCTION() << ppVar(m_d->renderer->numWorkers());
     ENTER_FUNCTION() << "Copying done in" << m_d->processingTime.elapsed();
 
-    tryInitiateFrameRegeneration();
     updateProgressLabel();
 
     if (m_d->numDirtyFramesLeft() > 0) {
@@ -197,17 +143,7 @@ KisAsyncAnimationRenderDialogBase::regenerateRange(KisViewManager *viewManager)
 
     ENTER_FUNCTION() << "Full regeneration done in" << m_d->processingTime.elapsed();
 
-    for (auto &pair : m_d->asyncRenderers) {
-        KIS_SAFE_ASSERT_RECOVER_NOOP(!pair.renderer->isActive());
-        if (viewManager) {
-            viewManager->blockUntilOperationsFinishedForced(pair.image);
-        } else {
-            pair.image->barrierLock(true);
-            pair.image->unlock();
-        }
-
-    }
-    m_d->asyncRenderers.clear();
+    m_d->renderer->releaseWorkers(viewManager);
 
     if (viewManager) {
         viewManager->blockUntilOperationsFinishedForced(m_d->image);
@@ -216,8 +152,6 @@ KisAsyncAnimationRenderDialogBase::regenerateRange(KisViewManager *viewManager)
         m_d->image->unlock();
     }
 
-    m_d->image->setWorkingThreadsLimit(oldWorkingThreadsLimit);
-
     m_d->progressDialog.reset();
 
     return m_d->result;
@@ -227,9 +161,6 @@ void KisAsyncAnimationRenderDialogBase::slotFrameCompleted(int frame)
 {
     Q_UNUSED(frame);
 
-    m_d->framesInProgress.removeOne(frame);
-
-    tryInitiateFrameRegeneration();
     updateProgressLabel();
 }
 
@@ -247,42 +178,12 @@ void KisAsyncAnimationRenderDialogBase::slotCancelRegeneration()
 
 void KisAsyncAnimationRenderDialogBase::cancelProcessingImpl(bool isUserCancelled)
 {
-    for (auto &pair : m_d->asyncRenderers) {
-        if (pair.renderer->isActive()) {
-            pair.renderer->cancelCurrentFrameRendering();
-        }
-        KIS_SAFE_ASSERT_RECOVER_NOOP(!pair.renderer->isActive());
-    }
+    m_d->renderer->cancelRendering();
 
-    m_d->stillDirtyFrames.clear();
-    m_d->framesInProgress.clear();
     m_d->result = isUserCancelled ? RenderCancelled : RenderFailed;
     updateProgressLabel();
 }
 
-
-void KisAsyncAnimationRenderDialogBase::tryInitiateFrameRegeneration()
-{
-    bool hadWorkOnPreviousCycle = false;
-
-    while (!m_d->stillDirtyFrames.isEmpty()) {
-        for (auto &pair : m_d->asyncRenderers) {
-            if (!pair.renderer->isActive()) {
-                const int currentDirtyFrame = m_d->stillDirtyFrames.takeFirst();
-
-                initializeRendererForFrame(pair.renderer.get(), pair.image, currentDirtyFrame);
-                pair.renderer->startFrameRegeneration(pair.image, currentDirtyFrame);
-                hadWorkOnPreviousCycle = true;
-                m_d->framesInProgress.append(currentDirtyFrame);
-                break;
-            }
-        }
-
-        if (!hadWorkOnPreviousCycle) break;
-        hadWorkOnPreviousCycle = false;
-    }
-}
-
 void KisAsyncAnimationRenderDialogBase::updateProgressLabel()
 {
     const int processedFramesCount = m_d->dirtyFramesCount - m_d->numDirtyFramesLeft();
@@ -302,14 +203,14 @@ void KisAsyncAnimationRenderDialogBase::updateProgressLabel()
 
     const QString memoryLimitMessage(
         i18n("\n\nMemory limit is reached!\nThe number of clones is limited to %1\n\n",
-             m_d->asyncRenderers.size()));
+             m_d->renderer->numWorkers()));
 
 
     const QString progressLabel(i18n("%1\n\nElapsed: %2\nEstimated: %3\n\n%4",
                                      m_d->actionTitle,
                                      elapsedTimeString,
                                      estimatedTimeString,
-                                     m_d->memoryLimitReached ? memoryLimitMessage : QString()));
+                                     m_d->renderer->memoryLimitReached() ? memoryLimitMessage : QString()));
     if (m_d->progressDialog) {
         m_d->progressDialog->setLabelText(progressLabel);
         m_d->progressDialog->setValue(processedFramesCount);
@@ -322,6 +223,11 @@ void KisAsyncAnimationRenderDialogBase::updateProgressLabel()
 
 
 
+void KisAsyncAnimationRenderDialogBase::setMaxFramesAhead(int value)
+{
+    m_d->renderer->setMaxFramesAhead(value);
+}
+
 void KisAsyncAnimationRenderDialogBase::setBatchMode(bool value)
 {
     m_d->isBatchMode = value;
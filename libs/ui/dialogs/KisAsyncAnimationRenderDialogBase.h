@@ -45,6 +45,7 @@ class KisViewManager;
  *      statistics server).
  *   - feed the images/threads with dirty frames until the all the frames
  *     are done
+ *   (all this is done by KisAsyncAnimationMultiFrameRenderer)
  *
  * Progress reporting:
  *   - if batchMode() is false, the user will see a progress dialog showing
@@ -107,7 +108,6 @@ private Q_SLOTS:
     void slotCancelRegeneration();
 
 private:
-    void tryInitiateFrameRegeneration();
     void updateProgressLabel();
     void cancelProcessingImpl(bool isUserCancelled);
 
@@ -132,6 +132,11 @@ protected:
     virtual void initializeRendererForFrame(KisAsyncAnimationRendererBase *renderer,
                                             KisImageSP image, int frame) = 0;
 
+    /**
+     * @see KisAsyncAnimationMultiFrameRenderer::setMaxFramesAhead()
+     */
+    void setMaxFramesAhead(int value);
+
 private:
     struct Private;
     const QScopedPointer<Private> m_d;
@@ -20,6 +20,8 @@
 
 #include <QPainter>
 #include <QMutexLocker>
+#include <QHash>
+#include <QtConcurrent>
 
 #include <KoShapeManager.h>
 #include <KoSelectedShapesProxySimple.h>
@@ -44,6 +46,8 @@
 #include <kis_spontaneous_job.h>
 #include "kis_image.h"
 #include "kis_global.h"
+#include "kis_algebra_2d.h"
+#include "krita_utils.h"
 
 //#define DEBUG_REPAINT
 
@@ -184,7 +188,9 @@ void KisShapeLayerCanvas::updateCanvas(const QVector<QRectF> &region)
      *
      * 2) If the layer is modified by a gui thread, it means that we are being accessed by
      *    a legacy vector tool. It this case just emit a queued signal to make sure the updates
-     *    are compressed a little bit (TODO: add a compressor?)
+     *    are compressed a little bit and repaint in the GUI thread. The tool modifies the
+     *    shapes in the GUI thread, so we cannot move the rasterization anywhere else
+     *    without racing with it.
      */
 
     if (qApp->thread() == QThread::currentThread()) {
@@ -223,22 +229,155 @@ void KisShapeLayerCanvas::slotImageSizeChanged()
     m_cachedImageRect = m_image->bounds();
 }
 
-void KisShapeLayerCanvas::repaint()
+namespace {
+
+/**
+ * Splits \p region into the tiles of the \p tileSize grid. Every tile is
+ * shrunk to the bounding rect of the part of \p region it covers, the
+ * tiles not touching the region are skipped.
+ */
+QVector<QRect> splitRegionIntoTiles(const QRegion &region, const QSize &tileSize)
 {
+    using KisAlgebra2D::divideFloor;
+
+    QVector<QRect> tiles;
+
+    const QRect bounds = region.boundingRect();
+
+    const int firstCol = divideFloor(bounds.left(), tileSize.width());
+    const int firstRow = divideFloor(bounds.top(), tileSize.height());
+    const int lastCol = divideFloor(bounds.right(), tileSize.width());
+    const int lastRow = divideFloor(bounds.bottom(), tileSize.height());
+
+    for (int row = firstRow; row <= lastRow; row++) {
+        for (int col = firstCol; col <= lastCol; col++) {
+            const QRect tileRect(col * tileSize.width(), row * tileSize.height(),
+                                 tileSize.width(), tileSize.height());
+
+            const QRegion dirtyPart = region & tileRect;
+            if (!dirtyPart.isEmpty()) {
+                tiles << dirtyPart.boundingRect();
+            }
+        }
+    }
+
+    return tiles;
+}
+
+/**
+ * Groups the indexes of \p jobs so that the jobs sharing at least one shape
+ * end up in the same group. Different groups don't have any common shapes,
+ * so they can be painted concurrently.
+ */
+QVector<QVector<int>> groupJobsBySharedShapes(const QVector<KoShapeManager::PaintJob> &jobs)
+{
+    QVector<int> parents(jobs.size());
+    for (int i = 0; i < parents.size(); i++) {
+        parents[i] = i;
+    }
+
+    auto findRoot = [&parents] (int i) {
+        while (parents[i] != i) {
+            parents[i] = parents[parents[i]];
+            i = parents[i];
+        }
+        return i;
+    };
+
+    QHash<KoShape*, int> shapeOwners;
+
+    for (int i = 0; i < jobs.size(); i++) {
+        Q_FOREACH (KoShape *shape, jobs[i].shapes) {
+            auto it = shapeOwners.find(shape);
+            if (it == shapeOwners.end()) {
+                shapeOwners.insert(shape, i);
+            } else {
+                parents[findRoot(i)] = findRoot(it.value());
+            }
+        }
+    }
+
+    QVector<QVector<int>> groups;
+    QHash<int, int> groupForRoot;
+
+    for (int i = 0; i < jobs.size(); i++) {
+        const int root = findRoot(i);
+
+        auto it = groupForRoot.find(root);
+        if (it == groupForRoot.end()) {
+            it = groupForRoot.insert(root, groups.size());
+            groups.append(QVector<int>());
+        }
+
+        groups[it.value()].append(i);
+    }
+
+    return groups;
+}
 
-    QRect r;
+}
+
+void KisShapeLayerCanvas::repaint()
+{
+    QRegion dirtyRegion;
 
     {
         QMutexLocker locker(&m_dirtyRegionMutex);
-        r = m_dirtyRegion.boundingRect();
+        dirtyRegion = m_dirtyRegion;
         m_dirtyRegion = QRegion();
     }
 
-    if (r.isEmpty()) return;
-
-    // Crop the update rect by the image bounds. We keep the cache consistent
+    // Crop the update region by the image bounds. We keep the cache consistent
     // by tracking the size of the image in slotImageSizeChanged()
-    r = r.intersected(m_parentLayer->image()->bounds());
+    dirtyRegion &= m_parentLayer->image()->bounds();
+
+    if (dirtyRegion.isEmpty()) return;
+
+    /**
+     * Only the tiles touched by the dirty region are rerendered, so two
+     * small updates in the opposite corners of the layer don't cause the
+     * whole layer to be repainted.
+     */
+    const QVector<QRect> tiles =
+        splitRegionIntoTiles(dirtyRegion, KritaUtils::optimalPatchSize());
+
+    QVector<KoShapeManager::PaintJob> jobs;
+    Q_FOREACH (const QRect &rc, tiles) {
+        jobs << KoShapeManager::PaintJob(m_viewConverter->viewToDocument(QRectF(rc)), rc);
+    }
+
+    m_shapeManager->preparePaintJobs(jobs);
+
+    /**
+     * The shapes are not modified while we are here: the GUI thread is
+     * either blocked until all the tiles are rendered or the repaint is
+     * executed by an exclusive spontaneous job. The shapes are not
+     * thread-safe though, so the tiles sharing a shape are rendered
+     * sequentially in the same thread, and only the independent groups
+     * of tiles are rendered concurrently.
+     */
+    const QVector<QVector<int>> groups = groupJobsBySharedShapes(jobs);
+
+    QtConcurrent::blockingMap(groups,
+        [this, &jobs] (const QVector<int> &group) {
+            Q_FOREACH (int index, group) {
+                paintJob(jobs[index]);
+            }
+        });
+
+    m_parentLayer->setDirty(tiles);
+}
+
+void KisShapeLayerCanvas::paintJob(const KoShapeManager::PaintJob &job)
+{
+    const QRect &r = job.viewUpdateRect;
+
+#ifndef DEBUG_REPAINT
+    if (job.shapes.isEmpty()) {
+        m_projection->clear(r);
+        return;
+    }
+#endif
 
     QImage image(r.width(), r.height(), QImage::Format_ARGB32);
     image.fill(0);
@@ -253,15 +392,11 @@ void KisShapeLayerCanvas::repaint()
     p.fillRect(r, color);
 #endif
 
-    m_shapeManager->paint(p, *m_viewConverter, false);
+    m_shapeManager->paintJob(p, *m_viewConverter, job);
     p.end();
 
-    KisPaintDeviceSP dev = new KisPaintDevice(m_projection->colorSpace());
-    dev->convertFromQImage(image, 0);
-
-    KisPainter::copyAreaOptimized(r.topLeft(), dev, m_projection, QRect(QPoint(), r.size()));
-
-    m_parentLayer->setDirty(r);
+    // the tiles don't overlap, so they can be written into the projection concurrently
+    m_projection->convertFromQImage(image, 0, r.x(), r.y());
 }
 
 KoToolProxy * KisShapeLayerCanvas::toolProxy() const
@@ -21,11 +21,11 @@
 #include <QMutex>
 #include <QRegion>
 #include <KoCanvasBase.h>
+#include <KoShapeManager.h>
 
 #include <kis_types.h>
 #include "kis_thread_safe_signal_compressor.h"
 
-class KoShapeManager;
 class KoToolProxy;
 class KoViewConverter;
 class KUndo2Command;
@@ -81,6 +81,10 @@ private Q_SLOTS:
     void slotImageSizeChanged();
 Q_SIGNALS:
     void forwardRepaint();
+private:
+    /// Renders the shapes of \p job straight into the projection
+    void paintJob(const KoShapeManager::PaintJob &job);
+
 private:
 
     bool m_isDestroying;
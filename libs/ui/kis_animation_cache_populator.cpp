@@ -41,6 +41,7 @@
 #include "kis_keyframe_channel.h"
 
 #include "KisAsyncAnimationCacheRenderer.h"
+#include "KisAsyncAnimationMultiFrameRenderer.h"
 #include "dialogs/KisAsyncAnimationCacheRenderDialog.h"
 
 
@@ -66,7 +67,18 @@ struct KisAnimationCachePopulator::Private
 
     QFutureWatcher<void> infoConversionWatcher;
 
-    KisAsyncAnimationCacheRenderer regenerator;
+    /**
+     * The image the regenerator keeps its workers for
+     */
+    KisImageWSP workersImage;
+
+    /**
+     * Renders the dirty frames on several clones of the image. The
+     * clones are created lazily on the first request and are kept
+     * across the idle cycles until the image is changed or closed,
+     * so they are not recreated on the GUI thread for every batch.
+     */
+    KisAsyncAnimationMultiFrameRenderer regenerator;
     bool calculateAnimationCacheInBackground = true;
 
 
@@ -84,9 +96,34 @@ struct KisAnimationCachePopulator::Private
           part(_part),
           idleCounter(0),
           requestedFrame(-1),
+          regenerator(
+              [] (KisImageSP image) {
+                  Q_UNUSED(image);
+                  return new KisAsyncAnimationCacheRenderer();
+              },
+              [this] (KisAsyncAnimationRendererBase *renderer, KisImageSP image, int frame) {
+                  Q_UNUSED(image);
+                  Q_UNUSED(frame);
+
+                  KisAsyncAnimationCacheRenderer *cacheRenderer =
+                      dynamic_cast<KisAsyncAnimationCacheRenderer*>(renderer);
+                  KIS_SAFE_ASSERT_RECOVER_RETURN(cacheRenderer);
+
+                  cacheRenderer->setFrameCache(requestCache);
+              }),
           state(WaitingForIdle)
     {
         timer.setSingleShot(true);
+        regenerator.setKeepWorkers(true);
+    }
+
+    void releaseRegenerator() {
+        if (regenerator.isActive()) return;
+
+        imageRequestConnections.clear();
+        regenerator.releaseWorkers();
+        requestCache.clear();
+        workersImage.clear();
     }
 
     void timerTimeout() {
@@ -179,18 +216,33 @@ struct KisAnimationCachePopulator::Private
         KisImageAnimationInterface *animation = image->animationInterface();
         KisTimeRange currentRange = animation->fullClipRange();
 
-        const int frame = KisAsyncAnimationCacheRenderDialog::calcFirstDirtyFrame(cache, currentRange, skipRange);
+        QList<int> frames = KisAsyncAnimationCacheRenderDialog::calcDirtyFramesList(cache, currentRange, skipRange);
 
-        if (frame >= 0) {
-            return regenerate(cache, frame);
+        /**
+         * Don't render more frames than the cache can keep, the rest
+         * would only evict each other. The size of a frame is estimated
+         * by the frames already stored.
+         */
+        const KisAnimationFrameCache::Statistics stats = cache->statistics();
+        if (!frames.isEmpty() && stats.numFrames > 0) {
+            const qint64 frameSize = qMax(qint64(1), stats.storedSize / stats.numFrames);
+            const qint64 numFramesFit = (cache->memoryLimit() - stats.storedSize) / frameSize;
+
+            if (numFramesFit < frames.size()) {
+                frames = frames.mid(0, int(qMax(qint64(0), numFramesFit)));
+            }
+        }
+
+        if (!frames.isEmpty()) {
+            return regenerate(cache, frames);
         }
 
         return false;
     }
 
-    bool regenerate(KisAnimationFrameCacheSP cache, int frame)
+    bool regenerate(KisAnimationFrameCacheSP cache, const QList<int> &frames)
     {
-        if (state == WaitingForFrame) {
+        if (state == WaitingForFrame || regenerator.isActive()) {
             // Already busy, deny request
             return false;
         }
@@ -202,8 +254,33 @@ struct KisAnimationCachePopulator::Private
          */
         enterState(WaitingForFrame);
 
-        regenerator.setFrameCache(cache);
-        regenerator.startFrameRegeneration(cache->image(), frame);
+        requestCache = cache;
+
+        KisImageSP image = cache->image();
+
+        /**
+         * The rendering should be stopped as soon as the image is
+         * changed and restarted later. The clones become outdated
+         * at that moment, so they are released as well. They also
+         * must not outlive the document, which expects its image
+         * to be destroyed when it is closed.
+         */
+        if (workersImage != image) {
+            imageRequestConnections.clear();
+            imageRequestConnections.addConnection(
+                image->animationInterface(), SIGNAL(sigFramesChanged(KisTimeRange,QRect)),
+                q, SLOT(slotImageChanged()));
+            imageRequestConnections.addConnection(
+                image, SIGNAL(sigImageModified()),
+                q, SLOT(slotImageChanged()));
+            imageRequestConnections.addConnection(
+                image, SIGNAL(sigAboutToBeDeleted()),
+                q, SLOT(slotImageChanged()));
+
+            workersImage = image;
+        }
+
+        regenerator.startRendering(image, frames);
 
         return true;
     }
@@ -268,7 +345,7 @@ KisAnimationCachePopulator::KisAnimationCachePopulator(KisPart *part)
     connect(&m_d->timer, SIGNAL(timeout()), this, SLOT(slotTimer()));
 
     connect(&m_d->regenerator, SIGNAL(sigFrameCancelled(int)), SLOT(slotRegeneratorFrameCancelled()));
-    connect(&m_d->regenerator, SIGNAL(sigFrameCompleted(int)), SLOT(slotRegeneratorFrameReady()));
+    connect(&m_d->regenerator, SIGNAL(sigRenderingFinished()), SLOT(slotRegeneratorFinished()));
 
     connect(KisConfigNotifier::instance(), SIGNAL(configChanged()), SLOT(slotConfigChanged()));
     slotConfigChanged();
@@ -279,7 +356,7 @@ KisAnimationCachePopulator::~KisAnimationCachePopulator()
 
 bool KisAnimationCachePopulator::regenerate(KisAnimationFrameCacheSP cache, int frame)
 {
-    return m_d->regenerate(cache, frame);
+    return m_d->regenerate(cache, QList<int>() << frame);
 }
 
 void KisAnimationCachePopulator::slotTimer()
@@ -297,15 +374,31 @@ void KisAnimationCachePopulator::slotRequestRegeneration()
 
 void KisAnimationCachePopulator::slotRegeneratorFrameCancelled()
 {
-    KIS_ASSERT_RECOVER_RETURN(m_d->state == Private::WaitingForFrame);
+    if (m_d->state != Private::WaitingForFrame) return;
     m_d->enterState(Private::NotWaitingForAnything);
 }
 
-void KisAnimationCachePopulator::slotRegeneratorFrameReady()
+void KisAnimationCachePopulator::slotRegeneratorFinished()
 {
+    /**
+     * The workers are kept for the next idle cycle, they are
+     * released only when the image is changed
+     */
+    m_d->requestCache.clear();
+
+    if (m_d->state != Private::WaitingForFrame) return;
     m_d->enterState(Private::BetweenFrames);
 }
 
+void KisAnimationCachePopulator::slotImageChanged()
+{
+    if (m_d->regenerator.isActive()) {
+        m_d->regenerator.cancelRendering();
+    }
+
+    m_d->releaseRegenerator();
+}
+
 void KisAnimationCachePopulator::slotConfigChanged()
 {
     KisConfig cfg;
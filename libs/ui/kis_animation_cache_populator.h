@@ -46,7 +46,9 @@ private Q_SLOTS:
     void slotTimer();
 
     void slotRegeneratorFrameCancelled();
-    void slotRegeneratorFrameReady();
+    void slotRegeneratorFinished();
+
+    void slotImageChanged();
 
     void slotConfigChanged();
 
@@ -19,24 +19,133 @@
 #include "kis_animation_frame_cache.h"
 
 #include <QMap>
+#include <QSet>
+#include <QMultiHash>
+#include <QSharedPointer>
+#include <QtConcurrent>
 
 #include "kis_debug.h"
 
 #include "kis_image.h"
 #include "kis_image_animation_interface.h"
+#include "kis_image_config.h"
 #include "kis_time_range.h"
 #include "KisPart.h"
 #include "kis_animation_cache_populator.h"
 
 #include "opengl/kis_opengl_image_textures.h"
+#include "opengl/kis_texture_tile_update_info.h"
+
+#include "tiles3/swap/kis_abstract_compression.h"
+#include "tiles3/swap/kis_compression_factory.h"
+
+
+namespace {
+
+/**
+ * Pixel data of a single texture tile of a cached frame. The color
+ * channels are linearized before compression, which gives a much
+ * better ratio. Equal tiles of different frames share one object.
+ */
+struct CompressedTile
+{
+    QByteArray data;
+    int rawSize;
+    int pixelSize;
+    uint hash;
+    bool isCompressed;
+};
+
+typedef QSharedPointer<CompressedTile> CompressedTileSP;
+typedef QWeakPointer<CompressedTile> CompressedTileWSP;
+
+CompressedTileSP compressTile(quint8 *src, int size, int pixelSize, uint hash,
+                              KisAbstractCompression *compression)
+{
+    CompressedTileSP tile(new CompressedTile());
+    tile->rawSize = size;
+    tile->pixelSize = pixelSize;
+    tile->hash = hash;
+
+    QByteArray linearized(size, Qt::Uninitialized);
+    KisAbstractCompression::linearizeColors(src, reinterpret_cast<quint8*>(linearized.data()),
+                                            size, pixelSize);
+
+    QByteArray buffer(compression->outputBufferSize(size), Qt::Uninitialized);
+    const qint32 compressedSize =
+        compression->compress(reinterpret_cast<const quint8*>(linearized.constData()), size,
+                              reinterpret_cast<quint8*>(buffer.data()), buffer.size());
+
+    if (compressedSize > 0 && compressedSize < size) {
+        buffer.resize(compressedSize);
+        buffer.squeeze();
+
+        tile->data = buffer;
+        tile->isCompressed = true;
+    } else {
+        tile->data = QByteArray(reinterpret_cast<const char*>(src), size);
+        tile->isCompressed = false;
+    }
+
+    return tile;
+}
+
+bool decompressTile(const CompressedTile &tile, quint8 *dst,
+                    KisAbstractCompression *compression)
+{
+    if (!tile.isCompressed) {
+        memcpy(dst, tile.data.constData(), tile.rawSize);
+        return true;
+    }
+
+    QByteArray linearized(tile.rawSize, Qt::Uninitialized);
+
+    const qint32 bytesWritten =
+        compression->decompress(reinterpret_cast<const quint8*>(tile.data.constData()), tile.data.size(),
+                                reinterpret_cast<quint8*>(linearized.data()), tile.rawSize);
+
+    if (bytesWritten != tile.rawSize) return false;
+
+    KisAbstractCompression::delinearizeColors(reinterpret_cast<quint8*>(linearized.data()), dst,
+                                              tile.rawSize, tile.pixelSize);
+    return true;
+}
+
+bool tileDataEquals(const CompressedTile &tile, const quint8 *data, int size, int pixelSize,
+                    KisAbstractCompression *compression)
+{
+    if (tile.rawSize != size || tile.pixelSize != pixelSize) return false;
+
+    QByteArray storedData(size, Qt::Uninitialized);
+    quint8 *storedPtr = reinterpret_cast<quint8*>(storedData.data());
+
+    return decompressTile(tile, storedPtr, compression) &&
+        !memcmp(storedPtr, data, size);
+}
+
+}
 
 
 struct KisAnimationFrameCache::Private
 {
     Private(KisOpenGLImageTexturesSP _textures)
-        : textures(_textures)
+        : textures(_textures),
+          storedSize(0),
+          accessCounter(0)
     {
         image = textures->image();
+
+        KisImageConfig cfg(true);
+        memoryLimit = qint64(cfg.frameCacheMemoryLimit()) * 1024 * 1024;
+
+        /**
+         * The data never leaves the memory, so we use the fastest
+         * codec the swap uses as well
+         */
+        compressionName = cfg.swapTileCompression();
+        if (!KisCompressionFactory::isAvailable(compressionName)) {
+            compressionName = KisCompressionFactory::defaultCompression();
+        }
     }
 
     ~Private()
@@ -47,18 +156,69 @@ struct KisAnimationFrameCache::Private
     KisOpenGLImageTexturesSP textures;
     KisImageWSP image;
 
-    struct Frame
+    /**
+     * A converted frame. It is shared by all the entries of the
+     * frames map that show this frame. The tiles of the update
+     * info keep only the geometry, their pixels are stored in
+     * the compressed tiles and restored on every upload.
+     */
+    struct FrameData
     {
         KisOpenGLUpdateInfoSP openGlFrame;
+        QVector<CompressedTileSP> tiles;
+        qint64 uncompressedSize;
+        quint64 lastAccess;
+    };
+
+    typedef QSharedPointer<FrameData> FrameDataSP;
+
+    struct Frame
+    {
+        FrameDataSP data;
         int length;
 
-        Frame(KisOpenGLUpdateInfoSP info, int length)
-            : openGlFrame(info), length(length)
+        Frame(FrameDataSP data, int length)
+            : data(data), length(length)
         {}
     };
 
     QMap<int, Frame*> frames;
 
+    /**
+     * The frames dropped to fit into the memory limit, in the same
+     * format as the frames map: start -> length (-1 means infinite).
+     * The background populator doesn't regenerate them, otherwise a
+     * clip bigger than the limit would be rendered and evicted in an
+     * endless loop. The record is dropped when the frame is changed or
+     * stored again.
+     */
+    QMap<int, int> evictedFrames;
+
+    struct StoredTile
+    {
+        StoredTile() : size(0) {}
+        StoredTile(CompressedTileSP tile)
+            : tile(tile), size(tile->data.size())
+        {}
+
+        CompressedTileWSP tile;
+        int size;
+    };
+
+    /**
+     * All the distinct tiles of the cached frames, hashed by their
+     * uncompressed content. The entries of the tiles that are not
+     * used by any frame anymore are removed by purgeStoredTiles()
+     */
+    QMultiHash<uint, StoredTile> storedTiles;
+    qint64 storedSize;
+
+    qint64 memoryLimit;
+    QString compressionName;
+
+    quint64 accessCounter;
+    KisAnimationFrameCache::Statistics statistics;
+
     Frame *getFrame(int time)
     {
         if (frames.isEmpty()) return 0;
@@ -81,12 +241,40 @@ struct KisAnimationFrameCache::Private
         return 0;
     }
 
-    void addFrame(KisOpenGLUpdateInfoSP info, const KisTimeRange& range)
+    bool isEvicted(int time) const
+    {
+        QMap<int, int>::const_iterator it = evictedFrames.upperBound(time);
+        if (it == evictedFrames.constBegin()) return false;
+
+        --it;
+        return it.value() == -1 || time <= it.key() + it.value() - 1;
+    }
+
+    void forgetEvictedFrames(const KisTimeRange &range)
+    {
+        QMap<int, int>::iterator it = evictedFrames.begin();
+        while (it != evictedFrames.end()) {
+            KisTimeRange evictedRange =
+                it.value() == -1 ?
+                KisTimeRange::infinite(it.key()) :
+                KisTimeRange(it.key(), it.value());
+
+            evictedRange &= range;
+
+            if (evictedRange.isValid()) {
+                it = evictedFrames.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    void addFrame(FrameDataSP data, const KisTimeRange& range)
     {
         invalidate(range);
 
         int length = range.isInfinite() ? -1 : range.end() - range.start() + 1;
-        Frame *frame = new Frame(info, length);
+        Frame *frame = new Frame(data, length);
 
         frames.insert(range.start(), frame);
     }
@@ -98,6 +286,8 @@ struct KisAnimationFrameCache::Private
      */
     bool invalidate(const KisTimeRange& range)
     {
+        forgetEvictedFrames(range);
+
         if (frames.isEmpty()) return false;
 
         bool cacheChanged = false;
@@ -121,7 +311,7 @@ struct KisAnimationFrameCache::Private
                     // Reinsert with a later start
                     int newStart = range.end() + 1;
                     int newLength = frameIsInfinite ? -1 : (end - newStart + 1);
-                    frames.insert(newStart, new Frame(frame->openGlFrame, newLength));
+                    frames.insert(newStart, new Frame(frame->data, newLength));
                 }
 
                 it = frames.erase(it);
@@ -140,6 +330,202 @@ struct KisAnimationFrameCache::Private
             it++;
         }
 
+        if (cacheChanged) {
+            purgeStoredTiles();
+        }
+
+        return cacheChanged;
+    }
+
+    void purgeStoredTiles()
+    {
+        QMultiHash<uint, StoredTile>::iterator it = storedTiles.begin();
+        while (it != storedTiles.end()) {
+            if (it->tile.isNull()) {
+                storedSize -= it->size;
+                it = storedTiles.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    /**
+     * Compresses the tiles of @info in parallel and frees their
+     * uncompressed pixels. The tiles equal to the ones of the
+     * frames stored earlier are not stored the second time.
+     */
+    FrameDataSP storeFrameData(KisOpenGLUpdateInfoSP info)
+    {
+        FrameDataSP data(new FrameData());
+        data->openGlFrame = info;
+        data->uncompressedSize = 0;
+        data->lastAccess = ++accessCounter;
+
+        const KisTextureTileUpdateInfoSPList &tileList = info->tileList;
+        data->tiles.resize(tileList.size());
+
+        QVector<int> tileIndexes;
+        for (int i = 0; i < tileList.size(); i++) {
+            if (tileList[i]->valid() && tileList[i]->data()) {
+                tileIndexes << i;
+                data->uncompressedSize += tileList[i]->patchDataSize();
+            }
+        }
+
+        QVector<bool> isNewTile(tileList.size(), false);
+
+        // write into the preallocated vectors without detaching them
+        CompressedTileSP *resultTiles = data->tiles.data();
+        bool *resultIsNew = isNewTile.data();
+
+        const QMultiHash<uint, StoredTile> &knownTiles = storedTiles;
+        const QString compressionName = this->compressionName;
+
+        QtConcurrent::blockingMap(tileIndexes,
+            [&tileList, &knownTiles, resultTiles, resultIsNew, compressionName] (int index) {
+                KisTextureTileUpdateInfoSP tileInfo = tileList.at(index);
+                QScopedPointer<KisAbstractCompression> compression(
+                    KisCompressionFactory::create(compressionName));
+
+                const int size = tileInfo->patchDataSize();
+                const int pixelSize = tileInfo->pixelSize();
+                const uint hash = qHashBits(tileInfo->data(), size);
+
+                QMultiHash<uint, StoredTile>::const_iterator it = knownTiles.constFind(hash);
+                for (; it != knownTiles.constEnd() && it.key() == hash; ++it) {
+                    CompressedTileSP candidate = it->tile.toStrongRef();
+
+                    if (candidate &&
+                        tileDataEquals(*candidate, tileInfo->data(), size, pixelSize,
+                                       compression.data())) {
+
+                        resultTiles[index] = candidate;
+                        return;
+                    }
+                }
+
+                resultTiles[index] = compressTile(tileInfo->data(), size, pixelSize,
+                                                  hash, compression.data());
+                resultIsNew[index] = true;
+            });
+
+        Q_FOREACH (int index, tileIndexes) {
+            if (isNewTile[index]) {
+                const CompressedTileSP &tile = data->tiles[index];
+
+                storedTiles.insert(tile->hash, StoredTile(tile));
+                storedSize += tile->data.size();
+            }
+
+            tileList[index]->releasePixelData();
+        }
+
+        return data;
+    }
+
+    void loadFrameData(FrameDataSP data)
+    {
+        const KisTextureTileUpdateInfoSPList &tileList = data->openGlFrame->tileList;
+        const QVector<CompressedTileSP> &tiles = data->tiles;
+
+        QVector<int> tileIndexes;
+        for (int i = 0; i < tiles.size(); i++) {
+            if (tiles[i]) {
+                tileList[i]->allocatePixelData();
+                tileIndexes << i;
+            }
+        }
+
+        const QString compressionName = this->compressionName;
+
+        QtConcurrent::blockingMap(tileIndexes,
+            [&tileList, &tiles, compressionName] (int index) {
+                QScopedPointer<KisAbstractCompression> compression(
+                    KisCompressionFactory::create(compressionName));
+
+                const bool result =
+                    decompressTile(*tiles.at(index), tileList.at(index)->data(),
+                                   compression.data());
+
+                KIS_SAFE_ASSERT_RECOVER_NOOP(result);
+            });
+    }
+
+    void releaseFrameData(FrameDataSP data)
+    {
+        Q_FOREACH (KisTextureTileUpdateInfoSP tileInfo, data->openGlFrame->tileList) {
+            tileInfo->releasePixelData();
+        }
+    }
+
+    void evictFrameData(FrameDataSP data)
+    {
+        QMap<int, Frame*>::iterator it = frames.begin();
+        while (it != frames.end()) {
+            if (it.value()->data == data) {
+                evictedFrames.insert(it.key(), it.value()->length);
+                delete it.value();
+                it = frames.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    /**
+     * Drops the least recently used frames until the cache fits into
+     * the memory limit. The frames that are going to be shown right
+     * after the playhead, as well as @keepData, are never dropped.
+     */
+    bool evictFrames(FrameDataSP keepData)
+    {
+        if (storedSize <= memoryLimit) return false;
+
+        KisImageAnimationInterface *animation = image->animationInterface();
+        const int playhead = animation->currentUITime();
+        const int lookAhead = qMax(1, animation->framerate());
+
+        bool cacheChanged = false;
+
+        while (storedSize > memoryLimit) {
+            QSet<FrameData*> protectedData;
+            protectedData.insert(keepData.data());
+
+            QMap<int, Frame*>::const_iterator it;
+
+            for (it = frames.constBegin(); it != frames.constEnd(); ++it) {
+                const int start = it.key();
+                const int length = it.value()->length;
+
+                if (start <= playhead + lookAhead &&
+                    (length == -1 || start + length - 1 >= playhead)) {
+
+                    protectedData.insert(it.value()->data.data());
+                }
+            }
+
+            FrameDataSP victim;
+
+            for (it = frames.constBegin(); it != frames.constEnd(); ++it) {
+                const FrameDataSP &data = it.value()->data;
+                if (protectedData.contains(data.data())) continue;
+
+                if (!victim || data->lastAccess < victim->lastAccess) {
+                    victim = data;
+                }
+            }
+
+            if (!victim) break;
+
+            evictFrameData(victim);
+            victim.clear();
+            purgeStoredTiles();
+
+            statistics.evictions++;
+            cacheChanged = true;
+        }
+
         return cacheChanged;
     }
 
@@ -186,18 +572,36 @@ bool KisAnimationFrameCache::uploadFrame(int time)
     Private::Frame *frame = m_d->getFrame(time);
 
     if (!frame) {
+        m_d->statistics.misses++;
         KisPart::instance()->cachePopulator()->regenerate(this, time);
     } else {
-        m_d->textures->recalculateCache(frame->openGlFrame);
+        m_d->statistics.hits++;
+        frame->data->lastAccess = ++m_d->accessCounter;
+
+        m_d->loadFrameData(frame->data);
+        m_d->textures->recalculateCache(frame->data->openGlFrame);
+        m_d->releaseFrameData(frame->data);
     }
 
     return frame != 0;
 }
 
+bool KisAnimationFrameCache::testingLoadFrame(int time, std::function<void (KisOpenGLUpdateInfoSP)> func)
+{
+    Private::Frame *frame = m_d->getFrame(time);
+    if (!frame) return false;
+
+    m_d->loadFrameData(frame->data);
+    func(frame->data->openGlFrame);
+    m_d->releaseFrameData(frame->data);
+
+    return true;
+}
+
 KisAnimationFrameCache::CacheStatus KisAnimationFrameCache::frameStatus(int time) const
 {
     Private::Frame *frame = m_d->getFrame(time);
-    return (frame) ? Cached : Uncached;
+    return frame ? Cached : m_d->isEvicted(time) ? Evicted : Uncached;
 }
 
 KisImageWSP KisAnimationFrameCache::image()
@@ -233,7 +637,51 @@ void KisAnimationFrameCache::addConvertedFrameData(KisOpenGLUpdateInfoSP info, i
     KisTimeRange identicalRange = KisTimeRange::infinite(0);
     KisTimeRange::calculateTimeRangeRecursive(m_d->image->root(), time, identicalRange, true);
 
-    m_d->addFrame(info, identicalRange);
+    Private::FrameDataSP data = m_d->storeFrameData(info);
+    m_d->addFrame(data, identicalRange);
+    m_d->evictFrames(data);
 
     emit changed();
 }
+
+void KisAnimationFrameCache::setMemoryLimit(qint64 bytes)
+{
+    // the evicted frames might fit into the new limit
+    if (bytes > m_d->memoryLimit) {
+        m_d->evictedFrames.clear();
+    }
+
+    m_d->memoryLimit = bytes;
+
+    if (m_d->evictFrames(Private::FrameDataSP())) {
+        emit changed();
+    }
+}
+
+qint64 KisAnimationFrameCache::memoryLimit() const
+{
+    return m_d->memoryLimit;
+}
+
+KisAnimationFrameCache::Statistics KisAnimationFrameCache::statistics() const
+{
+    Statistics stats = m_d->statistics;
+
+    QSet<Private::FrameData*> countedFrames;
+    Q_FOREACH (Private::Frame *frame, m_d->frames) {
+        if (countedFrames.contains(frame->data.data())) continue;
+
+        countedFrames.insert(frame->data.data());
+        stats.uncompressedSize += frame->data->uncompressedSize;
+    }
+
+    stats.numFrames = countedFrames.size();
+    stats.storedSize = m_d->storedSize;
+
+    return stats;
+}
+
+void KisAnimationFrameCache::resetStatistics()
+{
+    m_d->statistics = Statistics();
+}
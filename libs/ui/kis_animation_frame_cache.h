@@ -22,6 +22,8 @@
 #include <QImage>
 #include <QObject>
 
+#include <functional>
+
 #include "kritaui_export.h"
 #include "kis_types.h"
 #include "kis_shared.h"
@@ -54,6 +56,7 @@ public:
     enum CacheStatus {
         Cached,
         Uncached,
+        Evicted ///< the frame has been dropped to fit into the memory limit
     };
 
     CacheStatus frameStatus(int time) const;
@@ -63,6 +66,43 @@ public:
     KisOpenGLUpdateInfoSP fetchFrameData(int time, KisImageSP image) const;
     void addConvertedFrameData(KisOpenGLUpdateInfoSP info, int time);
 
+    /**
+     * The frames are kept compressed and the tiles that are equal to
+     * the tiles of other cached frames are stored only once. When the
+     * stored data exceeds the limit, the least recently used frames are
+     * dropped from the cache, except the ones right after the playhead.
+     * The default limit is KisImageConfig::frameCacheMemoryLimit().
+     */
+    void setMemoryLimit(qint64 bytes);
+    qint64 memoryLimit() const;
+
+    struct Statistics {
+        Statistics()
+            : hits(0), misses(0), evictions(0),
+              numFrames(0), uncompressedSize(0), storedSize(0)
+        {
+        }
+
+        int hits; ///< uploadFrame() calls that found the frame in the cache
+        int misses; ///< uploadFrame() calls that had to regenerate the frame
+        int evictions; ///< frames dropped to fit into the memory limit
+
+        int numFrames; ///< distinct frames currently in the cache
+        qint64 uncompressedSize; ///< size of the cached frames before compression
+        qint64 storedSize; ///< memory actually used by the cached frames
+    };
+
+    Statistics statistics() const;
+    void resetStatistics();
+
+    /**
+     * Decompresses the cached frame at \p time and passes it to \p func
+     * instead of uploading it to the textures. The pixel data of the
+     * tiles is valid only until \p func returns.
+     * @return false if the frame is not cached
+     */
+    bool testingLoadFrame(int time, std::function<void (KisOpenGLUpdateInfoSP)> func);
+
 Q_SIGNALS:
     void changed();
 
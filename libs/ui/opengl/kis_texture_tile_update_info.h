@@ -303,6 +303,34 @@ public:
         return m_patchRect.isValid();
     }
 
+    /**
+     * The number of bytes of the patch data actually used by the
+     * pixels, which may be smaller than patchPixelsLength()
+     */
+    inline quint32 patchDataSize() const {
+        return m_patchRect.width() * m_patchRect.height() * pixelSize();
+    }
+
+    /**
+     * Frees the pixel data of the patch, keeping its geometry and
+     * color space. Used by the animation frame cache that keeps
+     * the pixels compressed between the uploads.
+     */
+    void releasePixelData() {
+        DataBuffer emptyBuffer(m_pool);
+        m_patchPixels.swap(emptyBuffer);
+    }
+
+    /**
+     * Allocates the pixel data of the patch again after
+     * releasePixelData() has been called
+     */
+    void allocatePixelData() {
+        if (!m_patchPixels.data()) {
+            m_patchPixels.allocate(pixelSize());
+        }
+    }
+
 private:
     Q_DISABLE_COPY(KisTextureTileUpdateInfo)
 
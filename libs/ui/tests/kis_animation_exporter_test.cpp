@@ -19,6 +19,8 @@
 #include "kis_animation_exporter_test.h"
 
 #include "dialogs/KisAsyncAnimationFramesSaveDialog.h"
+#include "dialogs/KisAsyncAnimationFramesStreamDialog.h"
+#include "KisAnimationFrameSink.h"
 
 #include <QTest>
 #include <testutil.h>
@@ -90,4 +92,66 @@ void KisAnimationExporterTest::testAnimationExport()
     QCOMPARE(exported, frame2);
 }
 
+struct TestingFrameSink : public KisAnimationFrameSink
+{
+    bool writeFrame(int frame, const QImage &image) override {
+        frames << frame;
+        images << image;
+        return true;
+    }
+
+    QList<int> frames;
+    QList<QImage> images;
+};
+
+void KisAnimationExporterTest::testAnimationStreaming()
+{
+    KisDocument *document = KisPart::instance()->createDocument();
+    QRect rect(0,0,512,512);
+    QRect fillRect(10,0,502,512);
+    TestUtil::MaskParent p(rect);
+    document->setCurrentImage(p.image);
+    const KoColorSpace *cs = p.image->colorSpace();
+
+    KUndo2Command parentCommand;
+
+    p.layer->enableAnimation();
+    KisKeyframeChannel *rasterChannel = p.layer->getKeyframeChannel(KisKeyframeChannel::Content.id(), true);
+
+    rasterChannel->addKeyframe(1, &parentCommand);
+    rasterChannel->addKeyframe(2, &parentCommand);
+    p.image->animationInterface()->setFullClipRange(KisTimeRange::fromTime(0, 2));
+
+    KisPaintDeviceSP dev = p.layer->paintDevice();
+
+    dev->fill(fillRect, KoColor(Qt::red, cs));
+    QImage frame0 = dev->convertToQImage(0, rect).convertToFormat(QImage::Format_RGBA8888);
+
+    p.image->animationInterface()->switchCurrentTimeAsync(1);
+    p.image->waitForDone();
+    dev->fill(fillRect, KoColor(Qt::green, cs));
+    QImage frame1 = dev->convertToQImage(0, rect).convertToFormat(QImage::Format_RGBA8888);
+
+    p.image->animationInterface()->switchCurrentTimeAsync(2);
+    p.image->waitForDone();
+    dev->fill(fillRect, KoColor(Qt::blue, cs));
+    QImage frame2 = dev->convertToQImage(0, rect).convertToFormat(QImage::Format_RGBA8888);
+
+    TestingFrameSink sink;
+
+    KisAsyncAnimationFramesStreamDialog exporter(document->image(),
+                                                 KisTimeRange::fromTime(0,2),
+                                                 &sink);
+
+    exporter.setBatchMode(true);
+    QCOMPARE(exporter.regenerateRange(0), KisAsyncAnimationRenderDialogBase::RenderComplete);
+
+    // the frames come in the order of the range, even if rendered in parallel
+    QCOMPARE(sink.frames, QList<int>() << 0 << 1 << 2);
+
+    QCOMPARE(sink.images[0], frame0);
+    QCOMPARE(sink.images[1], frame1);
+    QCOMPARE(sink.images[2], frame2);
+}
+
 QTEST_MAIN(KisAnimationExporterTest)
@@ -26,15 +26,25 @@
 #include "opengl/kis_opengl_image_textures.h"
 #include "kis_time_range.h"
 #include "kis_keyframe_channel.h"
+#include "canvas/kis_update_info.h"
+#include "opengl/kis_texture_tile_update_info.h"
+#include "dialogs/KisAsyncAnimationCacheRenderDialog.h"
 
 #include "kundo2command.h"
+#include <KoColor.h>
+
+QString statusToString(KisAnimationFrameCache::CacheStatus status)
+{
+    return status == KisAnimationFrameCache::Cached ? "Cached" :
+        status == KisAnimationFrameCache::Evicted ? "Evicted" : "Uncached";
+}
 
 void verifyRangeIsCachedStatus(KisAnimationFrameCacheSP cache, int start, int end, KisAnimationFrameCache::CacheStatus status)
 {
     for (int t = start; t <= end; t++) {
         QVERIFY2(
             cache->frameStatus(t) == status,
-            qPrintable(QString("Expected status %1 for frame %2 in range %3 to %4").arg(status == KisAnimationFrameCache::Cached ? "Cached" : "Uncached").arg(t).arg(start).arg(end))
+            qPrintable(QString("Expected status %1 for frame %2 in range %3 to %4").arg(statusToString(status)).arg(t).arg(start).arg(end))
         );
     }
 }
@@ -100,4 +110,119 @@ void KisAnimationFrameCacheTest::testCache()
 
 }
 
+void addFrameToCache(KisAnimationFrameCacheSP cache, KisImageSP image, int time)
+{
+    int oldTime;
+    image->animationInterface()->saveAndResetCurrentTime(time, &oldTime);
+
+    KisOpenGLUpdateInfoSP info = cache->fetchFrameData(time, image);
+    cache->addConvertedFrameData(info, time);
+
+    image->animationInterface()->restoreCurrentTime(&oldTime);
+}
+
+void KisAnimationFrameCacheTest::testCompressedStorage()
+{
+    TestUtil::MaskParent p;
+    KisImageSP image = p.image;
+    KisImageAnimationInterface *animation = image->animationInterface();
+    KisPaintLayerSP layer = p.layer;
+
+    KUndo2Command parentCommand;
+
+    KisKeyframeChannel *rasterChannel = layer->getKeyframeChannel(KisKeyframeChannel::Content.id());
+    rasterChannel->addKeyframe(100, &parentCommand);
+    rasterChannel->addKeyframe(200, &parentCommand);
+    rasterChannel->addKeyframe(300, &parentCommand);
+
+    const QColor colors[] = {Qt::red, Qt::green, Qt::blue};
+
+    for (int i = 0; i < 3; i++) {
+        int oldTime;
+        animation->saveAndResetCurrentTime(100 * (i + 1), &oldTime);
+        layer->paintDevice()->fill(QRect(10, 10, 50, 50), KoColor(colors[i], layer->colorSpace()));
+        animation->restoreCurrentTime(&oldTime);
+    }
+
+    KisOpenGLImageTexturesSP glTex = KisOpenGLImageTextures::getImageTextures(image, 0, KoColorConversionTransformation::IntentPerceptual, KoColorConversionTransformation::Empty);
+    KisAnimationFrameCacheSP cache = new KisAnimationFrameCache(glTex);
+
+    addFrameToCache(cache, image, 100);
+    addFrameToCache(cache, image, 200);
+    addFrameToCache(cache, image, 300);
+
+    verifyRangeIsCachedStatus(cache, 100, 350, KisAnimationFrameCache::Cached);
+
+    // the decompressed frames are equal to the freshly converted ones
+    for (int i = 0; i < 3; i++) {
+        const int time = 100 * (i + 1);
+
+        int oldTime;
+        animation->saveAndResetCurrentTime(time, &oldTime);
+        KisOpenGLUpdateInfoSP reference = cache->fetchFrameData(time, image);
+        animation->restoreCurrentTime(&oldTime);
+
+        int numComparedTiles = 0;
+
+        const bool loaded = cache->testingLoadFrame(time,
+            [reference, &numComparedTiles] (KisOpenGLUpdateInfoSP info) {
+                QCOMPARE(info->tileList.size(), reference->tileList.size());
+
+                for (int j = 0; j < info->tileList.size(); j++) {
+                    KisTextureTileUpdateInfoSP tile = info->tileList[j];
+                    KisTextureTileUpdateInfoSP refTile = reference->tileList[j];
+
+                    if (!refTile->valid() || !refTile->data()) continue;
+
+                    QVERIFY(tile->data());
+                    QCOMPARE(tile->patchDataSize(), refTile->patchDataSize());
+                    QVERIFY(!memcmp(tile->data(), refTile->data(), refTile->patchDataSize()));
+                    numComparedTiles++;
+                }
+            });
+
+        QVERIFY(loaded);
+        QVERIFY(numComparedTiles > 0);
+    }
+
+    // the pixel data is released after the upload
+    QCOMPARE(cache->statistics().numFrames, 3);
+    QVERIFY(cache->uploadFrame(200));
+    QCOMPARE(cache->statistics().hits, 1);
+
+    KisAnimationFrameCache::Statistics stats = cache->statistics();
+    QCOMPARE(stats.numFrames, 3);
+    QVERIFY(stats.storedSize > 0);
+    QVERIFY(stats.storedSize < stats.uncompressedSize);
+
+    // storing an equal frame again doesn't take any new memory
+    addFrameToCache(cache, image, 200);
+    QCOMPARE(cache->statistics().numFrames, 3);
+    QCOMPARE(cache->statistics().storedSize, stats.storedSize);
+
+    // the playhead stays at frame 0, so nothing is protected
+    cache->setMemoryLimit(1);
+
+    stats = cache->statistics();
+    QCOMPARE(stats.numFrames, 0);
+    QCOMPARE(stats.storedSize, qint64(0));
+    QCOMPARE(stats.evictions, 3);
+    verifyRangeIsCachedStatus(cache, 100, 350, KisAnimationFrameCache::Evicted);
+
+    // the evicted frames are not regenerated in the background...
+    const QList<int> dirtyFrames =
+        KisAsyncAnimationCacheRenderDialog::calcDirtyFramesList(cache, KisTimeRange::fromTime(100, 350), KisTimeRange());
+    QVERIFY(dirtyFrames.isEmpty());
+
+    // ...until they are changed
+    image->invalidateFrames(KisTimeRange::fromTime(200, 299), QRect());
+    verifyRangeIsCachedStatus(cache, 100, 199, KisAnimationFrameCache::Evicted);
+    verifyRangeIsCachedStatus(cache, 200, 299, KisAnimationFrameCache::Uncached);
+    verifyRangeIsCachedStatus(cache, 300, 350, KisAnimationFrameCache::Evicted);
+
+    // ...or the limit grows
+    cache->setMemoryLimit(stats.uncompressedSize * 10);
+    verifyRangeIsCachedStatus(cache, 100, 350, KisAnimationFrameCache::Uncached);
+}
+
 QTEST_MAIN(KisAnimationFrameCacheTest)
@@ -27,6 +27,7 @@ class KisAnimationFrameCacheTest : public QObject
 
 private Q_SLOTS:
     void testCache();
+    void testCompressedStorage();
 
 };
 #endif
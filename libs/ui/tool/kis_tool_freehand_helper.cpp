@@ -32,6 +32,9 @@
 #include "kis_recording_adapter.h"
 #include "kis_image.h"
 #include "kis_painter.h"
+#include "kis_paint_device.h"
+#include "kis_node.h"
+#include "kis_global.h"
 #include <brushengine/kis_paintop_preset.h>
 #include <brushengine/kis_paintop_utils.h>
 
@@ -453,9 +456,39 @@ void KisToolFreehandHelper::paintEvent(KoPointerEvent *event)
 
     KisUpdateTimeMonitor::instance()->reportMouseMove(info.pos());
 
+    prefetchAlongStroke(info);
     paint(info);
 }
 
+void KisToolFreehandHelper::prefetchAlongStroke(const KisPaintInformation &info)
+{
+    KisNodeSP node = m_d->resources->currentNode();
+    KisPaintDeviceSP device = node ? node->paintDevice() : 0;
+    if (!device) return;
+
+    /**
+     * Extrapolate the motion of the cursor a few events ahead and
+     * ask the tile engine to load back the swapped tiles on the way
+     * of the brush. Tiles already in memory are skipped cheaply.
+     */
+    const int lookAheadEvents = 8;
+
+    const QPointF currentPos = info.pos();
+    const QPointF motion = currentPos - m_d->previousPaintInformation.pos();
+    const QPointF predictedPos = currentPos + lookAheadEvents * motion;
+
+    qreal brushSize = 0.0;
+    KisPaintOpPresetSP preset = m_d->resources->currentPaintOpPreset();
+    if (preset && preset->settings()) {
+        brushSize = preset->settings()->paintOpSize();
+    }
+
+    const QRect prefetchRect =
+        kisGrowRect(QRectF(currentPos, predictedPos).normalized(), 0.5 * brushSize + 1.0).toAlignedRect();
+
+    device->prefetchSwappedData(prefetchRect);
+}
+
 void KisToolFreehandHelper::paint(KisPaintInformation &info)
 {
     /**
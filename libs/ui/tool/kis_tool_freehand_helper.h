@@ -145,6 +145,7 @@ private:
     KisPaintInformation getStabilizedPaintInfo(const QQueue<KisPaintInformation> &queue,
                                                const KisPaintInformation &lastPaintInfo);
     int computeAirbrushTimerInterval() const;
+    void prefetchAlongStroke(const KisPaintInformation &info);
 
 private Q_SLOTS:
     void finishStroke();
@@ -24,8 +24,8 @@
 
 #include <colorprofiles/LcmsColorProfileContainer.h>
 #include <KoColorSpaceAbstract.h>
-#include <QMutex>
-#include <QMutexLocker>
+#include <QSharedPointer>
+#include <kis_lockless_stack.h>
 
 class LcmsColorProfileContainer;
 
@@ -153,18 +153,60 @@ class LcmsColorSpace : public KoColorSpaceAbstract<_CSTraits>, public KoLcmsInfo
         cmsHTRANSFORM cmsAlphaTransform;
     };
 
+    /**
+     * A transform to/from a custom RGB profile, cached between
+     * the calls to fromQColor()/toQColor()
+     */
+    struct KisLcmsLastTransformation {
+        cmsHPROFILE profile = 0;     // Profile the transform was created for
+        cmsHTRANSFORM transform = 0;
+
+        ~KisLcmsLastTransformation() {
+            if (transform) {
+                cmsDeleteTransform(transform);
+            }
+        }
+    };
+
+    typedef QSharedPointer<KisLcmsLastTransformation> KisLcmsLastTransformationSP;
+
+    /**
+     * The cached transforms are kept in lockless stacks, so that
+     * the concurrent conversions never wait for each other. Every
+     * thread pops a transform, uses it exclusively and pushes it
+     * back, so the number of transforms never exceeds the number
+     * of threads converting the colors at the same time.
+     */
+    typedef KisLocklessStack<KisLcmsLastTransformationSP> KisLcmsTransformationStack;
+
     struct Private {
-        mutable quint8 *qcolordata; // A small buffer for conversion from and to qcolor.
         KoLcmsDefaultTransformations *defaultTransformations;
 
-        mutable cmsHPROFILE   lastRGBProfile;  // Last used profile to transform to/from RGB
-        mutable cmsHTRANSFORM lastToRGB;       // Last used transform to transform to RGB
-        mutable cmsHTRANSFORM lastFromRGB;     // Last used transform to transform from RGB
+        KisLcmsTransformationStack fromRGBCachedTransformations; // Last used transforms from a custom RGB profile
+        KisLcmsTransformationStack toRGBCachedTransformations;   // Last used transforms to a custom RGB profile
+
         LcmsColorProfileContainer *profile;
         KoColorProfile *colorProfile;
-        QMutex mutex;
     };
 
+    /**
+     * Takes a cached transform for \p rgbProfile out of \p stack,
+     * the transforms for other profiles are dropped on the way.
+     * Returns a null pointer if no suitable transform is found.
+     */
+    static KisLcmsLastTransformationSP takeCachedTransformation(KisLcmsTransformationStack &stack, cmsHPROFILE rgbProfile)
+    {
+        KisLcmsLastTransformationSP last;
+
+        while (stack.pop(last)) {
+            if (last->profile == rgbProfile) {
+                return last;
+            }
+        }
+
+        return KisLcmsLastTransformationSP();
+    }
+
 protected:
 
     LcmsColorSpace(const QString &id,
@@ -181,27 +223,18 @@ protected:
         d->profile = asLcmsProfile(p);
         Q_ASSERT(d->profile);
         d->colorProfile = p;
-        d->qcolordata = 0;
-        d->lastRGBProfile = 0;
-        d->lastToRGB = 0;
-        d->lastFromRGB = 0;
         d->defaultTransformations = 0;
     }
 
     ~LcmsColorSpace() override
     {
         delete d->colorProfile;
-        delete[] d->qcolordata;
         delete d->defaultTransformations;
         delete d;
     }
 
     void init()
     {
-        // Default pixel buffer for QColor conversion
-        d->qcolordata = new quint8[3];
-        Q_CHECK_PTR(d->qcolordata);
-
         Q_ASSERT(d->profile);
 
         if (KoLcmsDefaultTransformations::s_RGBProfile == 0) {
@@ -248,29 +281,35 @@ public:
 
     void fromQColor(const QColor &color, quint8 *dst, const KoColorProfile *koprofile = 0) const override
     {
-        QMutexLocker locker(&d->mutex);
-        d->qcolordata[2] = color.red();
-        d->qcolordata[1] = color.green();
-        d->qcolordata[0] = color.blue();
+        quint8 qcolordata[3];
+        qcolordata[2] = color.red();
+        qcolordata[1] = color.green();
+        qcolordata[0] = color.blue();
 
         LcmsColorProfileContainer *profile = asLcmsProfile(koprofile);
         if (profile == 0) {
             // Default sRGB
             Q_ASSERT(d->defaultTransformations && d->defaultTransformations->fromRGB);
 
-            cmsDoTransform(d->defaultTransformations->fromRGB, d->qcolordata, dst, 1);
+            cmsDoTransform(d->defaultTransformations->fromRGB, qcolordata, dst, 1);
         } else {
-            if (d->lastFromRGB == 0 || (d->lastFromRGB != 0 && d->lastRGBProfile != profile->lcmsProfile())) {
-                d->lastFromRGB = cmsCreateTransform(profile->lcmsProfile(),
-                                                    TYPE_BGR_8,
-                                                    d->profile->lcmsProfile(),
-                                                    this->colorSpaceType(),
-                                                    KoColorConversionTransformation::internalRenderingIntent(),
-                                                    KoColorConversionTransformation::internalConversionFlags());
-                d->lastRGBProfile = profile->lcmsProfile();
-
+            KisLcmsLastTransformationSP last =
+                takeCachedTransformation(d->fromRGBCachedTransformations, profile->lcmsProfile());
+
+            if (!last) {
+                last.reset(new KisLcmsLastTransformation());
+                last->transform = cmsCreateTransform(profile->lcmsProfile(),
+                                                     TYPE_BGR_8,
+                                                     d->profile->lcmsProfile(),
+                                                     this->colorSpaceType(),
+                                                     KoColorConversionTransformation::internalRenderingIntent(),
+                                                     KoColorConversionTransformation::internalConversionFlags());
+                last->profile = profile->lcmsProfile();
             }
-            cmsDoTransform(d->lastFromRGB, d->qcolordata, dst, 1);
+
+            Q_ASSERT(last->transform);
+            cmsDoTransform(last->transform, qcolordata, dst, 1);
+            d->fromRGBCachedTransformations.push(last);
         }
 
         this->setOpacity(dst, (quint8)(color.alpha()), 1);
@@ -278,23 +317,31 @@ public:
 
     void toQColor(const quint8 *src, QColor *c, const KoColorProfile *koprofile = 0) const override
     {
-        QMutexLocker locker(&d->mutex);
+        quint8 qcolordata[3];
+
         LcmsColorProfileContainer *profile = asLcmsProfile(koprofile);
         if (profile == 0) {
             // Default sRGB transform
             Q_ASSERT(d->defaultTransformations && d->defaultTransformations->toRGB);
-            cmsDoTransform(d->defaultTransformations->toRGB, const_cast <quint8 *>(src), d->qcolordata, 1);
+            cmsDoTransform(d->defaultTransformations->toRGB, const_cast <quint8 *>(src), qcolordata, 1);
         } else {
-            if (d->lastToRGB == 0 || (d->lastToRGB != 0 && d->lastRGBProfile != profile->lcmsProfile())) {
-                d->lastToRGB = cmsCreateTransform(d->profile->lcmsProfile(), this->colorSpaceType(),
-                                                  profile->lcmsProfile(), TYPE_BGR_8,
-                                                  KoColorConversionTransformation::internalRenderingIntent(),
-                                                  KoColorConversionTransformation::internalConversionFlags());
-                d->lastRGBProfile = profile->lcmsProfile();
+            KisLcmsLastTransformationSP last =
+                takeCachedTransformation(d->toRGBCachedTransformations, profile->lcmsProfile());
+
+            if (!last) {
+                last.reset(new KisLcmsLastTransformation());
+                last->transform = cmsCreateTransform(d->profile->lcmsProfile(), this->colorSpaceType(),
+                                                     profile->lcmsProfile(), TYPE_BGR_8,
+                                                     KoColorConversionTransformation::internalRenderingIntent(),
+                                                     KoColorConversionTransformation::internalConversionFlags());
+                last->profile = profile->lcmsProfile();
             }
-            cmsDoTransform(d->lastToRGB, const_cast <quint8 *>(src), d->qcolordata, 1);
+
+            Q_ASSERT(last->transform);
+            cmsDoTransform(last->transform, const_cast <quint8 *>(src), qcolordata, 1);
+            d->toRGBCachedTransformations.push(last);
         }
-        c->setRgb(d->qcolordata[2], d->qcolordata[1], d->qcolordata[0]);
+        c->setRgb(qcolordata[2], qcolordata[1], qcolordata[0]);
         c->setAlpha(this->opacityU8(src));
     }
 
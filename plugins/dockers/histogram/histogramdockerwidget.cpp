@@ -26,13 +26,56 @@
 #include <functional>
 
 #include "KoChannelInfo.h"
+#include "KoBasicHistogramProducers.h"
 #include "kis_paint_device.h"
 #include "KoColorSpace.h"
-#include "kis_iterator_ng.h"
+#include "kis_histogram_cache.h"
 #include "kis_canvas2.h"
 
+namespace {
+
+/**
+ * Bins every channel of the device's color space scaled to 8 bits,
+ * transparent pixels included
+ */
+class HistogramDockerProducer : public KoBasicHistogramProducer
+{
+public:
+    HistogramDockerProducer(const KoColorSpace *cs)
+        : KoBasicHistogramProducer(KoID("histogramdocker"), std::numeric_limits<quint8>::max() + 1, cs)
+    {
+    }
+
+    void addRegionToBin(const quint8 *pixels, const quint8 *selectionMask, quint32 nPixels, const KoColorSpace *cs) override {
+        Q_UNUSED(selectionMask);
+
+        const quint32 pixelSize = cs->pixelSize();
+        const int channelCount = m_channels;
+
+        for (quint32 k = 0; k < nPixels; ++k) {
+            for (int chan = 0; chan < channelCount; ++chan) {
+                m_bins[chan][cs->scaleToU8(pixels, chan)]++;
+            }
+            pixels += pixelSize;
+        }
+
+        m_count += nPixels;
+    }
+
+    QString positionToString(qreal pos) const override {
+        return QString::number(static_cast<quint8>(pos * std::numeric_limits<quint8>::max()));
+    }
+
+    qreal maximalZoom() const override {
+        return 1.0;
+    }
+};
+
+}
+
 HistogramDockerWidget::HistogramDockerWidget(QWidget *parent, const char *name, Qt::WindowFlags f)
-    : QLabel(parent, f), m_paintDevice(nullptr), m_smoothHistogram(true)
+    : QLabel(parent, f), m_paintDevice(nullptr), m_smoothHistogram(true),
+      m_histogramCacheColorSpace(nullptr)
 {
     setObjectName(name);
 }
@@ -61,7 +104,18 @@ void HistogramDockerWidget::updateHistogram()
 
         m_devClone->makeCloneFrom(m_paintDevice, m_bounds);
 
-        HistogramComputationThread *workerThread = new HistogramComputationThread(m_devClone, m_bounds);
+        /**
+         * The clone shares the tiles with the projection, so the cache
+         * rescans only the parts of the image changed since the last
+         * update
+         */
+        const KoColorSpace *cs = m_paintDevice->colorSpace();
+        if (!m_histogramCache || m_histogramCacheColorSpace != cs) {
+            m_histogramCache.reset(new KisHistogramCache([cs] () { return new HistogramDockerProducer(cs); }));
+            m_histogramCacheColorSpace = cs;
+        }
+
+        HistogramComputationThread *workerThread = new HistogramComputationThread(m_devClone, m_histogramCache);
         connect(workerThread, &HistogramComputationThread::resultReady, this, &HistogramDockerWidget::receiveNewHistogram);
         connect(workerThread, &HistogramComputationThread::finished, workerThread, &QObject::deleteLater);
         workerThread->start();
@@ -158,10 +212,6 @@ void HistogramComputationThread::run()
 {
     const KoColorSpace *cs = m_dev->colorSpace();
     quint32 channelCount = m_dev->channelCount();
-    quint32 pixelSize = m_dev->pixelSize();
-
-    quint32 imageSize = m_bounds.width() * m_bounds.height();
-    quint32 nSkip = 1 + (imageSize >> 20); //for speed use about 1M pixels for computing histograms
 
     //allocate space for the histogram data
     bins.resize((int)channelCount);
@@ -173,23 +223,12 @@ void HistogramComputationThread::run()
     if (bounds.isEmpty())
         return;
 
-    quint32 toSkip = nSkip;
-
-    KisSequentialConstIterator it(m_dev, m_dev->exactBounds());
+    HistogramDockerProducer producer(cs);
+    m_cache->computeHistogram(m_dev, bounds, &producer);
 
-    int numConseqPixels = it.nConseqPixels();
-    while (it.nextPixels(numConseqPixels)) {
-
-        numConseqPixels = it.nConseqPixels();
-        const quint8* pixel = it.rawDataConst();
-        for (int k = 0; k < numConseqPixels; ++k) {
-            if (--toSkip == 0) {
-                for (int chan = 0; chan < (int)channelCount; ++chan) {
-                    bins[chan][cs->scaleToU8(pixel, chan)]++;
-                }
-                toSkip = nSkip;
-            }
-            pixel += pixelSize;
+    for (int chan = 0; chan < (int)channelCount; ++chan) {
+        for (int i = 0; i < producer.numberOfBins(); ++i) {
+            bins[chan][i] = producer.getBinAt(chan, i);
         }
     }
 
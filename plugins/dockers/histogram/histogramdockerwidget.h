@@ -23,10 +23,13 @@
 #include <QWidget>
 #include <QLabel>
 #include <QThread>
+#include <QSharedPointer>
 #include "kis_types.h"
 #include <vector>
 
 class KisCanvas2;
+class KisHistogramCache;
+class KoColorSpace;
 
 typedef std::vector<std::vector<quint32> > HistVector; //Don't use QVector here - it's too slow for this purpose
 
@@ -35,7 +38,7 @@ class HistogramComputationThread : public QThread
 {
     Q_OBJECT
 public:
-    HistogramComputationThread(KisPaintDeviceSP _dev, const QRect& _bounds) : m_dev(_dev), m_bounds(_bounds)
+    HistogramComputationThread(KisPaintDeviceSP _dev, QSharedPointer<KisHistogramCache> _cache) : m_dev(_dev), m_cache(_cache)
     {}
 
     void run() override;
@@ -45,7 +48,7 @@ Q_SIGNALS:
 
 private:
     KisPaintDeviceSP m_dev;
-    QRect m_bounds;
+    QSharedPointer<KisHistogramCache> m_cache;
     HistVector bins;
 };
 
@@ -69,6 +72,9 @@ private:
     HistVector m_histogramData;
     QRect m_bounds;
     bool m_smoothHistogram;
+
+    QSharedPointer<KisHistogramCache> m_histogramCache;
+    const KoColorSpace *m_histogramCacheColorSpace;
 };
 
 #endif // HISTOGRAMDOCKERWIDGET_H
@@ -101,23 +101,32 @@ void AnimaterionRenderer::slotRenderAnimation()
                 .arg(extension);
 
 
-        const bool batchMode = false; // TODO: fetch correctly!
-        KisAsyncAnimationFramesSaveDialog exporter(doc->image(),
-                                                   KisTimeRange::fromTime(sequenceConfig->getInt("first_frame"), sequenceConfig->getInt("last_frame")),
-                                                   baseFileName,
-                                                   sequenceConfig->getInt("sequence_start"),
-                                                   dlgAnimationRenderer.getFrameExportConfiguration());
-        exporter.setBatchMode(batchMode);
-
-
-        KisAsyncAnimationFramesSaveDialog::Result result =
-            exporter.regenerateRange(viewManager()->mainWindow()->viewManager());
+        KisPropertiesConfigurationSP videoConfig = dlgAnimationRenderer.getVideoConfiguration();
+
+        /**
+         * When the user asked for the video only, the frames are piped
+         * right into the encoder without writing the image sequence
+         */
+        const bool streamFrames = videoConfig && videoConfig->getBool("delete_sequence", false);
+
+        KisAsyncAnimationFramesSaveDialog::Result result = KisAsyncAnimationFramesSaveDialog::RenderComplete;
+        QString savedFilesMask;
+
+        if (!streamFrames) {
+            const bool batchMode = false; // TODO: fetch correctly!
+            KisAsyncAnimationFramesSaveDialog exporter(doc->image(),
+                                                       KisTimeRange::fromTime(sequenceConfig->getInt("first_frame"), sequenceConfig->getInt("last_frame")),
+                                                       baseFileName,
+                                                       sequenceConfig->getInt("sequence_start"),
+                                                       dlgAnimationRenderer.getFrameExportConfiguration());
+            exporter.setBatchMode(batchMode);
+
+            result = exporter.regenerateRange(viewManager()->mainWindow()->viewManager());
+            savedFilesMask = exporter.savedFilesMask();
+        }
 
         // the folder could have been read-only or something else could happen
         if (result == KisAsyncAnimationFramesSaveDialog::RenderComplete) {
-            QString savedFilesMask = exporter.savedFilesMask();
-
-            KisPropertiesConfigurationSP videoConfig = dlgAnimationRenderer.getVideoConfiguration();
             if (videoConfig) {
                 kisConfig.setExportConfiguration("ANIMATION_RENDERER", videoConfig);
 
@@ -125,6 +134,7 @@ void AnimaterionRenderer::slotRenderAnimation()
                 if (encoderConfig) {
                     kisConfig.setExportConfiguration("FFMPEG_CONFIG", encoderConfig);
                     encoderConfig->setProperty("savedFilesMask", savedFilesMask);
+                    encoderConfig->setProperty("stream_frames", streamFrames);
                 }
 
                 const QString fileName = videoConfig->getString("filename");
@@ -158,13 +168,6 @@ void AnimaterionRenderer::slotRenderAnimation()
                 if (res != KisImportExportFilter::OK) {
                     QMessageBox::critical(0, i18nc("@title:window", "Krita"), i18n("Could not render animation:\n%1", doc->errorMessage()));
                 }
-                if (videoConfig->getBool("delete_sequence", false)) {
-                    QDir d(sequenceConfig->getString("directory"));
-                    QStringList sequenceFiles = d.entryList(QStringList() << sequenceConfig->getString("basename") + "*." + extension, QDir::Files);
-                    Q_FOREACH(const QString &f, sequenceFiles) {
-                        d.remove(f);
-                    }
-                }
             }
         } else if (result == KisAsyncAnimationFramesSaveDialog::RenderFailed) {
             viewManager()->mainWindow()->viewManager()->showFloatingMessage(i18n("Failed to render animation frames!"), QIcon());
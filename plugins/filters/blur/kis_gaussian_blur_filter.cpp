@@ -91,7 +91,7 @@ void KisGaussianBlurFilter::processImpl(KisPaintDeviceSP device,
 
     KisGaussianKernel::applyGaussian(device, rect,
                                      horizontalRadius, verticalRadius,
-                                     channelFlags, progressUpdater);
+                                     channelFlags, progressUpdater, true);
 }
 
 QRect KisGaussianBlurFilter::neededRect(const QRect & rect, const KisFilterConfigurationSP _config, int lod) const
@@ -36,6 +36,7 @@
 
 #include "kis_paint_device.h"
 #include "kis_histogram.h"
+#include "kis_histogram_cache.h"
 #include "kis_painter.h"
 #include "kis_gradient_slider.h"
 #include "kis_processing_information.h"
@@ -44,7 +45,8 @@
 #include "filter/kis_color_transformation_configuration.h"
 
 KisLevelFilter::KisLevelFilter()
-        : KisColorTransformationFilter(id(), categoryAdjust(), i18n("&Levels..."))
+        : KisColorTransformationFilter(id(), categoryAdjust(), i18n("&Levels...")),
+          m_histogramCache(new KisHistogramCache([] () { return new KoGenericLabHistogramProducer(); }))
 {
     setShortcut(QKeySequence(Qt::CTRL + Qt::Key_L));
     setSupportsPainting(false);
@@ -57,7 +59,7 @@ KisLevelFilter::~KisLevelFilter()
 
 KisConfigWidget * KisLevelFilter::createConfigurationWidget(QWidget* parent, const KisPaintDeviceSP dev) const
 {
-    return new KisLevelConfigWidget(parent, dev);
+    return new KisLevelConfigWidget(parent, dev, m_histogramCache.data());
 }
 
 KoColorTransformation* KisLevelFilter::createTransformation(const KoColorSpace* cs, const KisFilterConfigurationSP config) const
@@ -91,7 +93,7 @@ KoColorTransformation* KisLevelFilter::createTransformation(const KoColorSpace*
     return cs->createBrightnessContrastAdjustment(transfer);
 }
 
-KisLevelConfigWidget::KisLevelConfigWidget(QWidget * parent, KisPaintDeviceSP dev)
+KisLevelConfigWidget::KisLevelConfigWidget(QWidget * parent, KisPaintDeviceSP dev, KisHistogramCache *histogramCache)
         : KisConfigWidget(parent)
 {
     Q_ASSERT(dev);
@@ -139,7 +141,7 @@ KisLevelConfigWidget::KisLevelConfigWidget(QWidget * parent, KisPaintDeviceSP de
     connect((QObject*)(m_page.chkLogarithmic), SIGNAL(toggled(bool)), this, SLOT(slotDrawHistogram(bool)));
 
     KoHistogramProducer *producer = new KoGenericLabHistogramProducer();
-    m_histogram.reset( new KisHistogram(dev, dev->exactBounds(), producer, LINEAR) );
+    m_histogram.reset( new KisHistogram(dev, dev->exactBounds(), producer, LINEAR, histogramCache) );
     m_histlog = false;
     m_page.histview->resize(288,100);
     m_inverted = false;
@@ -28,6 +28,7 @@
 class WdgLevel;
 class QWidget;
 class KisHistogram;
+class KisHistogramCache;
 
 
 /**
@@ -52,6 +53,12 @@ public:
         return KoID("levels", i18n("Levels"));
     }
 
+private:
+    /**
+     * Keeps the partial histograms of the last filtered device, so
+     * reopening the dialog rescans only the changed parts of it
+     */
+    QScopedPointer<KisHistogramCache> m_histogramCache;
 };
 
 
@@ -59,7 +66,7 @@ class KisLevelConfigWidget : public KisConfigWidget
 {
     Q_OBJECT
 public:
-    KisLevelConfigWidget(QWidget * parent, KisPaintDeviceSP dev);
+    KisLevelConfigWidget(QWidget * parent, KisPaintDeviceSP dev, KisHistogramCache *histogramCache = 0);
     ~KisLevelConfigWidget() override;
 
     KisPropertiesConfigurationSP configuration() const override;
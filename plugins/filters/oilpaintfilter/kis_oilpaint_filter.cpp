@@ -40,7 +40,6 @@
 
 #include <KisDocument.h>
 #include <kis_image.h>
-#include <KisSequentialIteratorProgress.h>
 #include <kis_layer.h>
 #include <filter/kis_filter_registry.h>
 #include <kis_global.h>
@@ -48,13 +47,15 @@
 #include <filter/kis_filter_configuration.h>
 #include <kis_processing_information.h>
 #include <kis_paint_device.h>
+#include <kis_default_bounds_base.h>
+#include <kis_iterator_ng.h>
 #include "widgets/kis_multi_integer_filter_widget.h"
 
 
 KisOilPaintFilter::KisOilPaintFilter() : KisFilter(id(), KisFilter::categoryArtistic(), i18n("&Oilpaint..."))
 {
     setSupportsPainting(true);
-    setSupportsThreading(false);
+    setSupportsThreading(true);
     setSupportsAdjustmentLayers(true);
 }
 
@@ -73,113 +74,280 @@ void KisOilPaintFilter::processImpl(KisPaintDeviceSP device,
     OilPaint(device, device, applyRect, brushSize, smooth, progressUpdater);
 }
 
+QRect KisOilPaintFilter::neededRect(const QRect & rect, const KisFilterConfigurationSP _config, int lod) const
+{
+    Q_UNUSED(lod);
+
+    const int brushSize = _config ? _config->getInt("brushSize", 1) : 1;
+    return rect.adjusted(-brushSize, -brushSize, brushSize, brushSize);
+}
+
+QRect KisOilPaintFilter::changedRect(const QRect & rect, const KisFilterConfigurationSP _config, int lod) const
+{
+    Q_UNUSED(lod);
+
+    const int brushSize = _config ? _config->getInt("brushSize", 1) : 1;
+    return rect.adjusted(-brushSize, -brushSize, brushSize, brushSize);
+}
+
+namespace {
+
+/**
+ * A histogram of the intensities of the pixels in the sliding window.
+ * Along with the number of pixels every bin keeps the sum of their
+ * normalized channels, so the average color of the most frequent
+ * intensity is known without revisiting the window.
+ */
+class SlidingIntensityHistogram
+{
+public:
+    SlidingIntensityHistogram(int numBins, int channelCount)
+        : m_channelCount(channelCount),
+          m_counts(numBins),
+          m_sums(numBins * channelCount)
+    {
+        reset();
+    }
+
+    void reset() {
+        m_counts.fill(0);
+        m_sums.fill(0.0f);
+        m_mostFrequentBin = 0;
+        m_mostFrequentCount = 0;
+        m_mostFrequentValid = true;
+    }
+
+    inline void addPixel(int bin, const float *channels) {
+        const int count = ++m_counts[bin];
+
+        float *sum = m_sums.data() + bin * m_channelCount;
+        for (int i = 0; i < m_channelCount; i++) {
+            sum[i] += channels[i];
+        }
+
+        /**
+         * On equal counts the lowest intensity wins, just like
+         * in the original full-scan algorithm
+         */
+        if (m_mostFrequentValid &&
+            (count > m_mostFrequentCount ||
+             (count == m_mostFrequentCount && bin < m_mostFrequentBin))) {
+
+            m_mostFrequentBin = bin;
+            m_mostFrequentCount = count;
+        }
+    }
+
+    inline void removePixel(int bin, const float *channels) {
+        const int count = --m_counts[bin];
+
+        float *sum = m_sums.data() + bin * m_channelCount;
+        if (count) {
+            for (int i = 0; i < m_channelCount; i++) {
+                sum[i] -= channels[i];
+            }
+        } else {
+            // an empty bin restarts from zero to avoid accumulating the rounding errors
+            memset(sum, 0, m_channelCount * sizeof(float));
+        }
+
+        if (bin == m_mostFrequentBin) {
+            m_mostFrequentValid = false;
+        }
+    }
+
+    /**
+     * Writes the average color of the most frequent intensity into \p dst
+     */
+    void mostFrequentColor(const KoColorSpace *cs, quint8 *dst, QVector<float> &channel) {
+        if (!m_mostFrequentValid) {
+            m_mostFrequentBin = 0;
+            m_mostFrequentCount = 0;
+
+            for (int i = 0; i < m_counts.size(); i++) {
+                if (m_counts[i] > m_mostFrequentCount) {
+                    m_mostFrequentBin = i;
+                    m_mostFrequentCount = m_counts[i];
+                }
+            }
+            m_mostFrequentValid = true;
+        }
+
+        if (m_mostFrequentCount != 0) {
+            const float *sum = m_sums.constData() + m_mostFrequentBin * m_channelCount;
+            for (int i = 0; i < m_channelCount; i++) {
+                channel[i] = sum[i] / m_mostFrequentCount;
+            }
+            cs->fromNormalisedChannelsValue(dst, channel);
+        } else {
+            memset(dst, 0, cs->pixelSize());
+            cs->setOpacity(dst, OPACITY_OPAQUE_U8, 1);
+        }
+    }
+
+private:
+    int m_channelCount;
+    QVector<int> m_counts;
+    QVector<float> m_sums;
+
+    int m_mostFrequentBin;
+    int m_mostFrequentCount;
+    bool m_mostFrequentValid;
+};
+
+}
+
 // This method have been ported from Pieter Z. Voloshyn algorithm code.
 
 /* Function to apply the OilPaint effect.
  *
- * data             => The image data in RGBA mode.
- * w                => Width of image.
- * h                => Height of image.
- * BrushSize        => Brush size.
- * Smoothness       => Smooth value.
+ * BrushSize        => Radius of the analyzed window.
+ * Smoothness       => Number of the intensity levels.
+ *
+ * Theory           => For every pixel we take the most frequent intensity in
+ *                     the window around it and write the average color of the
+ *                     pixels having that intensity.
  *
- * Theory           => Using MostFrequentColor function we take the main color in
- *                     a matrix and simply write at the original position.
+ * The histogram of the window is not rebuilt for every pixel. Instead,
+ * the window slides along the row, and only the column entering the
+ * window and the one leaving it are updated, which makes the cost per
+ * pixel O(BrushSize) instead of O(BrushSize^2) (Huang's algorithm).
+ *
+ * The intensities and the normalized channels of the source are cached
+ * for the (2 * BrushSize + 1) rows of the window. The source is read
+ * with oldRawData(), so the concurrently processed patches don't see
+ * each other's output. A row is written to \p dst only after all the
+ * source rows it depends on have been read, so the filter can work
+ * in-place even without a transaction.
  */
 
 void KisOilPaintFilter::OilPaint(const KisPaintDeviceSP src, KisPaintDeviceSP dst, const QRect &applyRect,
                                  int BrushSize, int Smoothness, KoUpdater* progressUpdater) const
 {
-    KisSequentialConstIteratorProgress it(src, applyRect, progressUpdater);
-    KisSequentialIterator dstIt(dst, applyRect);
+    if (applyRect.isEmpty()) return;
 
-    while (it.nextPixel() && dstIt.nextPixel()) {
-        MostFrequentColor(src, dstIt.rawData(), applyRect, it.x(), it.y(), BrushSize, Smoothness);
+    const KoColorSpace* cs = src->colorSpace();
+    const int pixelSize = cs->pixelSize();
+    const int channelCount = cs->channelCount();
+    const int radius = BrushSize;
+    const double scale = Smoothness / 255.0;
+
+    /**
+     * The window is clipped by the image bounds, but the pixels
+     * of the processed area itself are always taken into account
+     */
+    QRect sourceRect = applyRect.adjusted(-radius, -radius, radius, radius);
+    const QRect imageBounds = src->defaultBounds()->bounds();
+    if (!imageBounds.isEmpty()) {
+        sourceRect &= imageBounds | applyRect;
     }
-}
 
-// This method has been ported from Pieter Z. Voloshyn's algorithm code in Digikam.
+    const int sourceWidth = sourceRect.width();
+    const int numCachedRows = qMin(2 * radius + 1, sourceRect.height());
 
-/* Function to determine the most frequent color in a matrix
- *
- * Bits             => Bits array
- * Width            => Image width
- * Height           => Image height
- * X                => Position horizontal
- * Y                => Position vertical
- * Radius           => Is the radius of the matrix to be analyzed
- * Intensity        => Intensity to calculate
- *
- * Theory           => This function creates a matrix with the analyzed pixel in
- *                     the center of this matrix and find the most frequenty color
- */
+    /**
+     * The neighbouring patches may be processed concurrently in the same
+     * device, so the source is read through oldRawData() to get the pixels
+     * as they were before the filter started
+     */
+    KisHLineConstIteratorSP srcIt =
+        src->createHLineConstIteratorNG(sourceRect.left(), sourceRect.top(), sourceWidth);
 
-void KisOilPaintFilter::MostFrequentColor(KisPaintDeviceSP src, quint8* dst, const QRect& bounds, int X, int Y, int Radius, int Intensity) const
-{
-    uint I;
+    QVector<quint8> cachedBins(numCachedRows * sourceWidth);
+    QVector<float> cachedChannels(numCachedRows * sourceWidth * channelCount);
+    QVector<float> channel(channelCount);
 
-    double Scale = Intensity / 255.0;
+    auto cacheIndex = [&] (int x, int y) -> int {
+        return ((y - sourceRect.top()) % numCachedRows) * sourceWidth + x - sourceRect.left();
+    };
 
-    // Alloc some arrays to be used
-    uchar *IntensityCount = new uchar[(Intensity + 1) * sizeof(uchar)];
+    // the rows are always loaded in order, starting from sourceRect.top()
+    auto loadRow = [&] (int y) -> void {
+        const int rowStart = cacheIndex(sourceRect.left(), y);
+        quint8 *binPtr = cachedBins.data() + rowStart;
+        float *channelsPtr = cachedChannels.data() + rowStart * channelCount;
 
-    const KoColorSpace* cs = src->colorSpace();
+        for (int x = 0; x < sourceWidth; x++) {
+            const quint8 *srcPtr = srcIt->oldRawData();
 
-    QVector<float> channel(cs->channelCount());
-    QVector<float>* AverageChannels = new QVector<float>[(Intensity + 1)];
+            *binPtr = quint8(cs->intensity8(srcPtr) * scale);
 
-    // Erase the array
-    memset(IntensityCount, 0, (Intensity + 1) * sizeof(uchar));
+            cs->normalisedChannelsValue(srcPtr, channel);
+            memcpy(channelsPtr, channel.constData(), channelCount * sizeof(float));
 
-    int startx = qMax(X - Radius, bounds.left());
-    int starty = qMax(Y - Radius, bounds.top());
-    int width = (2 * Radius) + 1;
-    if ((startx + width - 1) > bounds.right()) width = bounds.right() - startx + 1;
-    Q_ASSERT((startx + width - 1) <= bounds.right());
-    int height = (2 * Radius) + 1;
-    if ((starty + height) > bounds.bottom()) height = bounds.bottom() - starty + 1;
-    Q_ASSERT((starty + height - 1) <= bounds.bottom());
-    KisSequentialConstIterator srcIt(src, QRect(startx, starty, width, height));
-    while (srcIt.nextPixel()) {
+            srcIt->nextPixel();
+            binPtr++;
+            channelsPtr += channelCount;
+        }
 
-        cs->normalisedChannelsValue(srcIt.rawDataConst(), channel);
+        srcIt->nextRow();
+    };
 
-        I = (uint)(cs->intensity8(srcIt.rawDataConst()) * Scale);
-        IntensityCount[I]++;
+    SlidingIntensityHistogram histogram(Smoothness + 1, channelCount);
+    QVector<quint8> dstRow(applyRect.width() * pixelSize);
 
-        if (IntensityCount[I] == 1) {
-            AverageChannels[I] = channel;
-        } else {
-            for (int i = 0; i < channel.size(); i++) {
-                AverageChannels[I][i] += channel[i];
-            }
-        }
+    if (progressUpdater) {
+        progressUpdater->setRange(0, applyRect.height());
     }
 
-    I = 0;
-    int MaxInstance = 0;
+    int nextRowToLoad = sourceRect.top();
+
+    for (int y = applyRect.top(); y <= applyRect.bottom(); y++) {
+        const int windowTop = qMax(y - radius, sourceRect.top());
+        const int windowBottom = qMin(y + radius, sourceRect.bottom());
 
-    for (int i = 0 ; i <= Intensity ; ++i) {
-        if (IntensityCount[i] > MaxInstance) {
-            I = i;
-            MaxInstance = IntensityCount[i];
+        while (nextRowToLoad <= windowBottom) {
+            loadRow(nextRowToLoad++);
         }
-    }
 
-    if (MaxInstance != 0) {
-        channel = AverageChannels[I];
-        for (int i = 0; i < channel.size(); i++) {
-            channel[i] /= MaxInstance;
+        auto addColumn = [&] (int x) -> void {
+            for (int row = windowTop; row <= windowBottom; row++) {
+                const int index = cacheIndex(x, row);
+                histogram.addPixel(cachedBins[index], cachedChannels.constData() + index * channelCount);
+            }
+        };
+
+        auto removeColumn = [&] (int x) -> void {
+            for (int row = windowTop; row <= windowBottom; row++) {
+                const int index = cacheIndex(x, row);
+                histogram.removePixel(cachedBins[index], cachedChannels.constData() + index * channelCount);
+            }
+        };
+
+        histogram.reset();
+
+        const int windowLeft = qMax(applyRect.left() - radius, sourceRect.left());
+        const int windowRight = qMin(applyRect.left() + radius, sourceRect.right());
+        for (int x = windowLeft; x <= windowRight; x++) {
+            addColumn(x);
         }
-        cs->fromNormalisedChannelsValue(dst, channel);
-    } else {
-        memset(dst, 0, cs->pixelSize());
-        cs->setOpacity(dst, OPACITY_OPAQUE_U8, 1);
-    }
 
+        quint8 *dstPtr = dstRow.data();
 
-    delete [] IntensityCount;        // free all the arrays
-    delete [] AverageChannels;
+        for (int x = applyRect.left(); x <= applyRect.right(); x++) {
+            if (x > applyRect.left()) {
+                const int leavingColumn = x - radius - 1;
+                const int enteringColumn = x + radius;
+
+                if (leavingColumn >= sourceRect.left()) {
+                    removeColumn(leavingColumn);
+                }
+
+                if (enteringColumn <= sourceRect.right()) {
+                    addColumn(enteringColumn);
+                }
+            }
+
+            histogram.mostFrequentColor(cs, dstPtr, channel);
+            dstPtr += pixelSize;
+        }
+
+        dst->writeBytes(dstRow.constData(), applyRect.left(), y, applyRect.width(), 1);
+
+        if (progressUpdater) {
+            progressUpdater->setValue(y - applyRect.top() + 1);
+        }
+    }
 }
 
 
@@ -106,7 +106,7 @@ void KisUnsharpFilter::processImpl(KisPaintDeviceSP device,
     KisGaussianKernel::applyGaussian(device, applyRect,
                                      halfSize, halfSize,
                                      channelFlags,
-                                     convolutionUpdater);
+                                     convolutionUpdater, true);
 
     qreal weights[2];
     qreal factor = 128;
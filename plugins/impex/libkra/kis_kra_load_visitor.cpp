@@ -24,6 +24,10 @@
 #include <QRect>
 #include <QBuffer>
 #include <QByteArray>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <functional>
+#include <kis_assert.h>
 
 #include <KoColorSpaceRegistry.h>
 #include <KoColorProfile.h>
@@ -62,6 +66,15 @@
 
 using namespace KRA;
 
+namespace {
+/**
+ * The compressed data queued in the parallel loading mode is
+ * decompressed as soon as it grows over this size, so that a big
+ * file is never kept in memory twice
+ */
+const qint64 maxPendingDataSize = 256 * 1024 * 1024;
+}
+
 QString expandEncodedDirectory(const QString& _intern)
 {
     QString intern = _intern;
@@ -93,6 +106,9 @@ KisKraLoadVisitor::KisKraLoadVisitor(KisImageSP image,
         m_keyframeFilenames(keyframeFilenames)
 {
     m_external = false;
+    m_parallelLoadingEnabled = false;
+    m_pendingReadingTime = 0;
+    m_pendingDataSize = 0;
     m_image = image;
     m_store = store;
     m_name = name;
@@ -118,12 +134,22 @@ KisKraLoadVisitor::KisKraLoadVisitor(KisImageSP image,
     m_syntaxVersion = syntaxVersion;
 }
 
+KisKraLoadVisitor::~KisKraLoadVisitor()
+{
+    KIS_SAFE_ASSERT_RECOVER_NOOP(m_pendingDevices.isEmpty());
+}
+
 void KisKraLoadVisitor::setExternalUri(const QString &uri)
 {
     m_external = true;
     m_uri = uri;
 }
 
+void KisKraLoadVisitor::setParallelLoadingEnabled(bool value)
+{
+    m_parallelLoadingEnabled = value;
+}
+
 bool KisKraLoadVisitor::visit(KisExternalLayer * layer)
 {
     bool result = false;
@@ -237,6 +263,10 @@ bool KisKraLoadVisitor::visit(KisGeneratorLayer *layer)
     loadNodeKeyframes(layer);
     result = loadSelection(getLocation(layer), layer->internalSelection());
     result = loadFilterConfiguration(layer->filter().data(), getLocation(layer, DOT_FILTERCONFIG));
+
+    // the generator needs the selection to be loaded
+    loadPendingPixelData();
+
     layer->update();
     result = visitAll(layer);
     return result;
@@ -388,6 +418,10 @@ bool KisKraLoadVisitor::visit(KisColorizeMask *mask)
     mask->setKeyStrokesDirect(QList<KisLazyFillTools::KeyStroke>::fromVector(strokes));
 
     loadPaintDevice(mask->coloringProjection(), COLORIZE_COLORING_DEVICE);
+
+    // the cache is built from the loaded devices
+    loadPendingPixelData();
+
     mask->resetCache();
 
     m_store->popDirectory();
@@ -469,6 +503,10 @@ bool KisKraLoadVisitor::loadPaintDevice(KisPaintDeviceSP device, const QString&
 template<class DevicePolicy>
 bool KisKraLoadVisitor::loadPaintDeviceFrame(KisPaintDeviceSP device, const QString &location, DevicePolicy policy)
 {
+    if (m_parallelLoadingEnabled) {
+        return queuePaintDeviceFrame(device, location, policy);
+    }
+
     if (m_store->open(location)) {
         if (!policy.read(device, m_store->device())) {
             m_warningMessages << i18n("Could not read pixel data: %1.", location);
@@ -495,6 +533,155 @@ bool KisKraLoadVisitor::loadPaintDeviceFrame(KisPaintDeviceSP device, const QStr
 }
 
 
+struct KisKraLoadVisitor::PendingFrameLoad
+{
+    QString location;
+    QByteArray data;
+    QByteArray defaultPixel;
+    std::function<bool (QIODevice*)> read;
+    std::function<void (const KoColor&)> setDefaultPixel;
+};
+
+struct KisKraLoadVisitor::PendingDeviceLoad
+{
+    PendingDeviceLoad() : decompressionTime(0) {}
+
+    KisPaintDeviceSP device;
+    QVector<PendingFrameLoad> frames;
+    QStringList failedLocations;
+    qint64 decompressionTime;
+};
+
+template<class DevicePolicy>
+bool KisKraLoadVisitor::queuePaintDeviceFrame(KisPaintDeviceSP device, const QString &location, DevicePolicy policy)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    PendingFrameLoad frame;
+    frame.location = location;
+
+    if (m_store->open(location)) {
+        frame.data = m_store->read(m_store->size());
+        m_store->close();
+    } else {
+        m_warningMessages << i18n("Could not load pixel data: %1.", location);
+        return true;
+    }
+    if (m_store->open(location + ".defaultpixel")) {
+        int pixelSize = device->colorSpace()->pixelSize();
+        if (m_store->size() == pixelSize) {
+            frame.defaultPixel = m_store->read(pixelSize);
+        }
+        m_store->close();
+    }
+
+    frame.read =
+        [device, policy] (QIODevice *stream) mutable {
+            return policy.read(device, stream);
+        };
+
+    frame.setDefaultPixel =
+        [device, policy] (const KoColor &color) {
+            policy.setDefaultPixel(device, color);
+        };
+
+    /**
+     * All the frames of a device are decompressed by the same job,
+     * so the device is never accessed by two threads at once
+     */
+    int index = m_pendingDeviceIndexes.value(device.data(), -1);
+    if (index < 0) {
+        index = m_pendingDevices.size();
+        m_pendingDevices.append(PendingDeviceLoad());
+        m_pendingDevices[index].device = device;
+        m_pendingDeviceIndexes.insert(device.data(), index);
+    }
+    m_pendingDevices[index].frames.append(frame);
+    m_pendingDataSize += frame.data.size();
+
+    m_pendingReadingTime += timer.elapsed();
+
+    if (m_pendingDataSize > maxPendingDataSize) {
+        loadPendingPixelData();
+    }
+
+    return true;
+}
+
+void KisKraLoadVisitor::loadPendingDevice(PendingDeviceLoad &load)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    for (int i = 0; i < load.frames.size(); i++) {
+        PendingFrameLoad &frame = load.frames[i];
+
+        QBuffer buffer(&frame.data);
+        buffer.open(QIODevice::ReadOnly);
+
+        if (!frame.read(&buffer)) {
+            load.failedLocations << frame.location;
+            continue;
+        }
+
+        if (!frame.defaultPixel.isEmpty()) {
+            /**
+             * The color space of the device might have got a new profile
+             * after the data has been queued, so we create the color
+             * right here to avoid any conversion of the default pixel
+             */
+            KoColor color((const quint8*)frame.defaultPixel.constData(),
+                          load.device->colorSpace());
+            frame.setDefaultPixel(color);
+        }
+
+        // free the compressed data as soon as possible
+        frame.data = QByteArray();
+    }
+
+    load.decompressionTime = timer.elapsed();
+}
+
+void KisKraLoadVisitor::loadPendingPixelData()
+{
+    if (m_pendingDevices.isEmpty()) return;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    QtConcurrent::blockingMap(m_pendingDevices, &KisKraLoadVisitor::loadPendingDevice);
+
+    const qint64 wallTime = timer.elapsed();
+
+    int numFrames = 0;
+    qint64 cpuTime = 0;
+
+    Q_FOREACH (const PendingDeviceLoad &load, m_pendingDevices) {
+        numFrames += load.frames.size();
+        cpuTime += load.decompressionTime;
+
+        Q_FOREACH (const QString &location, load.failedLocations) {
+            m_warningMessages << i18n("Could not read pixel data: %1.", location);
+        }
+
+        if (!load.failedLocations.isEmpty()) {
+            load.device->disconnect();
+        }
+    }
+
+    dbgFile << "Loaded pixel data of" << m_pendingDevices.size() << "devices"
+            << "(" << numFrames << "frames )";
+    dbgFile << "    reading from the store:" << m_pendingReadingTime << "ms";
+    dbgFile << "    decompression:" << wallTime << "ms"
+            << "(" << cpuTime << "ms of the summed job time )";
+
+    m_pendingDevices.clear();
+    m_pendingDeviceIndexes.clear();
+    m_pendingReadingTime = 0;
+    m_pendingDataSize = 0;
+}
+
 bool KisKraLoadVisitor::loadProfile(KisPaintDeviceSP device, const QString& location)
 {
 
@@ -22,6 +22,8 @@
 
 #include <QRect>
 #include <QStringList>
+#include <QHash>
+#include <QVector>
 
 // kritaimage
 #include "kis_types.h"
@@ -44,9 +46,26 @@ public:
                       const QString & name,
                       int syntaxVersion);
 
+    ~KisKraLoadVisitor() override;
+
 public:
     void setExternalUri(const QString &uri);
 
+    /**
+     * In the parallel loading mode the visitor only reads the compressed
+     * pixel data of the paint devices from the store. The data is
+     * decompressed later, concurrently for all the devices, when
+     * loadPendingPixelData() is called or when the queued data grows
+     * too big. The caller must call it after the visitor has finished.
+     */
+    void setParallelLoadingEnabled(bool value);
+
+    /**
+     * Decompresses the pixel data queued in the parallel loading mode
+     * and writes the timings of the loading stages to the debug log
+     */
+    void loadPendingPixelData();
+
     bool visit(KisNode*) override {
         return true;
     }
@@ -72,6 +91,13 @@ private:
     template<class DevicePolicy>
     bool loadPaintDeviceFrame(KisPaintDeviceSP device, const QString &location, DevicePolicy policy);
 
+    template<class DevicePolicy>
+    bool queuePaintDeviceFrame(KisPaintDeviceSP device, const QString &location, DevicePolicy policy);
+
+    struct PendingFrameLoad;
+    struct PendingDeviceLoad;
+    static void loadPendingDevice(PendingDeviceLoad &load);
+
     bool loadProfile(KisPaintDeviceSP device,  const QString& location);
     bool loadFilterConfiguration(KisFilterConfigurationSP kfc, const QString& location);
     bool loadMetaData(KisNode* node);
@@ -100,6 +126,12 @@ private:
     int m_syntaxVersion;
     QStringList m_errorMessages;
     QStringList m_warningMessages;
+
+    bool m_parallelLoadingEnabled;
+    QVector<PendingDeviceLoad> m_pendingDevices;
+    QHash<KisPaintDevice*, int> m_pendingDeviceIndexes;
+    qint64 m_pendingReadingTime;
+    qint64 m_pendingDataSize;
 };
 
 #endif // KIS_KRA_LOAD_VISITOR_H_
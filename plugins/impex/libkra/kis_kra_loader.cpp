@@ -407,7 +407,10 @@ void KisKraLoader::loadBinaryData(KoStore * store, KisImageSP image, const QStri
         visitor.setExternalUri(uri);
     }
 
+    visitor.setParallelLoadingEnabled(KisImageConfig(true).useParallelFileLoading());
+
     image->rootLayer()->accept(visitor);
+    visitor.loadPendingPixelData();
     if (!visitor.errorMessages().isEmpty()) {
         m_d->errorMessages.append(visitor.errorMessages());
     }
@@ -37,6 +37,8 @@
 #include "kis_image_animation_interface.h"
 #include "kis_keyframe_channel.h"
 #include "kis_time_range.h"
+#include "kis_image_config.h"
+#include "kis_layer_utils.h"
 
 void KisKraLoaderTest::initTestCase()
 {
@@ -169,4 +171,54 @@ void KisKraLoaderTest::testLoadAnimated()
 }
 
 
+KisImageSP loadTestImage(bool parallelLoading, QScopedPointer<KisDocument> &doc)
+{
+    KisImageConfig cfg;
+    const bool oldValue = cfg.useParallelFileLoading();
+    cfg.setUseParallelFileLoading(parallelLoading);
+
+    doc.reset(KisPart::instance()->createDocument());
+    doc->loadNativeFormat(QString(FILES_DATA_DIR) + QDir::separator() + "load_test.kra");
+
+    cfg.setUseParallelFileLoading(oldValue);
+
+    return doc->image();
+}
+
+void KisKraLoaderTest::testParallelLoading()
+{
+    QScopedPointer<KisDocument> serialDoc;
+    QScopedPointer<KisDocument> parallelDoc;
+
+    KisImageSP serialImage = loadTestImage(false, serialDoc);
+    KisImageSP parallelImage = loadTestImage(true, parallelDoc);
+
+    serialImage->waitForDone();
+    parallelImage->waitForDone();
+
+    QList<KisNodeSP> serialNodes;
+    QList<KisNodeSP> parallelNodes;
+
+    KisLayerUtils::recursiveApplyNodes(serialImage->root(),
+        [&serialNodes] (KisNodeSP node) { serialNodes << node; });
+    KisLayerUtils::recursiveApplyNodes(parallelImage->root(),
+        [&parallelNodes] (KisNodeSP node) { parallelNodes << node; });
+
+    QCOMPARE(parallelNodes.size(), serialNodes.size());
+
+    for (int i = 0; i < serialNodes.size(); i++) {
+        QCOMPARE(parallelNodes[i]->name(), serialNodes[i]->name());
+
+        KisPaintDeviceSP serialDevice = serialNodes[i]->paintDevice();
+        KisPaintDeviceSP parallelDevice = parallelNodes[i]->paintDevice();
+
+        QCOMPARE(bool(parallelDevice), bool(serialDevice));
+
+        if (serialDevice) {
+            QPoint pt;
+            QVERIFY(TestUtil::comparePaintDevices(pt, parallelDevice, serialDevice));
+        }
+    }
+}
+
 QTEST_MAIN(KisKraLoaderTest)
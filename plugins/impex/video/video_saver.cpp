@@ -43,8 +43,12 @@
 #include <QTemporaryFile>
 #include <QTemporaryDir>
 #include <QTime>
+#include <QImage>
+#include <QDir>
 
 #include "KisPart.h"
+#include "KisAnimationFrameSink.h"
+#include "dialogs/KisAsyncAnimationFramesStreamDialog.h"
 
 class KisFFMpegProgressWatcher : public QObject {
     Q_OBJECT
@@ -95,7 +99,7 @@ private:
 };
 
 
-class KisFFMpegRunner
+class KisFFMpegRunner : public KisAnimationFrameSink
 {
 public:
     KisFFMpegRunner(const QString &ffmpegPath)
@@ -107,42 +111,91 @@ public:
                                      const QString &logPath,
                                      int totalFrames)
     {
-        dbgFile << "runFFMpeg: specialArgs" << specialArgs
-                << "actionName" << actionName
+        startFFMpeg(specialArgs, logPath, false);
+        return waitForFFMpegProcess(actionName, totalFrames);
+    }
+
+    /**
+     * Starts ffmpeg without waiting for it to finish. If \p readFramesFromStdin
+     * is true, the frames are passed to the process with writeFrame(). The
+     * caller must then call closeFramesInput() and waitForFFMpegProcess().
+     */
+    void startFFMpeg(const QStringList &specialArgs,
+                     const QString &logPath,
+                     bool readFramesFromStdin)
+    {
+        dbgFile << "startFFMpeg: specialArgs" << specialArgs
                 << "logPath" << logPath
-                << "totalFrames" << totalFrames;
+                << "readFramesFromStdin" << readFramesFromStdin;
 
-        QTemporaryFile progressFile(QDir::tempPath() + QDir::separator() + "KritaFFmpegProgress.XXXXXX");
-        progressFile.open();
+        m_progressFile.reset(new QTemporaryFile(QDir::tempPath() + QDir::separator() + "KritaFFmpegProgress.XXXXXX"));
+        m_progressFile->open();
 
         m_process.setStandardOutputFile(logPath);
         m_process.setProcessChannelMode(QProcess::MergedChannels);
         QStringList args;
-        args << "-v" << "debug"
-             << "-nostdin"
-             << "-progress" << progressFile.fileName()
+        args << "-v" << "debug";
+
+        if (!readFramesFromStdin) {
+            args << "-nostdin";
+        }
+
+        args << "-progress" << m_progressFile->fileName()
              << specialArgs;
 
         qDebug() << "\t" << m_ffmpegPath << args.join(" ");
 
         m_cancelled = false;
         m_process.start(m_ffmpegPath, args);
-        return waitForFFMpegProcess(actionName, progressFile, m_process, totalFrames);
     }
 
-    void cancel() {
-        m_cancelled = true;
-        m_process.kill();
+    bool writeFrame(int frame, const QImage &image) override
+    {
+        Q_UNUSED(frame);
+
+        if (m_cancelled || m_process.state() == QProcess::NotRunning) {
+            return false;
+        }
+
+        const qint64 frameSize = image.byteCount();
+        if (m_process.write(reinterpret_cast<const char*>(image.constBits()), frameSize) != frameSize) {
+            return false;
+        }
+
+        /**
+         * Don't let the frames pile up in the write buffer when the
+         * encoder is slower than the renderer. The events are still
+         * processed while waiting, so the GUI stays responsive, and a
+         * slow encoder is not treated as a failure.
+         */
+        if (m_process.bytesToWrite() > maxPendingFramesBytes) {
+            QEventLoop loop;
+            QObject::connect(&m_process, &QProcess::bytesWritten, &loop,
+                [this, &loop] () {
+                    if (m_process.bytesToWrite() <= maxPendingFramesBytes) {
+                        loop.quit();
+                    }
+                });
+            loop.connect(&m_process, SIGNAL(finished(int, QProcess::ExitStatus)), SLOT(quit()));
+
+            if (m_process.state() != QProcess::NotRunning) {
+                loop.exec();
+            }
+        }
+
+        return !m_cancelled && m_process.state() != QProcess::NotRunning;
+    }
+
+    void closeFramesInput()
+    {
+        m_process.closeWriteChannel();
     }
 
-private:
     KisImageBuilder_Result waitForFFMpegProcess(const QString &message,
-                                                QFile &progressFile,
-                                                QProcess &ffmpegProcess,
                                                 int totalFrames)
     {
 
-        KisFFMpegProgressWatcher watcher(progressFile, totalFrames);
+        KisFFMpegProgressWatcher watcher(*m_progressFile, totalFrames);
 
         QProgressDialog progress(message, "", 0, 0, KisPart::instance()->currentMainwindow());
         progress.setWindowModality(Qt::ApplicationModal);
@@ -153,30 +206,44 @@ private:
 
         QEventLoop loop;
         loop.connect(&watcher, SIGNAL(sigProcessingFinished()), SLOT(quit()));
-        loop.connect(&ffmpegProcess, SIGNAL(finished(int, QProcess::ExitStatus)), SLOT(quit()));
+        loop.connect(&m_process, SIGNAL(finished(int, QProcess::ExitStatus)), SLOT(quit()));
         loop.connect(&watcher, SIGNAL(sigProgressChanged(int)), &progress, SLOT(setValue(int)));
-        loop.exec();
+
+        if (m_process.state() != QProcess::NotRunning) {
+            loop.exec();
+        }
 
         // wait for some erroneous case
-        ffmpegProcess.waitForFinished(5000);
+        m_process.waitForFinished(5000);
 
         KisImageBuilder_Result retval = KisImageBuilder_RESULT_OK;
 
-        if (ffmpegProcess.state() != QProcess::NotRunning) {
+        if (m_process.state() != QProcess::NotRunning) {
             // sorry...
-            ffmpegProcess.kill();
+            m_process.kill();
             retval = KisImageBuilder_RESULT_FAILURE;
         } else if (m_cancelled) {
             retval = KisImageBuilder_RESULT_CANCEL;
-        } else if (ffmpegProcess.exitCode()) {
+        } else if (m_process.exitStatus() != QProcess::NormalExit || m_process.exitCode()) {
             retval = KisImageBuilder_RESULT_FAILURE;
         }
 
+        m_progressFile.reset();
+
         return retval;
     }
 
+    void cancel() {
+        m_cancelled = true;
+        m_process.kill();
+    }
+
+private:
+    static const qint64 maxPendingFramesBytes = 64 * 1024 * 1024;
+
 private:
     QProcess m_process;
+    QScopedPointer<QTemporaryFile> m_progressFile;
     bool m_cancelled;
     QString m_ffmpegPath;
 };
@@ -260,6 +327,80 @@ KisImageBuilder_Result VideoSaver::encode(const QString &filename, KisProperties
 
     const QStringList additionalOptionsList = configuration->getString("customUserOptions").split(' ', QString::SkipEmptyParts);
 
+    const bool needsScaling = m_image->height() != exportHeight || m_image->width() != exportWidth;
+
+    auto appendAudioArgs = [&] (QStringList &args) {
+        QFileInfo audioFileInfo = animation->audioChannelFileName();
+        if (includeAudio && audioFileInfo.exists()) {
+            const int msecStart = clipRange.start() * 1000 / animation->framerate();
+            const int msecDuration = clipRange.duration() * 1000 / animation->framerate();
+
+            const QTime startTime = QTime::fromMSecsSinceStartOfDay(msecStart);
+            const QTime durationTime = QTime::fromMSecsSinceStartOfDay(msecDuration);
+            const QString ffmpegTimeFormat("H:m:s.zzz");
+
+            args << "-ss" << startTime.toString(ffmpegTimeFormat);
+            args << "-t" << durationTime.toString(ffmpegTimeFormat);
+
+            args << "-i" << audioFileInfo.absoluteFilePath();
+        }
+    };
+
+    if (configuration->getBool("stream_frames", false)) {
+        /**
+         * The frames are rendered right here and piped to ffmpeg as raw
+         * RGBA data, so the encoding overlaps with the rendering and no
+         * intermediate image files are written
+         */
+        const KisTimeRange streamRange =
+            KisTimeRange::fromTime(configuration->getInt("first_frame", fullRange.start()),
+                                   configuration->getInt("last_frame", fullRange.end()));
+
+        QStringList args;
+        args << "-f" << "rawvideo"
+             << "-pix_fmt" << "rgba"
+             << "-s" << QString("%1x%2").arg(m_image->width()).arg(m_image->height())
+             << "-r" << QString::number(frameRate)
+             << "-i" << "-";
+
+        if (suffix == "gif") {
+            // the palette is generated from the same stream in a single pass
+            const QString scaling = needsScaling ? exportDimensions + "," : QString();
+            args << "-lavfi" << scaling + "split[a][b];[a]palettegen[p];[b][p]paletteuse";
+        } else {
+            if (needsScaling) {
+                args << "-vf" << exportDimensions;
+            }
+            appendAudioArgs(args);
+        }
+
+        args << additionalOptionsList
+             << "-y" << resultFile;
+
+        // no frames are saved, but the log still goes to the rendering directory
+        if (!framesDir.exists()) {
+            framesDir.mkpath(framesDir.absolutePath());
+        }
+
+        m_runner->startFFMpeg(args, framesDir.filePath("log_encode_stream.log"), true);
+
+        KisAsyncAnimationFramesStreamDialog renderer(m_image, streamRange, m_runner.data());
+        renderer.setBatchMode(m_batchMode);
+
+        const KisAsyncAnimationRenderDialogBase::Result renderResult = renderer.regenerateRange(0);
+
+        if (renderResult != KisAsyncAnimationRenderDialogBase::RenderComplete) {
+            m_runner->cancel();
+            m_runner->waitForFFMpegProcess(i18n("Encoding frames..."), streamRange.duration());
+
+            return renderResult == KisAsyncAnimationRenderDialogBase::RenderCancelled ?
+                KisImageBuilder_RESULT_CANCEL : KisImageBuilder_RESULT_FAILURE;
+        }
+
+        m_runner->closeFramesInput();
+        return m_runner->waitForFFMpegProcess(i18n("Encoding frames..."), streamRange.duration());
+    }
+
     if (suffix == "gif") {
         {
             QStringList args;
@@ -313,25 +454,11 @@ KisImageBuilder_Result VideoSaver::encode(const QString &filename, KisProperties
              << "-i" << savedFilesMask;
 
         // if we are exporting out at a different image size, we apply scaling filter
-        if (m_image->height() != exportHeight || m_image->width() != exportWidth) {
+        if (needsScaling) {
             args << "-vf" << exportDimensions;
         }
 
-
-        QFileInfo audioFileInfo = animation->audioChannelFileName();
-        if (includeAudio && audioFileInfo.exists()) {
-            const int msecStart = clipRange.start() * 1000 / animation->framerate();
-            const int msecDuration = clipRange.duration() * 1000 / animation->framerate();
-
-            const QTime startTime = QTime::fromMSecsSinceStartOfDay(msecStart);
-            const QTime durationTime = QTime::fromMSecsSinceStartOfDay(msecDuration);
-            const QString ffmpegTimeFormat("H:m:s.zzz");
-
-            args << "-ss" << startTime.toString(ffmpegTimeFormat);
-            args << "-t" << durationTime.toString(ffmpegTimeFormat);
-
-            args << "-i" << audioFileInfo.absoluteFilePath();
-        }
+        appendAudioArgs(args);
 
         args << additionalOptionsList
              << "-y" << resultFile;
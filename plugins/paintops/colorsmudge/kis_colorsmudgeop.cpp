@@ -21,6 +21,8 @@
 #include <cmath>
 #include <memory>
 #include <QRect>
+#include <QtConcurrent>
+#include <QtMath>
 
 #include <KoColorSpaceRegistry.h>
 #include <KoColor.h>
@@ -40,6 +42,13 @@
 #include <kis_spacing_information.h>
 #include <KoColorModelStandardIds.h>
 
+namespace {
+/**
+ * Dabs with both sides not smaller than this are split into stripes
+ * and rendered in parallel.
+ */
+const int minStripedDabSize = 128;
+}
 
 KisColorSmudgeOp::KisColorSmudgeOp(const KisPaintOpSettingsSP settings, KisPainter* painter, KisNodeSP node, KisImageSP image)
     : KisBrushBasedPaintOp(settings, painter)
@@ -116,6 +125,11 @@ KisColorSmudgeOp::~KisColorSmudgeOp()
     delete m_hsvTransform;
 }
 
+void KisColorSmudgeOp::testingSetStripedRenderingEnabled(bool value)
+{
+    m_stripedRenderingEnabled = value;
+}
+
 void KisColorSmudgeOp::updateMask(const KisPaintInformation& info, double scale, double rotation, const QPointF &cursorPoint)
 {
     static const KoColorSpace *cs = KoColorSpaceRegistry::instance()->alpha8();
@@ -223,25 +237,42 @@ KisSpacingInformation KisColorSmudgeOp::paintAt(const KisPaintInformation& info)
 
     const qreal fpOpacity  = (qreal(painter()->opacity()) / 255.0) * m_opacityOption.getOpacityf(info);
 
-    if (m_image && m_overlayModeOption.isChecked()) {
-        m_image->blockUpdates();
-        m_backgroundPainter->bitBlt(QPoint(), m_image->projection(), srcDabRect);
-        m_image->unblockUpdates();
-    }
-    else {
-        // IMPORTANT: clear the temporary painting device to color black with zero opacity:
-        //            it will only clear the extents of the brush.
-        m_tempDev->clear(QRect(QPoint(), m_dstDabRect.size()));
-    }
-
+    const bool useOverlayMode = m_image && m_overlayModeOption.isChecked();
     const bool useDullingMode = m_smudgeRateOption.getMode() == KisSmudgeOption::DULLING_MODE;
 
+    /**
+     * Big dabs are rendered in stripes in parallel. Mirrored dabs are
+     * rendered with the sequential code path only, since the mirroring
+     * is done by the painter in one go.
+     */
+    const bool renderInStripes =
+        m_stripedRenderingEnabled &&
+        m_dstDabRect.width() >= minStripedDabSize &&
+        m_dstDabRect.height() >= minStripedDabSize &&
+        !m_finalPainter->hasMirroring();
+
+    if (!renderInStripes) {
+        if (useOverlayMode) {
+            m_image->blockUpdates();
+            m_backgroundPainter->bitBlt(QPoint(), m_image->projection(), srcDabRect);
+            m_image->unblockUpdates();
+        }
+        else {
+            // IMPORTANT: clear the temporary painting device to color black with zero opacity:
+            //            it will only clear the extents of the brush.
+            m_tempDev->clear(QRect(QPoint(), m_dstDabRect.size()));
+        }
+    }
+
     // stored in the color space of the paintColor
     KoColor dullingFillColor = m_paintColor;
 
     if (!useDullingMode) {
         m_preciseWrapper.readRect(srcDabRect);
-        m_smudgePainter->bitBlt(QPoint(), m_preciseWrapper.preciseDevice(), srcDabRect);
+
+        if (!renderInStripes) {
+            m_smudgePainter->bitBlt(QPoint(), m_preciseWrapper.preciseDevice(), srcDabRect);
+        }
     } else {
         QPoint pt = (srcDabRect.topLeft() + hotSpot).toPoint();
 
@@ -265,6 +296,9 @@ KisSpacingInformation KisColorSmudgeOp::paintAt(const KisPaintInformation& info)
         }
     }
 
+    // the color mixed into the dab in the smearing mode
+    KoColor colorRateColor = m_paintColor;
+
     // if the user selected the color smudge option,
     // we will mix some color into the temporary painting device (m_tempDev)
     if (m_colorRateOption.isChecked()) {
@@ -291,7 +325,10 @@ KisSpacingInformation KisColorSmudgeOp::paintAt(const KisPaintInformation& info)
                 color.convertTo(m_colorRatePainter->device()->colorSpace());
             }
 
-            m_colorRatePainter->fill(0, 0, m_dstDabRect.width(), m_dstDabRect.height(), color);
+            if (!renderInStripes) {
+                m_colorRatePainter->fill(0, 0, m_dstDabRect.width(), m_dstDabRect.height(), color);
+            }
+            colorRateColor = color;
         } else {
             KIS_SAFE_ASSERT_RECOVER(*dullingFillColor.colorSpace() == *color.colorSpace()) {
                 color.convertTo(dullingFillColor.colorSpace());
@@ -306,44 +343,171 @@ KisSpacingInformation KisColorSmudgeOp::paintAt(const KisPaintInformation& info)
         }
     }
 
-    if (useDullingMode) {
+    if (useDullingMode && !renderInStripes) {
         KIS_SAFE_ASSERT_RECOVER_NOOP(*dullingFillColor.colorSpace() == *m_preciseWrapper.preciseColorSpace());
         m_tempDev->fill(QRect(0, 0, m_dstDabRect.width(), m_dstDabRect.height()), dullingFillColor);
     }
 
     m_preciseWrapper.readRects(m_finalPainter->calculateAllMirroredRects(m_dstDabRect));
 
-    // if color is disabled (only smudge) and "overlay mode" is enabled
-    // then first blit the region under the brush from the image projection
-    // to the painting device to prevent a rapid build up of alpha value
-    // if the color to be smudged is semi transparent.
-    if (m_image && m_overlayModeOption.isChecked() && !m_colorRateOption.isChecked()) {
-        m_finalPainter->setOpacity(OPACITY_OPAQUE_U8);
-        m_image->blockUpdates();
-        // TODO: check if this code is correct in mirrored mode! Technically, the
-        //       painter renders the mirrored dab only, so we should also prepare
-        //       the overlay for it in all the places.
-        m_finalPainter->bitBlt(m_dstDabRect.topLeft(), m_image->projection(), m_dstDabRect);
-        m_image->unblockUpdates();
-    }
+    QVector<QRect> dirtyRects;
 
+    if (renderInStripes) {
+        // set opacity calculated by the rate option
+        m_smudgeRateOption.apply(*m_finalPainter, info, 0.0, 1.0, fpOpacity);
 
-    // set opacity calculated by the rate option
-    m_smudgeRateOption.apply(*m_finalPainter, info, 0.0, 1.0, fpOpacity);
+        dirtyRects = renderDabInStripes(srcDabRect,
+                                        colorRateColor, dullingFillColor,
+                                        useOverlayMode, useDullingMode);
+    } else {
+        // if color is disabled (only smudge) and "overlay mode" is enabled
+        // then first blit the region under the brush from the image projection
+        // to the painting device to prevent a rapid build up of alpha value
+        // if the color to be smudged is semi transparent.
+        if (useOverlayMode && !m_colorRateOption.isChecked()) {
+            m_finalPainter->setOpacity(OPACITY_OPAQUE_U8);
+            m_image->blockUpdates();
+            // TODO: check if this code is correct in mirrored mode! Technically, the
+            //       painter renders the mirrored dab only, so we should also prepare
+            //       the overlay for it in all the places.
+            m_finalPainter->bitBlt(m_dstDabRect.topLeft(), m_image->projection(), m_dstDabRect);
+            m_image->unblockUpdates();
+        }
+
+
+        // set opacity calculated by the rate option
+        m_smudgeRateOption.apply(*m_finalPainter, info, 0.0, 1.0, fpOpacity);
 
-    // then blit the temporary painting device on the canvas at the current brush position
-    // the alpha mask (maskDab) will be used here to only blit the pixels that are in the area (shape) of the brush
+        // then blit the temporary painting device on the canvas at the current brush position
+        // the alpha mask (maskDab) will be used here to only blit the pixels that are in the area (shape) of the brush
 
-    m_finalPainter->bitBltWithFixedSelection(m_dstDabRect.x(), m_dstDabRect.y(), m_tempDev, m_maskDab, m_dstDabRect.width(), m_dstDabRect.height());
-    m_finalPainter->renderMirrorMaskSafe(m_dstDabRect, m_tempDev, 0, 0, m_maskDab, !m_dabCache->needSeparateOriginal());
+        m_finalPainter->bitBltWithFixedSelection(m_dstDabRect.x(), m_dstDabRect.y(), m_tempDev, m_maskDab, m_dstDabRect.width(), m_dstDabRect.height());
+        m_finalPainter->renderMirrorMaskSafe(m_dstDabRect, m_tempDev, 0, 0, m_maskDab, !m_dabCache->needSeparateOriginal());
+
+        dirtyRects = m_finalPainter->takeDirtyRegion();
+    }
 
-    const QVector<QRect> dirtyRects = m_finalPainter->takeDirtyRegion();
     m_preciseWrapper.writeRects(dirtyRects);
     painter()->addDirtyRects(dirtyRects);
 
     return spacingInfo;
 }
 
+QVector<QRect> KisColorSmudgeOp::renderDabInStripes(const QRect &srcDabRect,
+                                                    const KoColor &colorRateColor,
+                                                    const KoColor &dullingFillColor,
+                                                    bool useOverlayMode,
+                                                    bool useDullingMode)
+{
+    /**
+     * Split the dab into horizontal stripes aligned to the tiles of the
+     * destination device, so that no two stripes write into the same
+     * tile of the canvas. The stripes are stored in the coordinate
+     * system of m_tempDev, that is relative to the top-left corner of
+     * the dab.
+     */
+    QVector<QRect> stripes;
+    {
+        const int tileHeight = 64;
+        const int dabTop = m_dstDabRect.y();
+        int y = 0;
+
+        while (y < m_dstDabRect.height()) {
+            const int tileRowEnd = tileHeight * qFloor(qreal(dabTop + y) / tileHeight + 1.0) - dabTop;
+            const int stripeHeight = qMin(tileRowEnd, m_dstDabRect.height()) - y;
+
+            stripes << QRect(0, y, m_dstDabRect.width(), stripeHeight);
+            y += stripeHeight;
+        }
+    }
+
+    const bool useColorRate = m_colorRateOption.isChecked();
+
+    KisPaintDeviceSP preciseDevice = m_preciseWrapper.preciseDevice();
+    KisPaintDeviceSP projection = useOverlayMode ? m_image->projection() : KisPaintDeviceSP();
+
+    const QString colorRateCompositeOp = m_colorRatePainter->compositeOp()->id();
+    const quint8 colorRateOpacity = m_colorRatePainter->opacity();
+
+    const quint8 smudgeOpacity = m_finalPainter->opacity();
+    KisSelectionSP selection = m_finalPainter->selection();
+    const QBitArray channelFlags = m_finalPainter->channelFlags();
+    const QRect maskBounds = m_maskDab->bounds();
+
+    if (useOverlayMode) {
+        m_image->blockUpdates();
+    }
+
+    /**
+     * First pass: fill the temporary device with the smudged and mixed
+     * colors. It reads from the canvas, so it should be complete before
+     * we start writing the dab back.
+     */
+    QtConcurrent::blockingMap(stripes,
+        [&] (const QRect &rc) {
+            const QRect srcRect = rc.translated(srcDabRect.topLeft());
+            KisPainter gc(m_tempDev);
+
+            if (useOverlayMode) {
+                gc.setCompositeOp(COMPOSITE_COPY);
+                gc.bitBlt(rc.topLeft(), projection, srcRect);
+            } else {
+                m_tempDev->clear(rc);
+            }
+
+            if (!useDullingMode) {
+                gc.setCompositeOp(COMPOSITE_OVER);
+                gc.bitBlt(rc.topLeft(), preciseDevice, srcRect);
+
+                if (useColorRate) {
+                    gc.setCompositeOp(colorRateCompositeOp);
+                    gc.setOpacity(colorRateOpacity);
+                    gc.fill(rc.x(), rc.y(), rc.width(), rc.height(), colorRateColor);
+                }
+            } else {
+                m_tempDev->fill(rc, dullingFillColor);
+            }
+        });
+
+    /**
+     * Second pass: blit the temporary device on the canvas through the
+     * brush mask.
+     */
+    QtConcurrent::blockingMap(stripes,
+        [&] (const QRect &rc) {
+            const QRect dstRect = rc.translated(m_dstDabRect.topLeft());
+
+            KisPainter gc(preciseDevice);
+            gc.setCompositeOp(COMPOSITE_COPY);
+            gc.setSelection(selection);
+            gc.setChannelFlags(channelFlags);
+
+            // see the comment about the overlay mode in paintAt()
+            if (useOverlayMode && !useColorRate) {
+                gc.setOpacity(OPACITY_OPAQUE_U8);
+                gc.bitBlt(dstRect.topLeft(), projection, dstRect);
+            }
+
+            gc.setOpacity(smudgeOpacity);
+            gc.bitBltWithFixedSelection(dstRect.x(), dstRect.y(),
+                                        m_tempDev, m_maskDab,
+                                        maskBounds.x() + rc.x(), maskBounds.y() + rc.y(),
+                                        rc.x(), rc.y(),
+                                        rc.width(), rc.height());
+        });
+
+    if (useOverlayMode) {
+        m_image->unblockUpdates();
+    }
+
+    QVector<QRect> dirtyRects;
+    Q_FOREACH (const QRect &rc, stripes) {
+        dirtyRects << rc.translated(m_dstDabRect.topLeft());
+    }
+
+    return dirtyRects;
+}
+
 KisSpacingInformation KisColorSmudgeOp::updateSpacingImpl(const KisPaintInformation &info) const
 {
     const qreal scale = m_sizeOption.apply(info) * KisLodTransform::lodToScale(painter()->device());
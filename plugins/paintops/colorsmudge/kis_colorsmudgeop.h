@@ -20,6 +20,7 @@
 #define _KIS_COLORSMUDGEOP_H_
 
 #include <QRect>
+#include <QVector>
 
 #include <kis_brush_based_paintop.h>
 #include <kis_types.h>
@@ -50,6 +51,12 @@ public:
     KisColorSmudgeOp(const KisPaintOpSettingsSP settings, KisPainter* painter, KisNodeSP node, KisImageSP image);
     ~KisColorSmudgeOp() override;
 
+    /**
+     * Forces the sequential code path for all dabs, used by the
+     * unittests to compare the result of the two paths
+     */
+    void testingSetStripedRenderingEnabled(bool value);
+
 protected:
     KisSpacingInformation paintAt(const KisPaintInformation& info) override;
 
@@ -61,6 +68,19 @@ private:
 
     inline void getTopLeftAligned(const QPointF &pos, const QPointF &hotSpot, qint32 *x, qint32 *y);
 
+    /**
+     * Renders the current dab in horizontal stripes concurrently. All the
+     * stripes of m_tempDev are prepared before any of them is written onto
+     * the canvas, so the result is the same as of the sequential path.
+     *
+     * @return the dirty rects of the canvas
+     */
+    QVector<QRect> renderDabInStripes(const QRect &srcDabRect,
+                                      const KoColor &colorRateColor,
+                                      const KoColor &dullingFillColor,
+                                      bool useOverlayMode,
+                                      bool useDullingMode);
+
 private:
     bool                      m_firstRun;
     KisImageWSP               m_image;
@@ -89,6 +109,7 @@ private:
 
     KoColorTransformation *m_hsvTransform {0};
     const KoCompositeOp *m_preciseColorRateCompositeOp {0};
+    bool m_stripedRenderingEnabled {true};
 };
 
 #endif // _KIS_COLORSMUDGEOP_H_
@@ -0,0 +1,153 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#include "KisColorSmudgeOpTest.h"
+
+#include <QTest>
+
+#include <KoColor.h>
+#include <KoColorSpaceRegistry.h>
+#include <kis_image.h>
+#include <kis_paint_device.h>
+#include <kis_paint_layer.h>
+#include <kis_painter.h>
+#include <kis_auto_brush.h>
+#include <kis_circle_mask_generator.h>
+#include <kis_brush_option.h>
+#include <kis_brush_based_paintop_settings.h>
+#include <kis_distance_information.h>
+#include <brushengine/kis_paint_information.h>
+
+#include "kis_colorsmudgeop.h"
+#include "kis_smudge_option.h"
+#include "kis_rate_option.h"
+#include "kis_overlay_mode_option.h"
+#include "testutil.h"
+
+namespace {
+
+KisPaintOpSettingsSP createSettings(KisSmudgeOption::Mode mode, bool useColorRate, bool useOverlayMode)
+{
+    KisPaintOpSettingsSP settings = new KisBrushBasedPaintOpSettings();
+
+    // the dab is big enough to be split into several stripes
+    KisCircleMaskGenerator *generator =
+        new KisCircleMaskGenerator(300, 1.0, 0.5, 0.5, 2, true);
+
+    KisBrushOption brushOption;
+    brushOption.setBrush(new KisAutoBrush(generator, 0.0, 0.0));
+    brushOption.writeOptionSetting(settings);
+
+    KisSmudgeOption smudgeOption;
+    smudgeOption.setMode(mode);
+    smudgeOption.setChecked(true);
+    smudgeOption.setRate(0.7);
+    smudgeOption.writeOptionSetting(settings);
+
+    KisRateOption colorRateOption("ColorRate", KisPaintOpOption::GENERAL, false);
+    colorRateOption.setChecked(useColorRate);
+    colorRateOption.setRate(0.3);
+    colorRateOption.writeOptionSetting(settings);
+
+    KisOverlayModeOption overlayModeOption;
+    overlayModeOption.setChecked(useOverlayMode);
+    overlayModeOption.writeOptionSetting(settings);
+
+    return settings;
+}
+
+KisPaintDeviceSP paintStroke(KisPaintOpSettingsSP settings, bool useStripes)
+{
+    const KoColorSpace *cs = KoColorSpaceRegistry::instance()->rgb8();
+
+    // the overlay mode reads the smudged color from the projection
+    KisImageSP image = new KisImage(0, 800, 800, cs, "smudge test");
+    KisPaintLayerSP layer = new KisPaintLayer(image, "paint1", OPACITY_OPAQUE_U8);
+    image->addNode(layer);
+
+    KisPaintDeviceSP dev = layer->paintDevice();
+
+    // bars not aligned to the tiles, so that smudging has something to mix
+    const QVector<QColor> colors = {Qt::red, Qt::green, Qt::blue, Qt::yellow};
+    for (int i = 0; i < 20; i++) {
+        dev->fill(QRect(i * 37, 0, 37, 800), KoColor(colors[i % colors.size()], cs));
+    }
+
+    image->initialRefreshGraph();
+    image->waitForDone();
+
+    KisPainter gc(dev);
+    gc.setPaintColor(KoColor(Qt::white, cs));
+
+    KisColorSmudgeOp op(settings, &gc, layer, image);
+    op.testingSetStripedRenderingEnabled(useStripes);
+
+    // KisColorSmudgeOp hides the public overload with its own paintAt()
+    KisPaintOp &paintOp = op;
+    KisDistanceInformation dist;
+
+    // the first dab only remembers the position
+    paintOp.paintAt(KisPaintInformation(QPointF(250, 250), 1.0), &dist);
+    paintOp.paintAt(KisPaintInformation(QPointF(290, 270), 1.0), &dist);
+    paintOp.paintAt(KisPaintInformation(QPointF(333, 317), 1.0), &dist);
+    paintOp.paintAt(KisPaintInformation(QPointF(371, 402), 1.0), &dist);
+
+    return dev;
+}
+
+}
+
+void KisColorSmudgeOpTest::testStripedDab_data()
+{
+    QTest::addColumn<bool>("dullingMode");
+    QTest::addColumn<bool>("useColorRate");
+    QTest::addColumn<bool>("useOverlayMode");
+
+    QTest::newRow("smearing") << false << false << false;
+    QTest::newRow("smearing-color") << false << true << false;
+    QTest::newRow("dulling") << true << false << false;
+    QTest::newRow("dulling-color") << true << true << false;
+    QTest::newRow("smearing-overlay") << false << false << true;
+    QTest::newRow("smearing-color-overlay") << false << true << true;
+    QTest::newRow("dulling-overlay") << true << false << true;
+    QTest::newRow("dulling-color-overlay") << true << true << true;
+}
+
+void KisColorSmudgeOpTest::testStripedDab()
+{
+    QFETCH(bool, dullingMode);
+    QFETCH(bool, useColorRate);
+    QFETCH(bool, useOverlayMode);
+
+    KisPaintOpSettingsSP settings =
+        createSettings(dullingMode ? KisSmudgeOption::DULLING_MODE : KisSmudgeOption::SMEARING_MODE,
+                       useColorRate, useOverlayMode);
+
+    KisPaintDeviceSP sequential = paintStroke(settings, false);
+    KisPaintDeviceSP striped = paintStroke(settings, true);
+
+    QCOMPARE(striped->exactBounds(), sequential->exactBounds());
+
+    QPoint pt;
+    if (!TestUtil::comparePaintDevices(pt, striped, sequential)) {
+        QFAIL(QString("The striped dab differs from the sequential one at (%1, %2)")
+              .arg(pt.x()).arg(pt.y()).toLatin1());
+    }
+}
+
+QTEST_MAIN(KisColorSmudgeOpTest)
@@ -31,7 +31,9 @@
 #include <random>
 #include <iostream>
 #include <functional>
+#include <numeric>
 
+#include <QtConcurrent>
 
 #include "kis_paint_device.h"
 #include "kis_painter.h"
@@ -52,12 +54,28 @@
 #include "KoColorSpaceRegistry.h"
 #include "KoColorSpaceTraits.h"
 
+#include "kis_inpaint.h"
+
 const int MAX_DIST = 65535;
 const quint8 MASK_SET = 255;
 const quint8 MASK_CLEAR = 0;
 
 class MaskedImage; //forward decl for the forward decl below
 template <typename T> float distance_impl(const MaskedImage& my, int x, int y, const MaskedImage& other, int xo, int yo);
+template <typename T> float rowDistance_impl(const quint8 *src, const quint8 *srcMask, const quint8 *dst, const quint8 *dstMask, int numPixels, int nChannels, float maskedDistance);
+
+/**
+ * Runs \p func for every row in [0, numRows) using the global thread
+ * pool. The rows are processed in an arbitrary order, so \p func must
+ * not depend on results of the other rows of the same call.
+ */
+template <class Func>
+void parallelForRows(int numRows, Func func)
+{
+    QVector<int> rows(numRows);
+    std::iota(rows.begin(), rows.end(), 0);
+    QtConcurrent::blockingMap(rows, [&func] (int row) { func(row); });
+}
 
 
 class ImageView
@@ -250,6 +268,13 @@ private:
 public:
     std::function< float(const MaskedImage&, int, int, const MaskedImage& , int , int ) > distance;
 
+    /**
+     * Sums distances between \p numPixels consecutive pixels of two rows.
+     * Masked pixels contribute \p maskedDistance each. Unlike \ref distance,
+     * it works on raw row pointers, so the inner loop can be vectorized.
+     */
+    float (*rowDistance)(const quint8 *src, const quint8 *srcMask, const quint8 *dst, const quint8 *dstMask, int numPixels, int nChannels, float maskedDistance);
+
     void toPaintDevice(KisPaintDeviceSP imageDev, QRect rect)
     {
         imageData.saveToDevice(imageDev, rect);
@@ -277,18 +302,27 @@ public:
 
         //Use RGB traits to assign actual pixel data types.
         distance = &distance_impl<KoRgbU8Traits::channels_type>;
+        rowDistance = &rowDistance_impl<KoRgbU8Traits::channels_type>;
 
-        if( colorDepthId == Integer16BitsColorDepthID )
+        if( colorDepthId == Integer16BitsColorDepthID ) {
             distance = &distance_impl<KoRgbU16Traits::channels_type>;
+            rowDistance = &rowDistance_impl<KoRgbU16Traits::channels_type>;
+        }
 #ifdef HAVE_OPENEXR
-        if( colorDepthId == Float16BitsColorDepthID )
+        if( colorDepthId == Float16BitsColorDepthID ) {
             distance = &distance_impl<KoRgbF16Traits::channels_type>;
+            rowDistance = &rowDistance_impl<KoRgbF16Traits::channels_type>;
+        }
 #endif
-        if( colorDepthId == Float32BitsColorDepthID )
+        if( colorDepthId == Float32BitsColorDepthID ) {
             distance = &distance_impl<KoRgbF32Traits::channels_type>;
+            rowDistance = &rowDistance_impl<KoRgbF32Traits::channels_type>;
+        }
 
-        if( colorDepthId == Float64BitsColorDepthID )
+        if( colorDepthId == Float64BitsColorDepthID ) {
             distance = &distance_impl<KoRgbF64Traits::channels_type>;
+            rowDistance = &rowDistance_impl<KoRgbF64Traits::channels_type>;
+        }
     }
 
     MaskedImage(KisPaintDeviceSP _imageDev, KisPaintDeviceSP _maskDev, QRect _maskRect)
@@ -385,6 +419,7 @@ public:
         clone->cs = this->cs;
         clone->csMask = this->csMask;
         clone->distance = this->distance;
+        clone->rowDistance = this->rowDistance;
         return clone;
     }
 
@@ -396,13 +431,13 @@ public:
         return count;
     }
 
-    inline bool isMasked(int x, int y)
+    inline bool isMasked(int x, int y) const
     {
         return (*maskData(x, y) > MASK_CLEAR);
     }
 
     //returns true if the patch contains a masked pixel
-    bool containsMasked(int x, int y, int S)
+    bool containsMasked(int x, int y, int S) const
     {
         for (int dy = -S; dy <= S; ++dy) {
             int ys = y + dy;
@@ -437,12 +472,22 @@ public:
         return imageData(x, y);
     }
 
+    inline const quint8* imagePixelPtr(int x, int y) const
+    {
+        return imageData(x, y);
+    }
+
+    inline const quint8* maskPixelPtr(int x, int y) const
+    {
+        return maskData(x, y);
+    }
+
     inline void setImagePixels(int x, int y, QVector<float>& value)
     {
         cs->fromNormalisedChannelsValue(imageData(x, y), value);
     }
 
-    inline void mixColors(std::vector< quint8* > pixels, std::vector< float > w, float wsum,  quint8* dst)
+    inline void mixColors(std::vector< quint8* > &pixels, const std::vector< float > &w, float wsum,  quint8* dst) const
     {
         const KoMixColorsOp* mixOp = cs->mixColorsOp();
 
@@ -495,6 +540,47 @@ template <typename T> float distance_impl(const MaskedImage& my, int x, int y, c
     return dsq / ( (float)KoColorSpaceMathsTraits<T>::unitValue * (float)KoColorSpaceMathsTraits<T>::unitValue / MAX_DIST );
 }
 
+//Row version of distance_impl(). There are no branches in the inner loop, so that the compiler
+//could vectorize it. Masked pixels are accounted for with a select, not with an early exit.
+template <typename T> float rowDistance_impl(const quint8 *src, const quint8 *srcMask, const quint8 *dst, const quint8 *dstMask, int numPixels, int nChannels, float maskedDistance)
+{
+    const T *v1 = reinterpret_cast<const T*>(src);
+    const T *v2 = reinterpret_cast<const T*>(dst);
+    const float scale = MAX_DIST / ((float)KoColorSpaceMathsTraits<T>::unitValue * (float)KoColorSpaceMathsTraits<T>::unitValue);
+
+    float distance = 0;
+
+    if (nChannels == 4) {
+        for (int i = 0; i < numPixels; i++) {
+            const float d0 = (float)v1[0] - (float)v2[0];
+            const float d1 = (float)v1[1] - (float)v2[1];
+            const float d2 = (float)v1[2] - (float)v2[2];
+            const float d3 = (float)v1[3] - (float)v2[3];
+            const float dsq = d0 * d0 + d1 * d1 + d2 * d2 + d3 * d3;
+            const bool masked = (srcMask[i] | dstMask[i]) > MASK_CLEAR;
+
+            distance += masked ? maskedDistance : dsq * scale;
+            v1 += 4;
+            v2 += 4;
+        }
+    } else {
+        for (int i = 0; i < numPixels; i++) {
+            float dsq = 0;
+            for (int chan = 0; chan < nChannels; chan++) {
+                const float v = (float)v1[chan] - (float)v2[chan];
+                dsq += v * v;
+            }
+            const bool masked = (srcMask[i] | dstMask[i]) > MASK_CLEAR;
+
+            distance += masked ? maskedDistance : dsq * scale;
+            v1 += nChannels;
+            v2 += nChannels;
+        }
+    }
+
+    return distance;
+}
+
 
 typedef KisSharedPtr<MaskedImage> MaskedImageSP;
 
@@ -517,15 +603,32 @@ class NearestNeighborField : public KisShared
 {
 
 private:
-    template< typename T> T randomInt(T range)
+    typedef std::mt19937 RandomGenerator;
+
+    template< typename T> static T randomInt(RandomGenerator &generator, T range)
     {
-        return rand() % range;
+        return generator() % range;
+    }
+
+    /**
+     * Every row of every parallel pass gets its own generator seeded from
+     * the field seed, the pass number and the row. It keeps the result
+     * reproducible regardless of how the rows are scheduled over threads.
+     */
+    RandomGenerator rowGenerator(quint32 pass, int row) const
+    {
+        std::seed_seq seq{m_seed, pass, quint32(row)};
+        return RandomGenerator(seq);
     }
 
     //compute initial value of the distance term
     void initialize(void)
     {
-        for (int y = 0; y < imSize.height(); y++) {
+        const quint32 pass = m_passCounter++;
+
+        parallelForRows(imSize.height(), [this, pass] (int y) {
+            RandomGenerator generator = rowGenerator(pass, y);
+
             for (int x = 0; x < imSize.width(); x++) {
                 field[x][y].distance = distance(x, y, field[x][y].x, field[x][y].y);
 
@@ -533,13 +636,13 @@ private:
                 int iter = 0;
                 const int maxretry = 20;
                 while (field[x][y].distance == MAX_DIST && iter < maxretry) {
-                    field[x][y].x = randomInt(imSize.width() + 1);
-                    field[x][y].y = randomInt(imSize.height() + 1);
+                    field[x][y].x = randomInt(generator, imSize.width() + 1);
+                    field[x][y].y = randomInt(generator, imSize.height() + 1);
                     field[x][y].distance = distance(x, y, field[x][y].x, field[x][y].y);
                     iter++;
                 }
             }
-        }
+        });
     }
 
     void init_similarity_curve(void)
@@ -561,6 +664,14 @@ private:
 
 private:
     int patchSize; //patch size
+    quint32 m_seed;
+    quint32 m_passCounter;
+
+    /**
+     * The second buffer of the jump flooding, the steps read one
+     * buffer and write the other one
+     */
+    NNArray_type m_propagationField;
 public:
     MaskedImageSP input;
     MaskedImageSP output;
@@ -571,10 +682,12 @@ public:
     QList<KoChannelInfo *> channels;
 
 public:
-    NearestNeighborField(const MaskedImageSP _input, MaskedImageSP _output, int _patchsize) : patchSize(_patchsize), input(_input), output(_output)
+    NearestNeighborField(const MaskedImageSP _input, MaskedImageSP _output, int _patchsize, quint32 _seed)
+        : patchSize(_patchsize), m_seed(_seed), m_passCounter(0), input(_input), output(_output)
     {
         imSize = input->size();
         field.resize(boost::extents[imSize.width()][imSize.height()]);
+        m_propagationField.resize(boost::extents[imSize.width()][imSize.height()]);
         init_similarity_curve();
 
         nColors = input->channelCount(); //only color count, doesn't include alpha channels
@@ -582,10 +695,12 @@ public:
 
     void randomize(void)
     {
+        RandomGenerator generator = rowGenerator(m_passCounter++, 0);
+
         for (int y = 0; y < imSize.height(); y++) {
             for (int x = 0; x < imSize.width(); x++) {
-                field[x][y].x = randomInt(imSize.width() + 1);
-                field[x][y].y = randomInt(imSize.height() + 1);
+                field[x][y].x = randomInt(generator, imSize.width() + 1);
+                field[x][y].y = randomInt(generator, imSize.height() + 1);
                 field[x][y].distance = MAX_DIST;
             }
         }
@@ -611,130 +726,152 @@ public:
         initialize();
     }
 
-    //multi-pass NN-field minimization (see "PatchMatch" paper referenced above - page 4)
+    /**
+     * Multi-pass NN-field minimization (see "PatchMatch" paper referenced above - page 4)
+     *
+     * The original algorithm propagates good matches in scanline order, which
+     * makes every pixel depend on its predecessor and cannot be threaded. Here
+     * the propagation is done with jump flooding instead: on every step each
+     * pixel looks at the neighbors \p step pixels away in the field of the
+     * previous step, so all the pixels of a step are independent. The step
+     * starts at a half of the image size and is halved every time, so a match
+     * can reach any pixel of the image, just like with the scanline passes.
+     * Then a random search is done for every pixel in parallel.
+     */
     void minimize(int pass)
     {
-        int min_x = 0;
-        int min_y = 0;
-        int max_x = imSize.width() - 1;
-        int max_y = imSize.height() - 1;
+        const int maxStep = std::max(1, std::max(imSize.width(), imSize.height()) / 2);
 
         for (int i = 0; i < pass; i++) {
-            //scanline order
-            for (int y = min_y; y < max_y; y++)
-                for (int x = min_x; x <= max_x; x++)
-                    if (field[x][y].distance > 0)
-                        minimizeLink(x, y, 1);
-
-            //reverse scanline order
-            for (int y = max_y; y >= min_y; y--)
-                for (int x = max_x; x >= min_x; x--)
-                    if (field[x][y].distance > 0)
-                        minimizeLink(x, y, -1);
+            NNArray_type *srcField = &field;
+            NNArray_type *dstField = &m_propagationField;
+
+            for (int step = maxStep; step >= 1; step /= 2) {
+                parallelForRows(imSize.height(), [this, srcField, dstField, step] (int y) {
+                    for (int x = 0; x < imSize.width(); x++) {
+                        propagateLink(*srcField, *dstField, x, y, step);
+                    }
+                });
+
+                std::swap(srcField, dstField);
+            }
+
+            // the result of the last step might be in the second buffer
+            if (srcField != &field) {
+                field = *srcField;
+            }
+
+            const quint32 searchPass = m_passCounter++;
+
+            parallelForRows(imSize.height(), [this, searchPass] (int y) {
+                RandomGenerator generator = rowGenerator(searchPass, y);
+
+                for (int x = 0; x < imSize.width(); x++) {
+                    if (field[x][y].distance > 0) {
+                        randomSearch(x, y, generator);
+                    }
+                }
+            });
         }
     }
 
-    void minimizeLink(int x, int y, int dir)
+    inline void tryLink(NNArray_type &dstField, int x, int y, int xp, int yp)
     {
-        int xp, yp, dp;
+        const int dp = distance(x, y, xp, yp);
+        if (dp < dstField[x][y].distance) {
+            dstField[x][y].x = xp;
+            dstField[x][y].y = yp;
+            dstField[x][y].distance = dp;
+        }
+    }
 
-        //Propagation Left/Right
-        if (x - dir > 0 && x - dir < imSize.width()) {
-            xp = field[x - dir][y].x + dir;
-            yp = field[x - dir][y].y;
-            dp = distance(x, y, xp, yp);
-            if (dp < field[x][y].distance) {
-                field[x][y].x = xp;
-                field[x][y].y = yp;
-                field[x][y].distance = dp;
-            }
+    inline void tryLink(int x, int y, int xp, int yp)
+    {
+        tryLink(field, x, y, xp, yp);
+    }
+
+    //Propagation from the neighbors \p step pixels away. Reads only
+    //\p prevField and writes only the pixel (x, y) of \p dstField
+    void propagateLink(const NNArray_type &prevField, NNArray_type &dstField, int x, int y, int step)
+    {
+        dstField[x][y] = prevField[x][y];
+
+        if (prevField[x][y].distance <= 0) return;
+
+        if (x - step >= 0) {
+            tryLink(dstField, x, y, prevField[x - step][y].x + step, prevField[x - step][y].y);
         }
 
-        //Propagation Up/Down
-        if (y - dir > 0 && y - dir < imSize.height()) {
-            xp = field[x][y - dir].x;
-            yp = field[x][y - dir].y + dir;
-            dp = distance(x, y, xp, yp);
-            if (dp < field[x][y].distance) {
-                field[x][y].x = xp;
-                field[x][y].y = yp;
-                field[x][y].distance = dp;
-            }
+        if (x + step < imSize.width()) {
+            tryLink(dstField, x, y, prevField[x + step][y].x - step, prevField[x + step][y].y);
+        }
+
+        if (y - step >= 0) {
+            tryLink(dstField, x, y, prevField[x][y - step].x, prevField[x][y - step].y + step);
         }
 
-        //Random search
+        if (y + step < imSize.height()) {
+            tryLink(dstField, x, y, prevField[x][y + step].x, prevField[x][y + step].y - step);
+        }
+    }
+
+    void randomSearch(int x, int y, RandomGenerator &generator)
+    {
         int wi = std::max(output->size().width(), output->size().height());
         int xpi = field[x][y].x;
         int ypi = field[x][y].y;
         while (wi > 0) {
-            xp = xpi + randomInt(2 * wi) - wi;
-            yp = ypi + randomInt(2 * wi) - wi;
+            int xp = xpi + randomInt(generator, 2 * wi) - wi;
+            int yp = ypi + randomInt(generator, 2 * wi) - wi;
             xp = std::max(0, std::min(output->size().width() - 1, xp));
             yp = std::max(0, std::min(output->size().height() - 1, yp));
 
-            dp = distance(x, y, xp, yp);
-            if (dp < field[x][y].distance) {
-                field[x][y].x = xp;
-                field[x][y].y = yp;
-                field[x][y].distance = dp;
-            }
+            tryLink(x, y, xp, yp);
             wi /= 2;
         }
     }
 
     //compute distance between two patches
-    int distance(int x, int y, int xp, int yp)
+    int distance(int x, int y, int xp, int yp) const
     {
-        float distance = 0;
-        float wsum = 0;
-        float ssdmax = nColors * 255 * 255;
+        const int inputWidth = input->size().width();
+        const int inputHeight = input->size().height();
+        const int outputWidth = output->size().width();
+        const int outputHeight = output->size().height();
 
-        //for each pixel in the source patch
-        for (int dy = -patchSize; dy <= patchSize; dy++) {
-            for (int dx = -patchSize; dx <= patchSize; dx++) {
-                wsum += ssdmax;
-                int xks = x + dx;
-                int yks = y + dy;
+        const int patchWidth = 2 * patchSize + 1;
+        const float ssdmax = nColors * 255 * 255;
+        const float wsum = ssdmax * patchWidth * patchWidth;
 
-                if (xks < 0 || xks >= input->size().width()) {
-                    distance += ssdmax;
-                    continue;
-                }
+        //horizontal span of the patch, where both source and target pixels are inside the images
+        const int dxMin = std::max(-patchSize, std::max(-x, -xp));
+        const int dxMax = std::min(patchSize, std::min(inputWidth - 1 - x, outputWidth - 1 - xp));
+        const int numValid = std::max(0, dxMax - dxMin + 1);
 
-                if (yks < 0 || yks >= input->size().height()) {
-                    distance += ssdmax;
-                    continue;
-                }
+        float distance = 0;
 
-                //cannot use masked pixels as a valid source of information
-                if (input->isMasked(xks, yks)) {
-                    distance += ssdmax;
-                    continue;
-                }
+        //for each row in the source patch
+        for (int dy = -patchSize; dy <= patchSize; dy++) {
+            const int yks = y + dy;
+            const int ykt = yp + dy;
 
-                //corresponding pixel in target patch
-                int xkt = xp + dx;
-                int ykt = yp + dy;
-                if (xkt < 0 || xkt >= output->size().width()) {
-                    distance += ssdmax;
-                    continue;
-                }
-                if (ykt < 0 || ykt >= output->size().height()) {
-                    distance += ssdmax;
-                    continue;
-                }
+            if (!numValid ||
+                yks < 0 || yks >= inputHeight ||
+                ykt < 0 || ykt >= outputHeight) {
 
-                //cannot use masked pixels as a valid source of information
-                if (output->isMasked(xkt, ykt)) {
-                    distance += ssdmax;
-                    continue;
-                }
+                distance += ssdmax * patchWidth;
+                continue;
+            }
 
-                //SSD distance between pixels
-                float ssd = input->distance(*input, xks, yks, *output, xkt, ykt);
-                distance += ssd;
+            distance += ssdmax * (patchWidth - numValid);
 
-            }
+            //masked pixels cannot be used as a valid source of information, rowDistance()
+            //accounts them as ssdmax
+            distance += input->rowDistance(input->imagePixelPtr(x + dxMin, yks),
+                                           input->maskPixelPtr(x + dxMin, yks),
+                                           output->imagePixelPtr(xp + dxMin, ykt),
+                                           output->maskPixelPtr(xp + dxMin, ykt),
+                                           numValid, input->channelCount(), ssdmax);
         }
         return (int)(MAX_DIST * (distance / wsum));
     }
@@ -756,14 +893,16 @@ private:
     NearestNeighborFieldSP nnf_TargetToSource;
     NearestNeighborFieldSP nnf_SourceToTarget;
     int radius;
+    quint32 seed;
     QList<MaskedImageSP> pyramid;
 
 
 public:
-    Inpaint(KisPaintDeviceSP dev, KisPaintDeviceSP devMask, int _radius, QRect maskRect)
+    Inpaint(KisPaintDeviceSP dev, KisPaintDeviceSP devMask, int _radius, QRect maskRect, quint32 _seed)
     {
         initial = new MaskedImage(dev, devMask, maskRect);
         radius = _radius;
+        seed = _seed;
         devCache = dev;
     }
     MaskedImageSP patch(void);
@@ -802,13 +941,13 @@ MaskedImageSP Inpaint::patch()
 
         if (level == maxlevel - 1) {
             //random initial guess
-            nnf_TargetToSource = new NearestNeighborField(target, source, radius);
+            nnf_TargetToSource = new NearestNeighborField(target, source, radius, seed + level);
             nnf_TargetToSource->randomize();
         } else {
             // then, we use the rebuilt (upscaled) target
             // and reuse the previous NNF as initial guess
 
-            NearestNeighborFieldSP new_nnf_rev = new NearestNeighborField(target, source, radius);
+            NearestNeighborFieldSP new_nnf_rev = new NearestNeighborField(target, source, radius, seed + level);
             new_nnf_rev->initialize(*nnf_TargetToSource);
             nnf_TargetToSource = new_nnf_rev;
         }
@@ -841,15 +980,17 @@ MaskedImageSP NearestNeighborField::ExpectationMaximization(NearestNeighborField
             newtarget = nullptr;
         }
 
-        for (int x = 0; x < target->size().width(); ++x) {
-            for (int y = 0; y < target->size().height(); ++y) {
+        const int targetWidth = target->size().width();
+
+        parallelForRows(target->size().height(), [&] (int y) {
+            for (int x = 0; x < targetWidth; ++x) {
                 if (!source->containsMasked(x, y, radius)) {
                     nnf_TargetToSource->field[x][y].x = x;
                     nnf_TargetToSource->field[x][y].y = y;
                     nnf_TargetToSource->field[x][y].distance = 0;
                 }
             }
-        }
+        });
 
         //minimize the NNF
         nnf_TargetToSource->minimize(iterNNF);
@@ -895,12 +1036,14 @@ void NearestNeighborField::ExpectationStep(NearestNeighborFieldSP nnf, MaskedIma
     int H_source = source->size().height();
     int W_source = source->size().width();
 
-    std::vector< quint8* > pixels;
-    std::vector< float > weights;
-    pixels.reserve(R * R);
-    weights.reserve(R * R);
-    for (int x = 0 ; x < W_target ; ++x) {
-        for (int y = 0 ; y < H_target; ++y) {
+    //every target pixel is written exactly once and the sources are only read, so the rows can be mixed in parallel
+    parallelForRows(H_target, [&] (int y) {
+        std::vector< quint8* > pixels;
+        std::vector< float > weights;
+        pixels.reserve(R * R);
+        weights.reserve(R * R);
+
+        for (int x = 0 ; x < W_target ; ++x) {
             float wsum = 0;
             pixels.clear();
             weights.clear();
@@ -962,7 +1105,7 @@ void NearestNeighborField::ExpectationStep(NearestNeighborFieldSP nnf, MaskedIma
                 target->mixColors(pixels, weights, wsum, target->getImagePixel(x, y));
             }
         }
-    }
+    });
 }
 
 QRect getMaskBoundingBox(KisPaintDeviceSP maskDev)
@@ -972,7 +1115,7 @@ QRect getMaskBoundingBox(KisPaintDeviceSP maskDev)
 }
 
 
-QRect patchImage(const KisPaintDeviceSP imageDev, const KisPaintDeviceSP maskDev, int patchRadius, int accuracy)
+QRect patchImage(const KisPaintDeviceSP imageDev, const KisPaintDeviceSP maskDev, int patchRadius, int accuracy, quint32 seed)
 {
     QRect maskRect = getMaskBoundingBox(maskDev);
     QRect imageRect = imageDev->exactBounds();
@@ -984,7 +1127,7 @@ QRect patchImage(const KisPaintDeviceSP imageDev, const KisPaintDeviceSP maskDev
     maskRect = maskRect.intersected(imageRect);
 
     if (!maskRect.isEmpty()) {
-        Inpaint inpaint(imageDev, maskDev, patchRadius, maskRect);
+        Inpaint inpaint(imageDev, maskDev, patchRadius, maskRect, seed);
         MaskedImageSP output = inpaint.patch();
         output->toPaintDevice(imageDev, maskRect);
     }
@@ -0,0 +1,36 @@
+/*
+ *  Copyright (c) 2018 The Krita Developers
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ */
+
+#ifndef __KIS_INPAINT_H
+#define __KIS_INPAINT_H
+
+#include <QRect>
+#include "kis_types.h"
+
+/**
+ * Fills the masked area of \p imageDev with patches of its surroundings
+ * using the PatchMatch algorithm.
+ *
+ * The random parts of the algorithm are driven by \p seed, so the result
+ * does not depend on the number of threads used for processing.
+ *
+ * \return the rect of \p imageDev that has been changed
+ */
+QRect patchImage(KisPaintDeviceSP imageDev, KisPaintDeviceSP maskDev, int radius, int accuracy, quint32 seed = 0);
+
+#endif /* __KIS_INPAINT_H */
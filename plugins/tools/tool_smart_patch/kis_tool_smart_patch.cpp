@@ -43,8 +43,7 @@
 #include "libs/image/kis_paint_device_debug_utils.h"
 
 #include "kis_paint_layer.h"
-
-QRect patchImage(KisPaintDeviceSP imageDev, KisPaintDeviceSP maskDev, int radius, int accuracy);
+#include "kis_inpaint.h"
 
 class KisToolSmartPatch::InpaintCommand : public KisTransactionBasedCommand {
 public:
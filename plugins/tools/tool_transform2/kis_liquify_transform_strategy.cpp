@@ -50,6 +50,7 @@ struct KisLiquifyTransformStrategy::Private
           converter(_converter),
           currentArgs(_currentArgs),
           transaction(_transaction),
+          scaledOriginalImageKey(0),
           helper(_converter),
           recalculateOnNextRedraw(false)
     {
@@ -77,6 +78,15 @@ struct KisLiquifyTransformStrategy::Private
 
     QImage transformedImage;
 
+    /**
+     * The original image scaled into the flake coordinates. It is kept
+     * between the redraws, so that the liquify worker could recognize
+     * its source image and update only the changed part of the preview.
+     */
+    QImage scaledOriginalImage;
+    qint64 scaledOriginalImageKey;
+    QTransform scaledOriginalImageTransform;
+
     // size-gesture-related
     QPointF lastMouseWidgetPos;
     QPointF startResizeImagePos;
@@ -279,7 +289,16 @@ void KisLiquifyTransformStrategy::Private::recalculateTransformations()
     paintingOffset = transaction.originalTopLeft();
     if (!q->originalImage().isNull()) {
         if (useFlakeOptimization) {
-            transformedImage = q->originalImage().transformed(resultThumbTransform);
+            if (scaledOriginalImage.isNull() ||
+                scaledOriginalImageKey != q->originalImage().cacheKey() ||
+                scaledOriginalImageTransform != resultThumbTransform) {
+
+                scaledOriginalImage = q->originalImage().transformed(resultThumbTransform);
+                scaledOriginalImageKey = q->originalImage().cacheKey();
+                scaledOriginalImageTransform = resultThumbTransform;
+            }
+
+            transformedImage = scaledOriginalImage;
             paintingTransform = QTransform();
         } else {
             transformedImage = q->originalImage();
@@ -284,6 +284,7 @@ void KisTransformUtils::transformDevice(const ToolTransformArgs &config,
         KisTransformWorker transformWorker =
             createTransformWorker(config, device, updater1, &transformedCenter);
 
+        transformWorker.setUseMultithreading(true);
         transformWorker.run();
 
         if (config.mode() == ToolTransformArgs::FREE_TRANSFORM) {
@@ -293,6 +294,7 @@ void KisTransformUtils::transformDevice(const ToolTransformArgs &config,
                                                             config.aY(),
                                                             config.cameraPos().z(),
                                                             updater2);
+            perspectiveWorker.setUseMultithreading(true);
             perspectiveWorker.run();
         } else if (config.mode() == ToolTransformArgs::PERSPECTIVE_4POINT) {
             QTransform T =
@@ -302,6 +304,7 @@ void KisTransformUtils::transformDevice(const ToolTransformArgs &config,
             KisPerspectiveTransformWorker perspectiveWorker(device,
                                                             T.inverted() * config.flattenedPerspectiveTransform() * T,
                                                             updater2);
+            perspectiveWorker.setUseMultithreading(true);
             perspectiveWorker.run();
         }
     }